@@ -0,0 +1,57 @@
+#include "Arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+using namespace stargate;
+
+Arena::Arena() {
+}
+
+Arena::~Arena() {
+    clear();
+}
+
+void* Arena::allocateSlow(size_t size, size_t align) {
+    // Oversized requests get a dedicated block so that they do not
+    // waste the tail of the current one.
+    const size_t blockSize = (size + align > BLOCK_SIZE / 4)
+        ? size + align
+        : BLOCK_SIZE;
+
+    char* block = static_cast<char*>(malloc(blockSize));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    _blocks.push_back(block);
+    _allocatedBytes += blockSize;
+
+    uintptr_t p = reinterpret_cast<uintptr_t>(block);
+    p = (p + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+
+    if (blockSize == BLOCK_SIZE) {
+        _cur = reinterpret_cast<char*>(p + size);
+        _end = block + blockSize;
+    }
+
+    return reinterpret_cast<void*>(p);
+}
+
+std::string_view Arena::copyString(std::string_view str) {
+    char* data = allocateArray<char>(str.size() + 1);
+    memcpy(data, str.data(), str.size());
+    data[str.size()] = '\0';
+    return std::string_view(data, str.size());
+}
+
+void Arena::clear() {
+    for (char* block : _blocks) {
+        free(block);
+    }
+    _blocks.clear();
+    _cur = nullptr;
+    _end = nullptr;
+    _allocatedBytes = 0;
+}
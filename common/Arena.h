@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+namespace stargate {
+
+// Bump allocator. Memory is carved out of large blocks and released
+// all at once when the arena is cleared or destroyed; individual
+// allocations are never freed. Objects placed in an arena must be
+// trivially destructible.
+class Arena {
+public:
+    Arena();
+    ~Arena();
+
+    void* allocate(size_t size, size_t align) {
+        uintptr_t p = reinterpret_cast<uintptr_t>(_cur);
+        p = (p + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+        if (_cur && p + size <= reinterpret_cast<uintptr_t>(_end)) {
+            _cur = reinterpret_cast<char*>(p + size);
+            return reinterpret_cast<void*>(p);
+        }
+        return allocateSlow(size, align);
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Copies str into the arena. The returned view stays valid for
+    // the lifetime of the arena.
+    std::string_view copyString(std::string_view str);
+
+    size_t getAllocatedBytes() const { return _allocatedBytes; }
+    size_t getNumBlocks() const { return _blocks.size(); }
+
+    void clear();
+
+private:
+    std::vector<char*> _blocks;
+    char* _cur {nullptr};
+    char* _end {nullptr};
+    size_t _allocatedBytes {0};
+
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    void* allocateSlow(size_t size, size_t align);
+};
+
+}
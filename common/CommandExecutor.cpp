@@ -1,6 +1,7 @@
 #include "CommandExecutor.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/wait.h>
@@ -8,6 +9,8 @@
 
 #include <filesystem>
 #include <fstream>
+#include <string_view>
+#include <vector>
 
 #include "Command.h"
 #include "Panic.h"
@@ -34,29 +37,93 @@ std::string shellQuote(const std::string& arg) {
     return result;
 }
 
-void applyEnv(const Command* command) {
+// The environment of this process, with the variables of command set
+// and its path entries put in front of PATH.
+void getEnv(const Command* command, std::vector<std::string>& result) {
+    const auto isOverridden = [&](std::string_view name) {
+        if (name == "PATH" && !command->pathEntries().empty()) {
+            return true;
+        }
+        for (const auto& env : command->envVars()) {
+            if (env.first == name) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::string existingPath;
+    if (const char* path = getenv("PATH")) {
+        existingPath = path;
+    }
+
+    result.clear();
+    for (char** env = environ; *env; env++) {
+        const std::string_view var(*env);
+        if (!isOverridden(var.substr(0, var.find('=')))) {
+            result.emplace_back(var);
+        }
+    }
     for (const auto& env : command->envVars()) {
-        setenv(env.first.c_str(), env.second.c_str(), 1);
+        if (env.first == "PATH") {
+            existingPath = env.second;
+        }
+        if (env.first != "PATH" || command->pathEntries().empty()) {
+            result.push_back(env.first + "=" + env.second);
+        }
     }
 
     if (command->pathEntries().empty()) {
         return;
     }
 
-    std::string newPath;
+    std::string newPath = "PATH=";
     for (const auto& entry : command->pathEntries()) {
-        if (!newPath.empty()) {
-            newPath += ":";
-        }
         newPath += entry;
+        newPath += ":";
     }
+    if (existingPath.empty()) {
+        newPath.pop_back();
+    } else {
+        newPath += existingPath;
+    }
+    result.push_back(newPath);
+}
 
-    const char* existing = getenv("PATH");
-    if (existing != nullptr && *existing != '\0') {
-        newPath += ":";
-        newPath += existing;
+// The program execvp() would run for name, searched in the PATH of env
+// since execvp() would search that of this process. name itself if it
+// has a slash or is not found, for execve() to fail on.
+void findProgram(const std::string& name,
+                 const std::vector<std::string>& env,
+                 std::string& result) {
+    result = name;
+    if (name.empty() || name.find('/') != std::string::npos) {
+        return;
+    }
+
+    std::string_view path = "/usr/bin:/bin";
+    for (const std::string& var : env) {
+        if (var.starts_with("PATH=")) {
+            path = std::string_view(var).substr(5);
+        }
+    }
+
+    while (true) {
+        const size_t end = path.find(':');
+        const std::string_view dir = path.substr(0, end);
+        std::string candidate = dir.empty() ? "." : std::string(dir);
+        candidate += "/";
+        candidate += name;
+        if (access(candidate.c_str(), X_OK) == 0
+            && !std::filesystem::is_directory(candidate)) {
+            result = candidate;
+            return;
+        }
+        if (end == std::string_view::npos) {
+            return;
+        }
+        path.remove_prefix(end + 1);
     }
-    setenv("PATH", newPath.c_str(), 1);
 }
 
 }
@@ -111,35 +178,50 @@ int CommandExecutor::exec(const Command* command) {
         writeScript(command, command->getScriptPath());
     }
 
+    // Commands are launched from many threads at once: everything the
+    // child needs is built before fork(), and the child only calls
+    // async-signal-safe functions. The pipe is close-on-exec so that a
+    // concurrent launch does not inherit it and hold it open.
+    std::vector<std::string> env;
+    getEnv(command, env);
+    std::string program;
+    findProgram(command->getName(), env, program);
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(command->getName().c_str()));
+    for (const auto& arg : command->args()) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    std::vector<char*> envp;
+    for (std::string& var : env) {
+        envp.push_back(var.data());
+    }
+    envp.push_back(nullptr);
+
     int pipeFd[2] = {-1, -1};
-    if (pipe(pipeFd) < 0) {
+    if (pipe2(pipeFd, O_CLOEXEC) < 0) {
         panic("Failed to create pipe: {}", strerror(errno));
     }
 
     const pid_t pid = fork();
     if (pid < 0) {
-        panic("Failed to fork: {}", strerror(errno));
+        const int error = errno;
+        close(pipeFd[0]);
+        close(pipeFd[1]);
+        panic("Failed to fork: {}", strerror(error));
     }
 
     if (pid == 0) {
-        close(pipeFd[0]);
+        // dup2() clears close-on-exec on the copies.
         dup2(pipeFd[1], STDOUT_FILENO);
         dup2(pipeFd[1], STDERR_FILENO);
-        close(pipeFd[1]);
-
-        applyEnv(command);
-
-        std::vector<char*> argv;
-        argv.push_back(const_cast<char*>(command->getName().c_str()));
-        for (const auto& arg : command->args()) {
-            argv.push_back(const_cast<char*>(arg.c_str()));
-        }
-        argv.push_back(nullptr);
 
-        execvp(command->getName().c_str(), argv.data());
+        execve(program.c_str(), argv.data(), envp.data());
 
-        const char* msg = "Failed to exec command\n";
-        const ssize_t ignored = write(STDERR_FILENO, msg, strlen(msg));
+        static const char msg[] = "Failed to exec command\n";
+        const ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
         (void)ignored;
         _exit(EXEC_FAILED_EXIT_CODE);
     }
@@ -0,0 +1,93 @@
+#include "ContentHash.h"
+
+#include <string.h>
+
+#include "MappedFile.h"
+
+using namespace stargate;
+
+namespace {
+
+constexpr uint64_t SEED_A = 0x9e3779b97f4a7c15ull;
+constexpr uint64_t SEED_B = 0xc2b2ae3d27d4eb4full;
+constexpr uint64_t MUL_A = 0x87c37b91114253d5ull;
+constexpr uint64_t MUL_B = 0x4cf5ad432745937full;
+
+uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Final avalanche of MurmurHash3.
+uint64_t fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+}
+
+ContentHash::ContentHash()
+    : _a(SEED_A),
+    _b(SEED_B)
+{
+}
+
+ContentHash::~ContentHash() {
+}
+
+void ContentHash::mix(uint64_t word) {
+    // Two lanes with different multipliers and rotations, so that a
+    // collision has to happen in both at once.
+    _a = rotl((_a ^ word) * MUL_A, 31);
+    _b = rotl(_b + word, 27) * MUL_B;
+}
+
+void ContentHash::update(std::string_view data) {
+    const char* p = data.data();
+    size_t n = data.size();
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        mix(word);
+    }
+
+    // An empty string may have a null data pointer, which memcpy must
+    // not be given even for no bytes.
+    uint64_t tail = 0;
+    if (n > 0) {
+        memcpy(&tail, p, n);
+    }
+    mix(tail);
+    mix(data.size());
+}
+
+void ContentHash::update(uint64_t value) {
+    mix(value);
+}
+
+void ContentHash::hex(std::string& result) const {
+    const uint64_t hi = fmix(_a + _b);
+    const uint64_t lo = fmix(_b ^ rotl(_a, 17));
+
+    static const char DIGITS[] = "0123456789abcdef";
+    result.assign(32, '0');
+    for (int i = 0; i < 16; i++) {
+        result[i] = DIGITS[(hi >> (60 - i * 4)) & 0xf];
+        result[16 + i] = DIGITS[(lo >> (60 - i * 4)) & 0xf];
+    }
+}
+
+bool ContentHash::hashFile(const std::string& path, std::string* hex) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    ContentHash hash;
+    hash.update(file.data());
+    hash.hex(*hex);
+    return true;
+}
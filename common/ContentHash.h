@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+namespace stargate {
+
+// 128-bit hash of a sequence of byte strings, for telling whether
+// inputs changed. Fast and well mixed, but not cryptographic: it only
+// has to separate honest edits, not resist crafted collisions.
+class ContentHash {
+public:
+    ContentHash();
+    ~ContentHash();
+
+    // Each string is hashed together with its length, so the split
+    // between successive updates is part of the hash.
+    void update(std::string_view data);
+    void update(uint64_t value);
+
+    // The hash as 32 lowercase hex digits.
+    void hex(std::string& result) const;
+
+    // Hashes the contents of a file into hex. Returns false if the file
+    // cannot be read.
+    static bool hashFile(const std::string& path, std::string* hex);
+
+private:
+    uint64_t _a {0};
+    uint64_t _b {0};
+
+    void mix(uint64_t word);
+};
+
+}
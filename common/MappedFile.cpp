@@ -0,0 +1,65 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace stargate;
+
+MappedFile::MappedFile() {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, Mode mode) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    // mmap rejects zero-length mappings.
+    if (st.st_size == 0) {
+        ::close(fd);
+        _open = true;
+        return true;
+    }
+
+    const bool writable = mode == Mode::CopyOnWrite;
+    const int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* p = mmap(nullptr, st.st_size, prot, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+
+    // Read-only files are scanned front to back exactly once, while a
+    // copy-on-write file is about to be patched and kept in memory.
+    madvise(p, st.st_size, writable ? MADV_WILLNEED : MADV_SEQUENTIAL);
+
+    _data = static_cast<char*>(p);
+    _size = st.st_size;
+    _open = true;
+    _writable = writable;
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data) {
+        munmap(_data, _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+    _writable = false;
+}
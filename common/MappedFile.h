@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <string_view>
+
+namespace stargate {
+
+// View of a whole file. The file is memory-mapped, so its contents
+// are paged in on demand and never copied. Empty files map to an empty
+// view.
+class MappedFile {
+public:
+    enum class Mode {
+        ReadOnly,
+        // Writable, but writes stay private to the mapping: a written
+        // page is copied and the file never changes.
+        CopyOnWrite,
+    };
+
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened or mapped.
+    bool open(const std::string& path, Mode mode = Mode::ReadOnly);
+    void close();
+
+    bool isOpen() const { return _open; }
+    std::string_view data() const { return {_data, _size}; }
+    size_t size() const { return _size; }
+
+    // nullptr unless opened CopyOnWrite.
+    char* getWritableData() const { return _writable ? _data : nullptr; }
+
+private:
+    char* _data {nullptr};
+    size_t _size {0};
+    bool _open {false};
+    bool _writable {false};
+};
+
+}
@@ -0,0 +1,149 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace stargate;
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < threadCount; i++) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        _threads.emplace_back([this, i]() { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+
+    for (std::thread& t : _threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+
+    std::unique_lock lock(_mutex);
+    _func = &func;
+    _error = nullptr;
+    _pending.store(count, std::memory_order_relaxed);
+    _remaining.store(count, std::memory_order_relaxed);
+
+    // One contiguous share per worker to start with; stealing evens
+    // out the rest.
+    const size_t share = (count + _workers.size() - 1) / _workers.size();
+    for (size_t i = 0; i < _workers.size(); i++) {
+        const size_t begin = std::min(count, i * share);
+        const size_t end = std::min(count, begin + share);
+        if (begin < end) {
+            std::lock_guard workerLock(_workers[i]->mutex);
+            _workers[i]->ranges.push_back({begin, end});
+        }
+    }
+
+    _generation++;
+    _wake.notify_all();
+
+    // Workers still looking for ranges hold on to the job, so it ends
+    // once they have all gone back to sleep.
+    _done.wait(lock, [this]() {
+        return _remaining.load(std::memory_order_acquire) == 0 && _activeWorkers == 0;
+    });
+    _func = nullptr;
+
+    if (_error) {
+        std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+}
+
+void ThreadPool::run(size_t index) {
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(_mutex);
+            _wake.wait(lock, [&]() { return _stop || _generation != generation; });
+            if (_stop) {
+                return;
+            }
+            generation = _generation;
+            _activeWorkers++;
+        }
+
+        runRanges(index);
+
+        {
+            std::lock_guard lock(_mutex);
+            _activeWorkers--;
+        }
+        _done.notify_all();
+    }
+}
+
+void ThreadPool::runRanges(size_t index) {
+    Worker* worker = _workers[index].get();
+    Range range;
+    while (_pending.load(std::memory_order_acquire) != 0) {
+        if (!popRange(index, &range) && !stealRange(index, &range)) {
+            // Another worker is between taking a range and splitting it.
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Split down to one item before running it, so that every item
+        // not yet started can be stolen.
+        while (range.end - range.begin > 1) {
+            const size_t mid = range.begin + (range.end - range.begin) / 2;
+            std::lock_guard lock(worker->mutex);
+            worker->ranges.push_back({mid, range.end});
+            range.end = mid;
+        }
+
+        _pending.fetch_sub(1, std::memory_order_acq_rel);
+        try {
+            (*_func)(range.begin);
+        } catch (...) {
+            std::lock_guard lock(_mutex);
+            if (!_error) {
+                _error = std::current_exception();
+            }
+        }
+        _remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+bool ThreadPool::popRange(size_t index, Range* range) {
+    Worker* worker = _workers[index].get();
+    std::lock_guard lock(worker->mutex);
+    if (worker->ranges.empty()) {
+        return false;
+    }
+
+    *range = worker->ranges.back();
+    worker->ranges.pop_back();
+    return true;
+}
+
+bool ThreadPool::stealRange(size_t index, Range* range) {
+    for (size_t i = 1; i < _workers.size(); i++) {
+        Worker* victim = _workers[(index + i) % _workers.size()].get();
+        std::lock_guard lock(victim->mutex);
+        if (!victim->ranges.empty()) {
+            *range = victim->ranges.front();
+            victim->ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
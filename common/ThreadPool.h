@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stargate {
+
+// Fixed set of worker threads running index ranges. Each worker has its
+// own deque of ranges: it splits the range it takes down to one item,
+// pushing the upper halves back, and an idle worker steals the oldest,
+// largest range of another. Uneven items thus balance without a shared
+// queue.
+//
+// parallelFor() is the barrier: it returns once every item has run.
+// A pool runs one parallelFor() at a time, and items must not call
+// parallelFor() on their own pool.
+class ThreadPool {
+public:
+    // One worker per core if threadCount is 0.
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(_threads.size()); }
+
+    // Runs func(i) for every i in [0, count). The first exception
+    // thrown by an item is rethrown once all items are done.
+    void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+private:
+    struct Range {
+        size_t begin {0};
+        size_t end {0};
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    uint64_t _generation {0};
+    unsigned _activeWorkers {0};
+    bool _stop {false};
+
+    // Job of the current parallelFor(). Items are pending until a
+    // worker starts them and remaining until they are done.
+    const std::function<void(size_t)>* _func {nullptr};
+    std::atomic<size_t> _pending {0};
+    std::atomic<size_t> _remaining {0};
+    std::exception_ptr _error;
+
+    void run(size_t index);
+    void runRanges(size_t index);
+    bool popRange(size_t index, Range* range);
+    bool stealRange(size_t index, Range* range);
+};
+
+}
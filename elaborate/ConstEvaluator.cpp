@@ -0,0 +1,1028 @@
+#include "ConstEvaluator.h"
+
+#include <algorithm>
+#include <bit>
+#include <string>
+
+#include "DesignUnits.h"
+
+namespace stargate {
+
+namespace {
+
+constexpr uint64_t MAX_WIDTH = 64;
+
+uint64_t getMask(uint64_t width) {
+    return width >= MAX_WIDTH ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+int64_t truncate(int64_t value, uint64_t width) {
+    return static_cast<int64_t>(static_cast<uint64_t>(value) & getMask(width));
+}
+
+int64_t signExtend(int64_t value, uint64_t width) {
+    if (width == 0 || width >= MAX_WIDTH) {
+        return value;
+    }
+    const uint64_t sign = uint64_t(1) << (width - 1);
+    const uint64_t bits = static_cast<uint64_t>(value) & getMask(width);
+    return static_cast<int64_t>((bits ^ sign) - sign);
+}
+
+// Keys of unknown values are never 0, which stands for no key.
+uint64_t mixKey(uint64_t key, uint64_t value) {
+    uint64_t h = (key ^ value) * 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return (h ^ (h >> 33)) | 1;
+}
+
+ConstValue makeBool(bool value) {
+    return ConstValue::make(value ? 1 : 0, 1);
+}
+
+// Width of an integer atom type, or 0 for the other types.
+uint32_t getAtomWidth(AstDataType type) {
+    switch (type) {
+        case AstDataType::Byte:
+            return 8;
+        case AstDataType::ShortInt:
+            return 16;
+        case AstDataType::Int:
+        case AstDataType::Integer:
+            return 32;
+        case AstDataType::LongInt:
+        case AstDataType::Time:
+            return 64;
+        default:
+            return 0;
+    }
+}
+
+bool isSigned(const Ast* ast, AstNodeID decl) {
+    if (ast->hasFlag(decl, AstFlags::Signed)) {
+        return true;
+    }
+    const AstDataType type = ast->getDataType(decl);
+    return type != AstDataType::Time
+        && getAtomWidth(type) != 0
+        && !ast->hasFlag(decl, AstFlags::Unsigned);
+}
+
+AstNodeID findDeclarator(const Ast* ast, AstNodeID decl) {
+    AstNodeID declarator = NULL_AST_NODE;
+    for (AstNodeID id = ast->getFirstChild(decl); id; id = ast->getNextSibling(id)) {
+        if (ast->getKind(id) == AstKind::Declarator) {
+            declarator = id;
+        }
+    }
+    return declarator;
+}
+
+// Value of a digit in base, or -1 for x, z and ?.
+int getDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+}
+
+uint64_t TypeLayout::getWidth() const {
+    uint64_t width = baseWidth;
+    for (const Dim& dim : dims) {
+        width *= dim.getSize();
+    }
+    return width;
+}
+
+uint64_t TypeLayout::getElementWidth() const {
+    return dims.empty() ? baseWidth : getWidth() / dims.front().getSize();
+}
+
+Scope::Scope(const Scope* parent)
+    : _parent(parent)
+{
+}
+
+Scope::~Scope() {
+}
+
+void Scope::addImport(const Scope* package) {
+    if (std::find(_imports.begin(), _imports.end(), package) == _imports.end()) {
+        _imports.push_back(package);
+    }
+}
+
+const ConstValue* Scope::findValue(std::string_view name) const {
+    for (const Scope* scope = this; scope; scope = scope->_parent) {
+        if (const ConstValue* value = scope->findLocalValue(name)) {
+            return value;
+        }
+        for (const Scope* package : scope->_imports) {
+            if (const ConstValue* value = package->findLocalValue(name)) {
+                return value;
+            }
+        }
+    }
+    return nullptr;
+}
+
+const TypeRef* Scope::findType(std::string_view name) const {
+    for (const Scope* scope = this; scope; scope = scope->_parent) {
+        if (const TypeRef* type = scope->findLocalType(name)) {
+            return type;
+        }
+        for (const Scope* package : scope->_imports) {
+            if (const TypeRef* type = package->findLocalType(name)) {
+                return type;
+            }
+        }
+    }
+    return nullptr;
+}
+
+const ConstValue* Scope::findLocalValue(std::string_view name) const {
+    const auto it = _values.find(name);
+    return it != _values.end() ? &it->second : nullptr;
+}
+
+const TypeRef* Scope::findLocalType(std::string_view name) const {
+    const auto it = _types.find(name);
+    return it != _types.end() ? &it->second : nullptr;
+}
+
+ConstValue parseNumber(std::string_view text) {
+    std::string digits;
+    digits.reserve(text.size());
+    for (char c : text) {
+        if (c != '_' && c != ' ' && c != '\t') {
+            digits += c;
+        }
+    }
+
+    const size_t apostrophe = digits.find('\'');
+    if (apostrophe == std::string::npos) {
+        uint64_t value = 0;
+        for (char c : digits) {
+            const int digit = getDigit(c);
+            if (digit < 0 || digit > 9 || value > (UINT64_MAX - digit) / 10) {
+                return ConstValue {};
+            }
+            value = value * 10 + digit;
+        }
+        return ConstValue::make(static_cast<int64_t>(value), value >> 32 ? 64 : 32);
+    }
+
+    // Unbased unsized literals fill whatever they are assigned to.
+    std::string_view rest = std::string_view(digits).substr(apostrophe + 1);
+    if (apostrophe == 0 && rest.size() == 1) {
+        if (rest[0] == '0') {
+            return ConstValue::make(0, 1);
+        }
+        if (rest[0] == '1') {
+            return ConstValue::make(-1, 64);
+        }
+        return ConstValue {0, 1, false};
+    }
+
+    uint64_t width = 32;
+    if (apostrophe > 0) {
+        width = 0;
+        for (char c : std::string_view(digits).substr(0, apostrophe)) {
+            const int digit = getDigit(c);
+            if (digit < 0 || digit > 9 || width > UINT32_MAX / 10) {
+                return ConstValue {};
+            }
+            width = width * 10 + digit;
+        }
+    }
+
+    bool isSigned = false;
+    if (!rest.empty() && (rest[0] == 's' || rest[0] == 'S')) {
+        isSigned = true;
+        rest.remove_prefix(1);
+    }
+    if (rest.empty() || width == 0) {
+        return ConstValue {};
+    }
+
+    unsigned base = 10;
+    switch (rest[0]) {
+        case 'b':
+        case 'B':
+            base = 2;
+            break;
+        case 'o':
+        case 'O':
+            base = 8;
+            break;
+        case 'd':
+        case 'D':
+            base = 10;
+            break;
+        case 'h':
+        case 'H':
+            base = 16;
+            break;
+        default:
+            return ConstValue {};
+    }
+    rest.remove_prefix(1);
+
+    ConstValue result {0, static_cast<uint32_t>(width), false};
+    uint64_t value = 0;
+    for (char c : rest) {
+        const int digit = getDigit(c);
+        if (digit < 0) {
+            // x, z or ?: the value is not a plain number.
+            return result;
+        }
+        if (static_cast<unsigned>(digit) >= base) {
+            return result;
+        }
+        if (value > (UINT64_MAX - digit) / base) {
+            return result;
+        }
+        value = value * base + digit;
+    }
+
+    if (width < MAX_WIDTH) {
+        value &= getMask(width);
+    }
+    result.value = static_cast<int64_t>(value);
+    if (isSigned) {
+        result.value = signExtend(result.value, width);
+    }
+    result.known = true;
+    return result;
+}
+
+ConstEvaluator::ConstEvaluator(const DesignUnits* units,
+                               const Ast* ast,
+                               const Scope* scope)
+    : _units(units),
+    _ast(ast),
+    _scope(scope)
+{
+}
+
+ConstValue ConstEvaluator::evaluate(AstNodeID expr) const {
+    if (expr == NULL_AST_NODE) {
+        return ConstValue {};
+    }
+
+    switch (_ast->getKind(expr)) {
+        case AstKind::Number:
+            return parseNumber(_ast->getName(expr));
+
+        case AstKind::Identifier:
+        case AstKind::ScopedIdentifier:
+            return findName(expr);
+
+        case AstKind::Unary:
+            return evaluateUnary(expr);
+
+        case AstKind::Binary:
+            return evaluateBinary(expr);
+
+        case AstKind::Ternary: {
+            const AstNodeID cond = _ast->getFirstChild(expr);
+            const AstNodeID a = _ast->getNextSibling(cond);
+            const AstNodeID b = _ast->getNextSibling(a);
+            const ConstValue c = evaluate(cond);
+            if (!c.known) {
+                return ConstValue {};
+            }
+            return evaluate(c.value != 0 ? a : b);
+        }
+
+        case AstKind::Concat:
+        case AstKind::Replicate:
+            return evaluateConcat(expr);
+
+        case AstKind::SystemCall:
+            return evaluateSystemCall(expr);
+
+        case AstKind::Cast:
+            return evaluateCast(expr);
+
+        case AstKind::Select:
+            return evaluateSelect(expr);
+
+        case AstKind::RangeSelect:
+            return evaluateRangeSelect(expr);
+
+        case AstKind::Inside:
+            return evaluateInside(expr);
+
+        default:
+            return ConstValue {};
+    }
+}
+
+bool ConstEvaluator::evaluateInt(AstNodeID expr, int64_t* value) const {
+    const ConstValue result = evaluate(expr);
+    if (!result.known) {
+        return false;
+    }
+    *value = result.value;
+    return true;
+}
+
+bool ConstEvaluator::evaluateDim(AstNodeID range, Dim* dim) const {
+    const AstNodeID first = _ast->getFirstChild(range);
+    const AstNodeID second = first ? _ast->getNextSibling(first) : NULL_AST_NODE;
+    if (!second) {
+        int64_t size = 0;
+        if (!evaluateInt(first, &size) || size <= 0) {
+            return false;
+        }
+        *dim = Dim {0, size - 1};
+        return true;
+    }
+    return evaluateInt(first, &dim->msb) && evaluateInt(second, &dim->lsb);
+}
+
+bool ConstEvaluator::getLayout(AstNodeID decl,
+                               AstNodeID declarator,
+                               TypeLayout* layout) const {
+    layout->dims.clear();
+    layout->baseWidth = 1;
+    layout->structType = TypeRef {};
+
+    if (declarator) {
+        for (AstNodeID id = _ast->getFirstChild(declarator); id;
+             id = _ast->getNextSibling(id)) {
+            if (_ast->getKind(id) != AstKind::Range) {
+                break;
+            }
+            Dim dim;
+            if (!evaluateDim(id, &dim)) {
+                return false;
+            }
+            layout->dims.push_back(dim);
+        }
+    }
+    return appendTypeLayout(decl, layout);
+}
+
+bool ConstEvaluator::appendTypeLayout(AstNodeID decl, TypeLayout* layout) const {
+    AstNodeID child = _ast->getFirstChild(decl);
+    for (; child && _ast->getKind(child) == AstKind::Range;
+         child = _ast->getNextSibling(child)) {
+        Dim dim;
+        if (!evaluateDim(child, &dim)) {
+            return false;
+        }
+        layout->dims.push_back(dim);
+    }
+
+    const AstDataType type = _ast->getDataType(decl);
+    switch (type) {
+        case AstDataType::Implicit:
+        case AstDataType::Wire:
+        case AstDataType::Wand:
+        case AstDataType::Wor:
+        case AstDataType::Supply0:
+        case AstDataType::Supply1:
+        case AstDataType::Reg:
+        case AstDataType::Logic:
+        case AstDataType::Bit:
+            return true;
+
+        case AstDataType::Byte:
+        case AstDataType::ShortInt:
+        case AstDataType::Int:
+        case AstDataType::LongInt:
+        case AstDataType::Integer:
+        case AstDataType::Time:
+            layout->dims.push_back(Dim {getAtomWidth(type) - 1, 0});
+            return true;
+
+        case AstDataType::Enum:
+            // The first member is the base type.
+            return child && appendTypeLayout(child, layout);
+
+        case AstDataType::Struct:
+        case AstDataType::Union: {
+            uint64_t width = 0;
+            if (!getStructWidth(decl, &width)) {
+                return false;
+            }
+            layout->baseWidth = width;
+            layout->structType = TypeRef {_ast, decl, _scope};
+            return true;
+        }
+
+        case AstDataType::User: {
+            const TypeRef* typeRef = findType(_ast->getName(decl));
+            if (!typeRef) {
+                return false;
+            }
+            const ConstEvaluator evaluator(_units, typeRef->ast, typeRef->scope);
+            TypeLayout typeLayout;
+            if (!evaluator.getLayout(typeRef->decl,
+                                     findDeclarator(typeRef->ast, typeRef->decl),
+                                     &typeLayout)) {
+                return false;
+            }
+            layout->dims.insert(layout->dims.end(),
+                                typeLayout.dims.begin(), typeLayout.dims.end());
+            layout->baseWidth = typeLayout.baseWidth;
+            layout->structType = typeLayout.structType;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool ConstEvaluator::getStructWidth(AstNodeID decl, uint64_t* width) const {
+    const bool isUnion = _ast->getDataType(decl) == AstDataType::Union;
+    *width = 0;
+    for (AstNodeID member = _ast->getFirstChild(decl); member;
+         member = _ast->getNextSibling(member)) {
+        if (_ast->getKind(member) != AstKind::VarDecl) {
+            continue;
+        }
+        for (AstNodeID id = _ast->getFirstChild(member); id;
+             id = _ast->getNextSibling(id)) {
+            if (_ast->getKind(id) != AstKind::Declarator) {
+                continue;
+            }
+            TypeLayout layout;
+            if (!getLayout(member, id, &layout)) {
+                return false;
+            }
+            const uint64_t memberWidth = layout.getWidth();
+            *width = isUnion ? std::max(*width, memberWidth) : *width + memberWidth;
+        }
+    }
+    return true;
+}
+
+bool ConstEvaluator::getMember(const TypeLayout& layout,
+                               std::string_view name,
+                               uint64_t* offset,
+                               TypeLayout* memberLayout) const {
+    const TypeRef& type = layout.structType;
+    if (!type.ast) {
+        return false;
+    }
+
+    const ConstEvaluator evaluator(_units, type.ast, type.scope);
+    const bool isUnion = type.ast->getDataType(type.decl) == AstDataType::Union;
+
+    // The first member is the most significant: the offset of a member
+    // is the width of the members after it.
+    bool found = false;
+    uint64_t after = 0;
+    for (AstNodeID member = type.ast->getFirstChild(type.decl); member;
+         member = type.ast->getNextSibling(member)) {
+        if (type.ast->getKind(member) != AstKind::VarDecl) {
+            continue;
+        }
+        for (AstNodeID id = type.ast->getFirstChild(member); id;
+             id = type.ast->getNextSibling(id)) {
+            if (type.ast->getKind(id) != AstKind::Declarator) {
+                continue;
+            }
+            TypeLayout current;
+            if (!evaluator.getLayout(member, id, &current)) {
+                return false;
+            }
+            if (found) {
+                after += current.getWidth();
+            } else if (type.ast->getName(id) == name) {
+                found = true;
+                *memberLayout = current;
+                if (isUnion) {
+                    *offset = 0;
+                    return true;
+                }
+            }
+        }
+    }
+
+    *offset = after;
+    return found;
+}
+
+ConstValue ConstEvaluator::evaluateParam(AstNodeID decl, AstNodeID declarator) const {
+    AstNodeID init = NULL_AST_NODE;
+    for (AstNodeID id = _ast->getFirstChild(declarator); id;
+         id = _ast->getNextSibling(id)) {
+        if (_ast->getKind(id) != AstKind::Range) {
+            init = id;
+        }
+    }
+
+    return sizeParam(decl, declarator, evaluateParamValue(init));
+}
+
+ConstValue ConstEvaluator::evaluateParamValue(AstNodeID expr) const {
+    ConstValue value = evaluate(expr);
+    if (!value.known && value.key == 0 && expr != NULL_AST_NODE) {
+        value.key = getUnknownKey(expr);
+    }
+    return value;
+}
+
+ConstValue ConstEvaluator::sizeParam(AstNodeID decl,
+                                     AstNodeID declarator,
+                                     ConstValue value) const {
+    if (!value.known) {
+        return value;
+    }
+
+    // An untyped parameter takes the width of its value.
+    const AstNodeID first = _ast->getFirstChild(decl);
+    if (_ast->getDataType(decl) == AstDataType::Implicit
+        && (!first || _ast->getKind(first) != AstKind::Range)
+        && !_ast->hasFlag(decl, AstFlags::Signed)) {
+        return value;
+    }
+
+    TypeLayout layout;
+    if (!getLayout(decl, declarator, &layout)) {
+        return value;
+    }
+    const uint64_t width = layout.getWidth();
+    if (width == 0 || width > MAX_WIDTH) {
+        ConstValue wide;
+        wide.key = mixKey(mixKey(static_cast<uint64_t>(value.value), width),
+                          isSigned(_ast, decl));
+        return wide;
+    }
+    value.width = static_cast<uint32_t>(width);
+    value.value = isSigned(_ast, decl) ? signExtend(value.value, width)
+                                       : truncate(value.value, width);
+    return value;
+}
+
+void ConstEvaluator::declareTypedef(Scope* scope, AstNodeID decl) const {
+    const AstNodeID declarator = findDeclarator(_ast, decl);
+    if (!declarator) {
+        return;
+    }
+    scope->addType(_ast->getName(declarator), TypeRef {_ast, decl, scope});
+    declareEnumItems(scope, decl);
+}
+
+void ConstEvaluator::declareEnumItems(Scope* scope, AstNodeID decl) const {
+    if (_ast->getDataType(decl) != AstDataType::Enum) {
+        return;
+    }
+
+    uint64_t width = 32;
+    AstNodeID id = _ast->getFirstChild(decl);
+    while (id && _ast->getKind(id) == AstKind::Range) {
+        id = _ast->getNextSibling(id);
+    }
+    if (id && _ast->getKind(id) == AstKind::VarDecl) {
+        TypeLayout layout;
+        if (getLayout(id, NULL_AST_NODE, &layout)) {
+            width = std::min(layout.getWidth(), MAX_WIDTH);
+        }
+        id = _ast->getNextSibling(id);
+    }
+
+    // Each constant without a value follows the previous one.
+    ConstValue next = ConstValue::make(0, static_cast<uint32_t>(width));
+    for (; id && _ast->getKind(id) == AstKind::EnumItem; id = _ast->getNextSibling(id)) {
+        const AstNodeID valueExpr = _ast->getFirstChild(id);
+        ConstValue value = valueExpr ? evaluate(valueExpr) : next;
+        if (value.known) {
+            value.value = truncate(value.value, width);
+        }
+        value.width = static_cast<uint32_t>(width);
+        scope->setValue(_ast->getName(id), value);
+        next = value;
+        next.value++;
+    }
+}
+
+const TypeRef* ConstEvaluator::findType(std::string_view name) const {
+    if (const TypeRef* type = _scope ? _scope->findType(name) : nullptr) {
+        return type;
+    }
+    for (const std::unique_ptr<Scope>& package : _units->getPackageScopes()) {
+        if (const TypeRef* type = package->findType(name)) {
+            return type;
+        }
+    }
+    return nullptr;
+}
+
+ConstValue ConstEvaluator::findName(AstNodeID expr) const {
+    const ConstValue* value = nullptr;
+    if (_ast->getKind(expr) == AstKind::ScopedIdentifier) {
+        const std::string_view packageName = _ast->getName(_ast->getFirstChild(expr));
+        const Scope* package = _units->findPackage(packageName);
+        value = package ? package->findValue(_ast->getName(expr)) : nullptr;
+    } else if (_scope) {
+        value = _scope->findValue(_ast->getName(expr));
+    }
+    return value ? *value : ConstValue {};
+}
+
+uint64_t ConstEvaluator::getUnknownKey(AstNodeID expr) const {
+    const AstNode& node = _ast->getNode(expr);
+    uint64_t key = mixKey(static_cast<uint64_t>(node.kind), node.sub);
+    key = mixKey(key, node.flags);
+
+    // A name stands for its value, so that the same expression in two
+    // specializations of a module gets two keys.
+    if (node.kind == AstKind::Identifier || node.kind == AstKind::ScopedIdentifier) {
+        const ConstValue value = findName(expr);
+        if (value.known) {
+            return mixKey(mixKey(key, static_cast<uint64_t>(value.value)), value.width);
+        }
+        if (value.key != 0) {
+            return mixKey(key, value.key);
+        }
+    }
+
+    if (node.name != NULL_SYMBOL) {
+        key = mixKey(key, StringTable::hash(_ast->getName(expr)));
+    }
+    for (AstNodeID id = node.firstChild; id; id = _ast->getNextSibling(id)) {
+        key = mixKey(key, getUnknownKey(id));
+    }
+    return key;
+}
+
+uint64_t ConstEvaluator::getTypeWidth(AstNodeID expr) const {
+    const TypeRef* type = nullptr;
+    const AstKind kind = _ast->getKind(expr);
+    if (kind == AstKind::ScopedIdentifier) {
+        const std::string_view packageName = _ast->getName(_ast->getFirstChild(expr));
+        const Scope* package = _units->findPackage(packageName);
+        type = package ? package->findType(_ast->getName(expr)) : nullptr;
+    } else if (kind == AstKind::Identifier) {
+        type = findType(_ast->getName(expr));
+    }
+    if (!type) {
+        return 0;
+    }
+
+    const ConstEvaluator evaluator(_units, type->ast, type->scope);
+    TypeLayout layout;
+    const AstNodeID declarator = findDeclarator(type->ast, type->decl);
+    if (!evaluator.getLayout(type->decl, declarator, &layout)) {
+        return 0;
+    }
+    return layout.getWidth();
+}
+
+ConstValue ConstEvaluator::evaluateUnary(AstNodeID expr) const {
+    const ConstValue operand = evaluate(_ast->getFirstChild(expr));
+    if (!operand.known) {
+        return ConstValue {};
+    }
+
+    const uint64_t bits = static_cast<uint64_t>(operand.value) & getMask(operand.width);
+    const uint64_t mask = getMask(operand.width);
+    switch (_ast->getOp(expr)) {
+        case AstOp::Plus:
+            return operand;
+        case AstOp::Minus:
+            return ConstValue::make(-operand.value, operand.width);
+        case AstOp::LogNot:
+            return makeBool(operand.value == 0);
+        case AstOp::BitNot:
+            return ConstValue::make(truncate(~operand.value, operand.width),
+                                    operand.width);
+        case AstOp::RedAnd:
+            return makeBool(bits == mask);
+        case AstOp::RedNand:
+            return makeBool(bits != mask);
+        case AstOp::RedOr:
+            return makeBool(bits != 0);
+        case AstOp::RedNor:
+            return makeBool(bits == 0);
+        case AstOp::RedXor:
+            return makeBool(std::popcount(bits) & 1);
+        case AstOp::RedXnor:
+            return makeBool(!(std::popcount(bits) & 1));
+        default:
+            return ConstValue {};
+    }
+}
+
+ConstValue ConstEvaluator::evaluateBinary(AstNodeID expr) const {
+    const AstNodeID lhs = _ast->getFirstChild(expr);
+    const AstNodeID rhs = _ast->getNextSibling(lhs);
+    const AstOp op = _ast->getOp(expr);
+    const ConstValue a = evaluate(lhs);
+
+    // The right operand of a decided && or || need not be constant.
+    if (a.known && op == AstOp::LogAnd && a.value == 0) {
+        return makeBool(false);
+    }
+    if (a.known && op == AstOp::LogOr && a.value != 0) {
+        return makeBool(true);
+    }
+
+    const ConstValue b = evaluate(rhs);
+    if (!a.known || !b.known) {
+        return ConstValue {};
+    }
+
+    const uint32_t width = std::max(a.width, b.width);
+    const uint64_t ua = static_cast<uint64_t>(a.value);
+    const uint64_t ub = static_cast<uint64_t>(b.value);
+    switch (op) {
+        case AstOp::Add:
+            return ConstValue::make(static_cast<int64_t>(ua + ub), width);
+        case AstOp::Sub:
+            return ConstValue::make(static_cast<int64_t>(ua - ub), width);
+        case AstOp::Mul:
+            return ConstValue::make(static_cast<int64_t>(ua * ub), width);
+        case AstOp::Div:
+            if (b.value == 0 || (a.value == INT64_MIN && b.value == -1)) {
+                return ConstValue {};
+            }
+            return ConstValue::make(a.value / b.value, width);
+        case AstOp::Mod:
+            if (b.value == 0 || (a.value == INT64_MIN && b.value == -1)) {
+                return ConstValue {};
+            }
+            return ConstValue::make(a.value % b.value, width);
+        case AstOp::Pow: {
+            if (b.value < 0) {
+                return ConstValue::make(a.value == 1 ? 1 : 0, width);
+            }
+            uint64_t result = 1;
+            uint64_t base = ua;
+            for (uint64_t e = ub; e; e >>= 1) {
+                if (e & 1) {
+                    result *= base;
+                }
+                base *= base;
+            }
+            return ConstValue::make(static_cast<int64_t>(result), width);
+        }
+        case AstOp::Lt:
+            return makeBool(a.value < b.value);
+        case AstOp::Le:
+            return makeBool(a.value <= b.value);
+        case AstOp::Gt:
+            return makeBool(a.value > b.value);
+        case AstOp::Ge:
+            return makeBool(a.value >= b.value);
+        case AstOp::Eq:
+        case AstOp::CaseEq:
+            return makeBool(a.value == b.value);
+        case AstOp::Neq:
+        case AstOp::CaseNeq:
+            return makeBool(a.value != b.value);
+        case AstOp::LogAnd:
+            return makeBool(a.value != 0 && b.value != 0);
+        case AstOp::LogOr:
+            return makeBool(a.value != 0 || b.value != 0);
+        case AstOp::BitAnd:
+            return ConstValue::make(a.value & b.value, width);
+        case AstOp::BitOr:
+            return ConstValue::make(a.value | b.value, width);
+        case AstOp::BitXor:
+            return ConstValue::make(a.value ^ b.value, width);
+        case AstOp::BitNand:
+            return ConstValue::make(truncate(~(a.value & b.value), width), width);
+        case AstOp::BitNor:
+            return ConstValue::make(truncate(~(a.value | b.value), width), width);
+        case AstOp::BitXnor:
+            return ConstValue::make(truncate(~(a.value ^ b.value), width), width);
+        case AstOp::Shl:
+        case AstOp::AShl:
+            if (ub >= MAX_WIDTH) {
+                return ConstValue::make(0, a.width);
+            }
+            return ConstValue::make(static_cast<int64_t>(ua << ub), a.width);
+        case AstOp::Shr: {
+            if (ub >= MAX_WIDTH) {
+                return ConstValue::make(0, a.width);
+            }
+            const uint64_t bits = ua & getMask(a.width);
+            return ConstValue::make(static_cast<int64_t>(bits >> ub), a.width);
+        }
+        case AstOp::AShr:
+            return ConstValue::make(a.value >> std::min<uint64_t>(ub, MAX_WIDTH - 1),
+                                    a.width);
+        default:
+            return ConstValue {};
+    }
+}
+
+ConstValue ConstEvaluator::evaluateConcat(AstNodeID expr) const {
+    int64_t count = 1;
+    AstNodeID concat = expr;
+    if (_ast->getKind(expr) == AstKind::Replicate) {
+        const AstNodeID countExpr = _ast->getFirstChild(expr);
+        if (!evaluateInt(countExpr, &count) || count < 0) {
+            return ConstValue {};
+        }
+        concat = _ast->getNextSibling(countExpr);
+    }
+
+    uint64_t width = 0;
+    uint64_t bits = 0;
+    for (AstNodeID id = _ast->getFirstChild(concat); id; id = _ast->getNextSibling(id)) {
+        const ConstValue part = evaluate(id);
+        if (!part.known) {
+            return ConstValue {};
+        }
+        width += part.width;
+        if (width > MAX_WIDTH) {
+            return ConstValue {};
+        }
+        bits = (part.width >= MAX_WIDTH ? 0 : bits << part.width)
+             | (static_cast<uint64_t>(part.value) & getMask(part.width));
+    }
+
+    if (width * count > MAX_WIDTH || width * count == 0) {
+        return ConstValue {};
+    }
+    uint64_t result = 0;
+    for (int64_t i = 0; i < count; i++) {
+        result = (width >= MAX_WIDTH ? 0 : result << width) | bits;
+    }
+    return ConstValue::make(static_cast<int64_t>(result),
+                            static_cast<uint32_t>(width * count));
+}
+
+ConstValue ConstEvaluator::evaluateSystemCall(AstNodeID expr) const {
+    const std::string_view name = _ast->getName(expr);
+    const AstNodeID arg = _ast->getFirstChild(expr);
+    if (!arg) {
+        return ConstValue {};
+    }
+
+    if (name == "$bits") {
+        const uint64_t typeWidth = getTypeWidth(arg);
+        if (typeWidth) {
+            return ConstValue::make(static_cast<int64_t>(typeWidth));
+        }
+        const ConstValue value = evaluate(arg);
+        return value.known ? ConstValue::make(value.width) : ConstValue {};
+    }
+
+    const ConstValue value = evaluate(arg);
+    if (!value.known) {
+        return ConstValue {};
+    }
+
+    if (name == "$clog2") {
+        const uint64_t n = static_cast<uint64_t>(value.value);
+        return ConstValue::make(n <= 1 ? 0 : 64 - std::countl_zero(n - 1));
+    }
+    if (name == "$signed") {
+        return ConstValue::make(signExtend(value.value, value.width), value.width);
+    }
+    if (name == "$unsigned") {
+        return ConstValue::make(truncate(value.value, value.width), value.width);
+    }
+    return ConstValue {};
+}
+
+ConstValue ConstEvaluator::evaluateCast(AstNodeID expr) const {
+    const AstNodeID first = _ast->getFirstChild(expr);
+    const AstNodeID second = first ? _ast->getNextSibling(first) : NULL_AST_NODE;
+
+    // signed'(x), unsigned'(x) and int'(x) forms have one child.
+    if (!second) {
+        const ConstValue value = evaluate(first);
+        if (!value.known) {
+            return value;
+        }
+        if (_ast->hasFlag(expr, AstFlags::Signed)) {
+            return ConstValue::make(signExtend(value.value, value.width), value.width);
+        }
+        if (_ast->hasFlag(expr, AstFlags::Unsigned)) {
+            return ConstValue::make(truncate(value.value, value.width), value.width);
+        }
+
+        const AstDataType type = _ast->getDataType(expr);
+        const uint32_t atomWidth = getAtomWidth(type);
+        if (atomWidth) {
+            return ConstValue::make(type == AstDataType::Time
+                                        ? truncate(value.value, atomWidth)
+                                        : signExtend(value.value, atomWidth),
+                                    atomWidth);
+        }
+        if (type == AstDataType::Void) {
+            return ConstValue {};
+        }
+        return ConstValue::make(truncate(value.value, 1), 1);
+    }
+
+    // T'(x) for a type T, or N'(x) for a width N.
+    uint64_t width = getTypeWidth(first);
+    if (!width) {
+        int64_t size = 0;
+        if (!evaluateInt(first, &size) || size <= 0) {
+            return ConstValue {};
+        }
+        width = static_cast<uint64_t>(size);
+    }
+
+    const ConstValue value = evaluate(second);
+    if (!value.known || width > MAX_WIDTH) {
+        return ConstValue {};
+    }
+    return ConstValue::make(truncate(value.value, width), static_cast<uint32_t>(width));
+}
+
+ConstValue ConstEvaluator::evaluateSelect(AstNodeID expr) const {
+    const AstNodeID base = _ast->getFirstChild(expr);
+    const ConstValue value = evaluate(base);
+    int64_t index = 0;
+    if (!value.known || !evaluateInt(_ast->getNextSibling(base), &index)) {
+        return ConstValue {};
+    }
+    if (index < 0 || index >= static_cast<int64_t>(value.width)) {
+        return ConstValue {};
+    }
+    return ConstValue::make((static_cast<uint64_t>(value.value) >> index) & 1, 1);
+}
+
+ConstValue ConstEvaluator::evaluateRangeSelect(AstNodeID expr) const {
+    const AstNodeID base = _ast->getFirstChild(expr);
+    const AstNodeID left = _ast->getNextSibling(base);
+    const AstNodeID right = _ast->getNextSibling(left);
+
+    const ConstValue value = evaluate(base);
+    int64_t a = 0;
+    int64_t b = 0;
+    if (!value.known || !evaluateInt(left, &a) || !evaluateInt(right, &b)) {
+        return ConstValue {};
+    }
+
+    int64_t low = 0;
+    int64_t width = 0;
+    switch (_ast->getOp(expr)) {
+        case AstOp::IndexedUp:
+            low = a;
+            width = b;
+            break;
+        case AstOp::IndexedDown:
+            low = a - b + 1;
+            width = b;
+            break;
+        default:
+            low = std::min(a, b);
+            width = std::max(a, b) - low + 1;
+            break;
+    }
+
+    if (low < 0 || width <= 0 || low >= static_cast<int64_t>(MAX_WIDTH)
+        || width > static_cast<int64_t>(MAX_WIDTH)) {
+        return ConstValue {};
+    }
+    const uint64_t bits = (static_cast<uint64_t>(value.value) >> low) & getMask(width);
+    return ConstValue::make(static_cast<int64_t>(bits), static_cast<uint32_t>(width));
+}
+
+ConstValue ConstEvaluator::evaluateInside(AstNodeID expr) const {
+    const AstNodeID operand = _ast->getFirstChild(expr);
+    const ConstValue value = evaluate(operand);
+    if (!value.known) {
+        return ConstValue {};
+    }
+
+    for (AstNodeID id = _ast->getNextSibling(operand); id;
+         id = _ast->getNextSibling(id)) {
+        if (_ast->getKind(id) == AstKind::Range) {
+            const AstNodeID lowExpr = _ast->getFirstChild(id);
+            int64_t low = 0;
+            int64_t high = 0;
+            if (!evaluateInt(lowExpr, &low)
+                || !evaluateInt(_ast->getNextSibling(lowExpr), &high)) {
+                return ConstValue {};
+            }
+            if (value.value >= low && value.value <= high) {
+                return makeBool(true);
+            }
+        } else {
+            const ConstValue item = evaluate(id);
+            if (!item.known) {
+                return ConstValue {};
+            }
+            if (item.value == value.value) {
+                return makeBool(true);
+            }
+        }
+    }
+    return makeBool(false);
+}
+
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <stdint.h>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Ast.h"
+
+namespace stargate {
+
+class DesignUnits;
+class Scope;
+
+// Value of a constant expression. Values wider than 64 bits, or with
+// x or z bits, are unknown: they cannot shape the netlist, and an
+// elaboration only fails if one is needed for a width, an index or a
+// generate condition.
+//
+// An unknown parameter value still selects a module of its own: its
+// key hashes the expression it comes from, over the values of the
+// names in it, so "a" and "b", or 'hx and 'hz, differ. Other unknown
+// values have key 0.
+struct ConstValue {
+    int64_t value {0};
+    uint32_t width {32};
+    bool known {false};
+    uint64_t key {0};
+
+    static ConstValue make(int64_t value, uint32_t width = 32) {
+        return ConstValue {value, width, true};
+    }
+
+    // Widths are left out: 4'd3 and 3 select the same module.
+    bool operator==(const ConstValue& other) const {
+        return known == other.known && (known ? value == other.value : key == other.key);
+    }
+};
+
+// Declared dimension [msb:lsb]. msb may be below lsb.
+struct Dim {
+    int64_t msb {0};
+    int64_t lsb {0};
+
+    uint64_t getSize() const {
+        return static_cast<uint64_t>(msb >= lsb ? msb - lsb : lsb - msb) + 1;
+    }
+
+    bool contains(int64_t index) const {
+        return msb >= lsb ? index <= msb && index >= lsb
+                          : index >= msb && index <= lsb;
+    }
+
+    // Position of index counted from the lsb end.
+    uint64_t getOffset(int64_t index) const {
+        return static_cast<uint64_t>(msb >= lsb ? index - lsb : lsb - index);
+    }
+};
+
+// A typedef, with the scope its names resolve in.
+struct TypeRef {
+    const Ast* ast {nullptr};
+    AstNodeID decl {NULL_AST_NODE};
+    const Scope* scope {nullptr};
+};
+
+// Bit layout of a data object: its dimensions, unpacked then packed,
+// outermost first, over elements of baseWidth bits. Integer atoms
+// like int are given their implicit [31:0] dimension, so only a
+// struct or union has a base wider than one bit; its declaration is
+// kept for member selects.
+struct TypeLayout {
+    std::vector<Dim> dims;
+    uint64_t baseWidth {1};
+    TypeRef structType;
+
+    uint64_t getWidth() const;
+    // Width of one element of the outermost dimension.
+    uint64_t getElementWidth() const;
+};
+
+// Names visible at one point of the design: parameters, genvars and
+// enum constants, and typedefs. A lookup searches the scope itself,
+// then the packages it imports, then its parent. Names are views into
+// the syntax trees, which outlive every scope.
+class Scope {
+public:
+    explicit Scope(const Scope* parent = nullptr);
+    ~Scope();
+
+    const Scope* getParent() const { return _parent; }
+
+    void setValue(std::string_view name, const ConstValue& value) {
+        _values[name] = value;
+    }
+    void addType(std::string_view name, const TypeRef& type) { _types[name] = type; }
+    void addImport(const Scope* package);
+
+    // Each returns nullptr if the name is not visible.
+    const ConstValue* findValue(std::string_view name) const;
+    const TypeRef* findType(std::string_view name) const;
+
+private:
+    const Scope* _parent {nullptr};
+    std::unordered_map<std::string_view, ConstValue> _values;
+    std::unordered_map<std::string_view, TypeRef> _types;
+    std::vector<const Scope*> _imports;
+
+    const ConstValue* findLocalValue(std::string_view name) const;
+    const TypeRef* findLocalType(std::string_view name) const;
+};
+
+// Evaluates constant expressions and type layouts of one syntax tree
+// in a scope. Constant function calls and struct-valued parameters
+// are not evaluated: they give unknown values.
+class ConstEvaluator {
+public:
+    ConstEvaluator(const DesignUnits* units, const Ast* ast, const Scope* scope);
+
+    const Ast* getAst() const { return _ast; }
+
+    ConstValue evaluate(AstNodeID expr) const;
+
+    // Returns false if expr is not a known constant.
+    bool evaluateInt(AstNodeID expr, int64_t* value) const;
+
+    // A Range node; [N] stands for [0:N-1].
+    bool evaluateDim(AstNodeID range, Dim* dim) const;
+
+    // Layout of the objects declared by decl, a declaration node, with
+    // the unpacked dimensions of declarator, if any, in front. Returns
+    // false for non-structural types (real, string, type parameters)
+    // or if a dimension is not constant.
+    bool getLayout(AstNodeID decl, AstNodeID declarator, TypeLayout* layout) const;
+
+    // Evaluates expr, the value of a parameter or of a parameter
+    // override, giving it a key if it is unknown.
+    ConstValue evaluateParamValue(AstNodeID expr) const;
+
+    // Evaluates a parameter declarator of decl, sized to the declared
+    // type if it has one.
+    ConstValue evaluateParam(AstNodeID decl, AstNodeID declarator) const;
+
+    // Sizes value, evaluated elsewhere, to the type of a parameter.
+    ConstValue sizeParam(AstNodeID decl, AstNodeID declarator, ConstValue value) const;
+
+    // Declares the typedef node decl in scope, with its enum constants
+    // if it is an enum.
+    void declareTypedef(Scope* scope, AstNodeID decl) const;
+
+    // Declares in scope the constants of decl if its type is an enum.
+    void declareEnumItems(Scope* scope, AstNodeID decl) const;
+
+    // Finds a typedef by name in the scope, then in every package,
+    // since `pkg::T` keeps only T in the syntax tree.
+    const TypeRef* findType(std::string_view name) const;
+
+    // Bit offset and layout of the struct or union member name, in the
+    // struct type of layout. Returns false if there is no such member.
+    bool getMember(const TypeLayout& layout,
+                   std::string_view name,
+                   uint64_t* offset,
+                   TypeLayout* memberLayout) const;
+
+private:
+    const DesignUnits* _units {nullptr};
+    const Ast* _ast {nullptr};
+    const Scope* _scope {nullptr};
+
+    bool appendTypeLayout(AstNodeID decl, TypeLayout* layout) const;
+    bool getStructWidth(AstNodeID decl, uint64_t* width) const;
+
+    ConstValue evaluateUnary(AstNodeID expr) const;
+    ConstValue evaluateBinary(AstNodeID expr) const;
+    ConstValue evaluateConcat(AstNodeID expr) const;
+    ConstValue evaluateSystemCall(AstNodeID expr) const;
+    ConstValue evaluateCast(AstNodeID expr) const;
+    ConstValue evaluateSelect(AstNodeID expr) const;
+    ConstValue evaluateRangeSelect(AstNodeID expr) const;
+    ConstValue evaluateInside(AstNodeID expr) const;
+    ConstValue findName(AstNodeID expr) const;
+    uint64_t getUnknownKey(AstNodeID expr) const;
+    // Width of the type named by expr, or 0 if it names none.
+    uint64_t getTypeWidth(AstNodeID expr) const;
+};
+
+// Parses the text of a Number node: 42, 8'hff, 'sd5, '1.
+ConstValue parseNumber(std::string_view text);
+
+}
@@ -0,0 +1,170 @@
+#include "DesignUnits.h"
+
+#include "ConstEvaluator.h"
+#include "SourceMap.h"
+
+namespace stargate {
+
+DesignUnits::DesignUnits() {
+}
+
+DesignUnits::~DesignUnits() {
+}
+
+void DesignUnits::addAst(const Ast* ast, const SourceMap* sourceMap) {
+    _asts.push_back(ast);
+    _sourceMaps[ast] = sourceMap;
+    _unitScopes[ast].reset(new Scope());
+
+    for (AstNodeID id = ast->getFirstChild(ast->root()); id;
+         id = ast->getNextSibling(id)) {
+        const std::string_view name = ast->getName(id);
+        switch (ast->getKind(id)) {
+            case AstKind::Module: {
+                const auto [it, inserted] = _moduleIndices.emplace(name, _modules.size());
+                if (inserted) {
+                    _modules.push_back(ModuleRef {ast, id});
+                } else {
+                    addError(ast, id,
+                             "module '" + std::string(name) + "' is already defined");
+                }
+            }
+            break;
+
+            case AstKind::Package: {
+                const auto [it, inserted] =
+                    _packageIndices.emplace(name, _packages.size());
+                if (inserted) {
+                    Package& package = _packages.emplace_back();
+                    package.ast = ast;
+                    package.node = id;
+                    package.scope = new Scope();
+                    _packageScopes.emplace_back(package.scope);
+                } else {
+                    addError(ast, id,
+                             "package '" + std::string(name) + "' is already defined");
+                }
+            }
+            break;
+
+            default:
+            break;
+        }
+    }
+}
+
+void DesignUnits::evaluatePackages() {
+    for (Package& package : _packages) {
+        evaluatePackage(&package);
+    }
+
+    for (const Ast* ast : _asts) {
+        declareItems(ast, ast->root(), _unitScopes[ast].get());
+    }
+}
+
+void DesignUnits::evaluatePackage(Package* package) {
+    if (package->evaluated) {
+        return;
+    }
+    if (package->evaluating) {
+        addError(package->ast, package->node, "package '"
+                 + std::string(package->ast->getName(package->node))
+                 + "' imports itself");
+        return;
+    }
+
+    package->evaluating = true;
+    evaluateReferencedPackages(package->ast, package->node);
+    declareItems(package->ast, package->node, package->scope);
+    package->evaluating = false;
+    package->evaluated = true;
+}
+
+void DesignUnits::evaluateReferencedPackages(const Ast* ast, AstNodeID node) {
+    for (AstNodeID id = ast->getFirstChild(node); id; id = ast->getNextSibling(id)) {
+        if (ast->getKind(id) == AstKind::ScopedIdentifier) {
+            const AstNodeID head = ast->getFirstChild(id);
+            const auto it = _packageIndices.find(ast->getName(head));
+            if (it != _packageIndices.end() && !_packages[it->second].evaluating) {
+                evaluatePackage(&_packages[it->second]);
+            }
+        }
+        evaluateReferencedPackages(ast, id);
+    }
+}
+
+void DesignUnits::declareItems(const Ast* ast, AstNodeID node, Scope* scope) {
+    const ConstEvaluator evaluator(this, ast, scope);
+    for (AstNodeID id = ast->getFirstChild(node); id; id = ast->getNextSibling(id)) {
+        switch (ast->getKind(id)) {
+            case AstKind::Import: {
+                const auto it = _packageIndices.find(ast->getName(id));
+                if (it == _packageIndices.end()) {
+                    addError(ast, id,
+                             "unknown package '" + std::string(ast->getName(id)) + "'");
+                    break;
+                }
+                Package* package = &_packages[it->second];
+                evaluatePackage(package);
+                scope->addImport(package->scope);
+            }
+            break;
+
+            case AstKind::ParamDecl:
+                if (ast->getDataType(id) == AstDataType::Type) {
+                    break;
+                }
+                for (AstNodeID d = ast->getFirstChild(id); d;
+                     d = ast->getNextSibling(d)) {
+                    if (ast->getKind(d) == AstKind::Declarator) {
+                        scope->setValue(ast->getName(d), evaluator.evaluateParam(id, d));
+                    }
+                }
+            break;
+
+            case AstKind::Typedef:
+                evaluator.declareTypedef(scope, id);
+            break;
+
+            default:
+            break;
+        }
+    }
+}
+
+const ModuleRef* DesignUnits::findModule(std::string_view name) const {
+    const auto it = _moduleIndices.find(name);
+    return it != _moduleIndices.end() ? &_modules[it->second] : nullptr;
+}
+
+const Scope* DesignUnits::findPackage(std::string_view name) const {
+    const auto it = _packageIndices.find(name);
+    return it != _packageIndices.end() ? _packages[it->second].scope : nullptr;
+}
+
+const Scope* DesignUnits::getUnitScope(const Ast* ast) const {
+    const auto it = _unitScopes.find(ast);
+    return it != _unitScopes.end() ? it->second.get() : nullptr;
+}
+
+void DesignUnits::formatError(const Ast* ast,
+                              AstNodeID node,
+                              std::string_view message,
+                              std::string& result) const {
+    const auto it = _sourceMaps.find(ast);
+    const SourceMap* sourceMap = it != _sourceMaps.end() ? it->second : nullptr;
+    uint32_t file = 0;
+    uint32_t line = 0;
+    result.clear();
+    if (sourceMap && sourceMap->resolve(ast->getNode(node).line, &file, &line)) {
+        result = sourceMap->getFileName(file) + ":" + std::to_string(line) + ": ";
+    }
+    result += message;
+}
+
+void DesignUnits::addError(const Ast* ast, AstNodeID node, std::string_view message) {
+    formatError(ast, node, message, _errors.emplace_back());
+}
+
+}
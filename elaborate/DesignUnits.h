@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Ast.h"
+
+namespace stargate {
+
+class Scope;
+class SourceMap;
+
+// A module of one of the parsed syntax trees.
+struct ModuleRef {
+    const Ast* ast {nullptr};
+    AstNodeID node {NULL_AST_NODE};
+
+    std::string_view getName() const { return ast->getName(node); }
+};
+
+// Every module and package of the syntax trees of one elaboration, by
+// name. Trees come from separate drivers, each with its own symbols,
+// so names are matched by text.
+//
+// Packages, and the declarations at the root of each tree, are
+// evaluated once by evaluatePackages(); their scopes are then only
+// read, from any thread.
+class DesignUnits {
+public:
+    DesignUnits();
+    ~DesignUnits();
+
+    DesignUnits(const DesignUnits&) = delete;
+    DesignUnits& operator=(const DesignUnits&) = delete;
+
+    // sourceMap resolves the lines of ast for messages, and may be
+    // null. A module or package defined twice keeps its first
+    // definition and adds an error.
+    void addAst(const Ast* ast, const SourceMap* sourceMap);
+
+    void evaluatePackages();
+
+    // Each returns nullptr if there is no such unit.
+    const ModuleRef* findModule(std::string_view name) const;
+    const Scope* findPackage(std::string_view name) const;
+
+    // Scope of the declarations at the root of ast, parent of the
+    // scopes of its modules.
+    const Scope* getUnitScope(const Ast* ast) const;
+
+    std::span<const ModuleRef> getModules() const { return _modules; }
+    std::span<const std::unique_ptr<Scope>> getPackageScopes() const {
+        return _packageScopes;
+    }
+
+    // "file:line: message", or "message" without a source map.
+    void formatError(const Ast* ast,
+                     AstNodeID node,
+                     std::string_view message,
+                     std::string& result) const;
+
+    const std::vector<std::string>& errors() const { return _errors; }
+    void addError(const Ast* ast, AstNodeID node, std::string_view message);
+
+private:
+    struct Package {
+        const Ast* ast {nullptr};
+        AstNodeID node {NULL_AST_NODE};
+        Scope* scope {nullptr};
+        bool evaluating {false};
+        bool evaluated {false};
+    };
+
+    std::vector<const Ast*> _asts;
+    std::unordered_map<const Ast*, const SourceMap*> _sourceMaps;
+    std::vector<ModuleRef> _modules;
+    std::unordered_map<std::string_view, size_t> _moduleIndices;
+    std::vector<Package> _packages;
+    std::unordered_map<std::string_view, size_t> _packageIndices;
+    std::vector<std::unique_ptr<Scope>> _packageScopes;
+    std::unordered_map<const Ast*, std::unique_ptr<Scope>> _unitScopes;
+    std::vector<std::string> _errors;
+
+    void evaluatePackage(Package* package);
+    // Evaluates first the packages that the subtree of node names in
+    // pkg::X references, which need no import.
+    void evaluateReferencedPackages(const Ast* ast, AstNodeID node);
+    // Declares the imports, parameters and typedefs among the children
+    // of node in scope, importing packages on demand.
+    void declareItems(const Ast* ast, AstNodeID node, Scope* scope);
+};
+
+}
@@ -0,0 +1,509 @@
+#include "Elaborator.h"
+
+#include <charconv>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Ast.h"
+#include "DesignUnits.h"
+#include "ModuleElaborator.h"
+
+#include "Design.h"
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistBuilder.h"
+#include "PrimitiveLibrary.h"
+
+#include "ThreadPool.h"
+
+namespace stargate {
+
+namespace {
+
+// Deepest hierarchy elaborated. Only a module that instantiates
+// itself with ever new parameters gets there.
+constexpr size_t MAX_DEPTH = 1024;
+
+// Names of the modules instantiated anywhere under node.
+void addInstantiated(const Ast* ast,
+                     AstNodeID node,
+                     std::unordered_set<std::string_view>* names) {
+    std::vector<AstNodeID> stack {node};
+    while (!stack.empty()) {
+        const AstNodeID id = stack.back();
+        stack.pop_back();
+        if (ast->getKind(id) == AstKind::Instantiation
+            && !ast->hasFlag(id, AstFlags::Gate)) {
+            names->insert(ast->getName(id));
+            continue;
+        }
+        for (AstNodeID child = ast->getFirstChild(id); child;
+             child = ast->getNextSibling(child)) {
+            stack.push_back(child);
+        }
+    }
+}
+
+// An unknown value is shown by its key, which tells it apart.
+void appendValue(const ConstValue& value, std::string& result) {
+    if (value.known) {
+        result += std::to_string(value.value);
+        return;
+    }
+    char digits[16];
+    const std::to_chars_result end =
+        std::to_chars(digits, digits + sizeof(digits), value.key, 16);
+    result += '?';
+    result.append(digits, end.ptr);
+}
+
+}
+
+// A module specialization, and the design it becomes.
+struct Elaborator::Specialization {
+    ModuleKey key;
+    ElaboratedModule module;
+    // Specialization of each of module.children.
+    std::vector<size_t> children;
+    std::string name;
+    size_t depth {0};
+
+    Design* design {nullptr};
+    // Net of each signal: a ScalarNet or the first bit of a BusNet.
+    std::vector<ScalarNet*> scalarNets;
+    std::vector<BusNet*> busNets;
+    // Index of the term of each port among the scalar or bus terms.
+    std::vector<uint32_t> portTerms;
+
+    BitNet* getNet(const SignalBit& bit) const {
+        if (BusNet* bus = busNets[bit.signal]) {
+            return &bus->bits[bus->getWidth() - 1 - bit.bit];
+        }
+        return scalarNets[bit.signal];
+    }
+};
+
+Elaborator::Elaborator(Netlist* netlist, unsigned threadCount)
+    : _netlist(netlist),
+    _threadCount(threadCount),
+    _units(new DesignUnits())
+{
+}
+
+Elaborator::~Elaborator() {
+}
+
+void Elaborator::addAst(const Ast* ast, const SourceMap* sourceMap) {
+    _units->addAst(ast, sourceMap);
+}
+
+bool Elaborator::elaborate(std::string_view top) {
+    _specs.clear();
+    _stats = ElaborationStats {};
+
+    _units->evaluatePackages();
+    _errors = _units->errors();
+    size_t topModule = 0;
+    if (!_errors.empty() || !findTop(top, &topModule)) {
+        return false;
+    }
+
+    elaborateSpecs(topModule);
+    for (const std::unique_ptr<Specialization>& spec : _specs) {
+        const std::vector<std::string>& errors = spec->module.errors;
+        _errors.insert(_errors.end(), errors.begin(), errors.end());
+    }
+    if (!_errors.empty() || !checkCycles()) {
+        return false;
+    }
+
+    linkPorts();
+    if (!_errors.empty()) {
+        return false;
+    }
+
+    nameDesigns();
+    if (!_errors.empty()) {
+        return false;
+    }
+
+    build();
+    return true;
+}
+
+bool Elaborator::findTop(std::string_view top, size_t* module) {
+    const std::span<const ModuleRef> modules = _units->getModules();
+    if (!top.empty()) {
+        const ModuleRef* ref = _units->findModule(top);
+        if (!ref) {
+            _errors.push_back("unknown top module '" + std::string(top) + "'");
+            return false;
+        }
+        *module = static_cast<size_t>(ref - modules.data());
+        return true;
+    }
+
+    std::unordered_set<std::string_view> instantiated;
+    for (const ModuleRef& ref : modules) {
+        addInstantiated(ref.ast, ref.node, &instantiated);
+    }
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < modules.size(); i++) {
+        if (!instantiated.contains(modules[i].getName())) {
+            candidates.push_back(i);
+        }
+    }
+    if (candidates.size() == 1) {
+        *module = candidates.front();
+        return true;
+    }
+
+    if (candidates.empty()) {
+        _errors.push_back("no top module found");
+        return false;
+    }
+    std::string message = "several top module candidates, pick one:";
+    for (size_t i : candidates) {
+        message += " " + std::string(modules[i].getName());
+    }
+    _errors.push_back(message);
+    return false;
+}
+
+void Elaborator::elaborateSpecs(size_t top) {
+    const ModuleElaborator elaborator(_units.get(), _netlist->getNameTable());
+
+    std::unordered_map<ModuleKey, size_t, ModuleKeyHash> indices;
+    const auto addSpec = [&](const ModuleKey& key, size_t depth) {
+        const auto [it, inserted] = indices.emplace(key, _specs.size());
+        if (inserted) {
+            Specialization* spec = new Specialization();
+            _specs.emplace_back(spec);
+            spec->key = key;
+            spec->depth = depth;
+        }
+        return it->second;
+    };
+
+    ModuleKey topKey;
+    elaborator.getKey(top, nullptr, nullptr, &_errors, &topKey);
+    addSpec(topKey, 0);
+    if (!_errors.empty()) {
+        return;
+    }
+
+    ThreadPool pool(_threadCount);
+    size_t begin = 0;
+    while (begin < _specs.size()) {
+        const size_t end = _specs.size();
+        pool.parallelFor(end - begin, [&](size_t i) {
+            Specialization* spec = _specs[begin + i].get();
+            elaborator.elaborate(spec->key, &spec->module);
+        });
+
+        // New specializations are numbered in the order of the
+        // instantiations, whatever the thread count.
+        for (size_t i = begin; i < end; i++) {
+            Specialization* spec = _specs[i].get();
+            if (spec->depth == MAX_DEPTH && !spec->module.children.empty()) {
+                const ModuleRef& module = _units->getModules()[spec->key.module];
+                _errors.push_back("hierarchy under module '"
+                                  + std::string(module.getName()) + "' is too deep");
+                return;
+            }
+            for (const ModuleKey& child : spec->module.children) {
+                spec->children.push_back(addSpec(child, spec->depth + 1));
+            }
+        }
+        begin = end;
+    }
+}
+
+bool Elaborator::checkCycles() {
+    // A module can only reach itself with the same parameters through
+    // an instantiation cycle.
+    enum class State : uint8_t {
+        New,
+        Visiting,
+        Done,
+    };
+
+    std::vector<State> states(_specs.size(), State::New);
+    std::vector<std::pair<size_t, size_t>> stack {{0, 0}};
+    states[0] = State::Visiting;
+    while (!stack.empty()) {
+        auto& [spec, next] = stack.back();
+        if (next == _specs[spec]->children.size()) {
+            states[spec] = State::Done;
+            stack.pop_back();
+            continue;
+        }
+
+        const size_t child = _specs[spec]->children[next++];
+        if (states[child] == State::Visiting) {
+            const ModuleRef& module = _units->getModules()[_specs[child]->key.module];
+            _errors.push_back("module '" + std::string(module.getName())
+                              + "' instantiates itself");
+            return false;
+        }
+        if (states[child] == State::New) {
+            states[child] = State::Visiting;
+            stack.emplace_back(child, 0);
+        }
+    }
+    return true;
+}
+
+void Elaborator::linkPorts() {
+    // Port names of each specialization.
+    std::vector<std::unordered_map<NameID, uint32_t>> portIndices(_specs.size());
+    for (size_t i = 0; i < _specs.size(); i++) {
+        const ElaboratedModule& module = _specs[i]->module;
+        for (uint32_t p = 0; p < module.ports.size(); p++) {
+            portIndices[i].emplace(module.signals[module.ports[p].signal].name, p);
+        }
+    }
+
+    // Named connections become positional.
+    const NameTable* names = _netlist->getNameTable();
+    for (const std::unique_ptr<Specialization>& spec : _specs) {
+        const Ast* ast = _units->getModules()[spec->key.module].ast;
+        for (ElaboratedInstance& instance : spec->module.instances) {
+            if (instance.primitive != PrimitiveKind::None) {
+                continue;
+            }
+
+            const size_t childIndex = spec->children[instance.child];
+            const Specialization* child = _specs[childIndex].get();
+            const std::string_view childName =
+                _units->getModules()[child->key.module].getName();
+            for (ElaboratedConnection& connection : instance.connections) {
+                if (connection.port == NULL_NAME) {
+                    if (connection.position >= child->module.ports.size()) {
+                        _units->formatError(ast, instance.node,
+                            "too many port connections to module '"
+                            + std::string(childName) + "'",
+                            _errors.emplace_back());
+                        break;
+                    }
+                    continue;
+                }
+
+                const auto it = portIndices[childIndex].find(connection.port);
+                if (it == portIndices[childIndex].end()) {
+                    _units->formatError(ast, instance.node,
+                        "module '" + std::string(childName) + "' has no port '"
+                        + std::string(names->getString(connection.port)) + "'",
+                        _errors.emplace_back());
+                    continue;
+                }
+                connection.port = NULL_NAME;
+                connection.position = it->second;
+            }
+        }
+    }
+}
+
+void Elaborator::nameDesigns() {
+    const ModuleElaborator elaborator(_units.get(), _netlist->getNameTable());
+    const NameTable* names = _netlist->getNameTable();
+
+    struct Defaults {
+        std::vector<std::string_view> names;
+        std::vector<ConstValue> values;
+    };
+    std::unordered_map<size_t, Defaults> defaults;
+
+    for (const std::unique_ptr<Specialization>& spec : _specs) {
+        const size_t module = spec->key.module;
+        auto it = defaults.find(module);
+        if (it == defaults.end()) {
+            it = defaults.emplace(module, Defaults()).first;
+            std::vector<std::string> ignored;
+            ModuleKey key;
+            elaborator.getKey(module, nullptr, &it->second.names, &ignored, &key);
+            it->second.values = key.params;
+        }
+
+        // Only the parameters that differ from their defaults are named.
+        spec->name = _units->getModules()[module].getName();
+        std::string params;
+        const Defaults& moduleDefaults = it->second;
+        for (size_t i = 0; i < spec->key.params.size(); i++) {
+            if (spec->key.params[i] == moduleDefaults.values[i]) {
+                continue;
+            }
+            if (!params.empty()) {
+                params += ',';
+            }
+            params += moduleDefaults.names[i];
+            params += '=';
+            appendValue(spec->key.params[i], params);
+        }
+        if (!params.empty()) {
+            spec->name += "#(" + params + ")";
+        }
+
+        const NameID name = names->findName(spec->name);
+        if (name != NULL_NAME && _netlist->findDesign(name)) {
+            _errors.push_back("design '" + spec->name
+                              + "' already exists in the netlist");
+        }
+    }
+}
+
+void Elaborator::build() {
+    NameTable* names = _netlist->getNameTable();
+    NetlistBuilder builder(_netlist);
+    PrimitiveLibrary* primitives = _netlist->getPrimitiveLibrary();
+    if (!primitives) {
+        primitives = builder.createPrimitiveLibrary();
+    }
+    const NameID workName = names->getName("work");
+    Library* library = _netlist->findLibrary(workName);
+    if (!library) {
+        library = builder.createLibrary(workName);
+    }
+
+    // Children before parents, since a design's terms must all exist
+    // before it is instantiated.
+    std::vector<size_t> order;
+    std::vector<bool> visited(_specs.size());
+    std::vector<std::pair<size_t, size_t>> stack {{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto& [spec, next] = stack.back();
+        if (next == _specs[spec]->children.size()) {
+            order.push_back(spec);
+            stack.pop_back();
+            continue;
+        }
+        const size_t child = _specs[spec]->children[next++];
+        if (!visited[child]) {
+            visited[child] = true;
+            stack.emplace_back(child, 0);
+        }
+    }
+
+    for (size_t index : order) {
+        Specialization* spec = _specs[index].get();
+        const ElaboratedModule& module = spec->module;
+        Design* design = builder.createDesign(library, names->getName(spec->name));
+        spec->design = design;
+
+        spec->scalarNets.assign(module.signals.size(), nullptr);
+        spec->busNets.assign(module.signals.size(), nullptr);
+        for (size_t s = 0; s < module.signals.size(); s++) {
+            const ElaboratedSignal& signal = module.signals[s];
+            if (signal.isBus) {
+                spec->busNets[s] =
+                    builder.addBusNet(design, signal.name, signal.msb, signal.lsb);
+            } else {
+                spec->scalarNets[s] = builder.addScalarNet(design, signal.name);
+            }
+        }
+
+        uint32_t numScalarTerms = 0;
+        uint32_t numBusTerms = 0;
+        for (const ElaboratedPort& port : module.ports) {
+            const ElaboratedSignal& signal = module.signals[port.signal];
+            if (BusNet* net = spec->busNets[port.signal]) {
+                BusDesignTerm* term = builder.addBusDesignTerm(design,
+                                                               signal.name,
+                                                               port.direction,
+                                                               signal.msb,
+                                                               signal.lsb);
+                for (size_t bit = 0; bit < net->getWidth(); bit++) {
+                    builder.connect(&net->bits[bit], &term->bits[bit]);
+                }
+                spec->portTerms.push_back(numBusTerms++);
+            } else {
+                ScalarDesignTerm* term =
+                    builder.addScalarDesignTerm(design, signal.name, port.direction);
+                builder.connect(spec->scalarNets[port.signal], term);
+                spec->portTerms.push_back(numScalarTerms++);
+            }
+        }
+
+        size_t numGates = 0;
+        for (const ElaboratedInstance& elaborated : module.instances) {
+            if (elaborated.primitive != PrimitiveKind::None) {
+                const NameID name = elaborated.name != NULL_NAME
+                    ? elaborated.name
+                    : names->getName("sgc_gate_" + std::to_string(numGates++));
+                Design* model = primitives->get(elaborated.primitive);
+                Instance* instance = builder.addInstance(design, name, model);
+                for (const ElaboratedConnection& connection : elaborated.connections) {
+                    if (!connection.bits.empty()
+                        && connection.bits[0].signal != SignalBit::NO_SIGNAL) {
+                        builder.connect(
+                            spec->getNet(connection.bits[0]),
+                            instance->getPrimitiveScalarTerm(connection.position));
+                    }
+                }
+                continue;
+            }
+
+            const Specialization* child = _specs[spec->children[elaborated.child]].get();
+            Instance* instance =
+                builder.addInstance(design, elaborated.name, child->design);
+            for (const ElaboratedConnection& connection : elaborated.connections) {
+                const ElaboratedPort& port = child->module.ports[connection.position];
+                const ElaboratedSignal& signal = child->module.signals[port.signal];
+                const uint32_t term = child->portTerms[connection.position];
+                const uint32_t width = signal.getWidth();
+
+                // Bits line up from the lsb; extra bits are dropped.
+                const size_t numBits = std::min<size_t>(width, connection.bits.size());
+                for (size_t bit = 0; bit < numBits; bit++) {
+                    if (connection.bits[bit].signal == SignalBit::NO_SIGNAL) {
+                        continue;
+                    }
+                    BitInstTerm* instTerm = nullptr;
+                    if (signal.isBus) {
+                        instTerm = &instance->busInstTerms[term].bits[width - 1 - bit];
+                    } else {
+                        instTerm = &instance->scalarInstTerms[term];
+                    }
+                    builder.connect(spec->getNet(connection.bits[bit]), instTerm);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < module.assigns.size(); i++) {
+            const ElaboratedAssign& assign = module.assigns[i];
+            const NameID name = names->getName("sgc_assign_" + std::to_string(i));
+            Instance* instance =
+                builder.addInstance(design, name, primitives->getAssign());
+            builder.connect(spec->getNet(assign.from),
+                            instance->getPrimitiveScalarTerm(SGC_ASSIGNPins::I));
+            builder.connect(spec->getNet(assign.to),
+                            instance->getPrimitiveScalarTerm(SGC_ASSIGNPins::O));
+        }
+
+        _stats.numInstances += module.instances.size() + module.assigns.size();
+        _stats.numNets += module.signals.size();
+        _stats.numAssigns += module.assigns.size();
+        _stats.numUnloweredConnections += module.numUnloweredConnections;
+        _stats.numUnloweredAssigns += module.numUnloweredAssigns;
+        _stats.numUnloweredGates += module.numUnloweredGates;
+        _stats.numProcesses += module.numProcesses;
+    }
+
+    builder.setTopDesign(_specs[0]->design);
+    builder.finalize();
+
+    std::unordered_set<size_t> modules;
+    for (const std::unique_ptr<Specialization>& spec : _specs) {
+        modules.insert(spec->key.module);
+        spec->design = nullptr;
+        spec->scalarNets.clear();
+        spec->busNets.clear();
+    }
+    _stats.numModules = modules.size();
+    _stats.numDesigns = _specs.size();
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stargate {
+
+class Ast;
+class DesignUnits;
+class Netlist;
+class SourceMap;
+
+struct ElaborationStats {
+    size_t numModules {0};
+    size_t numDesigns {0};
+    size_t numInstances {0};
+    size_t numNets {0};
+    size_t numAssigns {0};
+    size_t numUnloweredConnections {0};
+    size_t numUnloweredAssigns {0};
+    size_t numUnloweredGates {0};
+    size_t numProcesses {0};
+};
+
+// Lowers parsed modules into designs of a netlist. Each distinct
+// module and parameter set becomes one design, in the library "work":
+// the design of a module with its default parameters takes the
+// module's name, others are named like fifo#(DEPTH=8), or like
+// rom#(FILE=?9c3f...) with the key of a value that is not known, such
+// as a string. The modules of
+// the hierarchy are elaborated in parallel, one wave per level of
+// newly found specializations, and the netlist is built once every
+// specialization is known, with a single NetlistBuilder.
+//
+// Only structure is lowered: ports, nets, instances and assignments
+// between nets, through generate constructs. See
+// elaborate/ELABORATION.md for what is left out.
+class Elaborator {
+public:
+    // threadCount 0 uses one thread per core.
+    explicit Elaborator(Netlist* netlist, unsigned threadCount = 0);
+    ~Elaborator();
+
+    Elaborator(const Elaborator&) = delete;
+    Elaborator& operator=(const Elaborator&) = delete;
+
+    // ast and sourceMap must outlive the elaborator.
+    void addAst(const Ast* ast, const SourceMap* sourceMap);
+
+    // Elaborates the hierarchy under top, or under the one module that
+    // no other instantiates if top is empty, and makes it the top
+    // design. Returns false with errors(), leaving the netlist
+    // untouched, if the hierarchy cannot be elaborated.
+    bool elaborate(std::string_view top);
+
+    const std::vector<std::string>& errors() const { return _errors; }
+    const ElaborationStats& getStats() const { return _stats; }
+
+private:
+    struct Specialization;
+
+    Netlist* _netlist {nullptr};
+    unsigned _threadCount {0};
+    std::unique_ptr<DesignUnits> _units;
+    std::vector<std::unique_ptr<Specialization>> _specs;
+    std::vector<std::string> _errors;
+    ElaborationStats _stats;
+
+    bool findTop(std::string_view top, size_t* module);
+    void elaborateSpecs(size_t top);
+    bool checkCycles();
+    void linkPorts();
+    void nameDesigns();
+    void build();
+};
+
+}
@@ -0,0 +1,1147 @@
+#include "ModuleElaborator.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "DesignUnits.h"
+#include "NameTable.h"
+
+namespace stargate {
+
+namespace {
+
+// Widest signal that is turned into nets, one per bit.
+constexpr uint64_t MAX_SIGNAL_WIDTH = uint64_t(1) << 20;
+
+// Generate loops running longer than this are taken as endless.
+constexpr size_t MAX_GENERATE_ITERATIONS = 65536;
+
+Direction getDirection(const Ast* ast, AstNodeID decl, Direction previous) {
+    if (ast->hasFlag(decl, AstFlags::Input)) {
+        return Direction::Input;
+    }
+    if (ast->hasFlag(decl, AstFlags::Output)) {
+        return Direction::Output;
+    }
+    if (ast->hasFlag(decl, AstFlags::Inout)) {
+        return Direction::InOut;
+    }
+    return previous;
+}
+
+bool isNonStructural(AstDataType type) {
+    switch (type) {
+        case AstDataType::Real:
+        case AstDataType::String:
+        case AstDataType::Chandle:
+        case AstDataType::Event:
+        case AstDataType::Void:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Initializer of a declarator, after its unpacked dimensions.
+AstNodeID getInit(const Ast* ast, AstNodeID declarator) {
+    for (AstNodeID id = ast->getFirstChild(declarator); id;
+         id = ast->getNextSibling(id)) {
+        if (ast->getKind(id) != AstKind::Range) {
+            return id;
+        }
+    }
+    return NULL_AST_NODE;
+}
+
+}
+
+size_t ModuleKeyHash::operator()(const ModuleKey& key) const {
+    size_t hash = std::hash<size_t>()(key.module);
+    for (const ConstValue& param : key.params) {
+        const size_t value = param.known ? std::hash<int64_t>()(param.value) : param.key;
+        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+// Walks one module specialization. Declarations of a scope are all
+// made before its items are elaborated, so items may refer to nets
+// declared after them, and generate blocks see every declaration of
+// the scopes around them.
+class ModuleElaborator::Walker {
+public:
+    Walker(const ModuleElaborator* elaborator,
+           const ModuleKey& key,
+           ElaboratedModule* result)
+        : _elaborator(elaborator),
+        _units(elaborator->_units),
+        _names(elaborator->_names),
+        _module(elaborator->_units->getModules()[key.module]),
+        _ast(_module.ast),
+        _key(key),
+        _result(result)
+    {
+    }
+
+    void run();
+
+private:
+    // Generate scope: its values, and the nets declared in it under their
+    // source names.
+    struct GenScope {
+        GenScope(const Scope* parentValues,
+                 const GenScope* parentScope,
+                 const std::string& namePrefix)
+            : values(parentValues),
+            parent(parentScope),
+            prefix(namePrefix)
+        {
+        }
+
+        Scope values;
+        const GenScope* parent {nullptr};
+        std::string prefix;
+        std::unordered_map<std::string_view, uint32_t> signals;
+        // Generate constructs met so far, which number unnamed blocks.
+        uint32_t numGenerates {0};
+    };
+
+    // Part of a signal picked by a chain of selects, offset from its lsb.
+    struct Selection {
+        uint32_t signal {0};
+        uint64_t offset {0};
+        TypeLayout layout;
+    };
+
+    enum class ExprKind {
+        Net,
+        Constant,
+        Other,
+    };
+
+    const ModuleElaborator* _elaborator {nullptr};
+    const DesignUnits* _units {nullptr};
+    NameTable* _names {nullptr};
+    const ModuleRef& _module;
+    const Ast* _ast {nullptr};
+    const ModuleKey& _key;
+    ElaboratedModule* _result {nullptr};
+
+    // Layout of each signal, for selects.
+    std::vector<TypeLayout> _layouts;
+    // Non-ANSI ports declared without a type or range, which a net
+    // declaration of the same name may still shape.
+    std::vector<bool> _untypedPorts;
+    // Non-ANSI port declarations, by name.
+    std::unordered_map<std::string_view, ElaboratedPort> _portDecls;
+    std::unordered_map<ModuleKey, uint32_t, ModuleKeyHash> _children;
+
+    ConstEvaluator getEvaluator(const GenScope* scope) const {
+        return ConstEvaluator(_units, _ast, &scope->values);
+    }
+
+    void addError(AstNodeID node, std::string_view message) {
+        _units->formatError(_ast, node, message, _result->errors.emplace_back());
+    }
+
+    void declareScope(AstNodeID node, GenScope* scope, bool isModule);
+    void declarePorts();
+    uint32_t declareSignal(GenScope* scope,
+                           std::string_view name,
+                           AstNodeID decl,
+                           AstNodeID declarator);
+    uint32_t addSignal(GenScope* scope, std::string_view name, const TypeLayout& layout);
+    void shapeSignal(uint32_t signal, const TypeLayout& layout);
+    const uint32_t* findSignal(const GenScope* scope, std::string_view name) const;
+
+    void elaborateScope(AstNodeID node, GenScope* scope);
+    void elaborateAssign(GenScope* scope,
+                         const std::vector<SignalBit>& lhs,
+                         AstNodeID rhs);
+    void elaborateInstantiation(GenScope* scope, AstNodeID node);
+    void elaborateGate(GenScope* scope, AstNodeID node);
+    void elaborateGenerateIf(GenScope* scope, AstNodeID node, uint32_t number);
+    void elaborateGenerateCase(GenScope* scope, AstNodeID node, uint32_t number);
+    void elaborateGenerateFor(GenScope* scope, AstNodeID node, uint32_t number);
+    // Elaborates block in a new scope named after it, or genblk<number>.
+    void elaborateBlock(GenScope* scope,
+                        AstNodeID block,
+                        uint32_t number,
+                        std::string_view genvar = {},
+                        int64_t index = 0);
+
+    ExprKind resolveBits(GenScope* scope, AstNodeID expr, std::vector<SignalBit>* bits);
+    bool resolveSelection(const GenScope* scope,
+                          AstNodeID expr,
+                          Selection* selection) const;
+    void appendBits(const Selection& selection, std::vector<SignalBit>* bits) const;
+};
+
+void ModuleElaborator::Walker::run() {
+    GenScope root(_units->getUnitScope(_ast), nullptr, std::string());
+    _elaborator->declareParams(_module,
+                               &root.values,
+                               nullptr,
+                               &_key.params,
+                               nullptr,
+                               nullptr,
+                               &_result->errors,
+                               _ast,
+                               _module.node);
+    declareScope(_module.node, &root, true);
+    declarePorts();
+    elaborateScope(_module.node, &root);
+}
+
+void ModuleElaborator::Walker::declareScope(AstNodeID node,
+                                            GenScope* scope,
+                                            bool isModule) {
+    const ConstEvaluator evaluator = getEvaluator(scope);
+
+    // An ANSI header declares its ports itself; a port name alone
+    // inherits the declaration before it.
+    bool isAnsi = false;
+    if (isModule) {
+        for (AstNodeID id = _ast->getFirstChild(node); id;
+             id = _ast->getNextSibling(id)) {
+            const AstKind kind = _ast->getKind(id);
+            if (kind == AstKind::PortDecl || kind == AstKind::PortRef) {
+                isAnsi = kind == AstKind::PortDecl;
+                break;
+            }
+        }
+    }
+
+    AstNodeID lastPortDecl = NULL_AST_NODE;
+    Direction direction = Direction::InOut;
+    for (AstNodeID id = _ast->getFirstChild(node); id; id = _ast->getNextSibling(id)) {
+        switch (_ast->getKind(id)) {
+            case AstKind::Import: {
+                if (isModule) {
+                    break;
+                }
+                const Scope* package = _units->findPackage(_ast->getName(id));
+                if (package) {
+                    scope->values.addImport(package);
+                } else {
+                    addError(id,
+                             "unknown package '" + std::string(_ast->getName(id)) + "'");
+                }
+            }
+            break;
+
+            case AstKind::ParamDecl:
+                // Parameters of generate blocks are local.
+                if (isModule || _ast->getDataType(id) == AstDataType::Type) {
+                    break;
+                }
+                for (AstNodeID d = _ast->getFirstChild(id); d;
+                     d = _ast->getNextSibling(d)) {
+                    if (_ast->getKind(d) == AstKind::Declarator) {
+                        scope->values.setValue(_ast->getName(d),
+                                               evaluator.evaluateParam(id, d));
+                    }
+                }
+            break;
+
+            case AstKind::Typedef:
+                if (!isModule) {
+                    evaluator.declareTypedef(&scope->values, id);
+                }
+            break;
+
+            case AstKind::PortDecl: {
+                direction = getDirection(_ast, id, direction);
+                lastPortDecl = id;
+                for (AstNodeID d = _ast->getFirstChild(id); d;
+                     d = _ast->getNextSibling(d)) {
+                    if (_ast->getKind(d) != AstKind::Declarator) {
+                        continue;
+                    }
+                    const uint32_t signal = declareSignal(scope, _ast->getName(d), id, d);
+                    if (signal == SignalBit::NO_SIGNAL) {
+                        continue;
+                    }
+                    if (isAnsi) {
+                        _result->ports.push_back(ElaboratedPort {signal, direction});
+                    } else {
+                        _portDecls[_ast->getName(d)] = ElaboratedPort {signal, direction};
+                        _untypedPorts[signal] =
+                            _ast->getDataType(id) == AstDataType::Implicit
+                            && !_ast->getFirstChild(id);
+                    }
+                }
+            }
+            break;
+
+            case AstKind::PortRef:
+                if (!isAnsi) {
+                    break;
+                }
+                if (!lastPortDecl || _ast->hasFlag(id, AstFlags::Named)
+                    || _ast->getFirstChild(id)) {
+                    addError(id,
+                             "unsupported port '" + std::string(_ast->getName(id)) + "'");
+                    break;
+                }
+                {
+                    const uint32_t signal = declareSignal(scope, _ast->getName(id),
+                                                          lastPortDecl, NULL_AST_NODE);
+                    if (signal != SignalBit::NO_SIGNAL) {
+                        _result->ports.push_back(ElaboratedPort {signal, direction});
+                    }
+                }
+            break;
+
+            case AstKind::NetDecl:
+            case AstKind::VarDecl:
+                evaluator.declareEnumItems(&scope->values, id);
+                for (AstNodeID d = _ast->getFirstChild(id); d;
+                     d = _ast->getNextSibling(d)) {
+                    if (_ast->getKind(d) == AstKind::Declarator) {
+                        declareSignal(scope, _ast->getName(d), id, d);
+                    }
+                }
+            break;
+
+            default:
+            break;
+        }
+    }
+}
+
+void ModuleElaborator::Walker::declarePorts() {
+    for (AstNodeID id = _ast->getFirstChild(_module.node); id;
+         id = _ast->getNextSibling(id)) {
+        const AstKind kind = _ast->getKind(id);
+        if (kind == AstKind::PortDecl) {
+            return;
+        }
+        if (kind != AstKind::PortRef) {
+            continue;
+        }
+
+        const std::string_view name = _ast->getName(id);
+        if (_ast->hasFlag(id, AstFlags::Named) || _ast->getFirstChild(id)) {
+            addError(id, "unsupported port '" + std::string(name) + "'");
+            continue;
+        }
+        const auto it = _portDecls.find(name);
+        if (it == _portDecls.end()) {
+            addError(id, "port '" + std::string(name) + "' has no direction");
+            continue;
+        }
+        _result->ports.push_back(it->second);
+    }
+}
+
+uint32_t ModuleElaborator::Walker::declareSignal(GenScope* scope,
+                                                 std::string_view name,
+                                                 AstNodeID decl,
+                                                 AstNodeID declarator) {
+    TypeLayout layout;
+    if (!getEvaluator(scope).getLayout(decl, declarator, &layout)) {
+        if (!isNonStructural(_ast->getDataType(decl))) {
+            addError(decl, "cannot determine the type of '" + std::string(name) + "'");
+        }
+        return SignalBit::NO_SIGNAL;
+    }
+
+    const auto it = scope->signals.find(name);
+    if (it != scope->signals.end()) {
+        const uint32_t signal = it->second;
+        if (_untypedPorts[signal]) {
+            // input a; wire [3:0] a;
+            _untypedPorts[signal] = false;
+            shapeSignal(signal, layout);
+        } else if (!_portDecls.contains(name) || scope->parent) {
+            addError(decl, "'" + std::string(name) + "' is already declared");
+        }
+        return signal;
+    }
+
+    if (layout.getWidth() > MAX_SIGNAL_WIDTH) {
+        addError(decl, "'" + std::string(name) + "' is too wide to elaborate");
+        return SignalBit::NO_SIGNAL;
+    }
+    return addSignal(scope, name, layout);
+}
+
+uint32_t ModuleElaborator::Walker::addSignal(GenScope* scope,
+                                             std::string_view name,
+                                             const TypeLayout& layout) {
+    const uint32_t signal = static_cast<uint32_t>(_result->signals.size());
+    ElaboratedSignal& elaborated = _result->signals.emplace_back();
+    elaborated.name = _names->getName(scope->prefix + std::string(name));
+    _layouts.emplace_back();
+    _untypedPorts.push_back(false);
+    shapeSignal(signal, layout);
+    scope->signals.emplace(name, signal);
+    return signal;
+}
+
+void ModuleElaborator::Walker::shapeSignal(uint32_t signal, const TypeLayout& layout) {
+    ElaboratedSignal& elaborated = _result->signals[signal];
+    _layouts[signal] = layout;
+
+    const auto fitsInt32 = [](int64_t value) {
+        return value >= INT32_MIN && value <= INT32_MAX;
+    };
+    const bool isVector = layout.dims.size() == 1 && layout.baseWidth == 1
+                       && fitsInt32(layout.dims[0].msb) && fitsInt32(layout.dims[0].lsb);
+    if (isVector) {
+        elaborated.isBus = true;
+        elaborated.msb = static_cast<int32_t>(layout.dims[0].msb);
+        elaborated.lsb = static_cast<int32_t>(layout.dims[0].lsb);
+    } else if (layout.dims.empty() && layout.baseWidth == 1) {
+        elaborated.isBus = false;
+    } else {
+        // Bit i of the layout, counted from its lsb, is bit i of the bus.
+        elaborated.isBus = true;
+        elaborated.msb = static_cast<int32_t>(layout.getWidth() - 1);
+        elaborated.lsb = 0;
+    }
+}
+
+const uint32_t* ModuleElaborator::Walker::findSignal(const GenScope* scope,
+                                                     std::string_view name) const {
+    for (; scope; scope = scope->parent) {
+        const auto it = scope->signals.find(name);
+        if (it != scope->signals.end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+void ModuleElaborator::Walker::elaborateScope(AstNodeID node, GenScope* scope) {
+    for (AstNodeID id = _ast->getFirstChild(node); id; id = _ast->getNextSibling(id)) {
+        switch (_ast->getKind(id)) {
+            case AstKind::ContAssign: {
+                const AstNodeID lhs = _ast->getFirstChild(id);
+                std::vector<SignalBit> bits;
+                if (resolveBits(scope, lhs, &bits) != ExprKind::Net) {
+                    _result->numUnloweredAssigns++;
+                    break;
+                }
+                elaborateAssign(scope, bits, _ast->getNextSibling(lhs));
+            }
+            break;
+
+            case AstKind::NetDecl:
+                // wire a = b;
+                for (AstNodeID d = _ast->getFirstChild(id); d;
+                     d = _ast->getNextSibling(d)) {
+                    if (_ast->getKind(d) != AstKind::Declarator) {
+                        continue;
+                    }
+                    const AstNodeID init = getInit(_ast, d);
+                    const auto it = scope->signals.find(_ast->getName(d));
+                    if (!init || it == scope->signals.end()) {
+                        continue;
+                    }
+                    std::vector<SignalBit> bits;
+                    appendBits(Selection {it->second, 0, _layouts[it->second]}, &bits);
+                    elaborateAssign(scope, bits, init);
+                }
+            break;
+
+            case AstKind::Instantiation:
+                if (_ast->hasFlag(id, AstFlags::Gate)) {
+                    elaborateGate(scope, id);
+                } else {
+                    elaborateInstantiation(scope, id);
+                }
+            break;
+
+            case AstKind::Defparam:
+                addError(id, "defparam is not supported");
+            break;
+
+            case AstKind::GenerateIf:
+                elaborateGenerateIf(scope, id, ++scope->numGenerates);
+            break;
+
+            case AstKind::GenerateCase:
+                elaborateGenerateCase(scope, id, ++scope->numGenerates);
+            break;
+
+            case AstKind::GenerateFor:
+                elaborateGenerateFor(scope, id, ++scope->numGenerates);
+            break;
+
+            case AstKind::Always:
+            case AstKind::AlwaysComb:
+            case AstKind::AlwaysFF:
+            case AstKind::AlwaysLatch:
+                _result->numProcesses++;
+            break;
+
+            default:
+            break;
+        }
+    }
+}
+
+void ModuleElaborator::Walker::elaborateAssign(GenScope* scope,
+                                               const std::vector<SignalBit>& lhs,
+                                               AstNodeID rhs) {
+    std::vector<SignalBit> bits;
+    if (resolveBits(scope, rhs, &bits) != ExprKind::Net) {
+        _result->numUnloweredAssigns++;
+        return;
+    }
+
+    // Both sides line up from their lsb.
+    const size_t width = std::min(lhs.size(), bits.size());
+    for (size_t i = 0; i < width; i++) {
+        if (lhs[i].signal != SignalBit::NO_SIGNAL
+            && bits[i].signal != SignalBit::NO_SIGNAL) {
+            _result->assigns.push_back(ElaboratedAssign {bits[i], lhs[i]});
+        }
+    }
+}
+
+void ModuleElaborator::Walker::elaborateInstantiation(GenScope* scope, AstNodeID node) {
+    const std::string_view moduleName = _ast->getName(node);
+    const ModuleRef* module = _units->findModule(moduleName);
+    if (!module) {
+        addError(node, "unknown module '" + std::string(moduleName) + "'");
+        return;
+    }
+
+    const ConstEvaluator evaluator = getEvaluator(scope);
+    ParamOverrides overrides;
+    AstNodeID first = _ast->getFirstChild(node);
+    if (first && _ast->getKind(first) == AstKind::ParamOverrides) {
+        for (AstNodeID conn = _ast->getFirstChild(first); conn;
+             conn = _ast->getNextSibling(conn)) {
+            const AstNodeID expr = _ast->getFirstChild(conn);
+            if (!_ast->hasFlag(conn, AstFlags::Named)) {
+                overrides.positional.push_back(evaluator.evaluateParamValue(expr));
+            } else if (expr) {
+                overrides.named.emplace_back(_ast->getName(conn),
+                                             evaluator.evaluateParamValue(expr));
+            }
+        }
+        first = _ast->getNextSibling(first);
+    }
+
+    const size_t moduleIndex = static_cast<size_t>(module - _units->getModules().data());
+    ModuleKey key;
+    _elaborator->getKey(moduleIndex, &overrides, nullptr, &_result->errors, &key,
+                        _ast, node);
+    const uint32_t childIndex = static_cast<uint32_t>(_result->children.size());
+    const auto [it, inserted] = _children.emplace(key, childIndex);
+    if (inserted) {
+        _result->children.push_back(key);
+    }
+
+    for (AstNodeID id = first; id; id = _ast->getNextSibling(id)) {
+        if (_ast->getKind(id) != AstKind::Instance) {
+            continue;
+        }
+
+        ElaboratedInstance& instance = _result->instances.emplace_back();
+        instance.name =
+            _names->getName(scope->prefix + std::string(_ast->getName(id)));
+        instance.child = it->second;
+        instance.node = id;
+
+        uint32_t position = 0;
+        bool isArray = false;
+        for (AstNodeID conn = _ast->getFirstChild(id); conn;
+             conn = _ast->getNextSibling(conn)) {
+            if (_ast->getKind(conn) == AstKind::Range) {
+                isArray = true;
+                break;
+            }
+
+            ElaboratedConnection& connection = instance.connections.emplace_back();
+            if (_ast->hasFlag(conn, AstFlags::Named)) {
+                connection.port = _names->getName(_ast->getName(conn));
+            } else {
+                connection.position = position++;
+            }
+
+            const AstNodeID expr = _ast->getFirstChild(conn);
+            if (expr && resolveBits(scope, expr, &connection.bits) != ExprKind::Net) {
+                connection.bits.clear();
+                _result->numUnloweredConnections++;
+            }
+        }
+
+        if (isArray) {
+            addError(id, "instance arrays are not supported");
+            _result->instances.pop_back();
+        }
+    }
+}
+
+void ModuleElaborator::Walker::elaborateGate(GenScope* scope, AstNodeID node) {
+    const std::string_view gate = _ast->getName(node);
+    PrimitiveKind kind = PrimitiveKind::None;
+    if (gate == "buf") {
+        kind = PrimitiveKind::BUF;
+    } else if (gate == "not") {
+        kind = PrimitiveKind::INV;
+    }
+
+    for (AstNodeID id = _ast->getFirstChild(node); id; id = _ast->getNextSibling(id)) {
+        std::vector<AstNodeID> terminals;
+        for (AstNodeID conn = _ast->getFirstChild(id); conn;
+             conn = _ast->getNextSibling(conn)) {
+            if (_ast->getKind(conn) == AstKind::Range) {
+                addError(id, "instance arrays are not supported");
+                terminals.clear();
+                break;
+            }
+            terminals.push_back(_ast->getFirstChild(conn));
+        }
+
+        // buf and not drive their first terminal from their last.
+        if (kind == PrimitiveKind::None || terminals.size() != 2) {
+            _result->numUnloweredGates++;
+            continue;
+        }
+
+        ElaboratedInstance& instance = _result->instances.emplace_back();
+        if (_ast->getNode(id).name != NULL_SYMBOL) {
+            instance.name =
+                _names->getName(scope->prefix + std::string(_ast->getName(id)));
+        }
+        instance.primitive = kind;
+        instance.node = id;
+
+        // BUF and INV share their pin numbers.
+        const uint32_t pins[2] = {BUFPins::O, BUFPins::I};
+        for (size_t i = 0; i < 2; i++) {
+            ElaboratedConnection& connection = instance.connections.emplace_back();
+            connection.position = pins[i];
+            if (resolveBits(scope, terminals[i], &connection.bits) != ExprKind::Net) {
+                connection.bits.clear();
+                _result->numUnloweredConnections++;
+            }
+            connection.bits.resize(std::min<size_t>(connection.bits.size(), 1));
+        }
+    }
+}
+
+void ModuleElaborator::Walker::elaborateGenerateIf(GenScope* scope,
+                                                   AstNodeID node,
+                                                   uint32_t number) {
+    const AstNodeID cond = _ast->getFirstChild(node);
+    const AstNodeID thenBlock = _ast->getNextSibling(cond);
+    const AstNodeID elseBlock = _ast->getNextSibling(thenBlock);
+
+    int64_t value = 0;
+    if (!getEvaluator(scope).evaluateInt(cond, &value)) {
+        addError(node, "generate condition is not constant");
+        return;
+    }
+    elaborateBlock(scope, value != 0 ? thenBlock : elseBlock, number);
+}
+
+void ModuleElaborator::Walker::elaborateGenerateCase(GenScope* scope,
+                                                     AstNodeID node,
+                                                     uint32_t number) {
+    const ConstEvaluator evaluator = getEvaluator(scope);
+    const AstNodeID expr = _ast->getFirstChild(node);
+    const ConstValue value = evaluator.evaluate(expr);
+    if (!value.known) {
+        addError(node, "generate case expression is not constant");
+        return;
+    }
+
+    AstNodeID defaultBlock = NULL_AST_NODE;
+    for (AstNodeID item = _ast->getNextSibling(expr); item;
+         item = _ast->getNextSibling(item)) {
+        // The block is the last child of the item, after its values.
+        std::vector<AstNodeID> children;
+        _ast->getChildren(item, children);
+        if (children.empty()) {
+            continue;
+        }
+        if (_ast->hasFlag(item, AstFlags::Default)) {
+            defaultBlock = children.back();
+            continue;
+        }
+        for (size_t i = 0; i + 1 < children.size(); i++) {
+            const ConstValue itemValue = evaluator.evaluate(children[i]);
+            if (!itemValue.known) {
+                addError(children[i], "generate case item is not constant");
+                return;
+            }
+            if (itemValue == value) {
+                elaborateBlock(scope, children.back(), number);
+                return;
+            }
+        }
+    }
+    elaborateBlock(scope, defaultBlock, number);
+}
+
+void ModuleElaborator::Walker::elaborateGenerateFor(GenScope* scope,
+                                                    AstNodeID node,
+                                                    uint32_t number) {
+    const AstNodeID init = _ast->getFirstChild(node);
+    const AstNodeID cond = _ast->getNextSibling(init);
+    const AstNodeID step = _ast->getNextSibling(cond);
+    const AstNodeID block = _ast->getNextSibling(step);
+
+    const AstNodeID genvarNode = _ast->getFirstChild(init);
+    const std::string_view genvar = _ast->getName(genvarNode);
+    int64_t index = 0;
+    if (!getEvaluator(scope).evaluateInt(_ast->getNextSibling(genvarNode), &index)) {
+        addError(node, "generate loop start is not constant");
+        return;
+    }
+
+    for (size_t iteration = 0;; iteration++) {
+        if (iteration == MAX_GENERATE_ITERATIONS) {
+            addError(node, "generate loop does not terminate");
+            return;
+        }
+
+        Scope loopScope(&scope->values);
+        loopScope.setValue(genvar, ConstValue::make(index));
+        const ConstEvaluator evaluator(_units, _ast, &loopScope);
+        int64_t condition = 0;
+        if (!evaluator.evaluateInt(cond, &condition)) {
+            addError(node, "generate loop condition is not constant");
+            return;
+        }
+        if (!condition) {
+            return;
+        }
+
+        elaborateBlock(scope, block, number, genvar, index);
+
+        // genvar = expr, genvar op= expr, or genvar++ and the like.
+        if (_ast->getKind(step) == AstKind::Unary) {
+            const AstOp op = _ast->getOp(step);
+            index += op == AstOp::PostInc || op == AstOp::PreInc ? 1 : -1;
+            continue;
+        }
+
+        int64_t value = 0;
+        const AstNodeID rhs = _ast->getNextSibling(_ast->getFirstChild(step));
+        if (_ast->getKind(step) != AstKind::Assign
+            || !evaluator.evaluateInt(rhs, &value)) {
+            addError(node, "generate loop step is not constant");
+            return;
+        }
+        switch (_ast->getOp(step)) {
+            case AstOp::None:
+                index = value;
+            break;
+            case AstOp::Add:
+                index += value;
+            break;
+            case AstOp::Sub:
+                index -= value;
+            break;
+            case AstOp::Mul:
+                index *= value;
+            break;
+            case AstOp::Shl:
+                index = value < 64 ? index << value : 0;
+            break;
+            case AstOp::Shr:
+                index = value < 64 ? index >> value : 0;
+            break;
+            default:
+                addError(node, "unsupported generate loop step");
+                return;
+        }
+    }
+}
+
+void ModuleElaborator::Walker::elaborateBlock(GenScope* scope,
+                                              AstNodeID block,
+                                              uint32_t number,
+                                              std::string_view genvar,
+                                              int64_t index) {
+    if (!block) {
+        return;
+    }
+
+    // else if chains nest without adding scopes.
+    const AstNodeID first = _ast->getFirstChild(block);
+    const bool isNamed = _ast->getNode(block).name != NULL_SYMBOL;
+    if (genvar.empty() && !isNamed && first && !_ast->getNextSibling(first)) {
+        const AstKind kind = _ast->getKind(first);
+        if (kind == AstKind::GenerateIf) {
+            elaborateGenerateIf(scope, first, number);
+            return;
+        }
+        if (kind == AstKind::GenerateCase) {
+            elaborateGenerateCase(scope, first, number);
+            return;
+        }
+    }
+
+    std::string prefix = scope->prefix;
+    if (isNamed) {
+        prefix += _ast->getName(block);
+    } else {
+        prefix += "genblk" + std::to_string(number);
+    }
+    if (!genvar.empty()) {
+        prefix += "[" + std::to_string(index) + "]";
+    }
+    prefix += '.';
+
+    GenScope inner(&scope->values, scope, prefix);
+    if (!genvar.empty()) {
+        inner.values.setValue(genvar, ConstValue::make(index));
+    }
+    declareScope(block, &inner, false);
+    elaborateScope(block, &inner);
+}
+
+ModuleElaborator::Walker::ExprKind
+ModuleElaborator::Walker::resolveBits(GenScope* scope,
+                                      AstNodeID expr,
+                                      std::vector<SignalBit>* bits) {
+    switch (_ast->getKind(expr)) {
+        case AstKind::Identifier: {
+            const std::string_view name = _ast->getName(expr);
+            uint32_t signal = 0;
+            if (const uint32_t* found = findSignal(scope, name)) {
+                signal = *found;
+            } else if (scope->values.findValue(name)) {
+                return ExprKind::Constant;
+            } else {
+                // Implicit net.
+                signal = addSignal(scope, name, TypeLayout {});
+            }
+            appendBits(Selection {signal, 0, _layouts[signal]}, bits);
+            return ExprKind::Net;
+        }
+
+        case AstKind::Select:
+        case AstKind::RangeSelect:
+        case AstKind::Member: {
+            Selection selection;
+            if (resolveSelection(scope, expr, &selection)) {
+                appendBits(selection, bits);
+                return ExprKind::Net;
+            }
+            return getEvaluator(scope).evaluate(expr).known ? ExprKind::Constant
+                                                            : ExprKind::Other;
+        }
+
+        case AstKind::Concat: {
+            // The first part is the most significant.
+            std::vector<AstNodeID> parts;
+            _ast->getChildren(expr, parts);
+            bool hasNet = false;
+            for (auto it = parts.rbegin(); it != parts.rend(); ++it) {
+                const ExprKind kind = resolveBits(scope, *it, bits);
+                if (kind == ExprKind::Other) {
+                    return ExprKind::Other;
+                }
+                if (kind == ExprKind::Constant) {
+                    const ConstValue value = getEvaluator(scope).evaluate(*it);
+                    if (_ast->getKind(*it) != AstKind::Number && !value.known) {
+                        return ExprKind::Other;
+                    }
+                    bits->resize(bits->size() + value.width);
+                }
+                hasNet |= kind == ExprKind::Net;
+            }
+            return hasNet ? ExprKind::Net : ExprKind::Constant;
+        }
+
+        case AstKind::Replicate: {
+            const AstNodeID countExpr = _ast->getFirstChild(expr);
+            int64_t count = 0;
+            if (!getEvaluator(scope).evaluateInt(countExpr, &count) || count < 0) {
+                return ExprKind::Other;
+            }
+            std::vector<SignalBit> partBits;
+            const AstNodeID partExpr = _ast->getNextSibling(countExpr);
+            const ExprKind kind = resolveBits(scope, partExpr, &partBits);
+            if (kind != ExprKind::Net) {
+                return kind;
+            }
+            if (static_cast<uint64_t>(count) * partBits.size() > MAX_SIGNAL_WIDTH) {
+                return ExprKind::Other;
+            }
+            for (int64_t i = 0; i < count; i++) {
+                bits->insert(bits->end(), partBits.begin(), partBits.end());
+            }
+            return ExprKind::Net;
+        }
+
+        case AstKind::Number:
+            return ExprKind::Constant;
+
+        default:
+            return getEvaluator(scope).evaluate(expr).known ? ExprKind::Constant
+                                                            : ExprKind::Other;
+    }
+}
+
+bool ModuleElaborator::Walker::resolveSelection(const GenScope* scope,
+                                                AstNodeID expr,
+                                                Selection* selection) const {
+    const AstKind kind = _ast->getKind(expr);
+    if (kind == AstKind::Identifier) {
+        const uint32_t* signal = findSignal(scope, _ast->getName(expr));
+        if (!signal) {
+            return false;
+        }
+        *selection = Selection {*signal, 0, _layouts[*signal]};
+        return true;
+    }
+
+    if (kind != AstKind::Select && kind != AstKind::RangeSelect
+        && kind != AstKind::Member) {
+        return false;
+    }
+    const AstNodeID base = _ast->getFirstChild(expr);
+    if (!resolveSelection(scope, base, selection)) {
+        return false;
+    }
+
+    const ConstEvaluator evaluator = getEvaluator(scope);
+    TypeLayout& layout = selection->layout;
+    if (kind == AstKind::Member) {
+        uint64_t offset = 0;
+        TypeLayout member;
+        if (!layout.dims.empty()
+            || !evaluator.getMember(layout, _ast->getName(expr), &offset, &member)) {
+            return false;
+        }
+        selection->offset += offset;
+        layout = member;
+        return true;
+    }
+
+    // Bits of a packed struct are selected as those of a vector.
+    if (layout.dims.empty()) {
+        if (layout.baseWidth <= 1) {
+            return false;
+        }
+        layout.dims.push_back(Dim {static_cast<int64_t>(layout.baseWidth) - 1, 0});
+        layout.baseWidth = 1;
+        layout.structType = TypeRef {};
+    }
+
+    const Dim dim = layout.dims.front();
+    const uint64_t elementWidth = layout.getElementWidth();
+    const AstNodeID left = _ast->getNextSibling(base);
+    int64_t a = 0;
+    if (!evaluator.evaluateInt(left, &a)) {
+        return false;
+    }
+
+    if (kind == AstKind::Select) {
+        if (!dim.contains(a)) {
+            return false;
+        }
+        selection->offset += dim.getOffset(a) * elementWidth;
+        layout.dims.erase(layout.dims.begin());
+        return true;
+    }
+
+    int64_t b = 0;
+    if (!evaluator.evaluateInt(_ast->getNextSibling(left), &b)) {
+        return false;
+    }
+    int64_t first = a;
+    int64_t last = b;
+    switch (_ast->getOp(expr)) {
+        case AstOp::IndexedUp:
+            last = a + b - 1;
+        break;
+        case AstOp::IndexedDown:
+            first = a - b + 1;
+            last = a;
+        break;
+        default:
+        break;
+    }
+    if (!dim.contains(first) || !dim.contains(last)) {
+        return false;
+    }
+
+    const uint64_t low = std::min(dim.getOffset(first), dim.getOffset(last));
+    const uint64_t high = std::max(dim.getOffset(first), dim.getOffset(last));
+    selection->offset += low * elementWidth;
+    layout.dims.front() = Dim {static_cast<int64_t>(high - low), 0};
+    return true;
+}
+
+void ModuleElaborator::Walker::appendBits(const Selection& selection,
+                                          std::vector<SignalBit>* bits) const {
+    const uint64_t width = selection.layout.getWidth();
+    bits->reserve(bits->size() + width);
+    for (uint64_t i = 0; i < width; i++) {
+        const uint32_t bit = static_cast<uint32_t>(selection.offset + i);
+        bits->push_back(SignalBit {selection.signal, bit});
+    }
+}
+
+ModuleElaborator::ModuleElaborator(const DesignUnits* units, NameTable* names)
+    : _units(units),
+    _names(names)
+{
+}
+
+void ModuleElaborator::getKey(size_t module,
+                              const ParamOverrides* overrides,
+                              std::vector<std::string_view>* paramNames,
+                              std::vector<std::string>* errors,
+                              ModuleKey* key,
+                              const Ast* ast,
+                              AstNodeID node) const {
+    const ModuleRef& ref = _units->getModules()[module];
+    Scope scope(_units->getUnitScope(ref.ast));
+    key->module = module;
+    key->params.clear();
+    declareParams(ref, &scope, overrides, nullptr, &key->params, paramNames, errors,
+                  ast, node);
+}
+
+void ModuleElaborator::elaborate(const ModuleKey& key, ElaboratedModule* result) const {
+    Walker(this, key, result).run();
+}
+
+void ModuleElaborator::declareParams(const ModuleRef& module,
+                                     Scope* scope,
+                                     const ParamOverrides* overrides,
+                                     const std::vector<ConstValue>* keyValues,
+                                     std::vector<ConstValue>* values,
+                                     std::vector<std::string_view>* paramNames,
+                                     std::vector<std::string>* errors,
+                                     const Ast* ast,
+                                     AstNodeID node) const {
+    const Ast* moduleAst = module.ast;
+    const ConstEvaluator evaluator(_units, moduleAst, scope);
+
+    // Parameters in #(...) are the overridable ones if there are any;
+    // otherwise those of the body that are not localparams.
+    bool hasHeaderParams = false;
+    for (AstNodeID id = moduleAst->getFirstChild(module.node); id;
+         id = moduleAst->getNextSibling(id)) {
+        if (moduleAst->getKind(id) == AstKind::ParamDecl
+            && moduleAst->hasFlag(id, AstFlags::Header)) {
+            hasHeaderParams = true;
+            break;
+        }
+    }
+
+    const auto addError = [&](std::string_view message) {
+        std::string& error = errors->emplace_back();
+        if (ast) {
+            _units->formatError(ast, node, message, error);
+        } else {
+            error = message;
+        }
+    };
+
+    size_t numValues = 0;
+    std::vector<bool> usedNamed(overrides ? overrides->named.size() : 0);
+    size_t position = 0;
+    for (AstNodeID id = moduleAst->getFirstChild(module.node); id;
+         id = moduleAst->getNextSibling(id)) {
+        switch (moduleAst->getKind(id)) {
+            case AstKind::Import: {
+                const Scope* package = _units->findPackage(moduleAst->getName(id));
+                if (package) {
+                    scope->addImport(package);
+                } else if (!keyValues) {
+                    addError("unknown package '"
+                             + std::string(moduleAst->getName(id)) + "'");
+                }
+            }
+            break;
+
+            case AstKind::Typedef:
+                evaluator.declareTypedef(scope, id);
+            break;
+
+            case AstKind::VarDecl:
+            case AstKind::NetDecl:
+                evaluator.declareEnumItems(scope, id);
+            break;
+
+            case AstKind::ParamDecl: {
+                const bool overridable = hasHeaderParams
+                    ? moduleAst->hasFlag(id, AstFlags::Header)
+                    : !moduleAst->hasFlag(id, AstFlags::Local);
+                const bool isType = moduleAst->getDataType(id) == AstDataType::Type;
+                for (AstNodeID d = moduleAst->getFirstChild(id); d;
+                     d = moduleAst->getNextSibling(d)) {
+                    if (moduleAst->getKind(d) != AstKind::Declarator) {
+                        continue;
+                    }
+                    const std::string_view name = moduleAst->getName(d);
+                    if (!overridable) {
+                        if (!isType) {
+                            scope->setValue(name, evaluator.evaluateParam(id, d));
+                        }
+                        continue;
+                    }
+
+                    // Type parameters take a position, but no value.
+                    const ConstValue* override = nullptr;
+                    if (overrides && position < overrides->positional.size()) {
+                        override = &overrides->positional[position];
+                    }
+                    position++;
+                    for (size_t i = 0; overrides && i < overrides->named.size(); i++) {
+                        if (overrides->named[i].first == name) {
+                            override = &overrides->named[i].second;
+                            usedNamed[i] = true;
+                        }
+                    }
+                    if (isType) {
+                        continue;
+                    }
+
+                    ConstValue value;
+                    if (keyValues) {
+                        value = numValues < keyValues->size() ? (*keyValues)[numValues]
+                                                              : ConstValue {};
+                    } else if (override) {
+                        value = evaluator.sizeParam(id, d, *override);
+                    } else {
+                        value = evaluator.evaluateParam(id, d);
+                    }
+                    scope->setValue(name, value);
+                    numValues++;
+                    if (values) {
+                        values->push_back(value);
+                    }
+                    if (paramNames) {
+                        paramNames->push_back(name);
+                    }
+                }
+            }
+            break;
+
+            default:
+            break;
+        }
+    }
+
+    const std::string_view moduleName = module.getName();
+    if (overrides && overrides->positional.size() > position) {
+        addError("too many parameter overrides for module '"
+                 + std::string(moduleName) + "'");
+    }
+    for (size_t i = 0; i < usedNamed.size(); i++) {
+        if (!usedNamed[i]) {
+            addError("module '" + std::string(moduleName) + "' has no parameter '"
+                     + std::string(overrides->named[i].first) + "'");
+        }
+    }
+}
+
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ConstEvaluator.h"
+#include "NetlistIDs.h"
+#include "PrimitiveKind.h"
+
+namespace stargate {
+
+class DesignUnits;
+class NameTable;
+struct ModuleRef;
+
+// One specialization of a module: its index in
+// DesignUnits::getModules() and the values of its overridable
+// parameters, in declaration order. Each distinct key becomes one
+// design.
+struct ModuleKey {
+    size_t module {0};
+    std::vector<ConstValue> params;
+
+    bool operator==(const ModuleKey& other) const = default;
+};
+
+struct ModuleKeyHash {
+    size_t operator()(const ModuleKey& key) const;
+};
+
+// Overrides of the parameters of an instantiated module, already
+// evaluated in the instantiating scope.
+struct ParamOverrides {
+    std::vector<ConstValue> positional;
+    std::vector<std::pair<std::string_view, ConstValue>> named;
+};
+
+// A bit of a signal, counted from its lsb end. Bits of constants and
+// of unconnected ports have no signal.
+struct SignalBit {
+    static constexpr uint32_t NO_SIGNAL = UINT32_MAX;
+
+    uint32_t signal {NO_SIGNAL};
+    uint32_t bit {0};
+};
+
+// Net of an elaborated module. Objects with one packed dimension of
+// bits keep their declared range; other arrays and structs are
+// flattened into a [width-1:0] bus.
+struct ElaboratedSignal {
+    NameID name;
+    bool isBus {false};
+    int32_t msb {0};
+    int32_t lsb {0};
+
+    uint32_t getWidth() const {
+        return isBus ? static_cast<uint32_t>(msb > lsb ? msb - lsb : lsb - msb) + 1 : 1;
+    }
+};
+
+struct ElaboratedPort {
+    uint32_t signal {0};
+    Direction direction {Direction::InOut};
+};
+
+// Connection of a port of an instance, bits lsb first. A connection
+// to a module names its port, or gives its position if port is
+// NULL_NAME; a connection to a primitive gives the index of its
+// scalar pin. The Elaborator turns named connections into positional
+// ones once the ports of the child are known.
+struct ElaboratedConnection {
+    NameID port;
+    uint32_t position {0};
+    std::vector<SignalBit> bits;
+};
+
+struct ElaboratedInstance {
+    NameID name;
+    // None for an instance of the module children[child].
+    PrimitiveKind primitive {PrimitiveKind::None};
+    uint32_t child {0};
+    AstNodeID node {NULL_AST_NODE};
+    std::vector<ElaboratedConnection> connections;
+};
+
+// Continuous assignment of one bit.
+struct ElaboratedAssign {
+    SignalBit from;
+    SignalBit to;
+};
+
+// Structure of one module specialization, with generate constructs
+// expanded and names flattened: a net declared in generate block g of
+// iteration 2 is named g[2].net.
+struct ElaboratedModule {
+    std::vector<ElaboratedSignal> signals;
+    std::vector<ElaboratedPort> ports;
+    std::vector<ElaboratedInstance> instances;
+    std::vector<ModuleKey> children;
+    std::vector<ElaboratedAssign> assigns;
+    std::vector<std::string> errors;
+
+    // Connections and assignments of expressions other than selects
+    // and concatenations of nets, gates other than buf and not, and
+    // procedural blocks are not lowered; they are counted.
+    size_t numUnloweredConnections {0};
+    size_t numUnloweredAssigns {0};
+    size_t numUnloweredGates {0};
+    size_t numProcesses {0};
+};
+
+// Elaborates single modules. It only reads the design units, so one
+// elaborator may elaborate different keys from many threads at once.
+// Names are interned into the netlist's NameTable, which is
+// thread-safe.
+class ModuleElaborator {
+public:
+    ModuleElaborator(const DesignUnits* units, NameTable* names);
+
+    // Fills key with the key of module with overrides, which may be
+    // null. The names of the overridable parameters are added to
+    // paramNames if not null. Overrides of unknown parameters add
+    // errors, located at node of ast.
+    void getKey(size_t module,
+                const ParamOverrides* overrides,
+                std::vector<std::string_view>* paramNames,
+                std::vector<std::string>* errors,
+                ModuleKey* key,
+                const Ast* ast = nullptr,
+                AstNodeID node = NULL_AST_NODE) const;
+
+    void elaborate(const ModuleKey& key, ElaboratedModule* result) const;
+
+private:
+    class Walker;
+
+    const DesignUnits* _units {nullptr};
+    NameTable* _names {nullptr};
+
+    // Declares the imports, typedefs and parameters at the top level of
+    // module in scope. The overridable parameters take the values of
+    // keyValues if not null, else their overridden or default values.
+    // The overridable values are added in order to values if not null.
+    void declareParams(const ModuleRef& module,
+                       Scope* scope,
+                       const ParamOverrides* overrides,
+                       const std::vector<ConstValue>* keyValues,
+                       std::vector<ConstValue>* values,
+                       std::vector<std::string_view>* paramNames,
+                       std::vector<std::string>* errors,
+                       const Ast* ast,
+                       AstNodeID node) const;
+};
+
+}
@@ -0,0 +1,186 @@
+#include "ArtifactCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <vector>
+
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "FileUtils.h"
+
+using namespace stargate;
+
+namespace fs = std::filesystem;
+
+static const std::string TMP_DIR_NAME = "tmp";
+
+namespace {
+
+// Links, or else copies, the files of from into to. Stops at the
+// first file that can be neither, which happens when an entry is
+// evicted while it is read.
+bool linkTree(const fs::path& from, const fs::path& to) {
+    std::error_code ec;
+    fs::create_directories(to, ec);
+    if (ec) {
+        return false;
+    }
+
+    fs::recursive_directory_iterator it(from, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const fs::path dest = to / fs::relative(it->path(), from);
+        if (it->is_directory(ec)) {
+            fs::create_directories(dest, ec);
+            continue;
+        }
+
+        fs::create_hard_link(it->path(), dest, ec);
+        if (ec) {
+            // Other filesystem, or a file of another user under
+            // protected_hardlinks.
+            ec.clear();
+            fs::copy_file(it->path(), dest, ec);
+        }
+    }
+
+    return !ec;
+}
+
+void makeReadOnly(const fs::path& dir) {
+    constexpr fs::perms writePerms =
+        fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write;
+
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            fs::permissions(it->path(), writePerms, fs::perm_options::remove, ec);
+        }
+    }
+}
+
+uint64_t getTreeSize(const fs::path& dir) {
+    uint64_t size = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            size += it->file_size(ec);
+        }
+    }
+    return size;
+}
+
+void touch(const fs::path& path) {
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+}
+
+ArtifactCache::ArtifactCache(const std::string& dir, uint64_t maxSize)
+    : _dir(dir),
+    _maxSize(maxSize)
+{
+    FileUtils::createDirectory(_dir + "/" + TMP_DIR_NAME);
+}
+
+ArtifactCache::~ArtifactCache() {
+}
+
+bool ArtifactCache::restore(const std::string& key, const std::string& outputDir) {
+    const fs::path entryDir = fs::path(_dir) / key;
+
+    std::error_code ec;
+    if (!fs::is_directory(entryDir, ec)) {
+        return false;
+    }
+
+    if (!linkTree(entryDir, outputDir)) {
+        fs::remove_all(outputDir, ec);
+        return false;
+    }
+
+    touch(entryDir);
+    return true;
+}
+
+void ArtifactCache::store(const std::string& key, const std::string& outputDir) {
+    const fs::path entryDir = fs::path(_dir) / key;
+
+    std::error_code ec;
+    if (fs::exists(entryDir, ec)) {
+        touch(entryDir);
+        return;
+    }
+
+    // The entry is filled under a private name and renamed into place,
+    // so that no process sees it half written.
+    static std::atomic<uint64_t> tmpCount {0};
+    const fs::path tmpDir = fs::path(_dir) / TMP_DIR_NAME
+        / (key + "." + std::to_string(getpid()) + "." + std::to_string(tmpCount++));
+
+    if (!linkTree(outputDir, tmpDir)) {
+        spdlog::warn("Failed to store {} in the artifact cache", outputDir);
+        fs::remove_all(tmpDir, ec);
+        return;
+    }
+    makeReadOnly(tmpDir);
+
+    fs::rename(tmpDir, entryDir, ec);
+    if (ec) {
+        // Stored by another process in the meantime.
+        fs::remove_all(tmpDir, ec);
+        return;
+    }
+    touch(entryDir);
+
+    evict();
+}
+
+void ArtifactCache::evict() {
+    std::lock_guard<std::mutex> lock(_evictMutex);
+
+    struct Entry {
+        fs::path path;
+        fs::file_time_type lastUse;
+        uint64_t size {0};
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().filename() == TMP_DIR_NAME || !it->is_directory(ec)) {
+            continue;
+        }
+
+        Entry& entry = entries.emplace_back();
+        entry.path = it->path();
+        entry.lastUse = fs::last_write_time(entry.path, ec);
+        entry.size = getTreeSize(entry.path);
+        totalSize += entry.size;
+    }
+
+    if (totalSize <= _maxSize) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.lastUse < b.lastUse;
+    });
+
+    for (const Entry& entry : entries) {
+        if (totalSize <= _maxSize) {
+            break;
+        }
+
+        spdlog::info("Evicting {} from the artifact cache",
+                     entry.path.filename().string());
+        fs::remove_all(entry.path, ec);
+        totalSize -= entry.size;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+
+namespace stargate {
+
+// Store of task output directories keyed by task fingerprint, shared by
+// the output directories of any number of checkouts and users. Each
+// entry is a directory named after its key. Files are restored by hard
+// link, or copied when they cannot be linked, and are made read-only
+// since they are shared. Entries are evicted least recently used
+// first, once the cache grows beyond its maximum size.
+class ArtifactCache {
+public:
+    ArtifactCache(const std::string& dir, uint64_t maxSize);
+    ~ArtifactCache();
+
+    ArtifactCache(const ArtifactCache&) = delete;
+    ArtifactCache& operator=(const ArtifactCache&) = delete;
+
+    const std::string& getDir() const { return _dir; }
+
+    uint64_t getMaxSize() const { return _maxSize; }
+
+    // Fills outputDir, which must not exist, with the files stored under
+    // key. Returns false, leaving no outputDir, if there is no entry or
+    // it was evicted while being restored.
+    bool restore(const std::string& key, const std::string& outputDir);
+
+    // Stores the files of outputDir under key, unless another process
+    // already did, then evicts entries until the cache fits.
+    void store(const std::string& key, const std::string& outputDir);
+
+private:
+    std::string _dir;
+    uint64_t _maxSize {0};
+    std::mutex _evictMutex;
+
+    void evict();
+};
+
+}
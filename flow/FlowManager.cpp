@@ -3,6 +3,8 @@
 #include "Flow.h"
 #include "external/vivado/VivadoFlow.h"
 
+#include "ProjectTarget.h"
+
 using namespace stargate;
 
 FlowManager::FlowManager()
@@ -37,3 +39,9 @@ Flow* FlowManager::getFlow(std::string_view name) const {
 void FlowManager::setOutputDir(const std::string& outputDir) {
     _outputDir = outputDir;
 }
+
+void FlowManager::getTargetDir(const ProjectTarget* target, std::string& result) const {
+    result = _outputDir;
+    result += "/targets/";
+    result += target->getName();
+}
@@ -7,8 +7,10 @@
 
 namespace stargate {
 
+class ArtifactCache;
 class DistribConfig;
 class Flow;
+class ProjectTarget;
 class VivadoFlow;
 
 class FlowManager {
@@ -29,10 +31,24 @@ public:
 
     const std::string& getOutputDir() const { return _outputDir; }
 
+    // Directory the source paths of the project are relative to.
+    void setSourceDir(const std::string& sourceDir) { _sourceDir = sourceDir; }
+
+    const std::string& getSourceDir() const { return _sourceDir; }
+
+    // Root of the outputs of the flow tasks of target. Each target has
+    // its own, so several targets can build at once.
+    void getTargetDir(const ProjectTarget* target, std::string& result) const;
+
     void setDistribConfig(const DistribConfig* config) { _distribConfig = config; }
 
     const DistribConfig* getDistribConfig() const { return _distribConfig; }
 
+    // Null if outputs are not cached.
+    void setArtifactCache(ArtifactCache* cache) { _artifactCache = cache; }
+
+    ArtifactCache* getArtifactCache() const { return _artifactCache; }
+
 private:
     friend Flow;
     friend VivadoFlow;
@@ -42,7 +58,9 @@ private:
     Flows _flows;
     FlowNameMap _flowNameMap;
     std::string _outputDir;
+    std::string _sourceDir;
     const DistribConfig* _distribConfig {nullptr};
+    ArtifactCache* _artifactCache {nullptr};
 };
 
 }
@@ -1,10 +1,20 @@
 #include "FlowTask.h"
 
+#include <fstream>
+#include <sstream>
+
+#include <spdlog/spdlog.h>
+
 #include "FlowSection.h"
 #include "Flow.h"
 #include "FlowManager.h"
+#include "ArtifactCache.h"
+
+#include "ProjectTarget.h"
 
+#include "ContentHash.h"
 #include "FileUtils.h"
+#include "Panic.h"
 
 using namespace stargate;
 
@@ -20,39 +30,169 @@ void FlowTask::registerTask() {
 FlowTask::~FlowTask() {
 }
 
-TaskStatus::Status FlowTask::getStatus() const {
+void FlowTask::addDependency(FlowTask* task) {
+    _dependencies.push_back(task);
+}
+
+TaskStatus::Status FlowTask::getStatus(const ProjectTarget* target) const {
     std::string statusPath;
-    getStatusFilePath(statusPath);
+    getStatusFilePath(target, statusPath);
     return TaskStatus::read(statusPath);
 }
 
-void FlowTask::getOutputDir(std::string& result) const {
+void FlowTask::getOutputDir(const ProjectTarget* target, std::string& result) const {
     const Flow* flow = _parent->getParent();
     const FlowManager* manager = flow->getManager();
 
-    result = manager->getOutputDir();
+    manager->getTargetDir(target, result);
     result += "/";
     result += flow->getName();
     result += "/";
     result += getName();
 }
 
-void FlowTask::getStatusFilePath(std::string& result) const {
-    getOutputDir(result);
+void FlowTask::getStatusFilePath(const ProjectTarget* target, std::string& result) const {
+    getOutputDir(target, result);
     result += "/status.json";
 }
 
-void FlowTask::writeStatus(TaskStatus::Status status,
+void FlowTask::getFingerprintFilePath(const ProjectTarget* target,
+                                      std::string& result) const {
+    getOutputDir(target, result);
+    result += "/fingerprint";
+}
+
+bool FlowTask::update(const ProjectTarget* target) {
+    std::string fingerprint;
+    getFingerprint(target, fingerprint);
+    if (getStatus(target) == TaskStatus::Status::Success) {
+        std::string lastFingerprint;
+        readFingerprint(target, lastFingerprint);
+        if (lastFingerprint == fingerprint) {
+            return false;
+        }
+    }
+
+    // Outputs of an earlier run of the task must not outlive it.
+    std::string outputDir;
+    getOutputDir(target, outputDir);
+    if (FileUtils::exists(outputDir)) {
+        FileUtils::removeDirectory(outputDir);
+    }
+
+    ArtifactCache* cache = nullptr;
+    if (isCacheable()) {
+        cache = _parent->getParent()->getManager()->getArtifactCache();
+    }
+    if (cache && cache->restore(fingerprint, outputDir)) {
+        spdlog::info("Restored task {} (target {}) from the artifact cache",
+                     getName(), target->getName());
+        return true;
+    }
+
+    spdlog::info("Executing task: {} (target {})", getName(), target->getName());
+    execute(target);
+
+    if (getStatus(target) == TaskStatus::Status::Success) {
+        std::string fingerprintPath;
+        getFingerprintFilePath(target, fingerprintPath);
+        std::ofstream out(fingerprintPath);
+        if (!out) {
+            panic("Failed to write fingerprint file: {}", fingerprintPath);
+        }
+        out << fingerprint << "\n";
+        out.close();
+
+        if (cache) {
+            cache->store(fingerprint, outputDir);
+        }
+    }
+
+    return true;
+}
+
+void FlowTask::getFingerprint(const ProjectTarget* target, std::string& result) const {
+    ContentHash hash;
+    addFingerprint(target, hash);
+    hash.hex(result);
+}
+
+void FlowTask::addFingerprint(const ProjectTarget* target, ContentHash& hash) const {
+    hash.update(_parent->getParent()->getName());
+    hash.update(getName());
+    hash.update(target->getName());
+    hash.update(target->getPart());
+    hash.update(target->getTopModule());
+
+    // A dependency that ran again changes the fingerprint, whether or
+    // not its own inputs changed.
+    hash.update(_dependencies.size());
+    std::string fingerprint;
+    for (const FlowTask* dependency : _dependencies) {
+        dependency->readFingerprint(target, fingerprint);
+        hash.update(fingerprint);
+    }
+}
+
+void FlowTask::addTextFingerprint(std::string_view text, ContentHash& hash) const {
+    const FlowManager* manager = _parent->getParent()->getManager();
+
+    // The output directory is usually inside the source directory, so
+    // it is replaced first.
+    std::string normalized(text);
+    const std::pair<const std::string*, std::string_view> dirs[] = {
+        {&manager->getOutputDir(), "$SG_OUTPUT_DIR"},
+        {&manager->getSourceDir(), "$SG_SOURCE_DIR"},
+    };
+    for (const auto& [dir, placeholder] : dirs) {
+        if (dir->empty()) {
+            continue;
+        }
+        for (size_t pos = normalized.find(*dir); pos != std::string::npos;
+             pos = normalized.find(*dir, pos + placeholder.size())) {
+            normalized.replace(pos, dir->size(), placeholder);
+        }
+    }
+
+    hash.update(normalized);
+}
+
+void FlowTask::addFileFingerprint(const std::string& path, ContentHash& hash) const {
+    addTextFingerprint(path, hash);
+
+    std::ifstream in(path);
+    if (!in) {
+        hash.update(uint64_t(0));
+        return;
+    }
+
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    hash.update(uint64_t(1));
+    addTextFingerprint(contents.str(), hash);
+}
+
+void FlowTask::readFingerprint(const ProjectTarget* target, std::string& result) const {
+    std::string fingerprintPath;
+    getFingerprintFilePath(target, fingerprintPath);
+
+    result.clear();
+    std::ifstream in(fingerprintPath);
+    in >> result;
+}
+
+void FlowTask::writeStatus(const ProjectTarget* target,
+                           TaskStatus::Status status,
                            int exitCode,
                            const std::string& errorMessage) {
     std::string outputDir;
-    getOutputDir(outputDir);
+    getOutputDir(target, outputDir);
 
     if (!FileUtils::exists(outputDir)) {
         FileUtils::createDirectory(outputDir);
     }
 
     std::string statusPath;
-    getStatusFilePath(statusPath);
+    getStatusFilePath(target, statusPath);
     TaskStatus::write(statusPath, status, exitCode, errorMessage);
 }
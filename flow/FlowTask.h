@@ -2,17 +2,20 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "TaskStatus.h"
 
 namespace stargate {
 
+class ContentHash;
 class FlowSection;
 class ProjectTarget;
 
 class FlowTask {
 public:
     friend FlowSection;
+    using Tasks = std::vector<FlowTask*>;
 
     virtual ~FlowTask();
 
@@ -20,26 +23,68 @@ public:
 
     virtual void execute(const ProjectTarget* target) = 0;
 
+    // Executes the task for target in a cleared output directory,
+    // unless its last run succeeded with the same fingerprint. Outputs
+    // of cacheable tasks are restored from the artifact cache instead
+    // when it has them. Returns false if the task was up to date.
+    bool update(const ProjectTarget* target);
+
     FlowSection* getParent() const { return _parent; }
 
     size_t getIndex() const { return _index; }
 
-    TaskStatus::Status getStatus() const;
+    // Tasks of the same flow that must succeed before this one starts.
+    // Tasks that do not depend on each other may run concurrently.
+    const Tasks& dependencies() const { return _dependencies; }
+
+    void addDependency(FlowTask* task);
+
+    TaskStatus::Status getStatus(const ProjectTarget* target) const;
+
+    void getOutputDir(const ProjectTarget* target, std::string& result) const;
+
+    void getStatusFilePath(const ProjectTarget* target, std::string& result) const;
 
-    void getOutputDir(std::string& result) const;
+    // Hash of everything the outputs of the task for target depend on,
+    // recorded next to the status after a successful run. The output
+    // and source directories are left out, so that checkouts share
+    // fingerprints.
+    void getFingerprint(const ProjectTarget* target, std::string& result) const;
 
-    void getStatusFilePath(std::string& result) const;
+    void getFingerprintFilePath(const ProjectTarget* target, std::string& result) const;
 
 protected:
     explicit FlowTask(FlowSection* parent);
     void registerTask();
-    void writeStatus(TaskStatus::Status status,
+    void writeStatus(const ProjectTarget* target,
+                     TaskStatus::Status status,
                      int exitCode,
                      const std::string& errorMessage);
 
+    // Whether the outputs of the task are worth keeping in the artifact
+    // cache.
+    virtual bool isCacheable() const { return false; }
+
+    // Adds the inputs of the task to hash. The base adds the task and
+    // target names, the part, the top and the recorded fingerprints of
+    // the dependencies; tasks add the scripts and files they read.
+    virtual void addFingerprint(const ProjectTarget* target, ContentHash& hash) const;
+
+    // Adds text with the output and source directories replaced by
+    // placeholders.
+    void addTextFingerprint(std::string_view text, ContentHash& hash) const;
+
+    // Adds the path and contents of a text file, or its absence.
+    void addFileFingerprint(const std::string& path, ContentHash& hash) const;
+
 private:
     FlowSection* _parent {nullptr};
     size_t _index {0};
+    Tasks _dependencies;
+
+    // The fingerprint recorded by the last successful run, or an empty
+    // string.
+    void readFingerprint(const ProjectTarget* target, std::string& result) const;
 };
 
 }
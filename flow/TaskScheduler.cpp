@@ -0,0 +1,204 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "FlowTask.h"
+
+#include "ProjectTarget.h"
+
+#include "Panic.h"
+
+using namespace stargate;
+
+TaskScheduler::TaskScheduler(unsigned jobCount)
+    : _jobCount(jobCount)
+{
+    if (_jobCount == 0) {
+        _jobCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+}
+
+void TaskScheduler::addTask(FlowTask* task, const ProjectTarget* target) {
+    const auto [it, inserted] =
+        _nodeMap.emplace(std::make_pair(task, target), _nodes.size());
+    if (!inserted) {
+        return;
+    }
+
+    Node& node = _nodes.emplace_back();
+    node.task = task;
+    node.target = target;
+}
+
+bool TaskScheduler::run() {
+    _ready.clear();
+    _remaining = _nodes.size();
+    _error = nullptr;
+
+    if (!linkDependencies()) {
+        spdlog::error("Some tasks have unmet dependencies");
+    }
+    checkCycles();
+
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        if (!_nodes[i].skipped && _nodes[i].numPendingDependencies == 0) {
+            _ready.push_back(i);
+        }
+    }
+
+    // Tasks mostly wait on external tools, so each job is a thread.
+    const size_t workerCount = std::min<size_t>(_jobCount, _nodes.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; i++) {
+        workers.emplace_back(&TaskScheduler::work, this);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if (_error) {
+        std::rethrow_exception(_error);
+    }
+
+    return std::all_of(_nodes.begin(), _nodes.end(), [](const Node& node) {
+        return node.status == TaskStatus::Status::Success;
+    });
+}
+
+bool TaskScheduler::linkDependencies() {
+    std::vector<size_t> blocked;
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        Node& node = _nodes[i];
+        for (const FlowTask* dependency : node.task->dependencies()) {
+            const auto it = _nodeMap.find(std::make_pair(dependency, node.target));
+            if (it != _nodeMap.end()) {
+                _nodes[it->second].dependents.push_back(i);
+                node.numPendingDependencies++;
+                continue;
+            }
+
+            const TaskStatus::Status status = dependency->getStatus(node.target);
+            if (status != TaskStatus::Status::Success) {
+                spdlog::error(
+                    "Dependency task '{}' of task '{}' has not completed successfully "
+                    "(status: {})",
+                    dependency->getName(), node.task->getName(),
+                    TaskStatus::toString(status));
+                blocked.push_back(i);
+            }
+        }
+    }
+
+    // Tasks blocked by an unmet dependency block their dependents too.
+    for (size_t i : blocked) {
+        skip(i, _nodes[i]);
+    }
+
+    return blocked.empty();
+}
+
+void TaskScheduler::checkCycles() const {
+    std::vector<size_t> pending(_nodes.size());
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        pending[i] = _nodes[i].numPendingDependencies;
+        if (pending[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    size_t visited = 0;
+    while (!ready.empty()) {
+        const size_t index = ready.back();
+        ready.pop_back();
+        visited++;
+        for (size_t dependent : _nodes[index].dependents) {
+            if (--pending[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+
+    for (size_t i = 0; visited != _nodes.size() && i < _nodes.size(); i++) {
+        if (pending[i] != 0) {
+            panic("Task '{}' is part of a dependency cycle", _nodes[i].task->getName());
+        }
+    }
+}
+
+void TaskScheduler::work() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _wake.wait(lock, [this]() {
+            return !_ready.empty() || _remaining == 0 || _error;
+        });
+        if (_ready.empty() || _error) {
+            return;
+        }
+
+        const size_t index = _ready.front();
+        _ready.pop_front();
+        Node& node = _nodes[index];
+        lock.unlock();
+
+        TaskStatus::Status status = TaskStatus::Status::Failed;
+        std::exception_ptr error;
+        try {
+            if (!node.task->update(node.target)) {
+                spdlog::info("Task {} (target {}) is up to date",
+                             node.task->getName(), node.target->getName());
+            }
+            status = node.task->getStatus(node.target);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error && !_error) {
+            _error = error;
+        }
+        finish(index, status);
+    }
+}
+
+void TaskScheduler::finish(size_t index, TaskStatus::Status status) {
+    Node& node = _nodes[index];
+    node.status = status;
+    _remaining--;
+
+    for (size_t dependent : node.dependents) {
+        if (status != TaskStatus::Status::Success) {
+            skip(dependent, node);
+        } else if (--_nodes[dependent].numPendingDependencies == 0
+                   && !_nodes[dependent].skipped) {
+            _ready.push_back(dependent);
+        }
+    }
+
+    _wake.notify_all();
+}
+
+void TaskScheduler::skip(size_t index, const Node& cause) {
+    Node& node = _nodes[index];
+    if (node.skipped) {
+        return;
+    }
+
+    node.skipped = true;
+    _remaining--;
+    if (&node != &cause) {
+        spdlog::warn("Skipping task '{}': dependency '{}' did not succeed",
+                     node.task->getName(), cause.task->getName());
+    }
+
+    for (size_t dependent : node.dependents) {
+        skip(dependent, node);
+    }
+}
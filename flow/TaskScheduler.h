@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "TaskStatus.h"
+
+namespace stargate {
+
+class FlowTask;
+class ProjectTarget;
+
+// Runs flow tasks for targets as soon as their dependencies have
+// succeeded, at most jobCount at a time. A dependency that is not
+// scheduled for the same target must have succeeded in an earlier
+// invocation. When a task fails, the tasks that depend on it are
+// skipped and the independent ones still run.
+class TaskScheduler {
+public:
+    // One job per core if jobCount is 0.
+    explicit TaskScheduler(unsigned jobCount = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Adding a task twice for the same target has no effect.
+    void addTask(FlowTask* task, const ProjectTarget* target);
+
+    // Runs the added tasks, once. Returns true if every task succeeded.
+    // The first exception thrown by a task is rethrown once the running
+    // tasks are done; no new task starts after it.
+    bool run();
+
+private:
+    struct Node {
+        FlowTask* task {nullptr};
+        const ProjectTarget* target {nullptr};
+        std::vector<size_t> dependents;
+        size_t numPendingDependencies {0};
+        TaskStatus::Status status {TaskStatus::Status::NotStarted};
+        bool skipped {false};
+    };
+
+    unsigned _jobCount {0};
+    std::vector<Node> _nodes;
+    std::map<std::pair<const FlowTask*, const ProjectTarget*>, size_t> _nodeMap;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<size_t> _ready;
+    size_t _remaining {0};
+    std::exception_ptr _error;
+
+    bool linkDependencies();
+    void checkCycles() const;
+    void work();
+    void finish(size_t index, TaskStatus::Status status);
+    void skip(size_t index, const Node& cause);
+};
+
+}
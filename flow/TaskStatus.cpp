@@ -1,5 +1,7 @@
 #include "TaskStatus.h"
 
+#include <time.h>
+
 #include <fstream>
 #include <chrono>
 #include <iomanip>
@@ -22,8 +24,11 @@ const std::string STATUS_FAILED = "failed";
 std::string getCurrentTimestamp() {
     const auto now = std::chrono::system_clock::now();
     const auto timeT = std::chrono::system_clock::to_time_t(now);
+    // Tasks finish on scheduler threads: localtime_r, not localtime.
+    struct tm localTime;
+    localtime_r(&timeT, &localTime);
     std::ostringstream oss;
-    oss << std::put_time(std::localtime(&timeT), "%Y-%m-%dT%H:%M:%S");
+    oss << std::put_time(&localTime, "%Y-%m-%dT%H:%M:%S");
     return oss.str();
 }
 
@@ -1,5 +1,7 @@
 #include "VivadoBitstreamTask.h"
 
+#include <sstream>
+
 #include <spdlog/spdlog.h>
 
 #include "FlowSection.h"
@@ -9,6 +11,7 @@
 #include "VivadoTCLGenerator.h"
 #include "VivadoRunner.h"
 
+#include "ContentHash.h"
 #include "FileUtils.h"
 #include "Panic.h"
 
@@ -38,7 +41,7 @@ void VivadoBitstreamTask::execute(const ProjectTarget* target) {
     const FlowManager* manager = getParent()->getParent()->getManager();
 
     std::string outputDir;
-    getOutputDir(outputDir);
+    getOutputDir(target, outputDir);
 
     if (!FileUtils::exists(outputDir)) {
         FileUtils::createDirectory(outputDir);
@@ -55,5 +58,20 @@ void VivadoBitstreamTask::execute(const ProjectTarget* target) {
     const TaskStatus::Status status = (exitCode == 0)
         ? TaskStatus::Status::Success
         : TaskStatus::Status::Failed;
-    writeStatus(status, exitCode, "");
+    writeStatus(target, status, exitCode, "");
+}
+
+void VivadoBitstreamTask::addFingerprint(const ProjectTarget* target,
+                                         ContentHash& hash) const {
+    FlowTask::addFingerprint(target, hash);
+
+    const FlowManager* manager = getParent()->getParent()->getManager();
+
+    std::string outputDir;
+    getOutputDir(target, outputDir);
+
+    std::ostringstream tcl;
+    VivadoTCLGenerator generator(manager, target);
+    generator.generateBitstreamTcl(outputDir, tcl);
+    addTextFingerprint(tcl.str(), hash);
 }
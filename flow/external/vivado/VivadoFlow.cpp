@@ -24,7 +24,10 @@ VivadoFlow* VivadoFlow::create(FlowManager* manager) {
 void VivadoFlow::initSections() {
     FlowSection* buildSection = FlowSection::create(this, "build");
 
-    VivadoSynthTask::create(buildSection);
-    VivadoImplTask::create(buildSection);
-    VivadoBitstreamTask::create(buildSection);
+    VivadoSynthTask* synthTask = VivadoSynthTask::create(buildSection);
+    VivadoImplTask* implTask = VivadoImplTask::create(buildSection);
+    VivadoBitstreamTask* bitstreamTask = VivadoBitstreamTask::create(buildSection);
+
+    implTask->addDependency(synthTask);
+    bitstreamTask->addDependency(implTask);
 }
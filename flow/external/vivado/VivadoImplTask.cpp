@@ -1,14 +1,18 @@
 #include "VivadoImplTask.h"
 
+#include <sstream>
+
 #include <spdlog/spdlog.h>
 
 #include "FlowSection.h"
 #include "Flow.h"
 #include "FlowManager.h"
 
+#include "VivadoPaths.h"
 #include "VivadoTCLGenerator.h"
 #include "VivadoRunner.h"
 
+#include "ContentHash.h"
 #include "FileUtils.h"
 #include "Panic.h"
 
@@ -38,7 +42,7 @@ void VivadoImplTask::execute(const ProjectTarget* target) {
     const FlowManager* manager = getParent()->getParent()->getManager();
 
     std::string outputDir;
-    getOutputDir(outputDir);
+    getOutputDir(target, outputDir);
 
     if (!FileUtils::exists(outputDir)) {
         FileUtils::createDirectory(outputDir);
@@ -55,5 +59,26 @@ void VivadoImplTask::execute(const ProjectTarget* target) {
     const TaskStatus::Status status = (exitCode == 0)
         ? TaskStatus::Status::Success
         : TaskStatus::Status::Failed;
-    writeStatus(status, exitCode, "");
+    writeStatus(target, status, exitCode, "");
+}
+
+void VivadoImplTask::addFingerprint(const ProjectTarget* target,
+                                    ContentHash& hash) const {
+    FlowTask::addFingerprint(target, hash);
+
+    const FlowManager* manager = getParent()->getParent()->getManager();
+
+    std::string outputDir;
+    getOutputDir(target, outputDir);
+
+    std::ostringstream tcl;
+    VivadoTCLGenerator generator(manager, target);
+    generator.generateImplTcl(outputDir, tcl);
+    addTextFingerprint(tcl.str(), hash);
+
+    // The constraints script lists the constraint files with the
+    // hashes of their contents.
+    std::string tclPath;
+    VivadoPaths::getConstraintsTclPath(manager, target, tclPath);
+    addFileFingerprint(tclPath, hash);
 }
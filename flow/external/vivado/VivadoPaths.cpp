@@ -11,6 +11,7 @@ static const std::string SYNTH_TASK_NAME = "synth";
 static const std::string IMPL_TASK_NAME = "impl";
 static const std::string BITSTREAM_TASK_NAME = "bitstream";
 static const std::string FILES_TCL_NAME = "files.tcl";
+static const std::string CONSTRAINTS_TCL_NAME = "constraints.tcl";
 static const std::string SYNTH_DCP_NAME = "synth.dcp";
 static const std::string IMPL_DCP_NAME = "impl.dcp";
 
@@ -24,24 +25,40 @@ void VivadoPaths::getFilesTclPath(const FlowManager* manager,
     result += FILES_TCL_NAME;
 }
 
-void VivadoPaths::getSynthDir(const FlowManager* manager, std::string& result) {
+void VivadoPaths::getConstraintsTclPath(const FlowManager* manager,
+                                        const ProjectTarget* target,
+                                        std::string& result) {
     result = manager->getOutputDir();
+    result += "/project/";
+    result += target->getName();
+    result += "/";
+    result += CONSTRAINTS_TCL_NAME;
+}
+
+void VivadoPaths::getSynthDir(const FlowManager* manager,
+                              const ProjectTarget* target,
+                              std::string& result) {
+    manager->getTargetDir(target, result);
     result += "/";
     result += VIVADO_FLOW_NAME;
     result += "/";
     result += SYNTH_TASK_NAME;
 }
 
-void VivadoPaths::getImplDir(const FlowManager* manager, std::string& result) {
-    result = manager->getOutputDir();
+void VivadoPaths::getImplDir(const FlowManager* manager,
+                             const ProjectTarget* target,
+                             std::string& result) {
+    manager->getTargetDir(target, result);
     result += "/";
     result += VIVADO_FLOW_NAME;
     result += "/";
     result += IMPL_TASK_NAME;
 }
 
-void VivadoPaths::getBitstreamDir(const FlowManager* manager, std::string& result) {
-    result = manager->getOutputDir();
+void VivadoPaths::getBitstreamDir(const FlowManager* manager,
+                                  const ProjectTarget* target,
+                                  std::string& result) {
+    manager->getTargetDir(target, result);
     result += "/";
     result += VIVADO_FLOW_NAME;
     result += "/";
@@ -49,15 +66,17 @@ void VivadoPaths::getBitstreamDir(const FlowManager* manager, std::string& resul
 }
 
 void VivadoPaths::getSynthCheckpoint(const FlowManager* manager,
+                                     const ProjectTarget* target,
                                      std::string& result) {
-    getSynthDir(manager, result);
+    getSynthDir(manager, target, result);
     result += "/";
     result += SYNTH_DCP_NAME;
 }
 
 void VivadoPaths::getImplCheckpoint(const FlowManager* manager,
+                                    const ProjectTarget* target,
                                     std::string& result) {
-    getImplDir(manager, result);
+    getImplDir(manager, target, result);
     result += "/";
     result += IMPL_DCP_NAME;
 }
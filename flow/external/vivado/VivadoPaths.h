@@ -12,13 +12,26 @@ public:
     static void getFilesTclPath(const FlowManager* manager,
                                 const ProjectTarget* target,
                                 std::string& result);
+    static void getConstraintsTclPath(const FlowManager* manager,
+                                      const ProjectTarget* target,
+                                      std::string& result);
 
-    static void getSynthDir(const FlowManager* manager, std::string& result);
-    static void getImplDir(const FlowManager* manager, std::string& result);
-    static void getBitstreamDir(const FlowManager* manager, std::string& result);
+    static void getSynthDir(const FlowManager* manager,
+                            const ProjectTarget* target,
+                            std::string& result);
+    static void getImplDir(const FlowManager* manager,
+                           const ProjectTarget* target,
+                           std::string& result);
+    static void getBitstreamDir(const FlowManager* manager,
+                                const ProjectTarget* target,
+                                std::string& result);
 
-    static void getSynthCheckpoint(const FlowManager* manager, std::string& result);
-    static void getImplCheckpoint(const FlowManager* manager, std::string& result);
+    static void getSynthCheckpoint(const FlowManager* manager,
+                                   const ProjectTarget* target,
+                                   std::string& result);
+    static void getImplCheckpoint(const FlowManager* manager,
+                                  const ProjectTarget* target,
+                                  std::string& result);
 };
 
 }
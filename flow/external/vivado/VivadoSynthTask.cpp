@@ -1,14 +1,18 @@
 #include "VivadoSynthTask.h"
 
+#include <sstream>
+
 #include <spdlog/spdlog.h>
 
 #include "FlowSection.h"
 #include "Flow.h"
 #include "FlowManager.h"
 
+#include "VivadoPaths.h"
 #include "VivadoTCLGenerator.h"
 #include "VivadoRunner.h"
 
+#include "ContentHash.h"
 #include "FileUtils.h"
 #include "Panic.h"
 
@@ -34,7 +38,7 @@ void VivadoSynthTask::execute(const ProjectTarget* target) {
     const FlowManager* manager = getParent()->getParent()->getManager();
 
     std::string outputDir;
-    getOutputDir(outputDir);
+    getOutputDir(target, outputDir);
 
     if (!FileUtils::exists(outputDir)) {
         FileUtils::createDirectory(outputDir);
@@ -51,5 +55,26 @@ void VivadoSynthTask::execute(const ProjectTarget* target) {
     const TaskStatus::Status status = (exitCode == 0)
         ? TaskStatus::Status::Success
         : TaskStatus::Status::Failed;
-    writeStatus(status, exitCode, "");
+    writeStatus(target, status, exitCode, "");
+}
+
+void VivadoSynthTask::addFingerprint(const ProjectTarget* target,
+                                     ContentHash& hash) const {
+    FlowTask::addFingerprint(target, hash);
+
+    const FlowManager* manager = getParent()->getParent()->getManager();
+
+    std::string outputDir;
+    getOutputDir(target, outputDir);
+
+    std::ostringstream tcl;
+    VivadoTCLGenerator generator(manager, target);
+    generator.generateSynthTcl(outputDir, tcl);
+    addTextFingerprint(tcl.str(), hash);
+
+    // The files script lists the sources with the hashes of their
+    // contents, so it changes with any of them.
+    std::string tclPath;
+    VivadoPaths::getFilesTclPath(manager, target, tclPath);
+    addFileFingerprint(tclPath, hash);
 }
@@ -14,6 +14,10 @@ public:
     std::string_view getName() const override { return "synth"; }
     void execute(const ProjectTarget* target) override;
 
+protected:
+    bool isCacheable() const override { return true; }
+    void addFingerprint(const ProjectTarget* target, ContentHash& hash) const override;
+
 private:
     explicit VivadoSynthTask(FlowSection* parent);
 };
@@ -53,6 +53,17 @@ void VivadoTCLGenerator::requirePart() const {
 }
 
 void VivadoTCLGenerator::writeSynthTcl(const std::string& outputDir) {
+    const std::string tclPath = outputDir + "/" + SYNTH_TCL_NAME;
+    std::ofstream out(tclPath);
+    if (!out) {
+        panic("Failed to open synth.tcl for writing: {}", tclPath);
+    }
+
+    generateSynthTcl(outputDir, out);
+}
+
+void VivadoTCLGenerator::generateSynthTcl(const std::string& outputDir,
+                                          std::ostream& out) {
     requireTop();
     requirePart();
 
@@ -60,17 +71,11 @@ void VivadoTCLGenerator::writeSynthTcl(const std::string& outputDir) {
     VivadoPaths::getFilesTclPath(_manager, _target, filesTclPath);
 
     std::string synthDcpPath;
-    VivadoPaths::getSynthCheckpoint(_manager, synthDcpPath);
+    VivadoPaths::getSynthCheckpoint(_manager, _target, synthDcpPath);
 
-    const std::string tclPath = outputDir + "/" + SYNTH_TCL_NAME;
     const std::string utilReportPath = outputDir + "/" + SYNTH_REPORT_UTIL;
     const std::string timingReportPath = outputDir + "/" + SYNTH_REPORT_TIMING;
 
-    std::ofstream out(tclPath);
-    if (!out) {
-        panic("Failed to open synth.tcl for writing: {}", tclPath);
-    }
-
     out << TCL_BANNER;
     out << "# Vivado synthesis script for target '"
         << _target->getName() << "'\n\n";
@@ -91,33 +96,46 @@ void VivadoTCLGenerator::writeSynthTcl(const std::string& outputDir) {
 }
 
 void VivadoTCLGenerator::writeImplTcl(const std::string& outputDir) {
+    const std::string tclPath = outputDir + "/" + IMPL_TCL_NAME;
+    std::ofstream out(tclPath);
+    if (!out) {
+        panic("Failed to open impl.tcl for writing: {}", tclPath);
+    }
+
+    generateImplTcl(outputDir, out);
+}
+
+void VivadoTCLGenerator::generateImplTcl(const std::string& outputDir,
+                                         std::ostream& out) {
+    std::string constraintsTclPath;
+    VivadoPaths::getConstraintsTclPath(_manager, _target, constraintsTclPath);
+
     std::string synthDcpPath;
-    VivadoPaths::getSynthCheckpoint(_manager, synthDcpPath);
+    VivadoPaths::getSynthCheckpoint(_manager, _target, synthDcpPath);
 
     std::string implDcpPath;
-    VivadoPaths::getImplCheckpoint(_manager, implDcpPath);
+    VivadoPaths::getImplCheckpoint(_manager, _target, implDcpPath);
 
-    const std::string tclPath = outputDir + "/" + IMPL_TCL_NAME;
     const std::string utilReportPath = outputDir + "/" + IMPL_REPORT_UTIL;
     const std::string timingReportPath = outputDir + "/" + IMPL_REPORT_TIMING;
     const std::string drcReportPath = outputDir + "/" + IMPL_REPORT_DRC;
 
-    std::ofstream out(tclPath);
-    if (!out) {
-        panic("Failed to open impl.tcl for writing: {}", tclPath);
-    }
-
     out << TCL_BANNER;
     out << "# Vivado implementation script for target '"
         << _target->getName() << "'\n\n";
 
-    out << "set sg_synth_dcp " << synthDcpPath      << "\n";
-    out << "set sg_impl_dcp  " << implDcpPath       << "\n";
-    out << "set sg_util      " << utilReportPath    << "\n";
-    out << "set sg_tim       " << timingReportPath  << "\n";
-    out << "set sg_drc       " << drcReportPath     << "\n\n";
+    out << "set sg_synth_dcp   " << synthDcpPath       << "\n";
+    out << "set sg_impl_dcp    " << implDcpPath        << "\n";
+    out << "set sg_constraints " << constraintsTclPath << "\n";
+    out << "set sg_util        " << utilReportPath     << "\n";
+    out << "set sg_tim         " << timingReportPath   << "\n";
+    out << "set sg_drc         " << drcReportPath      << "\n\n";
 
+    // Implementation-only constraints are read here rather than before
+    // synthesis, so that editing them does not invalidate the
+    // synthesized checkpoint.
     out << "open_checkpoint $sg_synth_dcp\n";
+    out << "source $sg_constraints\n";
     out << "opt_design\n";
     out << "place_design\n";
     out << "phys_opt_design\n";
@@ -129,20 +147,25 @@ void VivadoTCLGenerator::writeImplTcl(const std::string& outputDir) {
 }
 
 void VivadoTCLGenerator::writeBitstreamTcl(const std::string& outputDir) {
+    const std::string tclPath = outputDir + "/" + BITSTREAM_TCL_NAME;
+    std::ofstream out(tclPath);
+    if (!out) {
+        panic("Failed to open bitstream.tcl for writing: {}", tclPath);
+    }
+
+    generateBitstreamTcl(outputDir, out);
+}
+
+void VivadoTCLGenerator::generateBitstreamTcl(const std::string& outputDir,
+                                              std::ostream& out) {
     requireTop();
 
     std::string implDcpPath;
-    VivadoPaths::getImplCheckpoint(_manager, implDcpPath);
+    VivadoPaths::getImplCheckpoint(_manager, _target, implDcpPath);
 
-    const std::string tclPath = outputDir + "/" + BITSTREAM_TCL_NAME;
     const std::string bitPath =
         outputDir + "/" + _target->getTopModule() + BITSTREAM_EXTENSION;
 
-    std::ofstream out(tclPath);
-    if (!out) {
-        panic("Failed to open bitstream.tcl for writing: {}", tclPath);
-    }
-
     out << TCL_BANNER;
     out << "# Vivado bitstream script for target '"
         << _target->getName() << "'\n\n";
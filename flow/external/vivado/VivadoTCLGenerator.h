@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ostream>
 #include <string>
 
 namespace stargate {
@@ -16,6 +17,11 @@ public:
     void writeImplTcl(const std::string& outputDir);
     void writeBitstreamTcl(const std::string& outputDir);
 
+    // Same scripts, written to out. Task fingerprints hash them.
+    void generateSynthTcl(const std::string& outputDir, std::ostream& out);
+    void generateImplTcl(const std::string& outputDir, std::ostream& out);
+    void generateBitstreamTcl(const std::string& outputDir, std::ostream& out);
+
 private:
     const FlowManager* _manager {nullptr};
     const ProjectTarget* _target {nullptr};
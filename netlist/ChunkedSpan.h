@@ -0,0 +1,182 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <span>
+
+#include "Panic.h"
+
+namespace stargate {
+
+// View over the objects of one kind that belong to a design, a bus or
+// an instance. The objects themselves are owned by NetlistSpace pools;
+// each chunk is a contiguous range of one space. A freshly built
+// object has a single chunk, and every later space that adds to it
+// appends one more. Once MaxChunks is reached the owner has to be
+// compacted before it can grow again.
+template <typename T, size_t MaxChunks = 3>
+class ChunkedSpan {
+public:
+    class Iterator {
+    public:
+        using value_type = T;
+        using reference = T&;
+        using pointer = T*;
+        using difference_type = ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const ChunkedSpan* span, size_t chunk, size_t index)
+            : _span(span),
+            _chunk(chunk),
+            _index(index)
+        {
+            skipEmpty();
+        }
+
+        reference operator*() const { return _span->_chunks[_chunk][_index]; }
+        pointer operator->() const { return &**this; }
+
+        Iterator& operator++() {
+            _index++;
+            skipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return _chunk == other._chunk && _index == other._index;
+        }
+
+    private:
+        const ChunkedSpan* _span {nullptr};
+        size_t _chunk {0};
+        size_t _index {0};
+
+        void skipEmpty() {
+            while (_chunk < _span->_numChunks
+                   && _index == _span->_chunks[_chunk].size()) {
+                _chunk++;
+                _index = 0;
+            }
+        }
+    };
+
+    ChunkedSpan() = default;
+    explicit ChunkedSpan(std::span<T> chunk) { append(chunk); }
+
+    // A full span must be compacted first: appending to it panics.
+    void append(std::span<T> chunk) {
+        if (chunk.empty()) {
+            return;
+        }
+        if (isFull()) {
+            panic("appending to a full chunked span");
+        }
+        _chunks[_numChunks++] = chunk;
+    }
+
+    template <typename F>
+    void forEach(F&& func) const {
+        if (_numChunks >= 1) {
+            for (T& e : _chunks[0]) {
+                func(e);
+            }
+        }
+        if constexpr (MaxChunks >= 2) {
+            if (_numChunks >= 2) {
+                for (T& e : _chunks[1]) {
+                    func(e);
+                }
+            }
+        }
+        if constexpr (MaxChunks >= 3) {
+            if (_numChunks >= 3) {
+                for (T& e : _chunks[2]) {
+                    func(e);
+                }
+            }
+        }
+        for (size_t i = 3; i < _numChunks; i++) {
+            for (T& e : _chunks[i]) {
+                func(e);
+            }
+        }
+    }
+
+    Iterator begin() const { return Iterator(this, 0, 0); }
+    Iterator end() const { return Iterator(this, _numChunks, 0); }
+
+    size_t size() const {
+        size_t count = 0;
+        for (size_t i = 0; i < _numChunks; i++) {
+            count += _chunks[i].size();
+        }
+        return count;
+    }
+
+    bool empty() const { return _numChunks == 0; }
+
+    // Element i in iteration order. Linear in the number of chunks.
+    T& operator[](size_t i) const {
+        size_t chunk = 0;
+        while (i >= _chunks[chunk].size()) {
+            i -= _chunks[chunk].size();
+            chunk++;
+        }
+        return _chunks[chunk][i];
+    }
+
+    // Position of the object at address object in iteration order, or
+    // size() if it is not in the span. Linear in the number of chunks.
+    size_t indexOf(const void* object) const {
+        const T* p = static_cast<const T*>(object);
+        size_t index = 0;
+        for (size_t i = 0; i < _numChunks; i++) {
+            const T* first = _chunks[i].data();
+            if (p >= first && p < first + _chunks[i].size()) {
+                return index + static_cast<size_t>(p - first);
+            }
+            index += _chunks[i].size();
+        }
+        return index;
+    }
+
+    size_t getNumChunks() const { return _numChunks; }
+    std::span<T> getChunk(size_t i) const { return _chunks[i]; }
+
+    bool isFull() const { return _numChunks == MaxChunks; }
+    bool needsCompaction() const { return isFull(); }
+
+    // Direct access for the single-chunk case, which is guaranteed for
+    // the terms of primitive instances.
+    bool isSingleChunk() const { return _numChunks <= 1; }
+    T* data() const { return _chunks[0].data(); }
+
+    void clear() { _numChunks = 0; }
+
+    // Points each chunk at func(data, size) instead, for moving the
+    // objects of a netlist image. Unused chunks are reset.
+    template <typename F>
+    void relocate(F&& func) {
+        for (size_t i = 0; i < MaxChunks; i++) {
+            if (i < _numChunks) {
+                _chunks[i] = std::span<T>(func(_chunks[i].data(), _chunks[i].size()),
+                                          _chunks[i].size());
+            } else {
+                _chunks[i] = std::span<T>();
+            }
+        }
+    }
+
+private:
+    std::array<std::span<T>, MaxChunks> _chunks;
+    uint8_t _numChunks {0};
+};
+
+}
@@ -0,0 +1,824 @@
+#include "Compactor.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Design.h"
+#include "Library.h"
+#include "Netlist.h"
+#include "NetlistSpace.h"
+#include "ThreadPool.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+// Finds the space of an object by address.
+class SpaceMap {
+public:
+    explicit SpaceMap(const Netlist* netlist) {
+        for (size_t s = 0; s < netlist->getNumSpaces(); s++) {
+            netlist->getSpace(s)->forEachPool([&](auto objects) {
+                if (objects.empty()) {
+                    return;
+                }
+                const uintptr_t begin = reinterpret_cast<uintptr_t>(objects.data());
+                _ranges.push_back({begin, begin + objects.size_bytes(),
+                                   netlist->getSpace(s)});
+            });
+        }
+        std::sort(_ranges.begin(), _ranges.end(),
+                  [](const Range& a, const Range& b) { return a.begin < b.begin; });
+    }
+
+    const NetlistSpace* getSpace(const void* object) const {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(object);
+        const auto lessBegin = [](uintptr_t a, const Range& r) { return a < r.begin; };
+        auto it = std::upper_bound(_ranges.begin(), _ranges.end(), address, lessBegin);
+        if (it == _ranges.begin() || address >= (--it)->end) {
+            panic("object outside of the netlist spaces");
+        }
+        return it->space;
+    }
+
+private:
+    struct Range {
+        uintptr_t begin {0};
+        uintptr_t end {0};
+        const NetlistSpace* space {nullptr};
+    };
+
+    std::vector<Range> _ranges;
+};
+
+// Calls func on every span of the objects of design, nested ones
+// included.
+template <typename F>
+void forEachSpan(const Design* design, F&& func) {
+    const auto netSpans = [&](const BitNet& net) {
+        func(net.connectedInstTerms);
+        func(net.connectedDesignTerms);
+    };
+
+    func(design->scalarNets);
+    design->scalarNets.forEach(netSpans);
+    func(design->busNets);
+    design->busNets.forEach([&](const BusNet& bus) {
+        func(bus.bits);
+        bus.bits.forEach(netSpans);
+    });
+
+    func(design->scalarDesignTerms);
+    func(design->busDesignTerms);
+    design->busDesignTerms.forEach([&](const BusDesignTerm& bus) { func(bus.bits); });
+
+    func(design->instances);
+    design->instances.forEach([&](const Instance& instance) {
+        func(instance.scalarInstTerms);
+        func(instance.busInstTerms);
+        instance.busInstTerms.forEach([&](const BusInstTerm& bus) { func(bus.bits); });
+    });
+}
+
+struct DesignLayout {
+    // Bytes of the design in each space it is in.
+    std::vector<std::pair<const NetlistSpace*, size_t>> spaces;
+    size_t numChunks {0};
+    size_t numSpans {0};
+    bool hasFullSpan {false};
+};
+
+void getDesignLayout(const Design* design,
+                     const SpaceMap& spaceMap,
+                     DesignLayout& layout) {
+    const auto addBytes = [&](const void* object, size_t bytes) {
+        const NetlistSpace* space = spaceMap.getSpace(object);
+        for (auto& [s, spaceBytes] : layout.spaces) {
+            if (s == space) {
+                spaceBytes += bytes;
+                return;
+            }
+        }
+        layout.spaces.emplace_back(space, bytes);
+    };
+
+    addBytes(design, sizeof(Design));
+    forEachSpan(design, [&](const auto& span) {
+        if (span.empty()) {
+            return;
+        }
+        layout.numSpans++;
+        layout.numChunks += span.getNumChunks();
+        layout.hasFullSpan |= span.isFull();
+        for (size_t i = 0; i < span.getNumChunks(); i++) {
+            addBytes(span.getChunk(i).data(), span.getChunk(i).size_bytes());
+        }
+    });
+}
+
+void getLiveDesigns(const Netlist* netlist, std::vector<Design*>& result) {
+    result.clear();
+    for (const Library* library : netlist->getLibraries()) {
+        const std::span<Design* const> libraryDesigns = library->getDesigns();
+        result.insert(result.end(), libraryDesigns.begin(), libraryDesigns.end());
+    }
+}
+
+}
+
+// The live designs and where their objects are. The design layouts
+// belong to the LiveLayout of the compactor and are valid until its
+// next analysis.
+struct Compactor::NetlistLayout {
+    std::vector<Design*> designs;
+    std::vector<const DesignLayout*> designLayouts;
+    std::vector<size_t> spaceBytes;
+    std::vector<size_t> spaceLiveBytes;
+    FragmentationReport report;
+};
+
+// Layouts of the live designs as of the last analysis, and their sums.
+// The objects of a design do not change once it is built, so a design
+// still live is not walked again.
+struct Compactor::LiveLayout {
+    struct Entry {
+        DesignLayout layout;
+        uint64_t generation {0};
+    };
+
+    std::unordered_map<const Design*, Entry> designs;
+    uint64_t generation {0};
+    // Spaces of the netlist at the last analysis. A design is only
+    // freed with its space: when one of these is gone, an address may
+    // have been reused and the layouts are dropped.
+    std::vector<const NetlistSpace*> spaces;
+
+    std::unordered_map<const NetlistSpace*, size_t> spaceLiveBytes;
+    size_t liveBytes {0};
+    size_t numChunks {0};
+    size_t numSpans {0};
+    size_t numDesignSpaces {0};
+
+    void add(const DesignLayout& layout) {
+        for (const auto& [space, bytes] : layout.spaces) {
+            spaceLiveBytes[space] += bytes;
+            liveBytes += bytes;
+        }
+        numChunks += layout.numChunks;
+        numSpans += layout.numSpans;
+        numDesignSpaces += layout.spaces.size();
+    }
+
+    void remove(const DesignLayout& layout) {
+        for (const auto& [space, bytes] : layout.spaces) {
+            const auto it = spaceLiveBytes.find(space);
+            if ((it->second -= bytes) == 0) {
+                spaceLiveBytes.erase(it);
+            }
+            liveBytes -= bytes;
+        }
+        numChunks -= layout.numChunks;
+        numSpans -= layout.numSpans;
+        numDesignSpaces -= layout.spaces.size();
+    }
+
+    void clear() {
+        designs.clear();
+        spaces.clear();
+        spaceLiveBytes.clear();
+        liveBytes = 0;
+        numChunks = 0;
+        numSpans = 0;
+        numDesignSpaces = 0;
+    }
+};
+
+void Compactor::analyzeLayout(NetlistLayout& layout) const {
+    LiveLayout* live = _live.get();
+    const size_t numSpaces = _netlist->getNumSpaces();
+    bool spacesKept = live->spaces.size() <= numSpaces;
+    for (size_t s = 0; spacesKept && s < live->spaces.size(); s++) {
+        spacesKept = live->spaces[s] == _netlist->getSpace(s);
+    }
+    if (!spacesKept) {
+        live->clear();
+    }
+    for (size_t s = live->spaces.size(); s < numSpaces; s++) {
+        live->spaces.push_back(_netlist->getSpace(s));
+    }
+
+    getLiveDesigns(_netlist, layout.designs);
+    layout.designLayouts.resize(layout.designs.size());
+
+    const uint64_t generation = ++live->generation;
+    std::vector<std::pair<const Design*, DesignLayout*>> added;
+    for (size_t i = 0; i < layout.designs.size(); i++) {
+        const auto [it, inserted] = live->designs.try_emplace(layout.designs[i]);
+        it->second.generation = generation;
+        layout.designLayouts[i] = &it->second.layout;
+        if (inserted) {
+            added.emplace_back(layout.designs[i], &it->second.layout);
+        }
+    }
+
+    // Every live design has an entry: there are more only when some
+    // are not live anymore.
+    if (live->designs.size() > layout.designs.size()) {
+        for (auto it = live->designs.begin(); it != live->designs.end();) {
+            if (it->second.generation != generation) {
+                live->remove(it->second.layout);
+                it = live->designs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (!added.empty()) {
+        const SpaceMap spaceMap(_netlist);
+        _pool->parallelFor(added.size(), [&](size_t i) {
+            getDesignLayout(added[i].first, spaceMap, *added[i].second);
+        });
+        for (const auto& [design, designLayout] : added) {
+            live->add(*designLayout);
+        }
+    }
+
+    FragmentationReport& report = layout.report;
+    report.numSpaces = numSpaces;
+    report.numDesigns = layout.designs.size();
+    report.liveBytes = live->liveBytes;
+    report.numChunks = live->numChunks;
+    report.numSpans = live->numSpans;
+    report.numDesignSpaces = live->numDesignSpaces;
+    layout.spaceBytes.resize(numSpaces);
+    layout.spaceLiveBytes.assign(numSpaces, 0);
+    for (size_t s = 0; s < numSpaces; s++) {
+        const NetlistSpace* space = _netlist->getSpace(s);
+        layout.spaceBytes[s] = space->getMemoryUsage();
+        report.allocatedBytes += layout.spaceBytes[s];
+        if (const auto it = live->spaceLiveBytes.find(space);
+            it != live->spaceLiveBytes.end()) {
+            layout.spaceLiveBytes[s] = it->second;
+        }
+    }
+}
+
+namespace {
+
+// Number of objects of each pool a design needs.
+struct DesignCounts {
+    size_t scalarNets {0};
+    size_t busNets {0};
+    size_t busNetBits {0};
+    size_t scalarDesignTerms {0};
+    size_t busDesignTerms {0};
+    size_t busDesignTermBits {0};
+    size_t instances {0};
+    size_t scalarInstTerms {0};
+    size_t busInstTerms {0};
+    size_t busInstTermBits {0};
+    size_t instTermRefs {0};
+    size_t designTermRefs {0};
+};
+
+DesignCounts countObjects(const Design* design) {
+    DesignCounts counts;
+    counts.scalarNets = design->scalarNets.size();
+    counts.busNets = design->busNets.size();
+    design->busNets.forEach([&](const BusNet& bus) {
+        counts.busNetBits += bus.bits.size();
+    });
+
+    // Connection lists are rebuilt from the terms.
+    const auto countDesignTerm = [&](const BitDesignTerm& term) {
+        counts.designTermRefs += term.connectedNet != nullptr;
+    };
+    const auto countInstTerm = [&](const BitInstTerm& term) {
+        counts.instTermRefs += term.connectedNet != nullptr;
+    };
+
+    counts.scalarDesignTerms = design->scalarDesignTerms.size();
+    design->scalarDesignTerms.forEach(countDesignTerm);
+    counts.busDesignTerms = design->busDesignTerms.size();
+    design->busDesignTerms.forEach([&](const BusDesignTerm& bus) {
+        counts.busDesignTermBits += bus.bits.size();
+        bus.bits.forEach(countDesignTerm);
+    });
+
+    counts.instances = design->instances.size();
+    design->instances.forEach([&](const Instance& instance) {
+        counts.scalarInstTerms += instance.scalarInstTerms.size();
+        instance.scalarInstTerms.forEach(countInstTerm);
+        counts.busInstTerms += instance.busInstTerms.size();
+        instance.busInstTerms.forEach([&](const BusInstTerm& bus) {
+            counts.busInstTermBits += bus.bits.size();
+            bus.bits.forEach(countInstTerm);
+        });
+    });
+    return counts;
+}
+
+// Ranges of the new space a design is copied to.
+struct DesignRanges {
+    Design* design {nullptr};
+    std::span<ScalarNet> scalarNets;
+    std::span<BusNet> busNets;
+    std::span<BusNetBit> busNetBits;
+    std::span<ScalarDesignTerm> scalarDesignTerms;
+    std::span<BusDesignTerm> busDesignTerms;
+    std::span<BusDesignTermBit> busDesignTermBits;
+    std::span<Instance> instances;
+    std::span<ScalarInstTerm> scalarInstTerms;
+    std::span<BusInstTerm> busInstTerms;
+    std::span<BusInstTermBit> busInstTermBits;
+    std::span<BitInstTerm*> instTermRefs;
+    std::span<BitDesignTerm*> designTermRefs;
+};
+
+void reserveSpace(NetlistSpace* space, const std::vector<DesignCounts>& counts) {
+    DesignCounts total;
+    for (const DesignCounts& c : counts) {
+        total.scalarNets += c.scalarNets;
+        total.busNets += c.busNets;
+        total.busNetBits += c.busNetBits;
+        total.scalarDesignTerms += c.scalarDesignTerms;
+        total.busDesignTerms += c.busDesignTerms;
+        total.busDesignTermBits += c.busDesignTermBits;
+        total.instances += c.instances;
+        total.scalarInstTerms += c.scalarInstTerms;
+        total.busInstTerms += c.busInstTerms;
+        total.busInstTermBits += c.busInstTermBits;
+        total.instTermRefs += c.instTermRefs;
+        total.designTermRefs += c.designTermRefs;
+    }
+
+    space->reserve<Design>(counts.size());
+    space->reserve<ScalarNet>(total.scalarNets);
+    space->reserve<BusNet>(total.busNets);
+    space->reserve<BusNetBit>(total.busNetBits);
+    space->reserve<ScalarDesignTerm>(total.scalarDesignTerms);
+    space->reserve<BusDesignTerm>(total.busDesignTerms);
+    space->reserve<BusDesignTermBit>(total.busDesignTermBits);
+    space->reserve<Instance>(total.instances);
+    space->reserve<ScalarInstTerm>(total.scalarInstTerms);
+    space->reserve<BusInstTerm>(total.busInstTerms);
+    space->reserve<BusInstTermBit>(total.busInstTermBits);
+    space->reserve<BitInstTerm*>(total.instTermRefs);
+    space->reserve<BitDesignTerm*>(total.designTermRefs);
+}
+
+DesignRanges allocateRanges(NetlistSpace* space, const DesignCounts& counts) {
+    DesignRanges ranges;
+    ranges.design = space->allocate<Design>(1).data();
+    ranges.scalarNets = space->allocate<ScalarNet>(counts.scalarNets);
+    ranges.busNets = space->allocate<BusNet>(counts.busNets);
+    ranges.busNetBits = space->allocate<BusNetBit>(counts.busNetBits);
+    ranges.scalarDesignTerms =
+        space->allocate<ScalarDesignTerm>(counts.scalarDesignTerms);
+    ranges.busDesignTerms = space->allocate<BusDesignTerm>(counts.busDesignTerms);
+    ranges.busDesignTermBits =
+        space->allocate<BusDesignTermBit>(counts.busDesignTermBits);
+    ranges.instances = space->allocate<Instance>(counts.instances);
+    ranges.scalarInstTerms = space->allocate<ScalarInstTerm>(counts.scalarInstTerms);
+    ranges.busInstTerms = space->allocate<BusInstTerm>(counts.busInstTerms);
+    ranges.busInstTermBits = space->allocate<BusInstTermBit>(counts.busInstTermBits);
+    ranges.instTermRefs = space->allocate<BitInstTerm*>(counts.instTermRefs);
+    ranges.designTermRefs = space->allocate<BitDesignTerm*>(counts.designTermRefs);
+    return ranges;
+}
+
+// Position of object in objects, or objects.size() if it is not there.
+template <typename T>
+size_t getPosition(std::span<T> objects, const void* object) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(object);
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(objects.data());
+    if (address < begin || address >= begin + objects.size_bytes()) {
+        return objects.size();
+    }
+    return (address - begin) / sizeof(T);
+}
+
+// Copies one design into its ranges. The models of the instances are
+// left to the caller, since they may move too.
+class DesignCopier {
+public:
+    DesignCopier(const Design* from, const DesignRanges& to)
+        : _from(from),
+        _to(to),
+        _design(to.design)
+    {
+    }
+
+    void run() {
+        *_design = *_from;
+        copyNets();
+        copyDesignTerms();
+        copyInstances();
+        buildConnections();
+    }
+
+private:
+    const Design* _from {nullptr};
+    const DesignRanges& _to;
+    Design* _design {nullptr};
+
+    void copyNets() {
+        size_t n = 0;
+        _from->scalarNets.forEach([&](const ScalarNet& net) {
+            ScalarNet& copy = _to.scalarNets[n++];
+            copy = net;
+            copy.parent = _design;
+        });
+        _design->scalarNets = ChunkedSpan<ScalarNet>(_to.scalarNets);
+
+        size_t b = 0;
+        size_t firstBit = 0;
+        _from->busNets.forEach([&](const BusNet& bus) {
+            BusNet& copy = _to.busNets[b++];
+            copy = bus;
+            copy.parent = _design;
+
+            const std::span<BusNetBit> bits =
+                _to.busNetBits.subspan(firstBit, bus.bits.size());
+            firstBit += bits.size();
+            size_t i = 0;
+            bus.bits.forEach([&](const BusNetBit& bit) {
+                BusNetBit& bitCopy = bits[i++];
+                bitCopy = bit;
+                bitCopy.parent = _design;
+                bitCopy.bus = &copy;
+            });
+            copy.bits = ChunkedSpan<BusNetBit>(bits);
+        });
+        _design->busNets = ChunkedSpan<BusNet>(_to.busNets);
+    }
+
+    BitNet* mapNet(const BitNet* net) const {
+        if (!net) {
+            return nullptr;
+        }
+        const size_t scalarIndex = _from->scalarNets.indexOf(net);
+        if (scalarIndex < _to.scalarNets.size()) {
+            return &_to.scalarNets[scalarIndex];
+        }
+
+        const BusNetBit* bit = static_cast<const BusNetBit*>(net);
+        const size_t busIndex = _from->busNets.indexOf(bit->bus);
+        if (busIndex == _to.busNets.size()) {
+            panic("term connected to a net of another design");
+        }
+        return &_to.busNets[busIndex].bits[bit->bus->bits.indexOf(bit)];
+    }
+
+    void copyDesignTerms() {
+        size_t n = 0;
+        _from->scalarDesignTerms.forEach([&](const ScalarDesignTerm& term) {
+            ScalarDesignTerm& copy = _to.scalarDesignTerms[n++];
+            copy = term;
+            copy.parent = _design;
+            copy.connectedNet = mapNet(term.connectedNet);
+        });
+        _design->scalarDesignTerms = ChunkedSpan<ScalarDesignTerm>(_to.scalarDesignTerms);
+
+        size_t b = 0;
+        size_t firstBit = 0;
+        _from->busDesignTerms.forEach([&](const BusDesignTerm& bus) {
+            BusDesignTerm& copy = _to.busDesignTerms[b++];
+            copy = bus;
+            copy.parent = _design;
+
+            const std::span<BusDesignTermBit> bits =
+                _to.busDesignTermBits.subspan(firstBit, bus.bits.size());
+            firstBit += bits.size();
+            size_t i = 0;
+            bus.bits.forEach([&](const BusDesignTermBit& bit) {
+                BusDesignTermBit& bitCopy = bits[i++];
+                bitCopy = bit;
+                bitCopy.parent = _design;
+                bitCopy.bus = &copy;
+                bitCopy.connectedNet = mapNet(bit.connectedNet);
+            });
+            copy.bits = ChunkedSpan<BusDesignTermBit>(bits);
+        });
+        _design->busDesignTerms = ChunkedSpan<BusDesignTerm>(_to.busDesignTerms);
+    }
+
+    void copyInstances() {
+        size_t n = 0;
+        size_t firstScalar = 0;
+        size_t firstBus = 0;
+        size_t firstBit = 0;
+        _from->instances.forEach([&](const Instance& instance) {
+            Instance& copy = _to.instances[n++];
+            copy = instance;
+            copy.parent = _design;
+
+            const std::span<ScalarInstTerm> terms =
+                _to.scalarInstTerms.subspan(firstScalar, instance.scalarInstTerms.size());
+            firstScalar += terms.size();
+            size_t i = 0;
+            instance.scalarInstTerms.forEach([&](const ScalarInstTerm& term) {
+                ScalarInstTerm& termCopy = terms[i++];
+                termCopy = term;
+                termCopy.instance = &copy;
+                termCopy.connectedNet = mapNet(term.connectedNet);
+            });
+            copy.scalarInstTerms = ChunkedSpan<ScalarInstTerm>(terms);
+
+            const std::span<BusInstTerm> buses =
+                _to.busInstTerms.subspan(firstBus, instance.busInstTerms.size());
+            firstBus += buses.size();
+            i = 0;
+            instance.busInstTerms.forEach([&](const BusInstTerm& bus) {
+                BusInstTerm& busCopy = buses[i++];
+                busCopy = bus;
+                busCopy.instance = &copy;
+
+                const std::span<BusInstTermBit> bits =
+                    _to.busInstTermBits.subspan(firstBit, bus.bits.size());
+                firstBit += bits.size();
+                size_t j = 0;
+                bus.bits.forEach([&](const BusInstTermBit& bit) {
+                    BusInstTermBit& bitCopy = bits[j++];
+                    bitCopy = bit;
+                    bitCopy.instance = &copy;
+                    bitCopy.bus = &busCopy;
+                    bitCopy.connectedNet = mapNet(bit.connectedNet);
+                });
+                busCopy.bits = ChunkedSpan<BusInstTermBit>(bits);
+            });
+            copy.busInstTerms = ChunkedSpan<BusInstTerm>(buses);
+        });
+        _design->instances = ChunkedSpan<Instance>(_to.instances);
+    }
+
+    // Dense index of a copied net: scalar nets, then bus bits.
+    size_t getNetIndex(const BitNet* net) const {
+        const size_t scalarIndex = getPosition(_to.scalarNets, net);
+        if (scalarIndex < _to.scalarNets.size()) {
+            return scalarIndex;
+        }
+        return _to.scalarNets.size() + getPosition(_to.busNetBits, net);
+    }
+
+    BitNet* getNet(size_t index) const {
+        if (index < _to.scalarNets.size()) {
+            return &_to.scalarNets[index];
+        }
+        return &_to.busNetBits[index - _to.scalarNets.size()];
+    }
+
+    // Gives each net one contiguous range of references, in term order
+    // as the NetlistBuilder does.
+    void buildConnections() {
+        const size_t numNets = _to.scalarNets.size() + _to.busNetBits.size();
+        std::vector<uint32_t> instTermCounts(numNets, 0);
+        std::vector<uint32_t> designTermCounts(numNets, 0);
+
+        const auto forEachInstTerm = [&](auto&& func) {
+            for (ScalarInstTerm& term : _to.scalarInstTerms) {
+                func(term);
+            }
+            for (BusInstTermBit& bit : _to.busInstTermBits) {
+                func(bit);
+            }
+        };
+        const auto forEachDesignTerm = [&](auto&& func) {
+            for (ScalarDesignTerm& term : _to.scalarDesignTerms) {
+                func(term);
+            }
+            for (BusDesignTermBit& bit : _to.busDesignTermBits) {
+                func(bit);
+            }
+        };
+
+        forEachInstTerm([&](BitInstTerm& term) {
+            if (term.connectedNet) {
+                instTermCounts[getNetIndex(term.connectedNet)]++;
+            }
+        });
+        forEachDesignTerm([&](BitDesignTerm& term) {
+            if (term.connectedNet) {
+                designTermCounts[getNetIndex(term.connectedNet)]++;
+            }
+        });
+
+        size_t firstInstTermRef = 0;
+        size_t firstDesignTermRef = 0;
+        for (size_t i = 0; i < numNets; i++) {
+            BitNet* net = getNet(i);
+            net->connectedInstTerms = ChunkedSpan<BitInstTerm*>(
+                _to.instTermRefs.subspan(firstInstTermRef, instTermCounts[i]));
+            net->connectedDesignTerms = ChunkedSpan<BitDesignTerm*>(
+                _to.designTermRefs.subspan(firstDesignTermRef, designTermCounts[i]));
+            firstInstTermRef += instTermCounts[i];
+            firstDesignTermRef += designTermCounts[i];
+            // Reused below as the number of references filled so far.
+            instTermCounts[i] = 0;
+            designTermCounts[i] = 0;
+        }
+
+        forEachInstTerm([&](BitInstTerm& term) {
+            if (BitNet* net = term.connectedNet) {
+                const size_t index = getNetIndex(net);
+                net->connectedInstTerms.data()[instTermCounts[index]++] = &term;
+            }
+        });
+        forEachDesignTerm([&](BitDesignTerm& term) {
+            if (BitNet* net = term.connectedNet) {
+                const size_t index = getNetIndex(net);
+                net->connectedDesignTerms.data()[designTermCounts[index]++] = &term;
+            }
+        });
+    }
+};
+
+}
+
+Compactor::Compactor(Netlist* netlist, ThreadPool* pool)
+    : _netlist(netlist),
+    _pool(pool),
+    _live(new LiveLayout())
+{
+}
+
+Compactor::~Compactor() {
+}
+
+FragmentationReport Compactor::analyze() const {
+    NetlistLayout layout;
+    analyzeLayout(layout);
+    return layout.report;
+}
+
+bool Compactor::needsCompaction() const {
+    NetlistLayout layout;
+    analyzeLayout(layout);
+    if (layout.report.getLiveRatio() < _minLiveRatio) {
+        return true;
+    }
+    for (const DesignLayout* designLayout : layout.designLayouts) {
+        if (designLayout->hasFullSpan
+            || designLayout->spaces.size() > _maxSpacesPerDesign) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Compactor::needsCompaction(const Design* design) const {
+    DesignLayout layout;
+    getDesignLayout(design, SpaceMap(_netlist), layout);
+    return layout.hasFullSpan || layout.spaces.size() > _maxSpacesPerDesign;
+}
+
+CompactionStats Compactor::compactFull() {
+    std::vector<Design*> designs;
+    getLiveDesigns(_netlist, designs);
+    return compactDesigns(designs);
+}
+
+CompactionStats Compactor::compactDesign(Design* design) {
+    return compactDesigns(std::span<Design* const>(&design, 1));
+}
+
+CompactionStats Compactor::compactIfNeeded() {
+    NetlistLayout layout;
+    analyzeLayout(layout);
+
+    // Spaces whose live objects are worth moving out, so that the
+    // space can be released.
+    std::unordered_set<const NetlistSpace*> sparse;
+    if (layout.report.getLiveRatio() < _minLiveRatio) {
+        for (size_t s = 0; s < layout.spaceBytes.size(); s++) {
+            if (layout.spaceLiveBytes[s] < _minLiveRatio * layout.spaceBytes[s]) {
+                sparse.insert(_netlist->getSpace(s));
+            }
+        }
+    }
+
+    std::vector<Design*> designs;
+    for (size_t i = 0; i < layout.designs.size(); i++) {
+        const DesignLayout& designLayout = *layout.designLayouts[i];
+        bool needed = designLayout.hasFullSpan
+                   || designLayout.spaces.size() > _maxSpacesPerDesign;
+        for (const auto& [space, bytes] : designLayout.spaces) {
+            needed |= sparse.contains(space);
+        }
+        if (needed) {
+            designs.push_back(layout.designs[i]);
+        }
+    }
+
+    if (designs.empty() && layout.report.getLiveRatio() >= _minLiveRatio) {
+        CompactionStats stats;
+        stats.before = layout.report;
+        stats.after = layout.report;
+        return stats;
+    }
+    return compactDesigns(designs);
+}
+
+CompactionStats Compactor::compactDesigns(std::span<Design* const> designs) {
+    CompactionStats stats;
+    {
+        NetlistLayout before;
+        analyzeLayout(before);
+        stats.before = before.report;
+    }
+
+    std::vector<Design*> moving;
+    std::unordered_set<const Design*> seen;
+    for (Design* design : designs) {
+        if (!design->library) {
+            panic("only the designs of a library can be compacted");
+        }
+        // Throws if the design is not live.
+        design->library->getDesignIndex(design);
+        if (seen.insert(design).second) {
+            moving.push_back(design);
+        }
+    }
+
+    std::unordered_map<const Design*, Design*> moved;
+    if (!moving.empty()) {
+        std::vector<DesignCounts> counts(moving.size());
+        _pool->parallelFor(moving.size(), [&](size_t i) {
+            counts[i] = countObjects(moving[i]);
+        });
+
+        NetlistSpace* space = _netlist->createSpace();
+        reserveSpace(space, counts);
+        std::vector<DesignRanges> ranges(moving.size());
+        for (size_t i = 0; i < moving.size(); i++) {
+            ranges[i] = allocateRanges(space, counts[i]);
+        }
+
+        _pool->parallelFor(moving.size(), [&](size_t i) {
+            DesignCopier(moving[i], ranges[i]).run();
+        });
+
+        for (size_t i = 0; i < moving.size(); i++) {
+            moved.emplace(moving[i], ranges[i].design);
+            Library* library = moving[i]->library;
+            library->replaceDesign(library->getDesignIndex(moving[i]), ranges[i].design);
+        }
+        if (const auto it = moved.find(_netlist->_topDesign); it != moved.end()) {
+            _netlist->_topDesign = it->second;
+        }
+
+        // Instances of every live design, moved or not, may have a
+        // moved model.
+        std::vector<Design*> live;
+        getLiveDesigns(_netlist, live);
+        _pool->parallelFor(live.size(), [&](size_t i) {
+            live[i]->instances.forEach([&](Instance& instance) {
+                if (const auto it = moved.find(instance.model); it != moved.end()) {
+                    instance.model = it->second;
+                }
+            });
+        });
+
+        stats.numDesigns = moving.size();
+        stats.bytesMoved = space->getMemoryUsage();
+    }
+
+    // Release the spaces that hold no live object anymore.
+    NetlistLayout after;
+    analyzeLayout(after);
+    std::vector<bool> released(after.spaceBytes.size(), false);
+    size_t bytesReleased = 0;
+    for (size_t s = 0; s < released.size(); s++) {
+        if (after.spaceLiveBytes[s] == 0) {
+            released[s] = true;
+            stats.numSpacesReleased++;
+            bytesReleased += after.spaceBytes[s];
+        }
+    }
+    _netlist->releaseSpaces(released);
+
+    // The released spaces held no live design: the layouts stay valid.
+    _live->spaces.clear();
+    for (size_t s = 0; s < _netlist->getNumSpaces(); s++) {
+        _live->spaces.push_back(_netlist->getSpace(s));
+    }
+
+    // The moved designs took a new space: only what the released
+    // spaces held beyond it is reclaimed.
+    if (bytesReleased > stats.bytesMoved) {
+        stats.bytesReclaimed = bytesReleased - stats.bytesMoved;
+    }
+
+    stats.after = after.report;
+    stats.after.numSpaces -= stats.numSpacesReleased;
+    stats.after.allocatedBytes -= bytesReleased;
+    return stats;
+}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <span>
+
+namespace stargate {
+
+class Netlist;
+class ThreadPool;
+struct Design;
+
+// Layout of the live designs of a netlist, those of its libraries.
+// Every other object of a space is garbage left by a rebuild.
+struct FragmentationReport {
+    size_t numSpaces {0};
+    size_t numDesigns {0};
+    // Bytes of every space, and of the live objects among them.
+    size_t allocatedBytes {0};
+    size_t liveBytes {0};
+    // Chunks of the non-empty spans of live objects, and those spans.
+    size_t numChunks {0};
+    size_t numSpans {0};
+    // Sum over live designs of the number of spaces their objects are
+    // in.
+    size_t numDesignSpaces {0};
+
+    double getLiveRatio() const {
+        return allocatedBytes ? double(liveBytes) / double(allocatedBytes) : 1.0;
+    }
+
+    // 1 when every span is contiguous.
+    double getChunksPerSpan() const {
+        return numSpans ? double(numChunks) / double(numSpans) : 1.0;
+    }
+
+    // 1 when each design lives in a single space.
+    double getSpacesPerDesign() const {
+        return numDesigns ? double(numDesignSpaces) / double(numDesigns) : 1.0;
+    }
+};
+
+struct CompactionStats {
+    size_t numDesigns {0};
+    size_t bytesMoved {0};
+    size_t numSpacesReleased {0};
+    // Bytes of the released spaces less bytesMoved, the net decrease of
+    // allocated bytes: 0 when there was no garbage to drop.
+    size_t bytesReclaimed {0};
+    FragmentationReport before;
+    FragmentationReport after;
+};
+
+// Moves live designs into a new space, each design's objects
+// contiguous per pool, and releases the spaces left without live
+// objects. This merges the chunks of full ChunkedSpans, drops the
+// garbage of rebuilt designs and gathers designs that are spread over
+// many spaces.
+//
+// A pass is incremental: it moves the designs it is given and leaves
+// the others in place, only updating the models of their instances.
+// Designs are copied in parallel on the threads of pool, into ranges
+// reserved up front.
+//
+// The layout of every live design is kept from one analysis to the
+// next, since the objects of a built design do not change: analyze()
+// and compactIfNeeded() only walk the designs built since the last
+// call, such as those rebuilt by a Uniquifier commit.
+//
+// Compaction moves the Design objects themselves: pointers to the
+// moved designs and their objects are invalid afterwards, as are
+// occurrences, FlatNetlists, EquipotentialExplorators and Uniquifiers
+// made before. Nothing else may use the netlist during a pass. The
+// pages of a mapped netlist image stay mapped, since names point into
+// them.
+class Compactor {
+public:
+    Compactor(Netlist* netlist, ThreadPool* pool);
+    ~Compactor();
+
+    // Thresholds of compactIfNeeded(): the live fraction of the bytes
+    // of the spaces below which sparse spaces are evacuated, and the
+    // number of spaces a design may be spread over.
+    void setMinLiveRatio(double ratio) { _minLiveRatio = ratio; }
+    void setMaxSpacesPerDesign(size_t count) { _maxSpacesPerDesign = count; }
+
+    FragmentationReport analyze() const;
+
+    // Whether a span of a live design is full, the live ratio is below
+    // its threshold, or a design is spread over too many spaces.
+    bool needsCompaction() const;
+    // Whether a span of design is full, or it is spread over too many
+    // spaces.
+    bool needsCompaction(const Design* design) const;
+
+    // Every live design.
+    CompactionStats compactFull();
+
+    // Designs must be live; the pointers are invalid afterwards.
+    CompactionStats compactDesign(Design* design);
+    CompactionStats compactDesigns(std::span<Design* const> designs);
+
+    // Compacts the designs that need it, and when the live ratio is
+    // below its threshold, the designs with objects in a space whose
+    // own live ratio is. Does nothing if no threshold is passed.
+    CompactionStats compactIfNeeded();
+
+private:
+    struct NetlistLayout;
+    struct LiveLayout;
+
+    Netlist* _netlist {nullptr};
+    ThreadPool* _pool {nullptr};
+    double _minLiveRatio {0.5};
+    size_t _maxSpacesPerDesign {4};
+    std::unique_ptr<LiveLayout> _live;
+
+    void analyzeLayout(NetlistLayout& layout) const;
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChunkedSpan.h"
+#include "DesignTerm.h"
+#include "Instance.h"
+#include "Net.h"
+#include "NetlistIDs.h"
+#include "PrimitiveKind.h"
+
+namespace stargate {
+
+class Library;
+
+// A design and the views over its objects. The objects live in the
+// pools of one or more NetlistSpaces; the design only refers to them.
+struct Design {
+    DesignID id;
+    NameID name;
+    Library* library {nullptr};
+    uint32_t flags {0};
+    // Set on the designs of the PrimitiveLibrary, and copied into the
+    // flags of their instances.
+    PrimitiveKind primitiveKind {PrimitiveKind::None};
+
+    ChunkedSpan<ScalarNet> scalarNets;
+    ChunkedSpan<BusNet> busNets;
+
+    ChunkedSpan<ScalarDesignTerm> scalarDesignTerms;
+    ChunkedSpan<BusDesignTerm> busDesignTerms;
+
+    ChunkedSpan<Instance> instances;
+
+    static constexpr uint32_t FLAG_PRIMITIVE = 1 << 0;
+
+    bool isPrimitive() const { return flags & FLAG_PRIMITIVE; }
+
+    void setPrimitive(bool primitive) {
+        if (primitive) {
+            flags |= FLAG_PRIMITIVE;
+        } else {
+            flags &= ~FLAG_PRIMITIVE;
+        }
+    }
+};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChunkedSpan.h"
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+struct BitNet;
+struct BusDesignTerm;
+struct Design;
+
+// Port of a design, at the bit level. A term connects to at most one
+// net of its design.
+struct BitDesignTerm {
+    DesignTermID id;
+    Design* parent {nullptr};
+    Direction direction {Direction::Input};
+    BitNet* connectedNet {nullptr};
+};
+
+struct ScalarDesignTerm : BitDesignTerm {
+    NameID name;
+};
+
+struct BusDesignTermBit : BitDesignTerm {
+    BusDesignTerm* bus {nullptr};
+    uint32_t index {0};
+};
+
+struct BusDesignTerm {
+    DesignTermID id;
+    NameID name;
+    Design* parent {nullptr};
+    Direction direction {Direction::Input};
+    int32_t msb {0};
+    int32_t lsb {0};
+    ChunkedSpan<BusDesignTermBit> bits;
+};
+
+}
@@ -0,0 +1,521 @@
+#include "EquipotentialExplorator.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Design.h"
+#include "Library.h"
+#include "Netlist.h"
+#include "NetlistSpace.h"
+#include "ThreadPool.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+constexpr uint32_t NO_VALUE = UINT32_MAX;
+
+bool canDrive(Direction direction) {
+    return direction != Direction::Input;
+}
+
+bool canLoad(Direction direction) {
+    return direction != Direction::Output;
+}
+
+// A port of a design seen from inside it: an input drives its net.
+Direction getInnerDirection(Direction direction) {
+    switch (direction) {
+    case Direction::Input:
+        return Direction::Output;
+    case Direction::Output:
+        return Direction::Input;
+    case Direction::InOut:
+        return Direction::InOut;
+    }
+    return direction;
+}
+
+// Whether a term with role direction is reported when exploring in dir.
+bool isReported(Direction direction, ExploreDirection dir) {
+    switch (dir) {
+    case ExploreDirection::Bidirectional:
+        return true;
+    case ExploreDirection::ToLoads:
+        return canLoad(direction);
+    case ExploreDirection::ToDrivers:
+        return canDrive(direction);
+    }
+    return true;
+}
+
+// Whether an exploration in dir may start from a term with role
+// direction.
+bool canStart(Direction direction, ExploreDirection dir) {
+    switch (dir) {
+    case ExploreDirection::Bidirectional:
+        return true;
+    case ExploreDirection::ToLoads:
+        return canDrive(direction);
+    case ExploreDirection::ToDrivers:
+        return canLoad(direction);
+    }
+    return true;
+}
+
+// Design term that an instance term stands for, in the model.
+BitDesignTerm* getModelTerm(const BitInstTerm* term) {
+    const Instance* instance = term->instance;
+    const size_t scalarIndex = instance->scalarInstTerms.indexOf(term);
+    if (scalarIndex < instance->scalarInstTerms.size()) {
+        const ScalarInstTerm* scalar = &instance->scalarInstTerms[scalarIndex];
+        return &instance->model->scalarDesignTerms[scalar->scalarTermIndex];
+    }
+    const BusInstTermBit* bit = static_cast<const BusInstTermBit*>(term);
+    return &instance->model->busDesignTerms[bit->busTermIndex].bits[bit->bitIndex];
+}
+
+// Term of instance that stands for term, a port of its model.
+BitInstTerm* getInstTerm(const Instance* instance, const BitDesignTerm* term) {
+    const Design* model = instance->model;
+    const size_t scalarIndex = model->scalarDesignTerms.indexOf(term);
+    if (scalarIndex < model->scalarDesignTerms.size()) {
+        return &instance->scalarInstTerms[scalarIndex];
+    }
+    const BusDesignTermBit* bit = static_cast<const BusDesignTermBit*>(term);
+    const size_t busIndex = model->busDesignTerms.indexOf(bit->bus);
+    return &instance->busInstTerms[busIndex].bits[bit->index];
+}
+
+// Value slot of object in tables, which are sorted by address.
+template <typename Tables>
+auto* findValue(Tables& tables, const void* object) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(object);
+    const auto lessBegin = [](uintptr_t a, const auto& t) { return a < t.begin; };
+    auto it = std::upper_bound(tables.begin(), tables.end(), address, lessBegin);
+    if (it == tables.begin() || address >= (--it)->end) {
+        panic("object outside of the netlist spaces");
+    }
+    return &it->values[(address - it->begin) / it->objectSize];
+}
+
+struct ChildKey {
+    uint32_t context {0};
+    const Instance* instance {nullptr};
+
+    bool operator==(const ChildKey& other) const = default;
+};
+
+struct ChildKeyHash {
+    size_t operator()(const ChildKey& key) const {
+        return std::hash<const Instance*>()(key.instance) ^ (size_t(key.context) << 1);
+    }
+};
+
+}
+
+// One occurrence of a design reached by an exploration, with the
+// visited bits of its nets at firstWord in Scratch::visited.
+struct EquipotentialExplorator::Scratch {
+    struct Context {
+        const Design* design {nullptr};
+        uint32_t parent {0};
+        const Instance* instance {nullptr};
+        size_t firstWord {0};
+        Path path;
+    };
+
+    std::vector<Context> contexts;
+    std::unordered_map<ChildKey, uint32_t, ChildKeyHash> children;
+    std::vector<uint64_t> visited;
+    std::vector<std::pair<uint32_t, const BitNet*>> stack;
+
+    void clear() {
+        contexts.clear();
+        children.clear();
+        visited.clear();
+        stack.clear();
+    }
+};
+
+// Depth-first walk of one exploration. Context 0 is the bounding
+// design.
+class EquipotentialExplorator::Walk {
+public:
+    Walk(const EquipotentialExplorator* explorator,
+         Scratch* scratch,
+         ExploreDirection dir,
+         bool withEndpoints,
+         bool withNets,
+         Equipotential* result)
+        : _explorator(explorator),
+        _scratch(scratch),
+        _dir(dir),
+        _withEndpoints(withEndpoints),
+        _withNets(withNets),
+        _result(result)
+    {
+        addContext(explorator->_boundingDesign, 0, nullptr);
+    }
+
+    void run(const BitNetOccurrence& start) {
+        const uint32_t context = getContext(start.path);
+        if (!start.net || start.net->parent != getDesign(context)) {
+            panic("start net is not in the design at the end of its path");
+        }
+        visitNet(context, start.net);
+        drain();
+    }
+
+    void run(const BitInstTermOccurrence& start) {
+        const uint32_t context = getContext(start.path);
+        const BitInstTerm* term = start.term;
+        if (!term || term->instance->parent != getDesign(context)) {
+            panic("start term is not in the design at the end of its path");
+        }
+        const BitDesignTerm* modelTerm = getModelTerm(term);
+        if (!canStart(modelTerm->direction, _dir)) {
+            return;
+        }
+
+        _startContext = context;
+        _startInstTerm = term;
+        if (term->connectedNet) {
+            visitNet(context, term->connectedNet);
+        }
+        if (!term->instance->isPrimitive() && modelTerm->connectedNet) {
+            visitNet(getChild(context, term->instance), modelTerm->connectedNet);
+        }
+        drain();
+    }
+
+    void run(const BitDesignTermOccurrence& start) {
+        const uint32_t context = getContext(start.path);
+        const BitDesignTerm* term = start.term;
+        if (!term || term->parent != getDesign(context)) {
+            panic("start term is not in the design at the end of its path");
+        }
+        if (!canStart(getInnerDirection(term->direction), _dir)) {
+            return;
+        }
+
+        _startContext = context;
+        _startDesignTerm = term;
+        if (term->connectedNet) {
+            visitNet(context, term->connectedNet);
+        }
+        followDesignTerm(context, term);
+        drain();
+    }
+
+private:
+    using Context = Scratch::Context;
+
+    const EquipotentialExplorator* _explorator {nullptr};
+    Scratch* _scratch {nullptr};
+    ExploreDirection _dir {ExploreDirection::Bidirectional};
+    bool _withEndpoints {false};
+    bool _withNets {false};
+    Equipotential* _result {nullptr};
+
+    uint32_t _startContext {0};
+    const BitInstTerm* _startInstTerm {nullptr};
+    const BitDesignTerm* _startDesignTerm {nullptr};
+
+    const Design* getDesign(uint32_t context) const {
+        return _scratch->contexts[context].design;
+    }
+
+    // The path of a context is the path of its parent followed by its
+    // instance; the root context, without instance, has an empty path.
+    uint32_t addContext(const Design* design,
+                        uint32_t parent,
+                        const Instance* instance) {
+        const uint32_t numNets = _explorator->getValue(design);
+        const size_t firstWord = _scratch->visited.size();
+        _scratch->visited.resize(firstWord + (numNets + 63) / 64, 0);
+        _scratch->contexts.push_back({design, parent, instance, firstWord, Path()});
+
+        Context& added = _scratch->contexts.back();
+        if (instance) {
+            added.path = _scratch->contexts[parent].path;
+            added.path.push_back(const_cast<Instance*>(instance));
+        }
+        return static_cast<uint32_t>(_scratch->contexts.size() - 1);
+    }
+
+    uint32_t getChild(uint32_t context, const Instance* instance) {
+        const auto it = _scratch->children.find({context, instance});
+        if (it != _scratch->children.end()) {
+            return it->second;
+        }
+
+        const uint32_t child = addContext(instance->model, context, instance);
+        _scratch->children.emplace(ChildKey {context, instance}, child);
+        return child;
+    }
+
+    uint32_t getContext(const Path& path) {
+        uint32_t context = 0;
+        for (const Instance* instance : path) {
+            if (instance->parent != getDesign(context) || instance->isPrimitive()) {
+                panic("path does not follow the hierarchy of the bounding design");
+            }
+            context = getChild(context, instance);
+        }
+        return context;
+    }
+
+    void visitNet(uint32_t context, const BitNet* net) {
+        const uint32_t index = _explorator->getValue(net);
+        const size_t firstWord = _scratch->contexts[context].firstWord;
+        uint64_t& word = _scratch->visited[firstWord + index / 64];
+        const uint64_t bit = uint64_t(1) << (index % 64);
+        if (word & bit) {
+            return;
+        }
+        word |= bit;
+        _scratch->stack.emplace_back(context, net);
+    }
+
+    void drain() {
+        while (!_scratch->stack.empty()) {
+            const auto [context, net] = _scratch->stack.back();
+            _scratch->stack.pop_back();
+
+            if (_withNets) {
+                _result->nets.push_back(
+                    {{_scratch->contexts[context].path, const_cast<BitNet*>(net)}});
+            }
+            net->connectedInstTerms.forEach([&](BitInstTerm* term) {
+                followInstTerm(context, term);
+            });
+            net->connectedDesignTerms.forEach([&](BitDesignTerm* term) {
+                followDesignTerm(context, term);
+            });
+        }
+    }
+
+    void followInstTerm(uint32_t context, const BitInstTerm* term) {
+        const Instance* instance = term->instance;
+        switch (instance->getPrimitiveKind()) {
+        case PrimitiveKind::None:
+            if (const BitNet* net = getModelTerm(term)->connectedNet) {
+                visitNet(getChild(context, instance), net);
+            }
+            break;
+        case PrimitiveKind::SGC_ASSIGN:
+            if (term == instance->getPrimitiveScalarTerm(SGC_ASSIGNPins::I)) {
+                if (_dir != ExploreDirection::ToDrivers) {
+                    crossTo(context, instance->getPrimitiveScalarTerm(SGC_ASSIGNPins::O));
+                }
+            } else if (_dir != ExploreDirection::ToLoads) {
+                crossTo(context, instance->getPrimitiveScalarTerm(SGC_ASSIGNPins::I));
+            }
+            break;
+        case PrimitiveKind::SGC_ALIAS:
+            if (term == instance->getPrimitiveScalarTerm(SGC_ALIASPins::A)) {
+                crossTo(context, instance->getPrimitiveScalarTerm(SGC_ALIASPins::B));
+            } else {
+                crossTo(context, instance->getPrimitiveScalarTerm(SGC_ALIASPins::A));
+            }
+            break;
+        default:
+            if (_withEndpoints
+                && !(term == _startInstTerm && context == _startContext)
+                && isReported(getModelTerm(term)->direction, _dir)) {
+                _result->endpoints.push_back({BitInstTermOccurrence {
+                    _scratch->contexts[context].path, const_cast<BitInstTerm*>(term)}});
+            }
+            break;
+        }
+    }
+
+    void followDesignTerm(uint32_t context, const BitDesignTerm* term) {
+        if (context != 0) {
+            const Context& inner = _scratch->contexts[context];
+            const uint32_t outer = inner.parent;
+            if (const BitNet* net = getInstTerm(inner.instance, term)->connectedNet) {
+                visitNet(outer, net);
+            }
+            return;
+        }
+
+        if (_withEndpoints
+            && !(term == _startDesignTerm && context == _startContext)
+            && isReported(getInnerDirection(term->direction), _dir)) {
+            _result->endpoints.push_back({BitDesignTermOccurrence {
+                Path(), const_cast<BitDesignTerm*>(term)}});
+        }
+    }
+
+    void crossTo(uint32_t context, const BitInstTerm* other) {
+        if (other->connectedNet) {
+            visitNet(context, other->connectedNet);
+        }
+    }
+};
+
+EquipotentialExplorator::EquipotentialExplorator(const Netlist* netlist,
+                                                 const Design* boundingDesign)
+    : _netlist(netlist),
+    _boundingDesign(boundingDesign)
+{
+    if (!_boundingDesign) {
+        panic("equipotential exploration without a bounding design");
+    }
+    buildTables();
+}
+
+EquipotentialExplorator::EquipotentialExplorator(const Netlist* netlist)
+    : EquipotentialExplorator(netlist, netlist->getTopDesign())
+{
+}
+
+EquipotentialExplorator::~EquipotentialExplorator() {
+}
+
+void EquipotentialExplorator::buildTables() {
+    for (size_t i = 0; i < _netlist->getNumSpaces(); i++) {
+        const NetlistSpace* space = _netlist->getSpace(i);
+        const auto addTable = [&](auto objects) {
+            if (objects.empty()) {
+                return;
+            }
+            PoolTable& table = _tables.emplace_back();
+            table.begin = reinterpret_cast<uintptr_t>(objects.data());
+            table.end = reinterpret_cast<uintptr_t>(objects.data() + objects.size());
+            table.objectSize = sizeof(objects[0]);
+            table.values.assign(objects.size(), NO_VALUE);
+        };
+        addTable(space->getObjects<Design>());
+        addTable(space->getObjects<ScalarNet>());
+        addTable(space->getObjects<BusNetBit>());
+    }
+    std::sort(_tables.begin(), _tables.end(),
+              [](const PoolTable& a, const PoolTable& b) { return a.begin < b.begin; });
+
+    for (const Library* library : _netlist->getLibraries()) {
+        for (const Design* design : library->getDesigns()) {
+            if (design->isPrimitive()) {
+                continue;
+            }
+
+            uint32_t numNets = 0;
+            design->scalarNets.forEach([&](const ScalarNet& net) {
+                *findValue(_tables, &net) = numNets++;
+            });
+            design->busNets.forEach([&](const BusNet& bus) {
+                bus.bits.forEach([&](const BusNetBit& bit) {
+                    *findValue(_tables, &bit) = numNets++;
+                });
+            });
+            *findValue(_tables, design) = numNets;
+        }
+    }
+}
+
+uint32_t EquipotentialExplorator::getValue(const void* object) const {
+    const uint32_t value = *findValue(_tables, object);
+    if (value == NO_VALUE) {
+        panic("object of a design that is not in a library of the netlist");
+    }
+    return value;
+}
+
+void EquipotentialExplorator::run(const EquipotentialSeed& seed,
+                                  ExploreDirection dir,
+                                  bool withEndpoints,
+                                  bool withNets,
+                                  Equipotential* result) const {
+    std::unique_ptr<Scratch> scratch;
+    {
+        std::lock_guard<std::mutex> lock(_scratchMutex);
+        if (!_scratches.empty()) {
+            scratch.reset(_scratches.back().release());
+            _scratches.pop_back();
+        }
+    }
+    if (!scratch) {
+        scratch.reset(new Scratch());
+    }
+
+    Walk walk(this, scratch.get(), dir, withEndpoints, withNets, result);
+    std::visit([&](const auto& start) { walk.run(start); }, seed);
+
+    scratch->clear();
+    std::lock_guard<std::mutex> lock(_scratchMutex);
+    _scratches.emplace_back(scratch.release());
+}
+
+EquipotentialEndpointRange EquipotentialExplorator::explore(
+    const BitNetOccurrence& start,
+    ExploreDirection dir) const {
+    Equipotential result;
+    run(start, dir, true, false, &result);
+    return EquipotentialEndpointRange(result.endpoints);
+}
+
+EquipotentialEndpointRange EquipotentialExplorator::explore(
+    const BitInstTermOccurrence& start,
+    ExploreDirection dir) const {
+    Equipotential result;
+    run(start, dir, true, false, &result);
+    return EquipotentialEndpointRange(result.endpoints);
+}
+
+EquipotentialEndpointRange EquipotentialExplorator::explore(
+    const BitDesignTermOccurrence& start,
+    ExploreDirection dir) const {
+    Equipotential result;
+    run(start, dir, true, false, &result);
+    return EquipotentialEndpointRange(result.endpoints);
+}
+
+EquipotentialNetRange EquipotentialExplorator::exploreNets(
+    const BitNetOccurrence& start,
+    ExploreDirection dir) const {
+    Equipotential result;
+    run(start, dir, false, true, &result);
+    return EquipotentialNetRange(result.nets);
+}
+
+EquipotentialNetRange EquipotentialExplorator::exploreNets(
+    const BitInstTermOccurrence& start,
+    ExploreDirection dir) const {
+    Equipotential result;
+    run(start, dir, false, true, &result);
+    return EquipotentialNetRange(result.nets);
+}
+
+EquipotentialNetRange EquipotentialExplorator::exploreNets(
+    const BitDesignTermOccurrence& start,
+    ExploreDirection dir) const {
+    Equipotential result;
+    run(start, dir, false, true, &result);
+    return EquipotentialNetRange(result.nets);
+}
+
+void EquipotentialExplorator::exploreBatch(
+    std::span<const EquipotentialSeed> seeds,
+    ExploreDirection dir,
+    ThreadPool* pool,
+    std::vector<Equipotential>& results) const {
+    results.resize(seeds.size());
+    const auto exploreSeed = [&](size_t i) {
+        results[i].endpoints.clear();
+        results[i].nets.clear();
+        run(seeds[i], dir, true, true, &results[i]);
+    };
+    if (pool) {
+        pool->parallelFor(seeds.size(), exploreSeed);
+    } else {
+        for (size_t i = 0; i < seeds.size(); i++) {
+            exploreSeed(i);
+        }
+    }
+}
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "Occurrence.h"
+
+namespace stargate {
+
+class Netlist;
+class ThreadPool;
+struct Design;
+
+enum class ExploreDirection : uint8_t {
+    // All connections.
+    Bidirectional,
+    // Fanout: from a term that can drive to the terms that can load.
+    ToLoads,
+    // Fanin: from a term that can load to the terms that can drive.
+    ToDrivers,
+};
+
+// A term of a primitive instance, or a port of the bounding design.
+struct EquipotentialEndpoint {
+    std::variant<BitInstTermOccurrence, BitDesignTermOccurrence> endpoint;
+
+    bool isPrimitiveInstTerm() const { return endpoint.index() == 0; }
+    bool isBoundaryDesignTerm() const { return endpoint.index() == 1; }
+
+    const BitInstTermOccurrence& asPrimitiveInstTerm() const {
+        return std::get<BitInstTermOccurrence>(endpoint);
+    }
+
+    const BitDesignTermOccurrence& asBoundaryDesignTerm() const {
+        return std::get<BitDesignTermOccurrence>(endpoint);
+    }
+};
+
+struct EquipotentialNet {
+    BitNetOccurrence net;
+};
+
+struct Equipotential {
+    std::vector<EquipotentialEndpoint> endpoints;
+    std::vector<EquipotentialNet> nets;
+};
+
+using EquipotentialSeed =
+    std::variant<BitNetOccurrence, BitInstTermOccurrence, BitDesignTermOccurrence>;
+
+// Results of one exploration, in the order they were reached.
+class EquipotentialEndpointRange {
+public:
+    using Iterator = std::vector<EquipotentialEndpoint>::const_iterator;
+
+    explicit EquipotentialEndpointRange(
+        const std::vector<EquipotentialEndpoint>& endpoints)
+        : _endpoints(endpoints)
+    {
+    }
+
+    Iterator begin() const { return _endpoints.begin(); }
+    Iterator end() const { return _endpoints.end(); }
+    size_t size() const { return _endpoints.size(); }
+    bool empty() const { return _endpoints.empty(); }
+
+    // Appends the endpoints to result.
+    void collect(Equipotential& result) const {
+        result.endpoints.insert(result.endpoints.end(), begin(), end());
+    }
+
+private:
+    std::vector<EquipotentialEndpoint> _endpoints;
+};
+
+class EquipotentialNetRange {
+public:
+    using Iterator = std::vector<EquipotentialNet>::const_iterator;
+
+    explicit EquipotentialNetRange(const std::vector<EquipotentialNet>& nets)
+        : _nets(nets)
+    {
+    }
+
+    Iterator begin() const { return _nets.begin(); }
+    Iterator end() const { return _nets.end(); }
+    size_t size() const { return _nets.size(); }
+    bool empty() const { return _nets.empty(); }
+
+    // Appends the nets to result.
+    void collect(Equipotential& result) const {
+        result.nets.insert(result.nets.end(), begin(), end());
+    }
+
+private:
+    std::vector<EquipotentialNet> _nets;
+};
+
+// Walks the connectivity of a net across the hierarchy, through the
+// ports of hierarchical instances and through SGC_ASSIGN and SGC_ALIAS
+// instances, down to the terms of primitive instances and up to the
+// ports of the bounding design. Paths are relative to the bounding
+// design, which is the top design when unbounded.
+//
+// A net is visited once per occurrence. Each instantiation context
+// reached by an exploration gets a bitset over the nets of its design,
+// indexed through dense tables built once per explorator over the net
+// pools of every space, so marking a net costs no hashing.
+//
+// The explorator is immutable once built: any number of threads may
+// explore at once, and exploreBatch() spreads seeds over a ThreadPool.
+// The netlist must not change while an explorator is in use.
+class EquipotentialExplorator {
+public:
+    // Bounded exploration, stopping at the ports of boundingDesign.
+    EquipotentialExplorator(const Netlist* netlist, const Design* boundingDesign);
+
+    // Unbounded exploration, bounded by the top design.
+    explicit EquipotentialExplorator(const Netlist* netlist);
+
+    ~EquipotentialExplorator();
+
+    EquipotentialExplorator(const EquipotentialExplorator&) = delete;
+    EquipotentialExplorator& operator=(const EquipotentialExplorator&) = delete;
+
+    // The start term itself is never reported. ToLoads from a term that
+    // cannot drive, or ToDrivers from one that cannot load, finds
+    // nothing. A port counts from inside its design: an input port
+    // drives its net.
+
+    EquipotentialEndpointRange explore(
+        const BitNetOccurrence& start,
+        ExploreDirection dir = ExploreDirection::Bidirectional) const;
+
+    EquipotentialEndpointRange explore(
+        const BitInstTermOccurrence& start,
+        ExploreDirection dir = ExploreDirection::Bidirectional) const;
+
+    EquipotentialEndpointRange explore(
+        const BitDesignTermOccurrence& start,
+        ExploreDirection dir = ExploreDirection::Bidirectional) const;
+
+    EquipotentialNetRange exploreNets(
+        const BitNetOccurrence& start,
+        ExploreDirection dir = ExploreDirection::Bidirectional) const;
+
+    EquipotentialNetRange exploreNets(
+        const BitInstTermOccurrence& start,
+        ExploreDirection dir = ExploreDirection::Bidirectional) const;
+
+    EquipotentialNetRange exploreNets(
+        const BitDesignTermOccurrence& start,
+        ExploreDirection dir = ExploreDirection::Bidirectional) const;
+
+    // Explores every seed independently, endpoints and nets, on the
+    // threads of pool or on the calling thread if pool is nullptr.
+    // results is resized to the number of seeds, and results[i] filled
+    // with the equipotential of seeds[i].
+    void exploreBatch(std::span<const EquipotentialSeed> seeds,
+                      ExploreDirection dir,
+                      ThreadPool* pool,
+                      std::vector<Equipotential>& results) const;
+
+private:
+    // Values for the objects of one pool of a space, by position.
+    struct PoolTable {
+        uintptr_t begin {0};
+        uintptr_t end {0};
+        size_t objectSize {0};
+        std::vector<uint32_t> values;
+    };
+
+    struct Scratch;
+    class Walk;
+
+    const Netlist* _netlist {nullptr};
+    const Design* _boundingDesign {nullptr};
+
+    // Sorted by address. For the net pools, the index of each net among
+    // the bit nets of its design; for the design pools, the number of
+    // bit nets of each design.
+    std::vector<PoolTable> _tables;
+
+    // Scratch state of finished explorations, for reuse.
+    mutable std::mutex _scratchMutex;
+    mutable std::vector<std::unique_ptr<Scratch>> _scratches;
+
+    void buildTables();
+    uint32_t getValue(const void* object) const;
+
+    void run(const EquipotentialSeed& seed,
+             ExploreDirection dir,
+             bool withEndpoints,
+             bool withNets,
+             Equipotential* result) const;
+
+    friend class Walk;
+};
+
+}
@@ -0,0 +1,568 @@
+#include "FlatNetlist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Design.h"
+#include "NameTable.h"
+#include "Netlist.h"
+
+#include "Panic.h"
+#include "ThreadPool.h"
+
+namespace stargate {
+
+namespace {
+
+constexpr uint32_t NONE = FlatNetlist::NONE;
+
+// Elements per batch of the passes over single objects. Designs and
+// scopes are handed out one at a time.
+constexpr size_t ELEMENT_BATCH_SIZE = 4096;
+
+// Runs func(begin, end) over batches of [0, count) on pool.
+void parallelForBatches(ThreadPool* pool,
+                        size_t count,
+                        size_t batchSize,
+                        const std::function<void(size_t, size_t)>& func) {
+    const size_t batchCount = (count + batchSize - 1) / batchSize;
+    pool->parallelFor(batchCount, [&](size_t batch) {
+        const size_t begin = batch * batchSize;
+        func(begin, std::min(begin + batchSize, count));
+    });
+}
+
+// Union-find that scopes merge into concurrently. A set is linked
+// under the other by CAS on its root, always the larger root under the
+// smaller, so the root of every set is its smallest element.
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(size_t size)
+        : _parents(size)
+    {
+        for (size_t i = 0; i < size; i++) {
+            _parents[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t find(uint32_t x) {
+        while (true) {
+            uint32_t parent = _parents[x].load(std::memory_order_relaxed);
+            if (parent == x) {
+                return x;
+            }
+
+            const uint32_t grandParent = _parents[parent].load(std::memory_order_relaxed);
+            if (grandParent == parent) {
+                return parent;
+            }
+
+            // Path halving. Losing the race only skips a shortcut.
+            _parents[x].compare_exchange_weak(parent, grandParent,
+                                              std::memory_order_relaxed);
+            x = grandParent;
+        }
+    }
+
+    void unite(uint32_t a, uint32_t b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) {
+                return;
+            }
+
+            if (a < b) {
+                std::swap(a, b);
+            }
+
+            uint32_t expected = a;
+            if (_parents[a].compare_exchange_strong(expected, b,
+                                                    std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+private:
+    std::vector<std::atomic<uint32_t>> _parents;
+};
+
+struct LeafTerm {
+    const BitInstTerm* origin {nullptr};
+    uint32_t net {NONE};
+    Direction direction {Direction::Input};
+};
+
+struct DesignTemplate;
+
+struct ChildInstance {
+    const Instance* instance {nullptr};
+    const DesignTemplate* model {nullptr};
+    uint32_t firstPort {0};
+};
+
+// What one design contributes to every scope that instantiates it,
+// with its nets numbered locally. Built once per design and copied
+// into each scope by offsetting.
+struct DesignTemplate {
+    const Design* design {nullptr};
+
+    // Scalar nets, then the bits of each bus net.
+    std::vector<const BitNet*> nets;
+    std::vector<NameID> netNames;
+
+    // Local net of each term bit of the design, scalar terms first, or
+    // NONE if the term is unconnected.
+    std::vector<uint32_t> portNets;
+
+    // Primitive instances and their terms, which stay in the flat
+    // netlist. The terms of leaf i are [leafTermOffsets[i], [i + 1]).
+    std::vector<const Instance*> leaves;
+    std::vector<uint32_t> leafTermOffsets {0};
+    std::vector<LeafTerm> leafTerms;
+
+    // Hierarchical instances. The local nets of the terms of child i,
+    // in the port order of its model, start at childPorts[firstPort].
+    std::vector<ChildInstance> children;
+    std::vector<uint32_t> childPorts;
+
+    // Pairs of local nets joined by an SGC_ASSIGN or SGC_ALIAS.
+    std::vector<std::pair<uint32_t, uint32_t>> joins;
+};
+
+// Calls func(term, direction) for every bit term of instance, in the
+// port order of its model: terms mirror the ports of their model.
+template<typename F>
+void forEachInstTerm(const Instance& instance, F&& func) {
+    const Design* model = instance.model;
+    instance.scalarInstTerms.forEach([&](const ScalarInstTerm& term) {
+        func(term, model->scalarDesignTerms[term.scalarTermIndex].direction);
+    });
+    instance.busInstTerms.forEach([&](const BusInstTerm& bus) {
+        const Direction direction = model->busDesignTerms[bus.busTermIndex].direction;
+        bus.bits.forEach([&](const BusInstTermBit& bit) {
+            func(bit, direction);
+        });
+    });
+}
+
+int32_t getBitNumber(int32_t msb, int32_t lsb, uint32_t index) {
+    const int32_t offset = static_cast<int32_t>(index);
+    return msb >= lsb ? msb - offset : msb + offset;
+}
+
+}
+
+// Flattens in four passes: templates of every design in parallel, the
+// scope tree sequentially, then every scope in parallel into ranges
+// laid out by the scope pass, nets being merged through a concurrent
+// union-find. The net rows are sorted last.
+class FlatNetlistBuilder {
+public:
+    FlatNetlistBuilder(Netlist* netlist, unsigned threadCount, FlatNetlist* flat);
+    ~FlatNetlistBuilder();
+
+    void build();
+
+private:
+    struct ScopeLayout {
+        const DesignTemplate* design {nullptr};
+        uint32_t netBase {0};
+        uint32_t instanceBase {0};
+        uint32_t termBase {0};
+        uint32_t firstChild {0};
+    };
+
+    enum class VisitState {
+        InProgress,
+        Done,
+    };
+
+    Netlist* _netlist {nullptr};
+    ThreadPool _pool;
+    FlatNetlist* _flat {nullptr};
+
+    std::vector<std::unique_ptr<DesignTemplate>> _templates;
+    std::unordered_map<const Design*, DesignTemplate*> _templateMap;
+    std::unordered_map<const Design*, VisitState> _visitStates;
+
+    std::vector<ScopeLayout> _layouts;
+    uint32_t _numScopeNets {0};
+    uint32_t _numLeafTerms {0};
+
+    void collectDesigns(const Design* design);
+    void buildTemplate(DesignTemplate* tmpl);
+    void buildScopes();
+    void flattenScope(ConcurrentUnionFind* netSets, uint32_t scope);
+    void addTopPorts();
+    void mergeNets(ConcurrentUnionFind* netSets);
+    void buildNetTerms();
+};
+
+FlatNetlistBuilder::FlatNetlistBuilder(Netlist* netlist,
+                                       unsigned threadCount,
+                                       FlatNetlist* flat)
+    : _netlist(netlist),
+    _pool(threadCount),
+    _flat(flat)
+{
+}
+
+FlatNetlistBuilder::~FlatNetlistBuilder() {
+}
+
+void FlatNetlistBuilder::build() {
+    const Design* top = _netlist->getTopDesign();
+    if (!top) {
+        panic("cannot flatten a netlist without a top design");
+    }
+    if (top->isPrimitive()) {
+        panic("cannot flatten a primitive top design");
+    }
+
+    collectDesigns(top);
+    _pool.parallelFor(_templates.size(), [&](size_t i) {
+        buildTemplate(_templates[i].get());
+    });
+
+    buildScopes();
+
+    ConcurrentUnionFind netSets(_numScopeNets);
+    _pool.parallelFor(_layouts.size(), [&](size_t i) {
+        flattenScope(&netSets, static_cast<uint32_t>(i));
+    });
+    addTopPorts();
+
+    mergeNets(&netSets);
+    buildNetTerms();
+}
+
+void FlatNetlistBuilder::collectDesigns(const Design* design) {
+    const auto [it, inserted] = _visitStates.emplace(design, VisitState::InProgress);
+    if (!inserted) {
+        if (it->second == VisitState::InProgress) {
+            panic("design {} instantiates itself",
+                  _netlist->getNameTable()->getString(design->name));
+        }
+        return;
+    }
+
+    design->instances.forEach([&](const Instance& instance) {
+        if (!instance.model->isPrimitive()) {
+            collectDesigns(instance.model);
+        }
+    });
+
+    // Children first, so that each template can look its models up.
+    DesignTemplate* tmpl = new DesignTemplate();
+    _templates.emplace_back(tmpl);
+    tmpl->design = design;
+    _templateMap.emplace(design, tmpl);
+    it->second = VisitState::Done;
+}
+
+void FlatNetlistBuilder::buildTemplate(DesignTemplate* tmpl) {
+    NameTable* names = _netlist->getNameTable();
+    const Design* design = tmpl->design;
+
+    std::unordered_map<const BitNet*, uint32_t> localNets;
+    auto addNet = [&](const BitNet* net, NameID name) {
+        localNets.emplace(net, static_cast<uint32_t>(tmpl->nets.size()));
+        tmpl->nets.push_back(net);
+        tmpl->netNames.push_back(name);
+    };
+
+    auto getLocalNet = [&](const BitNet* net) {
+        if (!net) {
+            return NONE;
+        }
+        const auto it = localNets.find(net);
+        return it != localNets.end() ? it->second : NONE;
+    };
+
+    design->scalarNets.forEach([&](const ScalarNet& net) {
+        addNet(&net, net.name);
+    });
+    design->busNets.forEach([&](const BusNet& bus) {
+        const std::string busName(names->getString(bus.name));
+        bus.bits.forEach([&](const BusNetBit& bit) {
+            const int32_t number = getBitNumber(bus.msb, bus.lsb, bit.index);
+            addNet(&bit, names->getName(busName + "[" + std::to_string(number) + "]"));
+        });
+    });
+
+    design->scalarDesignTerms.forEach([&](const ScalarDesignTerm& term) {
+        tmpl->portNets.push_back(getLocalNet(term.connectedNet));
+    });
+    design->busDesignTerms.forEach([&](const BusDesignTerm& bus) {
+        bus.bits.forEach([&](const BusDesignTermBit& bit) {
+            tmpl->portNets.push_back(getLocalNet(bit.connectedNet));
+        });
+    });
+
+    design->instances.forEach([&](const Instance& instance) {
+        const PrimitiveKind kind = instance.getPrimitiveKind();
+        if (kind == PrimitiveKind::SGC_ASSIGN || kind == PrimitiveKind::SGC_ALIAS) {
+            // Both pins of either are scalar pins 0 and 1.
+            const uint32_t a = getLocalNet(
+                instance.getPrimitiveScalarTerm(SGC_ASSIGNPins::I)->connectedNet);
+            const uint32_t b = getLocalNet(
+                instance.getPrimitiveScalarTerm(SGC_ASSIGNPins::O)->connectedNet);
+            if (a != NONE && b != NONE) {
+                tmpl->joins.emplace_back(a, b);
+            }
+            return;
+        }
+
+        if (instance.model->isPrimitive()) {
+            tmpl->leaves.push_back(&instance);
+            forEachInstTerm(instance, [&](const BitInstTerm& term, Direction dir) {
+                tmpl->leafTerms.push_back({&term, getLocalNet(term.connectedNet), dir});
+            });
+            tmpl->leafTermOffsets.push_back(
+                static_cast<uint32_t>(tmpl->leafTerms.size()));
+            return;
+        }
+
+        ChildInstance& child = tmpl->children.emplace_back();
+        child.instance = &instance;
+        child.model = _templateMap.at(instance.model);
+        child.firstPort = static_cast<uint32_t>(tmpl->childPorts.size());
+        forEachInstTerm(instance, [&](const BitInstTerm& term, Direction) {
+            tmpl->childPorts.push_back(getLocalNet(term.connectedNet));
+        });
+    });
+}
+
+void FlatNetlistBuilder::buildScopes() {
+    // Breadth first, so that the children of a scope are contiguous and
+    // follow their parent.
+    uint64_t numNets = 0;
+    uint64_t numInstances = 0;
+    uint64_t numTerms = 0;
+    auto addScope = [&](uint32_t parent, const Instance* instance,
+                        const DesignTemplate* tmpl) {
+        _flat->_scopes.push_back({parent, instance, tmpl->design});
+
+        ScopeLayout& layout = _layouts.emplace_back();
+        layout.design = tmpl;
+        layout.netBase = static_cast<uint32_t>(numNets);
+        layout.instanceBase = static_cast<uint32_t>(numInstances);
+        layout.termBase = static_cast<uint32_t>(numTerms);
+
+        numNets += tmpl->nets.size();
+        numInstances += tmpl->leaves.size();
+        numTerms += tmpl->leafTerms.size();
+        if (numNets >= NONE || numInstances >= NONE || numTerms >= NONE
+            || _layouts.size() >= NONE) {
+            panic("design {} is too large to flatten",
+                  _netlist->getNameTable()->getString(_netlist->getTopDesign()->name));
+        }
+    };
+
+    addScope(NONE, nullptr, _templateMap.at(_netlist->getTopDesign()));
+    for (size_t i = 0; i < _layouts.size(); i++) {
+        _layouts[i].firstChild = static_cast<uint32_t>(_layouts.size());
+        for (const ChildInstance& child : _layouts[i].design->children) {
+            addScope(static_cast<uint32_t>(i), child.instance, child.model);
+        }
+    }
+
+    const size_t numPorts = _layouts[0].design->portNets.size();
+    if (numTerms + numPorts >= NONE) {
+        panic("design {} is too large to flatten",
+              _netlist->getNameTable()->getString(_netlist->getTopDesign()->name));
+    }
+
+    _numScopeNets = static_cast<uint32_t>(numNets);
+    _numLeafTerms = static_cast<uint32_t>(numTerms);
+    _flat->_instances.resize(numInstances);
+    _flat->_instanceTermOffsets.resize(numInstances + 1);
+    _flat->_instanceTermOffsets.back() = _numLeafTerms;
+    _flat->_terms.resize(numTerms + numPorts);
+}
+
+void FlatNetlistBuilder::flattenScope(ConcurrentUnionFind* netSets, uint32_t scope) {
+    const ScopeLayout& layout = _layouts[scope];
+    const DesignTemplate* tmpl = layout.design;
+
+    for (size_t i = 0; i < tmpl->leaves.size(); i++) {
+        const uint32_t instance = layout.instanceBase + static_cast<uint32_t>(i);
+        FlatNetlist::FlatInstance& flatInstance = _flat->_instances[instance];
+        flatInstance.name = tmpl->leaves[i]->name;
+        flatInstance.scope = scope;
+        flatInstance.origin = tmpl->leaves[i];
+        const uint32_t firstTerm = tmpl->leafTermOffsets[i];
+        const uint32_t endTerm = tmpl->leafTermOffsets[i + 1];
+        _flat->_instanceTermOffsets[instance] = layout.termBase + firstTerm;
+
+        for (uint32_t t = firstTerm; t < endTerm; t++) {
+            const LeafTerm& leafTerm = tmpl->leafTerms[t];
+            FlatNetlist::FlatTerm& term = _flat->_terms[layout.termBase + t];
+            term.instance = instance;
+            term.net = leafTerm.net != NONE ? layout.netBase + leafTerm.net : NONE;
+            term.scope = scope;
+            term.direction = leafTerm.direction;
+            term.instTerm = leafTerm.origin;
+        }
+    }
+
+    for (const auto& [a, b] : tmpl->joins) {
+        netSets->unite(layout.netBase + a, layout.netBase + b);
+    }
+
+    // A port of a child joins the net of its instance term here with
+    // the net of its design term in the child.
+    for (size_t c = 0; c < tmpl->children.size(); c++) {
+        const ChildInstance& child = tmpl->children[c];
+        const ScopeLayout& childLayout = _layouts[layout.firstChild + c];
+        const std::vector<uint32_t>& childNets = child.model->portNets;
+        for (size_t p = 0; p < childNets.size(); p++) {
+            const uint32_t net = tmpl->childPorts[child.firstPort + p];
+            if (net != NONE && childNets[p] != NONE) {
+                netSets->unite(layout.netBase + net, childLayout.netBase + childNets[p]);
+            }
+        }
+    }
+}
+
+void FlatNetlistBuilder::addTopPorts() {
+    const Design* top = _netlist->getTopDesign();
+    const std::vector<uint32_t>& portNets = _layouts[0].design->portNets;
+    uint32_t index = _numLeafTerms;
+    auto addPort = [&](const BitDesignTerm& port) {
+        FlatNetlist::FlatTerm& term = _flat->_terms[index];
+        term.net = portNets[index - _numLeafTerms];
+        term.direction = port.direction;
+        term.designTerm = &port;
+        index++;
+    };
+
+    top->scalarDesignTerms.forEach(addPort);
+    top->busDesignTerms.forEach([&](const BusDesignTerm& bus) {
+        bus.bits.forEach(addPort);
+    });
+}
+
+void FlatNetlistBuilder::mergeNets(ConcurrentUnionFind* netSets) {
+    std::vector<uint32_t> roots(_numScopeNets);
+    auto findRoots = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            roots[i] = netSets->find(static_cast<uint32_t>(i));
+        }
+    };
+    parallelForBatches(&_pool, roots.size(), ELEMENT_BATCH_SIZE, findRoots);
+
+    // Numbered in scope order so that the result does not depend on
+    // the threads, each set taking the name of its outermost net.
+    std::vector<uint32_t> flatNets(_numScopeNets);
+    for (uint32_t scope = 0; scope < _layouts.size(); scope++) {
+        const ScopeLayout& layout = _layouts[scope];
+        const DesignTemplate* tmpl = layout.design;
+        for (uint32_t n = 0; n < tmpl->nets.size(); n++) {
+            const uint32_t net = layout.netBase + n;
+            if (roots[net] == net) {
+                flatNets[net] = static_cast<uint32_t>(_flat->_nets.size());
+                _flat->_nets.push_back({tmpl->netNames[n], scope, tmpl->nets[n]});
+            }
+        }
+    }
+
+    std::vector<FlatNetlist::FlatTerm>& terms = _flat->_terms;
+    auto remapTerms = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (terms[i].net != NONE) {
+                terms[i].net = flatNets[roots[terms[i].net]];
+            }
+        }
+    };
+    parallelForBatches(&_pool, terms.size(), ELEMENT_BATCH_SIZE, remapTerms);
+}
+
+void FlatNetlistBuilder::buildNetTerms() {
+    const std::vector<FlatNetlist::FlatTerm>& terms = _flat->_terms;
+    const size_t numNets = _flat->_nets.size();
+
+    // Drivers are 0, bidirectional terms 1 and receivers 2. A port of
+    // the top design drives its net from the outside.
+    auto getRank = [](const FlatNetlist::FlatTerm& term) -> size_t {
+        switch (term.direction) {
+            case Direction::Input:
+                return term.instance == NONE ? 0 : 2;
+
+            case Direction::Output:
+                return term.instance == NONE ? 2 : 0;
+
+            case Direction::InOut:
+                return 1;
+        }
+        return 1;
+    };
+
+    std::vector<uint32_t> cursors(numNets * 3);
+    for (const FlatNetlist::FlatTerm& term : terms) {
+        if (term.net != NONE) {
+            cursors[term.net * 3 + getRank(term)]++;
+        }
+    }
+
+    _flat->_netTermOffsets.resize(numNets + 1);
+    _flat->_netBidirOffsets.resize(numNets);
+    _flat->_netReceiverOffsets.resize(numNets);
+
+    uint32_t offset = 0;
+    for (size_t n = 0; n < numNets; n++) {
+        uint32_t* counts = &cursors[n * 3];
+        _flat->_netTermOffsets[n] = offset;
+        _flat->_netBidirOffsets[n] = offset + counts[0];
+        _flat->_netReceiverOffsets[n] = offset + counts[0] + counts[1];
+
+        const uint32_t total = counts[0] + counts[1] + counts[2];
+        counts[0] = _flat->_netTermOffsets[n];
+        counts[1] = _flat->_netBidirOffsets[n];
+        counts[2] = _flat->_netReceiverOffsets[n];
+        offset += total;
+    }
+    _flat->_netTermOffsets[numNets] = offset;
+
+    _flat->_netTerms.resize(offset);
+    for (uint32_t t = 0; t < terms.size(); t++) {
+        if (terms[t].net != NONE) {
+            _flat->_netTerms[cursors[terms[t].net * 3 + getRank(terms[t])]++] = t;
+        }
+    }
+}
+
+FlatNetlist::FlatNetlist() {
+}
+
+FlatNetlist::~FlatNetlist() {
+}
+
+void FlatNetlist::create(Netlist* netlist, FlatNetlist* result, unsigned threadCount) {
+    if (!result->_scopes.empty()) {
+        panic("a flat netlist can only be built once");
+    }
+
+    FlatNetlistBuilder builder(netlist, threadCount, result);
+    builder.build();
+}
+
+size_t FlatNetlist::getMemoryUsage() const {
+    return _scopes.capacity() * sizeof(FlatScope)
+         + _nets.capacity() * sizeof(FlatNet)
+         + _instances.capacity() * sizeof(FlatInstance)
+         + _terms.capacity() * sizeof(FlatTerm)
+         + (_instanceTermOffsets.capacity()
+            + _netTermOffsets.capacity()
+            + _netBidirOffsets.capacity()
+            + _netReceiverOffsets.capacity()
+            + _netTerms.capacity()) * sizeof(uint32_t);
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <span>
+#include <vector>
+
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+class Netlist;
+struct BitDesignTerm;
+struct BitInstTerm;
+struct BitNet;
+struct Design;
+struct Instance;
+
+// Bit-level view of the whole design under the top, built on demand
+// for transformations and never kept up to date with the netlist.
+//
+// Every hierarchical instantiation becomes a scope, and only the
+// instances of primitives remain, SGC_ASSIGN and SGC_ALIAS excepted:
+// those are dissolved, the nets they join merged into one flat net.
+// Objects are numbered densely and connectivity is kept in
+// compressed rows: the terms of an instance are contiguous, and the
+// terms of a net are an index range, drivers first, then bidirectional
+// terms, then receivers. The ports of the top design are terms with no
+// instance; an input port drives its net.
+class FlatNetlist {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // A hierarchical instantiation. Parents come before their children,
+    // and the scope of the top design is the first one.
+    struct FlatScope {
+        uint32_t parent {NONE};
+        // nullptr for the top design.
+        const Instance* instance {nullptr};
+        const Design* design {nullptr};
+    };
+
+    // The flat net takes its name and origin from its net in the
+    // outermost scope. Bits of buses are named "bus[3]".
+    struct FlatNet {
+        NameID name;
+        uint32_t scope {0};
+        const BitNet* origin {nullptr};
+    };
+
+    struct FlatInstance {
+        NameID name;
+        uint32_t scope {0};
+        const Instance* origin {nullptr};
+    };
+
+    // Origin is instTerm for the term of an instance and designTerm for
+    // a port of the top design.
+    struct FlatTerm {
+        uint32_t instance {NONE};
+        uint32_t net {NONE};
+        uint32_t scope {0};
+        Direction direction {Direction::Input};
+        const BitInstTerm* instTerm {nullptr};
+        const BitDesignTerm* designTerm {nullptr};
+    };
+
+    FlatNetlist();
+    ~FlatNetlist();
+
+    FlatNetlist(const FlatNetlist&) = delete;
+    FlatNetlist& operator=(const FlatNetlist&) = delete;
+
+    // Flattens the top design of netlist into result, which must be
+    // empty, on threadCount threads, or on one per core if 0. The names
+    // of bus bits are interned in the name table of netlist.
+    static void create(Netlist* netlist, FlatNetlist* result, unsigned threadCount = 0);
+
+    std::span<const FlatScope> getScopes() const { return _scopes; }
+    std::span<const FlatNet> getNets() const { return _nets; }
+    std::span<const FlatInstance> getInstances() const { return _instances; }
+    std::span<const FlatTerm> getTerms() const { return _terms; }
+
+    std::span<const FlatTerm> getInstanceTerms(uint32_t instance) const {
+        const uint32_t first = _instanceTermOffsets[instance];
+        return std::span<const FlatTerm>(_terms).subspan(
+            first, _instanceTermOffsets[instance + 1] - first);
+    }
+
+    // Term indices of a net: [drivers | bidirectional | receivers].
+    std::span<const uint32_t> getNetTerms(uint32_t net) const {
+        return getNetTermRange(_netTermOffsets[net], _netTermOffsets[net + 1]);
+    }
+
+    // Drivers and bidirectional terms.
+    std::span<const uint32_t> getNetDrivers(uint32_t net) const {
+        return getNetTermRange(_netTermOffsets[net], _netReceiverOffsets[net]);
+    }
+
+    // Bidirectional terms and receivers.
+    std::span<const uint32_t> getNetReceivers(uint32_t net) const {
+        return getNetTermRange(_netBidirOffsets[net], _netTermOffsets[net + 1]);
+    }
+
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<FlatScope> _scopes;
+    std::vector<FlatNet> _nets;
+    std::vector<FlatInstance> _instances;
+    std::vector<FlatTerm> _terms;
+
+    // Terms of instance i are [_instanceTermOffsets[i], [i + 1]).
+    std::vector<uint32_t> _instanceTermOffsets;
+
+    // Terms of net n are _netTerms[_netTermOffsets[n], [n + 1]), its
+    // bidirectional ones starting at _netBidirOffsets[n] and its
+    // receivers at _netReceiverOffsets[n].
+    std::vector<uint32_t> _netTermOffsets;
+    std::vector<uint32_t> _netBidirOffsets;
+    std::vector<uint32_t> _netReceiverOffsets;
+    std::vector<uint32_t> _netTerms;
+
+    std::span<const uint32_t> getNetTermRange(uint32_t begin, uint32_t end) const {
+        return std::span<const uint32_t>(_netTerms).subspan(begin, end - begin);
+    }
+
+    friend class FlatNetlistBuilder;
+};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChunkedSpan.h"
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+struct BitNet;
+struct BusInstTerm;
+struct Instance;
+
+// Terminal of an instance, at the bit level. It refers to the design
+// term it stands for by index into the model's terms, so that swapping
+// the model of the instance for a uniquified copy keeps it valid.
+struct BitInstTerm {
+    InstTermID id;
+    Instance* instance {nullptr};
+    BitNet* connectedNet {nullptr};
+};
+
+struct ScalarInstTerm : BitInstTerm {
+    // Index into the model's scalarDesignTerms.
+    uint16_t scalarTermIndex {0};
+};
+
+struct BusInstTermBit : BitInstTerm {
+    BusInstTerm* bus {nullptr};
+    // Index into the model's busDesignTerms, then into its bits.
+    uint16_t busTermIndex {0};
+    uint16_t bitIndex {0};
+};
+
+struct BusInstTerm {
+    InstTermID id;
+    Instance* instance {nullptr};
+    uint16_t busTermIndex {0};
+    ChunkedSpan<BusInstTermBit> bits;
+};
+
+}
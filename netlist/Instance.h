@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChunkedSpan.h"
+#include "InstTerm.h"
+#include "NetlistIDs.h"
+#include "PrimitiveKind.h"
+
+namespace stargate {
+
+struct Design;
+
+struct Instance {
+    InstanceID id;
+    NameID name;
+    Design* parent {nullptr};
+    // Instantiated design. Uniquification swaps it for a copy, which
+    // the terms still match since term order is preserved.
+    Design* model {nullptr};
+    // Bits 0-15: instance flags. Bits 16-31: PrimitiveKind.
+    uint32_t flags {0};
+
+    ChunkedSpan<ScalarInstTerm> scalarInstTerms;
+    ChunkedSpan<BusInstTerm> busInstTerms;
+
+    static constexpr uint32_t PRIMITIVE_KIND_SHIFT = 16;
+    static constexpr uint32_t PRIMITIVE_KIND_MASK = 0xFFFF0000;
+    static constexpr uint32_t INSTANCE_FLAGS_MASK = 0x0000FFFF;
+
+    PrimitiveKind getPrimitiveKind() const {
+        return static_cast<PrimitiveKind>(
+            (flags & PRIMITIVE_KIND_MASK) >> PRIMITIVE_KIND_SHIFT);
+    }
+
+    bool isPrimitive() const { return getPrimitiveKind() != PrimitiveKind::None; }
+
+    void setPrimitiveKind(PrimitiveKind kind) {
+        flags = (flags & INSTANCE_FLAGS_MASK)
+              | (static_cast<uint32_t>(kind) << PRIMITIVE_KIND_SHIFT);
+    }
+
+    // Terms of a primitive instance are always a single chunk, so pins
+    // are reached by index without walking chunks.
+    ScalarInstTerm* getPrimitiveScalarTerm(uint16_t scalarIndex) const {
+        return scalarInstTerms.data() + scalarIndex;
+    }
+
+    BusInstTerm* getPrimitiveBusTerm(uint16_t busIndex) const {
+        return busInstTerms.data() + busIndex;
+    }
+
+    BusInstTermBit* getPrimitiveBusTermBit(uint16_t busIndex, uint16_t bitIndex) const {
+        return getPrimitiveBusTerm(busIndex)->bits.data() + bitIndex;
+    }
+};
+
+}
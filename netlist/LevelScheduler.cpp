@@ -0,0 +1,66 @@
+#include "LevelScheduler.h"
+
+#include "Design.h"
+#include "Levelize.h"
+#include "Library.h"
+#include "ThreadPool.h"
+
+namespace stargate {
+
+namespace {
+
+uint64_t getDesignKey(const Design* design) {
+    return (uint64_t(design->library->getID().value) << 32) | design->name.value;
+}
+
+}
+
+LevelScheduler::LevelScheduler(const Netlist* netlist, ThreadPool* pool)
+    : _netlist(netlist),
+    _pool(pool)
+{
+}
+
+LevelScheduler::~LevelScheduler() {
+}
+
+void LevelScheduler::runBottomUp(const Transform& transform) {
+    _levelize = std::make_unique<Levelize>(_netlist);
+    _visited.clear();
+
+    // The number of levels may change with every callback.
+    for (uint32_t level = 0; level < _levelize->getNumLevels(); level++) {
+        runLevel(level, transform);
+    }
+}
+
+void LevelScheduler::runTopDown(const Transform& transform) {
+    _levelize = std::make_unique<Levelize>(_netlist);
+    _visited.clear();
+
+    for (uint32_t level = _levelize->getNumLevels(); level > 0; level--) {
+        if (level - 1 < _levelize->getNumLevels()) {
+            runLevel(level - 1, transform);
+        }
+    }
+}
+
+void LevelScheduler::runLevel(uint32_t level, const Transform& transform) {
+    _levelDesigns.clear();
+    for (Design* design : _levelize->designsAtLevel(level)) {
+        if (_visited.insert(getDesignKey(design)).second) {
+            _levelDesigns.push_back(design);
+        }
+    }
+
+    _pool->parallelFor(_levelDesigns.size(), [&](size_t i) {
+        transform(_levelDesigns[i]);
+    });
+
+    if (_levelCallback) {
+        _levelCallback(Level(level, _levelDesigns));
+        _levelize = std::make_unique<Levelize>(_netlist);
+    }
+}
+
+}
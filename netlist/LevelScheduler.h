@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace stargate {
+
+class Level;
+class Levelize;
+class Netlist;
+class ThreadPool;
+struct Design;
+
+// Runs a transform over every design of a netlist, one level at a
+// time. The designs of a level are spread over a work-stealing pool,
+// and the next level only starts once all of them are done and the
+// level callback has run, on the calling thread. That callback is
+// where changes collected during the level are committed.
+//
+// A commit or a compaction replaces Design objects, so the netlist is
+// levelized again after each callback, and the next level is taken
+// from the new levels. Designs are told apart by library and name
+// across these, so that a rebuilt design is not visited twice; copies
+// made by a commit have names of their own and are visited if their
+// level is still ahead. A design whose level moves behind the current
+// one before it is visited is not visited.
+//
+// The transform must only change the design it is given; designs of
+// a level never instantiate each other, so it needs no locking.
+class LevelScheduler {
+public:
+    using Transform = std::function<void(Design*)>;
+    // The designs of level are those the transform ran on. The callback
+    // may replace them: they are not used afterwards.
+    using LevelCallback = std::function<void(const Level&)>;
+
+    LevelScheduler(const Netlist* netlist, ThreadPool* pool);
+    ~LevelScheduler();
+
+    void setLevelCallback(const LevelCallback& callback) {
+        _levelCallback = callback;
+    }
+
+    // From the leaves up to the top.
+    void runBottomUp(const Transform& transform);
+
+    // From the top down to the leaves.
+    void runTopDown(const Transform& transform);
+
+private:
+    const Netlist* _netlist {nullptr};
+    ThreadPool* _pool {nullptr};
+    LevelCallback _levelCallback;
+
+    std::unique_ptr<Levelize> _levelize;
+    // Library and name of every design visited by the current run.
+    std::unordered_set<uint64_t> _visited;
+    // Designs of the level being run.
+    std::vector<Design*> _levelDesigns;
+
+    void runLevel(uint32_t level, const Transform& transform);
+};
+
+}
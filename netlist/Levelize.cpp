@@ -0,0 +1,86 @@
+#include "Levelize.h"
+
+#include <algorithm>
+#include <ranges>
+
+#include "Design.h"
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+static_assert(std::ranges::bidirectional_range<LevelRange>);
+
+namespace {
+
+// Level of a design whose instances are still being visited.
+constexpr uint32_t IN_PROGRESS = UINT32_MAX;
+
+}
+
+Levelize::Levelize(const Netlist* netlist) {
+    std::vector<Design*> order;
+    for (Library* library : netlist->getLibraries()) {
+        for (Design* design : library->getDesigns()) {
+            computeLevel(netlist->getNameTable(), design, &order);
+        }
+    }
+
+    // Counting sort, keeping the visit order within each level.
+    uint32_t numLevels = 0;
+    for (Design* design : order) {
+        numLevels = std::max(numLevels, _levels[design] + 1);
+    }
+
+    _levelOffsets.assign(numLevels + 1, 0);
+    for (Design* design : order) {
+        _levelOffsets[_levels[design] + 1]++;
+    }
+    for (uint32_t i = 0; i < numLevels; i++) {
+        _levelOffsets[i + 1] += _levelOffsets[i];
+    }
+
+    _designs.resize(order.size());
+    std::vector<uint32_t> cursors(_levelOffsets.begin(), _levelOffsets.end() - 1);
+    for (Design* design : order) {
+        _designs[cursors[_levels[design]]++] = design;
+    }
+}
+
+Levelize::~Levelize() {
+}
+
+uint32_t Levelize::computeLevel(const NameTable* names,
+                                Design* design,
+                                std::vector<Design*>* order) {
+    const auto [it, inserted] = _levels.emplace(design, IN_PROGRESS);
+    if (!inserted) {
+        if (it->second == IN_PROGRESS) {
+            panic("design {} instantiates itself", names->getString(design->name));
+        }
+        return it->second;
+    }
+
+    uint32_t level = 0;
+    design->instances.forEach([&](const Instance& instance) {
+        level = std::max(level, computeLevel(names, instance.model, order) + 1);
+    });
+
+    // The map may have rehashed since it was looked up.
+    _levels[design] = level;
+    order->push_back(design);
+    return level;
+}
+
+uint32_t Levelize::getLevel(const Design* design) const {
+    const auto it = _levels.find(design);
+    if (it == _levels.end()) {
+        panic("design is not part of the levelized netlist");
+    }
+    return it->second;
+}
+
+}
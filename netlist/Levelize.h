@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <iterator>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace stargate {
+
+class Levelize;
+class NameTable;
+class Netlist;
+struct Design;
+
+// Designs of one level.
+class Level {
+public:
+    Level(uint32_t index, std::span<Design* const> designs)
+        : _index(index),
+        _designs(designs)
+    {
+    }
+
+    uint32_t getIndex() const { return _index; }
+    std::span<Design* const> designs() const { return _designs; }
+
+private:
+    uint32_t _index {0};
+    std::span<Design* const> _designs;
+};
+
+// The levels of a Levelize, level 0 first. Reversible with
+// std::views::reverse for top-down passes.
+class LevelRange {
+public:
+    class Iterator {
+    public:
+        using iterator_concept = std::bidirectional_iterator_tag;
+        using value_type = Level;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const Levelize* levelize, uint32_t index)
+            : _levelize(levelize),
+            _index(index)
+        {
+        }
+
+        Level operator*() const;
+
+        Iterator& operator++() {
+            _index++;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator it = *this;
+            _index++;
+            return it;
+        }
+
+        Iterator& operator--() {
+            _index--;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator it = *this;
+            _index--;
+            return it;
+        }
+
+        bool operator==(const Iterator& other) const { return _index == other._index; }
+
+    private:
+        const Levelize* _levelize {nullptr};
+        uint32_t _index {0};
+    };
+
+    LevelRange(const Levelize* levelize, uint32_t numLevels)
+        : _levelize(levelize),
+        _numLevels(numLevels)
+    {
+    }
+
+    Iterator begin() const { return Iterator(_levelize, 0); }
+    Iterator end() const { return Iterator(_levelize, _numLevels); }
+
+private:
+    const Levelize* _levelize {nullptr};
+    uint32_t _numLevels {0};
+};
+
+// Instantiation depth of every design of a netlist. A design without
+// instances, primitives included, is at level 0, and any other design
+// one level above its deepest model. Designs of a level never
+// instantiate one another, so a level can be processed in parallel once
+// the levels below it are done.
+//
+// Computed once from the netlist; changes to the hierarchy need a new
+// Levelize.
+class Levelize {
+public:
+    explicit Levelize(const Netlist* netlist);
+    ~Levelize();
+
+    uint32_t getNumLevels() const {
+        return static_cast<uint32_t>(_levelOffsets.size() - 1);
+    }
+
+    std::span<Design* const> designsAtLevel(uint32_t level) const {
+        const uint32_t begin = _levelOffsets[level];
+        return std::span<Design* const>(_designs).subspan(
+            begin, _levelOffsets[level + 1] - begin);
+    }
+
+    LevelRange levels() const { return LevelRange(this, getNumLevels()); }
+
+    // Throws if design is not part of the netlist.
+    uint32_t getLevel(const Design* design) const;
+
+private:
+    // Designs sorted by level, each level in library order. Level i
+    // is [_levelOffsets[i], _levelOffsets[i + 1]).
+    std::vector<Design*> _designs;
+    std::vector<uint32_t> _levelOffsets {0};
+    std::unordered_map<const Design*, uint32_t> _levels;
+
+    uint32_t computeLevel(const NameTable* names,
+                          Design* design,
+                          std::vector<Design*>* order);
+};
+
+inline Level LevelRange::Iterator::operator*() const {
+    return Level(_index, _levelize->designsAtLevel(_index));
+}
+
+}
@@ -0,0 +1,49 @@
+#include "Library.h"
+
+#include "Design.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+Library::Library(LibraryID id, NameID name, uint32_t flags)
+    : _id(id),
+    _name(name),
+    _flags(flags)
+{
+}
+
+Library::~Library() {
+}
+
+void Library::addDesign(Design* design) {
+    if (design->isPrimitive() && !isPrimitiveOnly()) {
+        panic("cannot add a primitive design to a non-primitive library");
+    }
+
+    if (!_designIndices.emplace(design->name, _designs.size()).second) {
+        panic("design name already used in its library");
+    }
+    _designs.push_back(design);
+}
+
+Design* Library::findDesign(NameID name) const {
+    const auto it = _designIndices.find(name);
+    return it != _designIndices.end() ? _designs[it->second] : nullptr;
+}
+
+size_t Library::getDesignIndex(const Design* design) const {
+    const auto it = _designIndices.find(design->name);
+    if (it == _designIndices.end() || _designs[it->second] != design) {
+        panic("design is not in this library");
+    }
+    return it->second;
+}
+
+void Library::replaceDesign(size_t index, Design* design) {
+    _designIndices.erase(_designs[index]->name);
+    _designs[index] = design;
+    _designIndices[design->name] = index;
+}
+
+}
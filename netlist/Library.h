@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+struct Design;
+
+// Named collection of designs. Design names are unique within a
+// library. Only the PrimitiveLibrary holds primitive designs.
+class Library {
+public:
+    Library(LibraryID id, NameID name, uint32_t flags);
+    virtual ~Library();
+
+    LibraryID getID() const { return _id; }
+    NameID getName() const { return _name; }
+
+    static constexpr uint32_t FLAG_PRIMITIVE_ONLY = 1 << 0;
+
+    bool isPrimitiveOnly() const { return _flags & FLAG_PRIMITIVE_ONLY; }
+
+    // Throws if the name is taken, or if design is a primitive and this
+    // is not the primitive library.
+    void addDesign(Design* design);
+
+    // Returns nullptr if there is no such design.
+    Design* findDesign(NameID name) const;
+
+    std::span<Design* const> getDesigns() const { return _designs; }
+
+protected:
+    std::vector<Design*> _designs;
+
+private:
+    LibraryID _id;
+    NameID _name;
+    uint32_t _flags {0};
+    // Index in _designs of each design name.
+    std::unordered_map<NameID, size_t> _designIndices;
+
+    // Throws if design is not in this library.
+    size_t getDesignIndex(const Design* design) const;
+
+    // Points the library at the final copy of its index-th design.
+    void replaceDesign(size_t index, Design* design);
+
+    friend class Compactor;
+    friend class NetlistBuilder;
+};
+
+}
@@ -0,0 +1,223 @@
+#include "NameTable.h"
+
+#include <string.h>
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+uint64_t fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+uint64_t makeSlot(uint64_t h, uint32_t id) {
+    return (h & 0xffffffff00000000ull) | id;
+}
+
+}
+
+NameTable::NameTable()
+    : _shards(std::make_unique<Shard[]>(SHARD_COUNT)),
+    _pages(std::make_unique<std::atomic<std::string_view*>[]>(PAGE_COUNT))
+{
+}
+
+NameTable::~NameTable() {
+    for (size_t i = 0; i < PAGE_COUNT; i++) {
+        delete[] _pages[i].load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t NameTable::hash(std::string_view str) {
+    // Names are short: mix them 8 bytes at a time.
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ str.size();
+    size_t i = 0;
+    for (; i + 8 <= str.size(); i += 8) {
+        uint64_t word = 0;
+        memcpy(&word, str.data() + i, 8);
+        h = fmix(h ^ word);
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, str.data() + i, str.size() - i);
+    return fmix(h ^ tail);
+}
+
+NameID NameTable::getName(std::string_view str) {
+    if (str.empty()) {
+        return NULL_NAME;
+    }
+
+    const uint64_t h = hash(str);
+    Shard* shard = &_shards[h & (SHARD_COUNT - 1)];
+    const NameID found = find(shard->table.load(std::memory_order_acquire), h, str);
+    if (found != NULL_NAME) {
+        return found;
+    }
+
+    std::lock_guard lock(shard->mutex);
+    return insert(shard, h, str);
+}
+
+NameID NameTable::findName(std::string_view str) const {
+    if (str.empty()) {
+        return NULL_NAME;
+    }
+
+    const uint64_t h = hash(str);
+    const Shard* shard = &_shards[h & (SHARD_COUNT - 1)];
+    return find(shard->table.load(std::memory_order_acquire), h, str);
+}
+
+void NameTable::loadNames(std::span<const std::string_view> strings) {
+    if (size() != 0) {
+        panic("names can only be loaded into an empty name table");
+    }
+    if (strings.size() >= UINT32_MAX) {
+        panic("name table is full");
+    }
+
+    std::vector<uint64_t> hashes(strings.size());
+    std::vector<size_t> counts(SHARD_COUNT, 0);
+    for (size_t i = 0; i < strings.size(); i++) {
+        if (strings[i].empty()) {
+            panic("cannot load an empty name");
+        }
+        hashes[i] = hash(strings[i]);
+        counts[hashes[i] & (SHARD_COUNT - 1)]++;
+    }
+
+    // Each shard gets its final table at once.
+    for (size_t s = 0; s < SHARD_COUNT; s++) {
+        size_t slots = INITIAL_SLOTS;
+        while (counts[s] * 2 > slots) {
+            slots *= 2;
+        }
+
+        Table* table = new Table();
+        table->mask = slots - 1;
+        table->slots.reset(new std::atomic<uint64_t>[slots]());
+        _shards[s].tables.emplace_back(table);
+        _shards[s].table.store(table, std::memory_order_relaxed);
+        _shards[s].count = counts[s];
+    }
+
+    for (size_t i = 0; i < strings.size(); i++) {
+        const uint32_t id = static_cast<uint32_t>(i + 1);
+        setString(id, strings[i]);
+
+        const uint64_t h = hashes[i];
+        const Shard* shard = &_shards[h & (SHARD_COUNT - 1)];
+        Table* table = shard->table.load(std::memory_order_relaxed);
+        size_t slot = (h >> SHARD_BITS) & table->mask;
+        while (table->slots[slot].load(std::memory_order_relaxed) != 0) {
+            slot = (slot + 1) & table->mask;
+        }
+        table->slots[slot].store(makeSlot(h, id), std::memory_order_relaxed);
+    }
+    _nextID.store(static_cast<uint32_t>(strings.size() + 1), std::memory_order_release);
+}
+
+NameID NameTable::find(const Table* table, uint64_t h, std::string_view str) const {
+    if (!table) {
+        return NULL_NAME;
+    }
+
+    // The low bits chose the shard; the probe starts from the next ones.
+    size_t slot = (h >> SHARD_BITS) & table->mask;
+    while (true) {
+        const uint64_t value = table->slots[slot].load(std::memory_order_acquire);
+        if (value == 0) {
+            return NULL_NAME;
+        }
+
+        const NameID id {static_cast<uint32_t>(value)};
+        if (makeSlot(h, 0) == makeSlot(value, 0) && getString(id) == str) {
+            return id;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+}
+
+NameID NameTable::insert(Shard* shard, uint64_t h, std::string_view str) {
+    // Another thread may have inserted str since the unlocked lookup.
+    const NameID found = find(shard->table.load(std::memory_order_relaxed), h, str);
+    if (found != NULL_NAME) {
+        return found;
+    }
+
+    const Table* current = shard->table.load(std::memory_order_relaxed);
+    if (!current || (shard->count + 1) * 2 > current->mask + 1) {
+        grow(shard);
+    }
+
+    const uint32_t id = _nextID.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0) {
+        panic("name table is full");
+    }
+    setString(id, shard->arena.copyString(str));
+
+    // Published last: a reader that finds the slot sees the string.
+    Table* table = shard->table.load(std::memory_order_relaxed);
+    size_t slot = (h >> SHARD_BITS) & table->mask;
+    while (table->slots[slot].load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) & table->mask;
+    }
+    table->slots[slot].store(makeSlot(h, id), std::memory_order_release);
+    shard->count++;
+    return NameID {id};
+}
+
+void NameTable::grow(Shard* shard) {
+    const Table* old = shard->table.load(std::memory_order_relaxed);
+    const size_t size = old ? (old->mask + 1) * 2 : INITIAL_SLOTS;
+
+    Table* table = new Table();
+    shard->tables.emplace_back(table);
+    table->mask = size - 1;
+    table->slots.reset(new std::atomic<uint64_t>[size]());
+
+    if (old) {
+        for (size_t i = 0; i <= old->mask; i++) {
+            const uint64_t value = old->slots[i].load(std::memory_order_relaxed);
+            if (value == 0) {
+                continue;
+            }
+
+            const NameID id {static_cast<uint32_t>(value)};
+            size_t slot = (hash(getString(id)) >> SHARD_BITS) & table->mask;
+            while (table->slots[slot].load(std::memory_order_relaxed) != 0) {
+                slot = (slot + 1) & table->mask;
+            }
+            table->slots[slot].store(value, std::memory_order_relaxed);
+        }
+    }
+
+    shard->table.store(table, std::memory_order_release);
+}
+
+void NameTable::setString(uint32_t id, std::string_view str) {
+    std::atomic<std::string_view*>& pageRef = _pages[id >> PAGE_BITS];
+    std::string_view* page = pageRef.load(std::memory_order_acquire);
+    if (!page) {
+        // Shards insert concurrently, so two of them may race to create
+        // the page; the loser frees its copy.
+        std::string_view* created = new std::string_view[PAGE_SIZE];
+        if (pageRef.compare_exchange_strong(page, created,
+                                            std::memory_order_acq_rel)) {
+            page = created;
+        } else {
+            delete[] created;
+        }
+    }
+    page[id & PAGE_MASK] = str;
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "NetlistIDs.h"
+
+#include "Arena.h"
+
+namespace stargate {
+
+// Interned names of netlist objects. Objects carry a 4-byte NameID
+// instead of a string, the same string always yields the same ID, and
+// each distinct string is stored once.
+//
+// Safe to use from many threads at once. getString() and findName()
+// are wait-free; getName() is too when the name already exists, and
+// otherwise locks one of SHARD_COUNT shards to insert it. Each shard
+// is an open-addressing table that readers probe without locking. A
+// shard that grows publishes a new table and keeps the old one for
+// readers still probing it, until the NameTable is destroyed.
+class NameTable {
+public:
+    NameTable();
+    ~NameTable();
+
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    NameID getName(std::string_view str);
+
+    // Returns NULL_NAME if str was never interned.
+    NameID findName(std::string_view str) const;
+
+    std::string_view getString(NameID name) const {
+        const std::string_view* page =
+            _pages[name.value >> PAGE_BITS].load(std::memory_order_acquire);
+        return page[name.value & PAGE_MASK];
+    }
+
+    size_t size() const { return _nextID.load(std::memory_order_relaxed) - 1; }
+
+    // Fills an empty table with strings[i] as name i + 1, without
+    // copying them: they must outlive the table. The strings of a dumped
+    // table are distinct and non-empty. Not thread-safe.
+    void loadNames(std::span<const std::string_view> strings);
+
+private:
+    // Slots hold the upper half of a name's hash next to its ID, so
+    // most mismatches are rejected without reading the string. A zero
+    // slot is empty, since ID 0 is never stored.
+    struct Table {
+        size_t mask {0};
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::atomic<Table*> table {nullptr};
+        // Every table of the shard, the current one last.
+        std::vector<std::unique_ptr<Table>> tables;
+        size_t count {0};
+        Arena arena;
+    };
+
+    static constexpr size_t SHARD_BITS = 6;
+    static constexpr size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+    static constexpr size_t INITIAL_SLOTS = 64;
+
+    // IDs index strings through fixed-size pages, so a reader never
+    // sees storage move under it.
+    static constexpr uint32_t PAGE_BITS = 16;
+    static constexpr uint32_t PAGE_SIZE = uint32_t(1) << PAGE_BITS;
+    static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+    static constexpr size_t PAGE_COUNT = size_t(1) << (32 - PAGE_BITS);
+
+    std::unique_ptr<Shard[]> _shards;
+    std::unique_ptr<std::atomic<std::string_view*>[]> _pages;
+    std::atomic<uint32_t> _nextID {1};
+
+    static uint64_t hash(std::string_view str);
+
+    NameID find(const Table* table, uint64_t h, std::string_view str) const;
+    NameID insert(Shard* shard, uint64_t h, std::string_view str);
+    void grow(Shard* shard);
+    void setString(uint32_t id, std::string_view str);
+};
+
+}
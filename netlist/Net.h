@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChunkedSpan.h"
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+struct BitDesignTerm;
+struct BitInstTerm;
+struct BusNet;
+struct Design;
+
+// Bit-level net, the only kind of net that takes part in
+// connectivity. The connection lists point into the reference pools
+// of the spaces that made the connections.
+struct BitNet {
+    NetID id;
+    NameID name;
+    Design* parent {nullptr};
+    ChunkedSpan<BitInstTerm*> connectedInstTerms;
+    ChunkedSpan<BitDesignTerm*> connectedDesignTerms;
+};
+
+struct ScalarNet : BitNet {
+};
+
+// Bit index of a bus net. Its name is the name of the bus.
+struct BusNetBit : BitNet {
+    BusNet* bus {nullptr};
+    uint32_t index {0};
+};
+
+struct BusNet {
+    NetID id;
+    NameID name;
+    Design* parent {nullptr};
+    int32_t msb {0};
+    int32_t lsb {0};
+    ChunkedSpan<BusNetBit> bits;
+
+    uint32_t getWidth() const {
+        return static_cast<uint32_t>(msb > lsb ? msb - lsb : lsb - msb) + 1;
+    }
+};
+
+}
@@ -0,0 +1,65 @@
+#include "Netlist.h"
+
+#include "Design.h"
+#include "Library.h"
+#include "MappedFile.h"
+#include "NameTable.h"
+#include "NetlistSpace.h"
+#include "PrimitiveLibrary.h"
+
+namespace stargate {
+
+Netlist::Netlist()
+    : _nameTable(std::make_unique<NameTable>())
+{
+}
+
+Netlist::~Netlist() {
+}
+
+Library* Netlist::findLibrary(NameID name) const {
+    for (Library* library : _libraries) {
+        if (library->getName() == name) {
+            return library;
+        }
+    }
+    return nullptr;
+}
+
+Design* Netlist::findDesign(NameID name) const {
+    for (Library* library : _libraries) {
+        if (Design* design = library->findDesign(name)) {
+            return design;
+        }
+    }
+    return nullptr;
+}
+
+NetlistSpace* Netlist::getCurrentSpace() const {
+    return _spaces.empty() ? nullptr : _spaces.back().get();
+}
+
+NetlistSpace* Netlist::createSpace() {
+    const uint32_t index = static_cast<uint32_t>(_spaces.size());
+    _spaces.emplace_back(new NetlistSpace(index));
+    return _spaces.back().get();
+}
+
+void Netlist::releaseSpaces(const std::vector<bool>& released) {
+    size_t kept = 0;
+    for (size_t i = 0; i < _spaces.size(); i++) {
+        if (released[i]) {
+            continue;
+        }
+        _spaces[i]->_index = static_cast<uint32_t>(kept);
+        _spaces[kept++].reset(_spaces[i].release());
+    }
+    _spaces.resize(kept);
+}
+
+void Netlist::addLibrary(Library* library) {
+    _libraries.push_back(library);
+    _ownedLibraries.emplace_back(library);
+}
+
+}
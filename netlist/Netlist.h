@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+class Library;
+class MappedFile;
+class NameTable;
+class NetlistSpace;
+class PrimitiveLibrary;
+struct Design;
+
+// Hierarchical netlist: libraries of designs, whose objects are owned
+// by a stack of NetlistSpaces. Objects are only created through the
+// NetlistBuilder, which also hands out their IDs, or loaded from a
+// dump by the NetlistLoader.
+class Netlist {
+public:
+    Netlist();
+    ~Netlist();
+
+    Netlist(const Netlist&) = delete;
+    Netlist& operator=(const Netlist&) = delete;
+
+    Design* getTopDesign() const { return _topDesign; }
+
+    NameTable* getNameTable() { return _nameTable.get(); }
+    const NameTable* getNameTable() const { return _nameTable.get(); }
+
+    PrimitiveLibrary* getPrimitiveLibrary() const { return _primitiveLibrary; }
+    std::span<Library* const> getLibraries() const { return _libraries; }
+
+    // Return nullptr if there is no such library or design. A design
+    // is searched in every library in turn.
+    Library* findLibrary(NameID name) const;
+    Design* findDesign(NameID name) const;
+
+    // Spaces, oldest first. The newest one is the current space.
+    size_t getNumSpaces() const { return _spaces.size(); }
+    NetlistSpace* getSpace(size_t index) const { return _spaces[index].get(); }
+    NetlistSpace* getCurrentSpace() const;
+
+private:
+    // Mapped image the spaces of a loaded netlist live in.
+    std::unique_ptr<MappedFile> _image;
+    std::unique_ptr<NameTable> _nameTable;
+    std::vector<std::unique_ptr<NetlistSpace>> _spaces;
+    std::vector<std::unique_ptr<Library>> _ownedLibraries;
+    std::vector<Library*> _libraries;
+    PrimitiveLibrary* _primitiveLibrary {nullptr};
+    Design* _topDesign {nullptr};
+
+    // Next ID of each kind, unique across the whole netlist.
+    uint32_t _nextNetID {0};
+    uint32_t _nextInstanceID {0};
+    uint32_t _nextDesignTermID {0};
+    uint32_t _nextInstTermID {0};
+    uint32_t _nextDesignID {0};
+    uint32_t _nextLibraryID {0};
+
+    NetlistSpace* createSpace();
+    // Takes ownership of library.
+    void addLibrary(Library* library);
+    // Destroys the spaces flagged in released, and renumbers the others.
+    void releaseSpaces(const std::vector<bool>& released);
+
+    friend class Compactor;
+    friend class NetlistBuilder;
+    friend class NetlistDumper;
+    friend class NetlistLoader;
+};
+
+}
@@ -0,0 +1,629 @@
+#include "NetlistBuilder.h"
+
+#include <memory>
+#include <span>
+
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistSpace.h"
+#include "PrimitiveLibrary.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+// Copies the staged objects into space grouped by design, in creation
+// order within each design, and points the span member of every
+// design at its range.
+template <typename T, typename DesignIndex>
+std::span<T> groupByDesign(NetlistSpace* space,
+                           const std::deque<T>& staged,
+                           const std::vector<Design*>& designs,
+                           DesignIndex designIndex,
+                           ChunkedSpan<T> Design::*member) {
+    std::vector<size_t> offsets(designs.size() + 1, 0);
+    for (const T& obj : staged) {
+        offsets[designIndex(obj) + 1]++;
+    }
+    for (size_t d = 0; d < designs.size(); d++) {
+        offsets[d + 1] += offsets[d];
+    }
+
+    const std::span<T> objects = space->allocate<T>(staged.size());
+    for (size_t d = 0; d < designs.size(); d++) {
+        const size_t count = offsets[d + 1] - offsets[d];
+        designs[d]->*member = ChunkedSpan<T>(objects.subspan(offsets[d], count));
+    }
+
+    for (const T& obj : staged) {
+        objects[offsets[designIndex(obj)]++] = obj;
+    }
+    return objects;
+}
+
+// Copies the staged range of a span into space, and points the span at
+// the copy.
+template <typename T>
+std::span<T> moveToSpace(NetlistSpace* space, ChunkedSpan<T>& span) {
+    const std::span<T> staged = span.empty() ? std::span<T>() : span.getChunk(0);
+    const std::span<T> objects = space->allocate<T>(staged.size());
+    for (size_t i = 0; i < staged.size(); i++) {
+        objects[i] = staged[i];
+    }
+    span = ChunkedSpan<T>(objects);
+    return objects;
+}
+
+uint32_t getWidth(int32_t msb, int32_t lsb) {
+    return static_cast<uint32_t>(msb > lsb ? msb - lsb : lsb - msb) + 1;
+}
+
+}
+
+NetlistBuilder::NetlistBuilder(Netlist* netlist)
+    : _netlist(netlist),
+    _firstNetID(netlist->_nextNetID),
+    _firstDesignID(netlist->_nextDesignID)
+{
+}
+
+NetlistBuilder::~NetlistBuilder() {
+}
+
+Library* NetlistBuilder::createLibrary(NameID name) {
+    if (_netlist->findLibrary(name)) {
+        panic("library {} already exists",
+              _netlist->getNameTable()->getString(name));
+    }
+
+    const LibraryID id {_netlist->_nextLibraryID++};
+    Library* library = new Library(id, name, 0);
+    _netlist->addLibrary(library);
+    return library;
+}
+
+PrimitiveLibrary* NetlistBuilder::createPrimitiveLibrary() {
+    if (_netlist->_primitiveLibrary) {
+        panic("the netlist already has a primitive library");
+    }
+
+    const LibraryID id {_netlist->_nextLibraryID++};
+    const NameID name = _netlist->getNameTable()->getName("SYSTEM");
+    PrimitiveLibrary* library = new PrimitiveLibrary(id, name);
+    _netlist->addLibrary(library);
+    _netlist->_primitiveLibrary = library;
+
+    library->initialize(this);
+    return library;
+}
+
+Design* NetlistBuilder::createDesign(Library* library, NameID name) {
+    return stageDesign(library, name, PrimitiveKind::None);
+}
+
+Design* NetlistBuilder::createPrimitiveDesign(PrimitiveLibrary* library,
+                                              PrimitiveKind kind,
+                                              NameID name) {
+    return stageDesign(library, name, kind);
+}
+
+Design* NetlistBuilder::stageDesign(Library* library, NameID name, PrimitiveKind kind) {
+    Design& design = _designs.emplace_back();
+    design.id = DesignID {_netlist->_nextDesignID++};
+    design.name = name;
+    design.library = library;
+    design.primitiveKind = kind;
+    design.setPrimitive(kind != PrimitiveKind::None);
+
+    DesignStage& stage = _stages.emplace_back();
+    stage.library = library;
+    stage.libraryIndex = library->getDesigns().size();
+    library->addDesign(&design);
+    return &design;
+}
+
+Design* NetlistBuilder::createReplacement(Design* design) {
+    if (isStaged(design)) {
+        panic("design {} is not built yet",
+              _netlist->getNameTable()->getString(design->name));
+    }
+    if (design->isPrimitive()) {
+        panic("primitive designs cannot be replaced");
+    }
+
+    Design& replacement = _designs.emplace_back();
+    replacement.id = DesignID {_netlist->_nextDesignID++};
+    replacement.name = design->name;
+    replacement.library = design->library;
+    replacement.flags = design->flags;
+
+    DesignStage& stage = _stages.emplace_back();
+    stage.library = design->library;
+    stage.libraryIndex = design->library->getDesignIndex(design);
+    stage.replaced = design;
+    return &replacement;
+}
+
+void NetlistBuilder::setTopDesign(Design* design) {
+    _topDesign = design;
+}
+
+bool NetlistBuilder::isStaged(const Design* design) const {
+    if (design->id.value < _firstDesignID) {
+        return false;
+    }
+    const size_t index = design->id.value - _firstDesignID;
+    return index < _designs.size() && &_designs[index] == design;
+}
+
+NetlistBuilder::DesignStage* NetlistBuilder::getStage(const Design* design) {
+    if (!isStaged(design)) {
+        panic("design {} is not being built by this builder",
+              _netlist->getNameTable()->getString(design->name));
+    }
+    return &_stages[design->id.value - _firstDesignID];
+}
+
+ScalarNet* NetlistBuilder::addScalarNet(Design* design, NameID name) {
+    getStage(design);
+    if (design->isPrimitive()) {
+        panic("primitive designs have no nets");
+    }
+
+    ScalarNet& net = _scalarNets.emplace_back();
+    net.id = NetID {_netlist->_nextNetID++};
+    net.name = name;
+    net.parent = design;
+    return &net;
+}
+
+BusNet* NetlistBuilder::addBusNet(Design* design, NameID name, int32_t msb, int32_t lsb) {
+    getStage(design);
+    if (design->isPrimitive()) {
+        panic("primitive designs have no nets");
+    }
+
+    BusNet& bus = _busNets.emplace_back();
+    bus.id = NetID {_netlist->_nextNetID++};
+    bus.name = name;
+    bus.parent = design;
+    bus.msb = msb;
+    bus.lsb = lsb;
+
+    std::vector<BusNetBit>& bits = _busNetBits.emplace_back(getWidth(msb, lsb));
+    for (size_t i = 0; i < bits.size(); i++) {
+        BusNetBit& bit = bits[i];
+        bit.id = NetID {_netlist->_nextNetID++};
+        bit.name = name;
+        bit.parent = design;
+        bit.bus = &bus;
+        bit.index = static_cast<uint32_t>(i);
+    }
+    bus.bits = ChunkedSpan<BusNetBit>(bits);
+    _numBusNetBits += bits.size();
+    return &bus;
+}
+
+ScalarDesignTerm* NetlistBuilder::addScalarDesignTerm(Design* design,
+                                                      NameID name,
+                                                      Direction dir) {
+    DesignStage* stage = getStage(design);
+    if (stage->instantiated) {
+        panic("cannot add a term to an instantiated design");
+    }
+
+    ScalarDesignTerm& term = _scalarDesignTerms.emplace_back();
+    term.id = DesignTermID {_netlist->_nextDesignTermID++};
+    term.name = name;
+    term.parent = design;
+    term.direction = dir;
+    stage->scalarDesignTerms.push_back(&term);
+    return &term;
+}
+
+BusDesignTerm* NetlistBuilder::addBusDesignTerm(Design* design,
+                                                NameID name,
+                                                Direction dir,
+                                                int32_t msb,
+                                                int32_t lsb) {
+    DesignStage* stage = getStage(design);
+    if (stage->instantiated) {
+        panic("cannot add a term to an instantiated design");
+    }
+
+    BusDesignTerm& bus = _busDesignTerms.emplace_back();
+    bus.id = DesignTermID {_netlist->_nextDesignTermID++};
+    bus.name = name;
+    bus.parent = design;
+    bus.direction = dir;
+    bus.msb = msb;
+    bus.lsb = lsb;
+
+    std::vector<BusDesignTermBit>& bits =
+        _busDesignTermBits.emplace_back(getWidth(msb, lsb));
+    for (size_t i = 0; i < bits.size(); i++) {
+        BusDesignTermBit& bit = bits[i];
+        bit.id = DesignTermID {_netlist->_nextDesignTermID++};
+        bit.parent = design;
+        bit.direction = dir;
+        bit.bus = &bus;
+        bit.index = static_cast<uint32_t>(i);
+    }
+    bus.bits = ChunkedSpan<BusDesignTermBit>(bits);
+    _numBusDesignTermBits += bits.size();
+    stage->busDesignTerms.push_back(&bus);
+    return &bus;
+}
+
+Instance* NetlistBuilder::addInstance(Design* design, NameID name, Design* model) {
+    getStage(design);
+    if (design->isPrimitive()) {
+        panic("primitive designs have no instances");
+    }
+
+    // The terms of the model, staged or built.
+    std::vector<const BusDesignTerm*> busTerms;
+    size_t numScalarTerms = 0;
+    if (isStaged(model)) {
+        DesignStage* modelStage = getStage(model);
+        modelStage->instantiated = true;
+        numScalarTerms = modelStage->scalarDesignTerms.size();
+        busTerms.assign(modelStage->busDesignTerms.begin(),
+                        modelStage->busDesignTerms.end());
+    } else {
+        numScalarTerms = model->scalarDesignTerms.size();
+        for (const BusDesignTerm& term : model->busDesignTerms) {
+            busTerms.push_back(&term);
+        }
+    }
+
+    if (numScalarTerms > UINT16_MAX || busTerms.size() > UINT16_MAX) {
+        panic("design {} has too many terms to be instantiated",
+              _netlist->getNameTable()->getString(model->name));
+    }
+
+    Instance& inst = _instances.emplace_back();
+    inst.id = InstanceID {_netlist->_nextInstanceID++};
+    inst.name = name;
+    inst.parent = design;
+    inst.model = model;
+    inst.setPrimitiveKind(model->primitiveKind);
+
+    std::vector<ScalarInstTerm>& scalarTerms =
+        _scalarInstTerms.emplace_back(numScalarTerms);
+    for (size_t i = 0; i < scalarTerms.size(); i++) {
+        ScalarInstTerm& term = scalarTerms[i];
+        term.id = InstTermID {_netlist->_nextInstTermID++};
+        term.instance = &inst;
+        term.scalarTermIndex = static_cast<uint16_t>(i);
+    }
+    inst.scalarInstTerms = ChunkedSpan<ScalarInstTerm>(scalarTerms);
+    _numScalarInstTerms += scalarTerms.size();
+
+    std::vector<BusInstTerm>& buses = _busInstTerms.emplace_back(busTerms.size());
+    for (size_t i = 0; i < buses.size(); i++) {
+        BusInstTerm& bus = buses[i];
+        bus.id = InstTermID {_netlist->_nextInstTermID++};
+        bus.instance = &inst;
+        bus.busTermIndex = static_cast<uint16_t>(i);
+
+        std::vector<BusInstTermBit>& bits =
+            _busInstTermBits.emplace_back(busTerms[i]->bits.size());
+        for (size_t j = 0; j < bits.size(); j++) {
+            BusInstTermBit& bit = bits[j];
+            bit.id = InstTermID {_netlist->_nextInstTermID++};
+            bit.instance = &inst;
+            bit.bus = &bus;
+            bit.busTermIndex = static_cast<uint16_t>(i);
+            bit.bitIndex = static_cast<uint16_t>(j);
+        }
+        bus.bits = ChunkedSpan<BusInstTermBit>(bits);
+        _numBusInstTermBits += bits.size();
+    }
+    inst.busInstTerms = ChunkedSpan<BusInstTerm>(buses);
+    _numBusInstTerms += buses.size();
+
+    return &inst;
+}
+
+void NetlistBuilder::checkConnection(const BitNet* net, const Design* termDesign) {
+    if (net->id.value < _firstNetID || !isStaged(net->parent)) {
+        panic("net is not being built by this builder");
+    }
+    if (net->parent != termDesign) {
+        panic("a net only connects to terms of its own design");
+    }
+}
+
+void NetlistBuilder::connect(BitNet* net, BitInstTerm* term) {
+    checkConnection(net, term->instance->parent);
+    term->connectedNet = net;
+}
+
+void NetlistBuilder::connect(BitNet* net, BitDesignTerm* term) {
+    checkConnection(net, term->parent);
+    term->connectedNet = net;
+}
+
+void NetlistBuilder::checkStaged(const Design* termDesign) {
+    if (!isStaged(termDesign)) {
+        panic("term is not being built by this builder");
+    }
+}
+
+void NetlistBuilder::disconnect(BitInstTerm* term) {
+    checkStaged(term->instance->parent);
+    term->connectedNet = nullptr;
+}
+
+void NetlistBuilder::disconnect(BitDesignTerm* term) {
+    checkStaged(term->parent);
+    term->connectedNet = nullptr;
+}
+
+void NetlistBuilder::finalize() {
+    if (_designs.empty()) {
+        if (_topDesign) {
+            _netlist->_topDesign = _topDesign;
+        }
+        clear();
+        return;
+    }
+
+    // Connections are only known once every term is staged.
+    size_t numInstTermRefs = 0;
+    for (const std::vector<ScalarInstTerm>& terms : _scalarInstTerms) {
+        for (const ScalarInstTerm& term : terms) {
+            numInstTermRefs += term.connectedNet != nullptr;
+        }
+    }
+    for (const std::vector<BusInstTermBit>& bits : _busInstTermBits) {
+        for (const BusInstTermBit& bit : bits) {
+            numInstTermRefs += bit.connectedNet != nullptr;
+        }
+    }
+
+    size_t numDesignTermRefs = 0;
+    for (const ScalarDesignTerm& term : _scalarDesignTerms) {
+        numDesignTermRefs += term.connectedNet != nullptr;
+    }
+    for (const std::vector<BusDesignTermBit>& bits : _busDesignTermBits) {
+        for (const BusDesignTermBit& bit : bits) {
+            numDesignTermRefs += bit.connectedNet != nullptr;
+        }
+    }
+
+    NetlistSpace* space = _netlist->createSpace();
+    space->reserve<Design>(_designs.size());
+    space->reserve<ScalarNet>(_scalarNets.size());
+    space->reserve<BusNet>(_busNets.size());
+    space->reserve<BusNetBit>(_numBusNetBits);
+    space->reserve<ScalarDesignTerm>(_scalarDesignTerms.size());
+    space->reserve<BusDesignTerm>(_busDesignTerms.size());
+    space->reserve<BusDesignTermBit>(_numBusDesignTermBits);
+    space->reserve<Instance>(_instances.size());
+    space->reserve<ScalarInstTerm>(_numScalarInstTerms);
+    space->reserve<BusInstTerm>(_numBusInstTerms);
+    space->reserve<BusInstTermBit>(_numBusInstTermBits);
+    space->reserve<BitInstTerm*>(numInstTermRefs);
+    space->reserve<BitDesignTerm*>(numDesignTermRefs);
+
+    std::vector<Design*> finalDesigns;
+    std::vector<BitNet*> finalNets;
+    layOutDesigns(space, finalDesigns);
+    layOutNets(space, finalDesigns, finalNets);
+    layOutDesignTerms(space, finalDesigns);
+    layOutInstances(space, finalDesigns);
+    layOutConnections(space, finalNets);
+
+    for (size_t d = 0; d < _stages.size(); d++) {
+        if (_stages[d].replaced && _stages[d].replaced == _netlist->_topDesign) {
+            _netlist->_topDesign = finalDesigns[d];
+        }
+    }
+
+    if (_topDesign) {
+        _netlist->_topDesign = isStaged(_topDesign)
+            ? finalDesigns[_topDesign->id.value - _firstDesignID]
+            : _topDesign;
+    }
+
+    clear();
+}
+
+void NetlistBuilder::layOutDesigns(NetlistSpace* space,
+                                   std::vector<Design*>& finalDesigns) {
+    const std::span<Design> designs = space->allocate<Design>(_designs.size());
+    finalDesigns.resize(designs.size());
+    for (size_t d = 0; d < designs.size(); d++) {
+        designs[d] = _designs[d];
+        finalDesigns[d] = &designs[d];
+        _stages[d].library->replaceDesign(_stages[d].libraryIndex, &designs[d]);
+    }
+}
+
+void NetlistBuilder::layOutNets(NetlistSpace* space,
+                                const std::vector<Design*>& finalDesigns,
+                                std::vector<BitNet*>& finalNets) {
+    const auto designIndex = [this](const auto& obj) {
+        return obj.parent->id.value - _firstDesignID;
+    };
+    finalNets.assign(_netlist->_nextNetID - _firstNetID, nullptr);
+
+    const std::span<ScalarNet> scalarNets = groupByDesign(
+        space, _scalarNets, finalDesigns, designIndex, &Design::scalarNets);
+    for (ScalarNet& net : scalarNets) {
+        net.parent = finalDesigns[designIndex(net)];
+        finalNets[net.id.value - _firstNetID] = &net;
+    }
+
+    const std::span<BusNet> busNets = groupByDesign(
+        space, _busNets, finalDesigns, designIndex, &Design::busNets);
+    for (BusNet& bus : busNets) {
+        bus.parent = finalDesigns[designIndex(bus)];
+        for (BusNetBit& bit : moveToSpace(space, bus.bits)) {
+            bit.parent = bus.parent;
+            bit.bus = &bus;
+            finalNets[bit.id.value - _firstNetID] = &bit;
+        }
+    }
+}
+
+void NetlistBuilder::layOutDesignTerms(NetlistSpace* space,
+                                       const std::vector<Design*>& finalDesigns) {
+    const auto designIndex = [this](const auto& obj) {
+        return obj.parent->id.value - _firstDesignID;
+    };
+
+    const std::span<ScalarDesignTerm> scalarTerms = groupByDesign(
+        space, _scalarDesignTerms, finalDesigns, designIndex,
+        &Design::scalarDesignTerms);
+    for (ScalarDesignTerm& term : scalarTerms) {
+        term.parent = finalDesigns[designIndex(term)];
+    }
+
+    const std::span<BusDesignTerm> busTerms = groupByDesign(
+        space, _busDesignTerms, finalDesigns, designIndex, &Design::busDesignTerms);
+    for (BusDesignTerm& bus : busTerms) {
+        bus.parent = finalDesigns[designIndex(bus)];
+        for (BusDesignTermBit& bit : moveToSpace(space, bus.bits)) {
+            bit.parent = bus.parent;
+            bit.bus = &bus;
+        }
+    }
+}
+
+void NetlistBuilder::layOutInstances(NetlistSpace* space,
+                                     const std::vector<Design*>& finalDesigns) {
+    const auto designIndex = [this](const Instance& inst) {
+        return inst.parent->id.value - _firstDesignID;
+    };
+
+    const std::span<Instance> instances = groupByDesign(
+        space, _instances, finalDesigns, designIndex, &Design::instances);
+
+    for (Instance& inst : instances) {
+        inst.parent = finalDesigns[designIndex(inst)];
+        if (isStaged(inst.model)) {
+            inst.model = finalDesigns[inst.model->id.value - _firstDesignID];
+        }
+
+        for (ScalarInstTerm& term : moveToSpace(space, inst.scalarInstTerms)) {
+            term.instance = &inst;
+        }
+        for (BusInstTerm& bus : moveToSpace(space, inst.busInstTerms)) {
+            bus.instance = &inst;
+            for (BusInstTermBit& bit : moveToSpace(space, bus.bits)) {
+                bit.instance = &inst;
+                bit.bus = &bus;
+            }
+        }
+    }
+}
+
+void NetlistBuilder::layOutConnections(NetlistSpace* space,
+                                       const std::vector<BitNet*>& finalNets) {
+    // Point every connected term at the final net and count the terms
+    // of each net, then give each net one contiguous range of
+    // references.
+    std::vector<uint32_t> instTermCounts(finalNets.size(), 0);
+    std::vector<uint32_t> designTermCounts(finalNets.size(), 0);
+
+    const auto remapInstTerm = [&](BitInstTerm& term) {
+        if (term.connectedNet) {
+            const size_t index = term.connectedNet->id.value - _firstNetID;
+            term.connectedNet = finalNets[index];
+            instTermCounts[index]++;
+        }
+    };
+    const auto remapDesignTerm = [&](BitDesignTerm& term) {
+        if (term.connectedNet) {
+            const size_t index = term.connectedNet->id.value - _firstNetID;
+            term.connectedNet = finalNets[index];
+            designTermCounts[index]++;
+        }
+    };
+
+    for (ScalarInstTerm& term : space->getObjects<ScalarInstTerm>()) {
+        remapInstTerm(term);
+    }
+    for (BusInstTermBit& bit : space->getObjects<BusInstTermBit>()) {
+        remapInstTerm(bit);
+    }
+    for (ScalarDesignTerm& term : space->getObjects<ScalarDesignTerm>()) {
+        remapDesignTerm(term);
+    }
+    for (BusDesignTermBit& bit : space->getObjects<BusDesignTermBit>()) {
+        remapDesignTerm(bit);
+    }
+
+    for (size_t i = 0; i < finalNets.size(); i++) {
+        BitNet* net = finalNets[i];
+        if (!net) {
+            continue;
+        }
+        net->connectedInstTerms = ChunkedSpan<BitInstTerm*>(
+            space->allocate<BitInstTerm*>(instTermCounts[i]));
+        net->connectedDesignTerms = ChunkedSpan<BitDesignTerm*>(
+            space->allocate<BitDesignTerm*>(designTermCounts[i]));
+        // Reused below as the number of references filled so far.
+        instTermCounts[i] = 0;
+        designTermCounts[i] = 0;
+    }
+
+    const auto addInstTerm = [&](BitInstTerm& term) {
+        if (BitNet* net = term.connectedNet) {
+            const size_t index = net->id.value - _firstNetID;
+            net->connectedInstTerms.data()[instTermCounts[index]++] = &term;
+        }
+    };
+    const auto addDesignTerm = [&](BitDesignTerm& term) {
+        if (BitNet* net = term.connectedNet) {
+            const size_t index = net->id.value - _firstNetID;
+            net->connectedDesignTerms.data()[designTermCounts[index]++] = &term;
+        }
+    };
+
+    for (ScalarInstTerm& term : space->getObjects<ScalarInstTerm>()) {
+        addInstTerm(term);
+    }
+    for (BusInstTermBit& bit : space->getObjects<BusInstTermBit>()) {
+        addInstTerm(bit);
+    }
+    for (ScalarDesignTerm& term : space->getObjects<ScalarDesignTerm>()) {
+        addDesignTerm(term);
+    }
+    for (BusDesignTermBit& bit : space->getObjects<BusDesignTermBit>()) {
+        addDesignTerm(bit);
+    }
+}
+
+void NetlistBuilder::clear() {
+    _topDesign = nullptr;
+    _firstNetID = _netlist->_nextNetID;
+    _firstDesignID = _netlist->_nextDesignID;
+
+    _designs.clear();
+    _stages.clear();
+    _scalarNets.clear();
+    _busNets.clear();
+    _scalarDesignTerms.clear();
+    _busDesignTerms.clear();
+    _instances.clear();
+    _busNetBits.clear();
+    _busDesignTermBits.clear();
+    _scalarInstTerms.clear();
+    _busInstTerms.clear();
+    _busInstTermBits.clear();
+
+    _numBusNetBits = 0;
+    _numBusDesignTermBits = 0;
+    _numScalarInstTerms = 0;
+    _numBusInstTerms = 0;
+    _numBusInstTermBits = 0;
+}
+
+}
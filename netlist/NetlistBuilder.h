@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+#include "Design.h"
+#include "NetlistIDs.h"
+
+namespace stargate {
+
+class Library;
+class Netlist;
+class NetlistSpace;
+class PrimitiveLibrary;
+
+// Builds new designs into a netlist. Objects are staged as they are
+// added and laid out by finalize() in one new NetlistSpace, every
+// design's nets, terms and instances in a contiguous range each. The
+// pointers handed out before finalize() refer to the staged objects:
+// they may be used to build and connect, but are invalid afterwards,
+// and a staged design's own spans stay empty until then. Libraries
+// and the top design are repointed to the final designs.
+//
+// The terms of a design must all be added before it is instantiated.
+// Only one builder may add to a netlist at a time.
+class NetlistBuilder {
+public:
+    explicit NetlistBuilder(Netlist* netlist);
+    ~NetlistBuilder();
+
+    Netlist* getNetlist() const { return _netlist; }
+
+    Library* createLibrary(NameID name);
+    // Creates the library of primitive designs, which is named SYSTEM.
+    PrimitiveLibrary* createPrimitiveLibrary();
+
+    Design* createDesign(Library* library, NameID name);
+    void setTopDesign(Design* design);
+
+    // Stages an empty design that takes the place of a built design in
+    // its library once finalized, under the same name. The netlist's
+    // top design follows. Instances of the old design keep it as their
+    // model.
+    Design* createReplacement(Design* design);
+
+    ScalarNet* addScalarNet(Design* design, NameID name);
+    BusNet* addBusNet(Design* design, NameID name, int32_t msb, int32_t lsb);
+
+    ScalarDesignTerm* addScalarDesignTerm(Design* design, NameID name, Direction dir);
+    BusDesignTerm* addBusDesignTerm(Design* design,
+                                    NameID name,
+                                    Direction dir,
+                                    int32_t msb,
+                                    int32_t lsb);
+
+    // model may be a design of this builder or of the netlist.
+    Instance* addInstance(Design* design, NameID name, Design* model);
+
+    // Connecting a term that is already connected moves it to net.
+    void connect(BitNet* net, BitInstTerm* term);
+    void connect(BitNet* net, BitDesignTerm* term);
+
+    void disconnect(BitInstTerm* term);
+    void disconnect(BitDesignTerm* term);
+
+    void finalize();
+
+private:
+    struct DesignStage {
+        Library* library {nullptr};
+        size_t libraryIndex {0};
+        bool instantiated {false};
+        // Design this one takes the place of, if any.
+        Design* replaced {nullptr};
+        std::vector<ScalarDesignTerm*> scalarDesignTerms;
+        std::vector<BusDesignTerm*> busDesignTerms;
+    };
+
+    Netlist* _netlist {nullptr};
+    Design* _topDesign {nullptr};
+
+    // First ID handed out by this builder for each kind; staged objects
+    // are told apart from built ones by their IDs.
+    uint32_t _firstNetID {0};
+    uint32_t _firstDesignID {0};
+
+    std::deque<Design> _designs;
+    std::vector<DesignStage> _stages;
+    std::deque<ScalarNet> _scalarNets;
+    std::deque<BusNet> _busNets;
+    std::deque<ScalarDesignTerm> _scalarDesignTerms;
+    std::deque<BusDesignTerm> _busDesignTerms;
+    std::deque<Instance> _instances;
+
+    // Contiguous storage behind the spans of staged buses and
+    // instances, one vector each.
+    std::deque<std::vector<BusNetBit>> _busNetBits;
+    std::deque<std::vector<BusDesignTermBit>> _busDesignTermBits;
+    std::deque<std::vector<ScalarInstTerm>> _scalarInstTerms;
+    std::deque<std::vector<BusInstTerm>> _busInstTerms;
+    std::deque<std::vector<BusInstTermBit>> _busInstTermBits;
+
+    size_t _numBusNetBits {0};
+    size_t _numBusDesignTermBits {0};
+    size_t _numScalarInstTerms {0};
+    size_t _numBusInstTerms {0};
+    size_t _numBusInstTermBits {0};
+
+    Design* stageDesign(Library* library, NameID name, PrimitiveKind kind);
+    Design* createPrimitiveDesign(PrimitiveLibrary* library,
+                                  PrimitiveKind kind,
+                                  NameID name);
+
+    bool isStaged(const Design* design) const;
+    DesignStage* getStage(const Design* design);
+    void checkConnection(const BitNet* net, const Design* termDesign);
+    void checkStaged(const Design* termDesign);
+
+    void layOutDesigns(NetlistSpace* space, std::vector<Design*>& finalDesigns);
+    void layOutNets(NetlistSpace* space,
+                    const std::vector<Design*>& finalDesigns,
+                    std::vector<BitNet*>& finalNets);
+    void layOutDesignTerms(NetlistSpace* space, const std::vector<Design*>& finalDesigns);
+    void layOutInstances(NetlistSpace* space, const std::vector<Design*>& finalDesigns);
+    void layOutConnections(NetlistSpace* space, const std::vector<BitNet*>& finalNets);
+    void clear();
+
+    friend class PrimitiveLibrary;
+};
+
+}
@@ -0,0 +1,293 @@
+#include "NetlistDumper.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include "ContentHash.h"
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistImage.h"
+#include "NetlistSpace.h"
+#include "PrimitiveLibrary.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+// Objects per batch copied, encoded and written.
+constexpr size_t WRITE_BATCH_SIZE = 16384;
+
+// Turns pointers into image offsets. Every pointer of the netlist
+// targets an object of one of its pools, found by address.
+class PointerEncoder {
+public:
+    struct Range {
+        uintptr_t begin {0};
+        uintptr_t end {0};
+        uint64_t offset {0};
+    };
+
+    // Takes over the contents of ranges and libraries.
+    PointerEncoder(std::vector<Range>& ranges,
+                   std::unordered_map<const Library*, uint64_t>& libraries)
+    {
+        _ranges.swap(ranges);
+        _libraries.swap(libraries);
+        std::sort(_ranges.begin(), _ranges.end(),
+                  [](const Range& a, const Range& b) { return a.begin < b.begin; });
+    }
+
+    template <typename T>
+    void operator()(T*& ptr) const {
+        ptr = reinterpret_cast<T*>(encode(ptr));
+    }
+
+    void operator()(Library*& library) const {
+        const auto it = _libraries.find(library);
+        if (it == _libraries.end()) {
+            panic("design of a library that is not in the netlist");
+        }
+        library = reinterpret_cast<Library*>(it->second);
+    }
+
+    template <typename T>
+    void operator()(ChunkedSpan<T>& span) const {
+        span.relocate([&](T* data, size_t) {
+            return reinterpret_cast<T*>(encode(data));
+        });
+    }
+
+    uint64_t encode(const void* ptr) const {
+        if (!ptr) {
+            return 0;
+        }
+
+        const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        const auto lessBegin = [](uintptr_t a, const Range& r) { return a < r.begin; };
+        auto it = std::upper_bound(_ranges.begin(), _ranges.end(), address, lessBegin);
+        if (it == _ranges.begin() || address >= (--it)->end) {
+            panic("pointer to an object outside of the netlist spaces");
+        }
+        return it->offset + (address - it->begin);
+    }
+
+private:
+    std::vector<Range> _ranges;
+    std::unordered_map<const Library*, uint64_t> _libraries;
+};
+
+// String of the i-th name record.
+std::string_view getNameString(const NameTable* names, size_t i) {
+    return names->getString(NameID {static_cast<uint32_t>(i + 1)});
+}
+
+class ImageWriter {
+public:
+    explicit ImageWriter(const std::string& path)
+        : _path(path),
+        _out(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!_out) {
+            panic("cannot write netlist image {}", _path);
+        }
+    }
+
+    void write(const void* data, size_t size) {
+        _out.write(static_cast<const char*>(data), size);
+        if (!_out) {
+            panic("cannot write netlist image {}", _path);
+        }
+        _offset += size;
+    }
+
+    void padTo(uint64_t offset) {
+        static const char zeros[NETLIST_IMAGE_ALIGNMENT] = {};
+        if (offset < _offset || offset - _offset > NETLIST_IMAGE_ALIGNMENT) {
+            panic("netlist image layout mismatch at offset {}", _offset);
+        }
+        write(zeros, offset - _offset);
+    }
+
+    void close() {
+        _out.close();
+        if (!_out) {
+            panic("cannot write netlist image {}", _path);
+        }
+    }
+
+private:
+    std::string _path;
+    std::ofstream _out;
+    uint64_t _offset {0};
+};
+
+template <typename T>
+void writePool(std::span<T> objects, const PointerEncoder& encoder, ImageWriter* writer) {
+    std::vector<T> batch;
+    for (size_t begin = 0; begin < objects.size(); begin += WRITE_BATCH_SIZE) {
+        const size_t end = std::min(begin + WRITE_BATCH_SIZE, objects.size());
+        batch.assign(objects.begin() + begin, objects.begin() + end);
+        for (T& object : batch) {
+            relocateObject(object, encoder);
+        }
+        writer->write(batch.data(), batch.size() * sizeof(T));
+    }
+}
+
+}
+
+NetlistDumper::NetlistDumper(const Netlist* netlist)
+    : _netlist(netlist)
+{
+}
+
+NetlistDumper::~NetlistDumper() {
+}
+
+void NetlistDumper::dump(const std::string& path) const {
+    const NameTable* names = _netlist->getNameTable();
+    const std::span<Library* const> libraries = _netlist->getLibraries();
+    const size_t numSpaces = _netlist->getNumSpaces();
+
+    // Layout: metadata first, then names, then pools.
+    NetlistImageHeader header;
+    memcpy(header.magic, NETLIST_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = NETLIST_IMAGE_VERSION;
+    header.headerSize = sizeof(NetlistImageHeader);
+    getImageObjectSizes(header.objectSizes);
+    header.pointerSize = sizeof(void*);
+
+    uint64_t offset = sizeof(NetlistImageHeader);
+    header.spaces = {offset, numSpaces};
+    offset += numSpaces * sizeof(NetlistImageSpace);
+    header.libraries = {offset, libraries.size()};
+    offset += libraries.size() * sizeof(NetlistImageLibrary);
+
+    std::vector<NetlistImageLibrary> libraryRecords(libraries.size());
+    std::unordered_map<const Library*, uint64_t> libraryIndices;
+    for (size_t i = 0; i < libraries.size(); i++) {
+        const Library* library = libraries[i];
+        NetlistImageLibrary& record = libraryRecords[i];
+        record.id = library->getID().value;
+        record.name = library->getName().value;
+        record.flags = library->isPrimitiveOnly() ? Library::FLAG_PRIMITIVE_ONLY : 0;
+        record.designs = {offset, library->getDesigns().size()};
+        offset += record.designs.count * sizeof(uint64_t);
+
+        libraryIndices[library] = i + 1;
+        if (library == _netlist->getPrimitiveLibrary()) {
+            header.primitiveLibrary = static_cast<uint32_t>(i + 1);
+        }
+    }
+    header.metadataSize = offset;
+
+    const size_t numNames = names->size();
+    offset = alignImageOffset(offset);
+    header.names = {offset, numNames};
+    offset += numNames * sizeof(NetlistImageName);
+
+    std::vector<NetlistImageName> nameRecords(numNames);
+    for (size_t i = 0; i < numNames; i++) {
+        const size_t size = getNameString(names, i).size();
+        nameRecords[i] = {offset, size};
+        offset += size;
+    }
+
+    std::vector<NetlistImageSpace> spaceRecords(numSpaces);
+    std::vector<PointerEncoder::Range> ranges;
+    for (size_t s = 0; s < numSpaces; s++) {
+        size_t p = 0;
+        _netlist->getSpace(s)->forEachPool([&](auto objects) {
+            const size_t bytes = objects.size() * sizeof(objects[0]);
+            offset = alignImageOffset(offset);
+            spaceRecords[s].pools[p++] = {offset, objects.size()};
+            if (bytes) {
+                const uintptr_t begin = reinterpret_cast<uintptr_t>(objects.data());
+                ranges.push_back({begin, begin + bytes, offset});
+            }
+            offset += bytes;
+        });
+    }
+    header.fileSize = offset;
+
+    header.nextNetID = _netlist->_nextNetID;
+    header.nextInstanceID = _netlist->_nextInstanceID;
+    header.nextDesignTermID = _netlist->_nextDesignTermID;
+    header.nextInstTermID = _netlist->_nextInstTermID;
+    header.nextDesignID = _netlist->_nextDesignID;
+    header.nextLibraryID = _netlist->_nextLibraryID;
+
+    const PointerEncoder encoder(ranges, libraryIndices);
+    header.topDesign = encoder.encode(_netlist->getTopDesign());
+
+    // The metadata after the header, checksummed along with it.
+    std::string metadata;
+    const auto append = [&](const void* data, size_t size) {
+        metadata.append(static_cast<const char*>(data), size);
+    };
+    append(spaceRecords.data(), spaceRecords.size() * sizeof(NetlistImageSpace));
+    append(libraryRecords.data(), libraryRecords.size() * sizeof(NetlistImageLibrary));
+    for (const Library* library : libraries) {
+        for (const Design* design : library->getDesigns()) {
+            const uint64_t designOffset = encoder.encode(design);
+            append(&designOffset, sizeof(designOffset));
+        }
+    }
+
+    if (sizeof(header) + metadata.size() != header.metadataSize) {
+        panic("netlist image metadata size mismatch");
+    }
+
+    ContentHash hash;
+    hash.update(std::string_view(reinterpret_cast<const char*>(&header),
+                                 sizeof(header)));
+    hash.update(metadata);
+    std::string checksum;
+    hash.hex(checksum);
+    memcpy(header.checksum, checksum.data(), sizeof(header.checksum));
+
+    // Written aside and renamed, so a reader never maps a partial image.
+    const std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    try {
+        ImageWriter writer(tmpPath);
+        writer.write(&header, sizeof(header));
+        writer.write(metadata.data(), metadata.size());
+
+        writer.padTo(header.names.offset);
+        writer.write(nameRecords.data(), nameRecords.size() * sizeof(NetlistImageName));
+        for (size_t i = 0; i < numNames; i++) {
+            const std::string_view str = getNameString(names, i);
+            writer.write(str.data(), str.size());
+        }
+
+        for (size_t s = 0; s < numSpaces; s++) {
+            size_t p = 0;
+            _netlist->getSpace(s)->forEachPool([&](auto objects) {
+                writer.padTo(spaceRecords[s].pools[p++].offset);
+                writePool(objects, encoder, &writer);
+            });
+        }
+        writer.close();
+    } catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+        throw;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        panic("cannot write netlist image {}", path);
+    }
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+namespace stargate {
+
+class Netlist;
+
+// Writes a netlist as a binary image that NetlistLoader maps back in
+// one step. The pools of every space are written as they are, so the
+// image is as large as the netlist in memory, and dead objects of old
+// spaces are kept: compact the netlist first for a smaller image.
+//
+// The netlist must not change while it is dumped, and objects staged
+// in a NetlistBuilder cannot be dumped.
+class NetlistDumper {
+public:
+    explicit NetlistDumper(const Netlist* netlist);
+    ~NetlistDumper();
+
+    // Writes to a temporary file renamed to path, so readers never see
+    // a partial image. Throws if the file cannot be written.
+    void dump(const std::string& path) const;
+
+private:
+    const Netlist* _netlist {nullptr};
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+namespace stargate {
+
+// Netlist object IDs. Every ID is unique across the whole netlist,
+// not only within its design or space, and the wrappers keep the
+// kinds apart. Nets share one ID sequence whether they are scalar
+// nets, buses or bus bits; terms and instance terms likewise.
+struct NetID {
+    uint32_t value {0};
+
+    bool operator==(const NetID& other) const = default;
+};
+
+struct InstanceID {
+    uint32_t value {0};
+
+    bool operator==(const InstanceID& other) const = default;
+};
+
+struct DesignTermID {
+    uint32_t value {0};
+
+    bool operator==(const DesignTermID& other) const = default;
+};
+
+struct InstTermID {
+    uint32_t value {0};
+
+    bool operator==(const InstTermID& other) const = default;
+};
+
+struct DesignID {
+    uint32_t value {0};
+
+    bool operator==(const DesignID& other) const = default;
+};
+
+struct LibraryID {
+    uint32_t value {0};
+
+    bool operator==(const LibraryID& other) const = default;
+};
+
+// Interned name. Id 0 is reserved for "no name" and maps to the empty
+// string.
+struct NameID {
+    uint32_t value {0};
+
+    bool operator==(const NameID& other) const = default;
+};
+
+constexpr NameID NULL_NAME {0};
+
+enum class Direction : uint8_t {
+    Input,
+    Output,
+    InOut,
+};
+
+}
+
+template <>
+struct std::hash<stargate::NameID> {
+    size_t operator()(stargate::NameID id) const noexcept { return id.value; }
+};
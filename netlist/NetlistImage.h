@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Design.h"
+#include "NetlistSpace.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+// On-disk layout of a dumped netlist, shared by NetlistDumper and
+// NetlistLoader.
+//
+// An image holds the pools of every NetlistSpace, each as one aligned
+// section, byte for byte as they are in memory except for pointers:
+// a pointer holds the offset of its target in the image, 0 standing
+// for nullptr, and Design::library holds the index of its library plus
+// one. Loading maps the image and adds its address to every pointer.
+//
+//   header | spaces | libraries | library designs   (checksummed)
+//   names | strings
+//   pools of space 0 | pools of space 1 | ...
+//
+// Bump NETLIST_IMAGE_VERSION whenever a netlist object changes layout:
+// object sizes are checked on load, but not the order of their fields.
+
+constexpr char NETLIST_IMAGE_MAGIC[8] = {'S', 'G', 'N', 'E', 'T', 'L', 'S', 'T'};
+constexpr uint32_t NETLIST_IMAGE_VERSION = 1;
+constexpr size_t NETLIST_IMAGE_POOL_COUNT = 13;
+constexpr size_t NETLIST_IMAGE_ALIGNMENT = 64;
+
+struct NetlistImageSection {
+    uint64_t offset {0};
+    uint64_t count {0};
+};
+
+// Laid out without padding, so that every byte of it is checksummed.
+struct NetlistImageHeader {
+    char magic[8] {};
+    uint32_t version {0};
+    uint32_t headerSize {0};
+    uint64_t fileSize {0};
+    // The checksum covers [0, metadataSize), checksum field zeroed.
+    uint64_t metadataSize {0};
+    char checksum[32] {};
+
+    uint64_t topDesign {0};
+
+    // Size of the objects of each pool, in NetlistSpace order.
+    uint32_t objectSizes[NETLIST_IMAGE_POOL_COUNT] {};
+    uint32_t pointerSize {0};
+
+    // Index of the primitive library plus one, 0 if none.
+    uint32_t primitiveLibrary {0};
+
+    uint32_t nextNetID {0};
+    uint32_t nextInstanceID {0};
+    uint32_t nextDesignTermID {0};
+    uint32_t nextInstTermID {0};
+    uint32_t nextDesignID {0};
+    uint32_t nextLibraryID {0};
+    uint32_t reserved {0};
+
+    // NetlistImageSpace, NetlistImageLibrary and NetlistImageName
+    // records. Name i + 1 is the i-th name record.
+    NetlistImageSection spaces;
+    NetlistImageSection libraries;
+    NetlistImageSection names;
+};
+
+struct NetlistImageSpace {
+    NetlistImageSection pools[NETLIST_IMAGE_POOL_COUNT];
+};
+
+// designs is an array of the image offsets of the library's designs.
+struct NetlistImageLibrary {
+    uint32_t id {0};
+    uint32_t name {0};
+    uint32_t flags {0};
+    uint32_t reserved {0};
+    NetlistImageSection designs;
+};
+
+struct NetlistImageName {
+    uint64_t offset {0};
+    uint64_t size {0};
+};
+
+inline uint64_t alignImageOffset(uint64_t offset) {
+    constexpr uint64_t mask = NETLIST_IMAGE_ALIGNMENT - 1;
+    return (offset + mask) & ~mask;
+}
+
+// Size of the objects of each pool of a NetlistSpace, in order.
+inline void getImageObjectSizes(uint32_t* sizes) {
+    const NetlistSpace space(0);
+    size_t i = 0;
+    space.forEachPool([&](auto objects) {
+        if (i < NETLIST_IMAGE_POOL_COUNT) {
+            sizes[i] = static_cast<uint32_t>(sizeof(objects[0]));
+        }
+        i++;
+    });
+    if (i != NETLIST_IMAGE_POOL_COUNT) {
+        panic("NETLIST_IMAGE_POOL_COUNT does not match NetlistSpace");
+    }
+}
+
+// Calls reloc on every pointer and ChunkedSpan of a pooled object.
+
+template <typename R>
+void relocateObject(Design& design, R& reloc) {
+    reloc(design.library);
+    reloc(design.scalarNets);
+    reloc(design.busNets);
+    reloc(design.scalarDesignTerms);
+    reloc(design.busDesignTerms);
+    reloc(design.instances);
+}
+
+template <typename R>
+void relocateObject(BitNet& net, R& reloc) {
+    reloc(net.parent);
+    reloc(net.connectedInstTerms);
+    reloc(net.connectedDesignTerms);
+}
+
+template <typename R>
+void relocateObject(BusNetBit& bit, R& reloc) {
+    relocateObject(static_cast<BitNet&>(bit), reloc);
+    reloc(bit.bus);
+}
+
+template <typename R>
+void relocateObject(BusNet& bus, R& reloc) {
+    reloc(bus.parent);
+    reloc(bus.bits);
+}
+
+template <typename R>
+void relocateObject(BitDesignTerm& term, R& reloc) {
+    reloc(term.parent);
+    reloc(term.connectedNet);
+}
+
+template <typename R>
+void relocateObject(BusDesignTermBit& bit, R& reloc) {
+    relocateObject(static_cast<BitDesignTerm&>(bit), reloc);
+    reloc(bit.bus);
+}
+
+template <typename R>
+void relocateObject(BusDesignTerm& bus, R& reloc) {
+    reloc(bus.parent);
+    reloc(bus.bits);
+}
+
+template <typename R>
+void relocateObject(Instance& instance, R& reloc) {
+    reloc(instance.parent);
+    reloc(instance.model);
+    reloc(instance.scalarInstTerms);
+    reloc(instance.busInstTerms);
+}
+
+template <typename R>
+void relocateObject(BitInstTerm& term, R& reloc) {
+    reloc(term.instance);
+    reloc(term.connectedNet);
+}
+
+template <typename R>
+void relocateObject(BusInstTermBit& bit, R& reloc) {
+    relocateObject(static_cast<BitInstTerm&>(bit), reloc);
+    reloc(bit.bus);
+}
+
+template <typename R>
+void relocateObject(BusInstTerm& bus, R& reloc) {
+    reloc(bus.instance);
+    reloc(bus.bits);
+}
+
+template <typename R>
+void relocateObject(BitInstTerm*& term, R& reloc) {
+    reloc(term);
+}
+
+template <typename R>
+void relocateObject(BitDesignTerm*& term, R& reloc) {
+    reloc(term);
+}
+
+}
@@ -0,0 +1,256 @@
+#include "NetlistLoader.h"
+
+#include <string.h>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "ContentHash.h"
+#include "Library.h"
+#include "MappedFile.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistImage.h"
+#include "NetlistSpace.h"
+#include "PrimitiveLibrary.h"
+#include "ThreadPool.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+// Objects per batch of the pointer pass.
+constexpr size_t RELOCATE_BATCH_SIZE = 16384;
+
+// Turns image offsets back into pointers. Offsets are checked to land
+// in the object sections, so a corrupt image fails to load instead of
+// handing out wild pointers.
+class PointerDecoder {
+public:
+    PointerDecoder(char* base, uint64_t begin, uint64_t end,
+                   const std::vector<Library*>& libraries)
+        : _base(base),
+        _begin(begin),
+        _end(end),
+        _libraries(libraries)
+    {
+    }
+
+    template <typename T>
+    void operator()(T*& ptr) const {
+        ptr = static_cast<T*>(decode(reinterpret_cast<uint64_t>(ptr), sizeof(T)));
+    }
+
+    void operator()(Library*& library) const {
+        const uint64_t index = reinterpret_cast<uint64_t>(library);
+        if (index == 0 || index > _libraries.size()) {
+            panic("corrupt netlist image: invalid library index");
+        }
+        library = _libraries[index - 1];
+    }
+
+    template <typename T>
+    void operator()(ChunkedSpan<T>& span) const {
+        span.relocate([&](T* data, size_t size) {
+            const uint64_t offset = reinterpret_cast<uint64_t>(data);
+            return static_cast<T*>(decode(offset, size * sizeof(T)));
+        });
+    }
+
+    void* decode(uint64_t offset, uint64_t size) const {
+        if (offset == 0) {
+            return nullptr;
+        }
+        if (offset < _begin || offset > _end || size > _end - offset) {
+            panic("corrupt netlist image: offset {} out of bounds", offset);
+        }
+        return _base + offset;
+    }
+
+private:
+    char* _base {nullptr};
+    uint64_t _begin {0};
+    uint64_t _end {0};
+    const std::vector<Library*>& _libraries;
+};
+
+// Checks that count elements of size bytes at offset lie in the file
+// and are aligned for their type.
+void checkSection(const NetlistImageSection& section,
+                  size_t size,
+                  size_t alignment,
+                  uint64_t fileSize) {
+    if (section.offset % alignment != 0
+        || section.offset > fileSize
+        || section.count > (fileSize - section.offset) / size) {
+        panic("corrupt netlist image: section out of bounds");
+    }
+}
+
+template <typename T>
+std::span<T> getSection(char* base,
+                        const NetlistImageSection& section,
+                        uint64_t fileSize) {
+    checkSection(section, sizeof(T), alignof(T), fileSize);
+    return std::span<T>(reinterpret_cast<T*>(base + section.offset), section.count);
+}
+
+void checkHeader(const NetlistImageHeader& header,
+                 std::string_view image,
+                 const std::string& path) {
+    if (memcmp(header.magic, NETLIST_IMAGE_MAGIC, sizeof(header.magic)) != 0) {
+        panic("{} is not a netlist image", path);
+    }
+    if (header.version != NETLIST_IMAGE_VERSION
+        || header.headerSize != sizeof(NetlistImageHeader)) {
+        panic("netlist image {} has version {}, expected {}",
+              path, header.version, NETLIST_IMAGE_VERSION);
+    }
+
+    uint32_t objectSizes[NETLIST_IMAGE_POOL_COUNT] {};
+    getImageObjectSizes(objectSizes);
+    if (memcmp(header.objectSizes, objectSizes, sizeof(objectSizes)) != 0
+        || header.pointerSize != sizeof(void*)) {
+        panic("netlist image {} was written by an incompatible build", path);
+    }
+
+    if (header.fileSize != image.size()
+        || header.metadataSize < sizeof(NetlistImageHeader)
+        || header.metadataSize > image.size()) {
+        panic("netlist image {} is truncated or corrupt", path);
+    }
+
+    NetlistImageHeader zeroed = header;
+    memset(zeroed.checksum, 0, sizeof(zeroed.checksum));
+    ContentHash hash;
+    hash.update(std::string_view(reinterpret_cast<const char*>(&zeroed),
+                                 sizeof(zeroed)));
+    hash.update(image.substr(sizeof(NetlistImageHeader),
+                             header.metadataSize - sizeof(NetlistImageHeader)));
+
+    std::string checksum;
+    hash.hex(checksum);
+    if (checksum != std::string_view(header.checksum, sizeof(header.checksum))) {
+        panic("netlist image {} has a bad checksum", path);
+    }
+}
+
+}
+
+NetlistLoader::NetlistLoader(Netlist* netlist, unsigned threadCount)
+    : _netlist(netlist),
+    _threadCount(threadCount)
+{
+}
+
+NetlistLoader::~NetlistLoader() {
+}
+
+void NetlistLoader::load(const std::string& path) {
+    NameTable* names = _netlist->getNameTable();
+    if (_netlist->getNumSpaces() != 0 || !_netlist->getLibraries().empty()
+        || names->size() != 0) {
+        panic("a netlist image can only be loaded into an empty netlist");
+    }
+
+    auto image = std::make_unique<MappedFile>();
+    if (!image->open(path, MappedFile::Mode::CopyOnWrite)) {
+        panic("cannot open netlist image {}", path);
+    }
+    if (image->size() < sizeof(NetlistImageHeader)) {
+        panic("{} is not a netlist image", path);
+    }
+
+    char* base = image->getWritableData();
+    NetlistImageHeader header;
+    memcpy(&header, base, sizeof(header));
+    checkHeader(header, image->data(), path);
+    const uint64_t fileSize = header.fileSize;
+
+    // Names point into the image, which the netlist keeps.
+    const std::span<NetlistImageName> nameRecords =
+        getSection<NetlistImageName>(base, header.names, fileSize);
+    std::vector<std::string_view> strings(nameRecords.size());
+    for (size_t i = 0; i < nameRecords.size(); i++) {
+        const NetlistImageName& record = nameRecords[i];
+        if (record.offset > fileSize || record.size > fileSize - record.offset) {
+            panic("corrupt netlist image: name out of bounds");
+        }
+        strings[i] = std::string_view(base + record.offset, record.size);
+    }
+    names->loadNames(strings);
+
+    const std::span<NetlistImageLibrary> libraryRecords =
+        getSection<NetlistImageLibrary>(base, header.libraries, header.metadataSize);
+    std::vector<Library*> libraries;
+    for (size_t i = 0; i < libraryRecords.size(); i++) {
+        const NetlistImageLibrary& record = libraryRecords[i];
+        const LibraryID id {record.id};
+        const NameID name {record.name};
+        Library* library = nullptr;
+        if (header.primitiveLibrary == i + 1) {
+            PrimitiveLibrary* primitives = new PrimitiveLibrary(id, name);
+            _netlist->_primitiveLibrary = primitives;
+            library = primitives;
+        } else {
+            library = new Library(id, name, record.flags);
+        }
+        libraries.push_back(library);
+        _netlist->addLibrary(library);
+    }
+
+    // Map the pools, and cut them into batches for the pointer pass.
+    const std::span<NetlistImageSpace> spaceRecords =
+        getSection<NetlistImageSpace>(base, header.spaces, header.metadataSize);
+    const PointerDecoder decoder(base, header.metadataSize, fileSize, libraries);
+    std::vector<std::function<void()>> batches;
+    for (const NetlistImageSpace& record : spaceRecords) {
+        NetlistSpace* space = _netlist->createSpace();
+        size_t p = 0;
+        space->forEachPool([&](auto empty) {
+            using T = typename decltype(empty)::element_type;
+            const std::span<T> objects = getSection<T>(base, record.pools[p++], fileSize);
+            space->mapObjects(objects);
+
+            for (size_t begin = 0; begin < objects.size(); begin += RELOCATE_BATCH_SIZE) {
+                const std::span<T> batch = objects.subspan(
+                    begin, std::min(RELOCATE_BATCH_SIZE, objects.size() - begin));
+                batches.push_back([batch, &decoder]() {
+                    for (T& object : batch) {
+                        relocateObject(object, decoder);
+                    }
+                });
+            }
+        });
+    }
+
+    ThreadPool pool(_threadCount);
+    pool.parallelFor(batches.size(), [&](size_t i) { batches[i](); });
+
+    for (size_t i = 0; i < libraryRecords.size(); i++) {
+        const std::span<uint64_t> designs =
+            getSection<uint64_t>(base, libraryRecords[i].designs, header.metadataSize);
+        for (uint64_t offset : designs) {
+            Design* design = static_cast<Design*>(decoder.decode(offset, sizeof(Design)));
+            if (!design) {
+                panic("corrupt netlist image: null design in a library");
+            }
+            libraries[i]->addDesign(design);
+        }
+    }
+
+    _netlist->_topDesign =
+        static_cast<Design*>(decoder.decode(header.topDesign, sizeof(Design)));
+    _netlist->_nextNetID = header.nextNetID;
+    _netlist->_nextInstanceID = header.nextInstanceID;
+    _netlist->_nextDesignTermID = header.nextDesignTermID;
+    _netlist->_nextInstTermID = header.nextInstTermID;
+    _netlist->_nextDesignID = header.nextDesignID;
+    _netlist->_nextLibraryID = header.nextLibraryID;
+    _netlist->_image.reset(image.release());
+}
+
+}
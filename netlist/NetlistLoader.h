@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+namespace stargate {
+
+class Netlist;
+
+// Loads a netlist image written by NetlistDumper. The image is mapped
+// copy-on-write and used in place as the pools of the netlist's
+// spaces: loading costs one pass that turns the stored offsets back
+// into pointers, split across threads, and interning the names
+// without copying their strings. Nothing is parsed or rebuilt.
+class NetlistLoader {
+public:
+    // Patches pointers on threadCount threads, or one per core if 0.
+    explicit NetlistLoader(Netlist* netlist, unsigned threadCount = 0);
+    ~NetlistLoader();
+
+    // Loads the image at path into the netlist, which must be empty.
+    // Throws if the image cannot be read, is corrupt or was written by
+    // a build with a different object layout; the netlist is then left
+    // unusable.
+    void load(const std::string& path);
+
+private:
+    Netlist* _netlist {nullptr};
+    unsigned _threadCount {0};
+};
+
+}
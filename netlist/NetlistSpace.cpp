@@ -0,0 +1,24 @@
+#include "NetlistSpace.h"
+
+#include <algorithm>
+
+namespace stargate {
+
+NetlistSpace::NetlistSpace(uint32_t index)
+    : _index(index)
+{
+}
+
+NetlistSpace::~NetlistSpace() {
+}
+
+size_t NetlistSpace::getMemoryUsage() const {
+    size_t bytes = 0;
+    std::apply([&](const auto&... pools) {
+        ((bytes += std::max(pools.storage.capacity(), pools.objects.size())
+                 * sizeof(pools.objects[0])), ...);
+    }, _pools);
+    return bytes;
+}
+
+}
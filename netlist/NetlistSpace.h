@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "Design.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+// Pools that own the netlist objects created in one step: the initial
+// build, a commit of the Uniquifier or a compaction. Designs, buses
+// and instances only hold ChunkedSpans into these pools.
+//
+// Allocation rules:
+// - New objects are only ever allocated in a new space. An older
+//   space is never grown; at commit time only its objects may be
+//   updated in place.
+// - The creator of a space counts what it will allocate and reserves
+//   every pool before the first allocation. A pool never reallocates,
+//   so spans and pointers into it stay valid for the life of the
+//   space; allocating past the reservation is a bug.
+// - The objects of one design, bus or instance are allocated as one
+//   contiguous range per space, which becomes one chunk of its span.
+class NetlistSpace {
+public:
+    explicit NetlistSpace(uint32_t index);
+    ~NetlistSpace();
+
+    NetlistSpace(const NetlistSpace&) = delete;
+    NetlistSpace& operator=(const NetlistSpace&) = delete;
+
+    // Position of the space in its netlist, oldest first.
+    uint32_t getIndex() const { return _index; }
+
+    template <typename T>
+    void reserve(size_t count) {
+        getPool<T>().storage.reserve(count);
+    }
+
+    // Contiguous range of count new objects, value-initialized.
+    template <typename T>
+    std::span<T> allocate(size_t count) {
+        Pool<T>& pool = getPool<T>();
+        const size_t start = pool.storage.size();
+        if (start + count > pool.storage.capacity()) {
+            panic("netlist space {}: allocation beyond its reserved size", _index);
+        }
+        pool.storage.resize(start + count);
+        pool.objects = pool.storage;
+        return std::span<T>(pool.storage.data() + start, count);
+    }
+
+    // Makes objects, which live in a mapped netlist image, the pool of
+    // type T. Such a space never allocates.
+    template <typename T>
+    void mapObjects(std::span<T> objects) {
+        getPool<T>().objects = objects;
+    }
+
+    // Every object of type T allocated in this space.
+    template <typename T>
+    std::span<T> getObjects() {
+        return getPool<T>().objects;
+    }
+
+    template <typename T>
+    std::span<const T> getObjects() const {
+        return std::get<Pool<T>>(_pools).objects;
+    }
+
+    // Calls func(getObjects<T>()) for every pool, always in the same
+    // order.
+    template <typename F>
+    void forEachPool(F&& func) const {
+        std::apply([&](const auto&... pools) { (func(pools.objects), ...); }, _pools);
+    }
+
+    size_t getMemoryUsage() const;
+
+private:
+    template <typename T>
+    struct Pool {
+        std::vector<T> storage;
+        // The storage, or the objects of a mapped image.
+        std::span<T> objects;
+    };
+
+    uint32_t _index {0};
+    std::tuple<Pool<Design>,
+               Pool<ScalarNet>,
+               Pool<BusNet>,
+               Pool<BusNetBit>,
+               Pool<ScalarDesignTerm>,
+               Pool<BusDesignTerm>,
+               Pool<BusDesignTermBit>,
+               Pool<Instance>,
+               Pool<ScalarInstTerm>,
+               Pool<BusInstTerm>,
+               Pool<BusInstTermBit>,
+               // Backing storage of the connection lists of nets.
+               Pool<BitInstTerm*>,
+               Pool<BitDesignTerm*>> _pools;
+
+    template <typename T>
+    Pool<T>& getPool() {
+        return std::get<Pool<T>>(_pools);
+    }
+
+    friend class Netlist;
+};
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+namespace stargate {
+
+struct BitDesignTerm;
+struct BitInstTerm;
+struct BitNet;
+struct Instance;
+
+// Instantiation path from the top design: the first instance is in the
+// top design, and each next one in the model of the previous one. The
+// empty path stands for the top design itself.
+using Path = std::vector<Instance*>;
+
+// An object of the design at the end of a path, in the context of
+// that path. Occurrences refer to the netlist as it is when they are
+// made, and are invalidated by a Uniquifier commit.
+struct InstanceOccurrence {
+    Path path;
+    Instance* instance {nullptr};
+};
+
+struct BitNetOccurrence {
+    Path path;
+    BitNet* net {nullptr};
+};
+
+struct BitInstTermOccurrence {
+    Path path;
+    BitInstTerm* term {nullptr};
+};
+
+struct BitDesignTermOccurrence {
+    Path path;
+    BitDesignTerm* term {nullptr};
+};
+
+}
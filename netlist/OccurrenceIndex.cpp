@@ -0,0 +1,368 @@
+#include "OccurrenceIndex.h"
+
+#include <charconv>
+#include <unordered_set>
+#include <vector>
+
+#include "Design.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "ThreadPool.h"
+
+namespace stargate {
+
+namespace {
+
+// Splits "data[3]" into data and 3.
+bool splitBitSelect(std::string_view leaf, std::string_view* base, int32_t* number) {
+    const size_t open = leaf.rfind('[');
+    if (open == std::string_view::npos || open == 0 || leaf.back() != ']') {
+        return false;
+    }
+
+    const char* first = leaf.data() + open + 1;
+    const char* last = leaf.data() + leaf.size() - 1;
+    const auto [ptr, ec] = std::from_chars(first, last, *number);
+    if (ec != std::errc() || ptr != last) {
+        return false;
+    }
+    *base = leaf.substr(0, open);
+    return true;
+}
+
+// Position in its bus of the bit numbered number, or width if the bus
+// has no such bit.
+uint32_t getBitPosition(int32_t msb, int32_t lsb, int32_t number, uint32_t width) {
+    const int64_t offset = msb >= lsb ? int64_t(msb) - number : int64_t(number) - msb;
+    return offset >= 0 && offset < width ? static_cast<uint32_t>(offset) : width;
+}
+
+// Maps the name of each object of span to its position in the span.
+template <typename T>
+void addNames(const ChunkedSpan<T>& span, std::unordered_map<NameID, uint32_t>* names) {
+    names->reserve(span.size());
+    uint32_t position = 0;
+    span.forEach([&](const T& object) {
+        names->emplace(object.name, position++);
+    });
+}
+
+// Position of the object named component, or UINT32_MAX. A component
+// that was never interned names no object, so it is not interned here.
+uint32_t findPosition(const std::unordered_map<NameID, uint32_t>& names,
+                      const NameTable* nameTable,
+                      std::string_view component) {
+    const NameID name = nameTable->findName(component);
+    if (name == NULL_NAME) {
+        return UINT32_MAX;
+    }
+    const auto it = names.find(name);
+    return it != names.end() ? it->second : UINT32_MAX;
+}
+
+}
+
+struct OccurrenceIndex::DesignNames {
+    std::unordered_map<NameID, uint32_t> instances;
+    std::unordered_map<NameID, uint32_t> scalarNets;
+    std::unordered_map<NameID, uint32_t> busNets;
+    std::unordered_map<NameID, uint32_t> scalarDesignTerms;
+    std::unordered_map<NameID, uint32_t> busDesignTerms;
+};
+
+// Splits a hierarchical name into its components. An escaped
+// identifier runs from its backslash to the next whitespace, which is
+// dropped with the backslash, and may contain the separator.
+class OccurrenceIndex::NameParser {
+public:
+    NameParser(std::string_view name, char separator)
+        : _rest(name),
+        _separator(separator)
+    {
+    }
+
+    // Number of components of name, or 0 if it is malformed.
+    static size_t countComponents(std::string_view name, char separator) {
+        NameParser parser(name, separator);
+        std::string_view component;
+        size_t count = 0;
+        while (parser.next(&component)) {
+            count++;
+        }
+        return parser._malformed ? 0 : count;
+    }
+
+    // Returns false at the end of the name, or if it is malformed.
+    bool next(std::string_view* component) {
+        if (_rest.empty() || _malformed) {
+            return false;
+        }
+
+        size_t end = 0;
+        if (_rest[0] == '\\') {
+            end = std::min(_rest.find_first_of(" \t\r\n"), _rest.size());
+            *component = _rest.substr(1, end - 1);
+            end = std::min(end + 1, _rest.size());
+        } else {
+            end = std::min(_rest.find(_separator), _rest.size());
+            *component = _rest.substr(0, end);
+        }
+        _rest.remove_prefix(end);
+
+        // Components are separated by exactly one separator.
+        if (!_rest.empty()) {
+            _malformed = _rest[0] != _separator || _rest.size() == 1;
+            _rest.remove_prefix(1);
+        }
+        _malformed |= component->empty();
+        return !_malformed;
+    }
+
+private:
+    std::string_view _rest;
+    char _separator {'.'};
+    bool _malformed {false};
+};
+
+OccurrenceIndex::OccurrenceIndex(const Netlist* netlist,
+                                 char separator,
+                                 unsigned threadCount)
+    : _netlist(netlist),
+    _top(netlist->getTopDesign()),
+    _separator(separator)
+{
+    if (!_top) {
+        return;
+    }
+
+    // Every design under the top, primitives included for their ports.
+    std::vector<const Design*> designs {_top};
+    std::unordered_set<const Design*> visited {_top};
+    for (size_t i = 0; i < designs.size(); i++) {
+        designs[i]->instances.forEach([&](const Instance& instance) {
+            if (visited.insert(instance.model).second) {
+                designs.push_back(instance.model);
+            }
+        });
+    }
+
+    std::vector<DesignNames*> names(designs.size());
+    for (size_t i = 0; i < designs.size(); i++) {
+        std::unique_ptr<DesignNames>& designNames = _designs[designs[i]];
+        designNames = std::make_unique<DesignNames>();
+        names[i] = designNames.get();
+    }
+
+    ThreadPool pool(threadCount);
+    pool.parallelFor(designs.size(), [&](size_t i) {
+        const Design* design = designs[i];
+        addNames(design->instances, &names[i]->instances);
+        addNames(design->scalarNets, &names[i]->scalarNets);
+        addNames(design->busNets, &names[i]->busNets);
+        addNames(design->scalarDesignTerms, &names[i]->scalarDesignTerms);
+        addNames(design->busDesignTerms, &names[i]->busDesignTerms);
+    });
+}
+
+OccurrenceIndex::~OccurrenceIndex() {
+}
+
+const OccurrenceIndex::DesignNames*
+OccurrenceIndex::getNames(const Design* design) const {
+    const auto it = _designs.find(design);
+    return it != _designs.end() ? it->second.get() : nullptr;
+}
+
+bool OccurrenceIndex::findContext(NameParser* parser,
+                                  size_t count,
+                                  PackedPath* path,
+                                  const Design** design) const {
+    const NameTable* nameTable = _netlist->getNameTable();
+    path->clear();
+    *design = _top;
+    std::string_view component;
+    for (size_t i = 0; i < count; i++) {
+        parser->next(&component);
+        const uint32_t position =
+            findPosition(getNames(*design)->instances, nameTable, component);
+        if (position == UINT32_MAX) {
+            return false;
+        }
+        const Instance& instance = (*design)->instances[position];
+        if (instance.isPrimitive()) {
+            return false;
+        }
+        path->push(position);
+        *design = instance.model;
+    }
+    return true;
+}
+
+bool OccurrenceIndex::findInstance(std::string_view name, PackedPath* path) const {
+    const size_t count = NameParser::countComponents(name, _separator);
+    if (!_top || count == 0) {
+        return false;
+    }
+
+    NameParser parser(name, _separator);
+    const Design* design = nullptr;
+    std::string_view leaf;
+    if (!findContext(&parser, count - 1, path, &design) || !parser.next(&leaf)) {
+        return false;
+    }
+
+    const uint32_t position =
+        findPosition(getNames(design)->instances, _netlist->getNameTable(), leaf);
+    if (position == UINT32_MAX) {
+        return false;
+    }
+    path->push(position);
+    return true;
+}
+
+bool OccurrenceIndex::findNet(std::string_view name,
+                              PackedBitNetOccurrence* occurrence) const {
+    const size_t count = NameParser::countComponents(name, _separator);
+    if (!_top || count == 0) {
+        return false;
+    }
+
+    NameParser parser(name, _separator);
+    const Design* design = nullptr;
+    std::string_view leaf;
+    if (!findContext(&parser, count - 1, &occurrence->path, &design)
+        || !parser.next(&leaf)) {
+        return false;
+    }
+
+    const NameTable* nameTable = _netlist->getNameTable();
+    const DesignNames* names = getNames(design);
+    const uint32_t scalar = findPosition(names->scalarNets, nameTable, leaf);
+    if (scalar != UINT32_MAX) {
+        occurrence->net = &design->scalarNets[scalar];
+        return true;
+    }
+
+    std::string_view base;
+    int32_t number = 0;
+    if (!splitBitSelect(leaf, &base, &number)) {
+        return false;
+    }
+    const uint32_t busPosition = findPosition(names->busNets, nameTable, base);
+    if (busPosition == UINT32_MAX) {
+        return false;
+    }
+    const BusNet& bus = design->busNets[busPosition];
+    const uint32_t bit = getBitPosition(bus.msb, bus.lsb, number, bus.getWidth());
+    if (bit == bus.getWidth()) {
+        return false;
+    }
+    occurrence->net = &bus.bits[bit];
+    return true;
+}
+
+bool OccurrenceIndex::findDesignTerm(std::string_view name,
+                                     PackedBitDesignTermOccurrence* occurrence) const {
+    const size_t count = NameParser::countComponents(name, _separator);
+    if (!_top || count == 0) {
+        return false;
+    }
+
+    NameParser parser(name, _separator);
+    const Design* design = nullptr;
+    std::string_view leaf;
+    if (!findContext(&parser, count - 1, &occurrence->path, &design)
+        || !parser.next(&leaf)) {
+        return false;
+    }
+
+    occurrence->term = findPort(design, leaf);
+    return occurrence->term != nullptr;
+}
+
+bool OccurrenceIndex::findInstTerm(std::string_view name,
+                                   PackedBitInstTermOccurrence* occurrence) const {
+    const size_t count = NameParser::countComponents(name, _separator);
+    if (!_top || count < 2) {
+        return false;
+    }
+
+    NameParser parser(name, _separator);
+    const Design* design = nullptr;
+    std::string_view instanceName;
+    std::string_view pin;
+    if (!findContext(&parser, count - 2, &occurrence->path, &design)
+        || !parser.next(&instanceName) || !parser.next(&pin)) {
+        return false;
+    }
+
+    const uint32_t position =
+        findPosition(getNames(design)->instances, _netlist->getNameTable(), instanceName);
+    if (position == UINT32_MAX) {
+        return false;
+    }
+    const Instance& instance = design->instances[position];
+    const BitDesignTerm* port = findPort(instance.model, pin);
+    if (!port) {
+        return false;
+    }
+
+    // Instance terms mirror the ports of the model.
+    const Design* model = instance.model;
+    const size_t scalar = model->scalarDesignTerms.indexOf(port);
+    if (scalar < model->scalarDesignTerms.size()) {
+        occurrence->term = &instance.scalarInstTerms[scalar];
+    } else {
+        const BusDesignTermBit* bit = static_cast<const BusDesignTermBit*>(port);
+        const size_t bus = model->busDesignTerms.indexOf(bit->bus);
+        occurrence->term = &instance.busInstTerms[bus].bits[bit->index];
+    }
+    return true;
+}
+
+BitDesignTerm* OccurrenceIndex::findPort(const Design* design,
+                                         std::string_view leaf) const {
+    const NameTable* nameTable = _netlist->getNameTable();
+    const DesignNames* names = getNames(design);
+    const uint32_t scalar = findPosition(names->scalarDesignTerms, nameTable, leaf);
+    if (scalar != UINT32_MAX) {
+        return &design->scalarDesignTerms[scalar];
+    }
+
+    std::string_view base;
+    int32_t number = 0;
+    if (!splitBitSelect(leaf, &base, &number)) {
+        return nullptr;
+    }
+    const uint32_t busPosition = findPosition(names->busDesignTerms, nameTable, base);
+    if (busPosition == UINT32_MAX) {
+        return nullptr;
+    }
+    const BusDesignTerm& bus = design->busDesignTerms[busPosition];
+    const uint32_t width = static_cast<uint32_t>(bus.bits.size());
+    const uint32_t bit = getBitPosition(bus.msb, bus.lsb, number, width);
+    return bit < width ? &bus.bits[bit] : nullptr;
+}
+
+void OccurrenceIndex::getName(const PackedPath& path, std::string& result) const {
+    const NameTable* nameTable = _netlist->getNameTable();
+    result.clear();
+    const Design* design = _top;
+    for (uint32_t position : path.getPositions()) {
+        const Instance& instance = design->instances[position];
+        const std::string_view component = nameTable->getString(instance.name);
+        if (!result.empty()) {
+            result += _separator;
+        }
+        if (component.find(_separator) != std::string_view::npos) {
+            result += '\\';
+            result += component;
+            result += ' ';
+        } else {
+            result += component;
+        }
+        design = instance.model;
+    }
+}
+
+}
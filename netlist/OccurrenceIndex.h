@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "NetlistIDs.h"
+#include "PackedPath.h"
+
+namespace stargate {
+
+class Netlist;
+
+// Resolves full hierarchical names, as found in constraints, to packed
+// occurrences under the top design: "cpu.alu.add0" with the '.'
+// separator of Verilog names, "cpu/alu/add0" with the '/' of XDC.
+//
+// Each design under the top gets hash maps from the NameIDs of its
+// instances, nets and ports to their positions. A name resolves with
+// one lookup per level, and its components are looked up in the
+// NameTable without being interned, so no string is built. Components
+// may be escaped Verilog identifiers, "\a.b " standing for the name
+// a.b. Bus bits are named "data[3]".
+//
+// The index refers to the netlist as it is when built, and is
+// invalidated like occurrences by a Uniquifier commit or a compaction.
+// Lookups are const and may run from many threads at once.
+class OccurrenceIndex {
+public:
+    // Builds the maps of the designs under the top on threadCount
+    // threads, or one per core if 0.
+    explicit OccurrenceIndex(const Netlist* netlist,
+                             char separator = '.',
+                             unsigned threadCount = 0);
+    ~OccurrenceIndex();
+
+    OccurrenceIndex(const OccurrenceIndex&) = delete;
+    OccurrenceIndex& operator=(const OccurrenceIndex&) = delete;
+
+    // Each returns false if name does not resolve. The path of an
+    // instance occurrence ends with the instance itself.
+    bool findInstance(std::string_view name, PackedPath* path) const;
+    bool findNet(std::string_view name, PackedBitNetOccurrence* occurrence) const;
+    bool findInstTerm(std::string_view name,
+                      PackedBitInstTermOccurrence* occurrence) const;
+    // A port of the top design, or of the design of a hierarchical
+    // instance: "cpu.clk" is the port clk of the model of cpu.
+    bool findDesignTerm(std::string_view name,
+                        PackedBitDesignTermOccurrence* occurrence) const;
+
+    // Full hierarchical name of the instance at the end of path, for
+    // reporting.
+    void getName(const PackedPath& path, std::string& result) const;
+
+private:
+    struct DesignNames;
+    class NameParser;
+
+    const Netlist* _netlist {nullptr};
+    const Design* _top {nullptr};
+    char _separator {'.'};
+    std::unordered_map<const Design*, std::unique_ptr<DesignNames>> _designs;
+
+    const DesignNames* getNames(const Design* design) const;
+
+    // Resolves the next count components of parser as hierarchical
+    // instances, from the top design to the design they lead to.
+    bool findContext(NameParser* parser,
+                     size_t count,
+                     PackedPath* path,
+                     const Design** design) const;
+    BitDesignTerm* findPort(const Design* design, std::string_view leaf) const;
+};
+
+}
@@ -0,0 +1,130 @@
+#include "PackedPath.h"
+
+#include <string.h>
+
+#include "Design.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+PackedPath::PackedPath(const PackedPath& other) {
+    *this = other;
+}
+
+PackedPath& PackedPath::operator=(const PackedPath& other) {
+    if (this == &other) {
+        return *this;
+    }
+    _size = 0;
+    reserve(other._size);
+    memcpy(getData(), other.getData(), other._size * sizeof(uint32_t));
+    _size = other._size;
+    _hash = other._hash;
+    return *this;
+}
+
+PackedPath::~PackedPath() {
+    if (!isInline()) {
+        delete[] _heap;
+    }
+}
+
+uint64_t PackedPath::extendHash(uint64_t hash, uint32_t position) {
+    uint64_t h = (hash ^ position) * 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+
+void PackedPath::reserve(uint32_t capacity) {
+    if (capacity <= _capacity) {
+        return;
+    }
+
+    uint32_t* data = new uint32_t[capacity];
+    memcpy(data, getData(), _size * sizeof(uint32_t));
+    if (!isInline()) {
+        delete[] _heap;
+    }
+    _heap = data;
+    _capacity = capacity;
+}
+
+void PackedPath::push(uint32_t position) {
+    if (_size == _capacity) {
+        reserve(_capacity * 2);
+    }
+    getData()[_size++] = position;
+    _hash = extendHash(_hash, position);
+}
+
+void PackedPath::pop() {
+    if (_size == 0) {
+        panic("cannot pop an empty packed path");
+    }
+    _size--;
+    _hash = EMPTY_HASH;
+    for (uint32_t position : getPositions()) {
+        _hash = extendHash(_hash, position);
+    }
+}
+
+void PackedPath::clear() {
+    _size = 0;
+    _hash = EMPTY_HASH;
+}
+
+bool PackedPath::operator==(const PackedPath& other) const {
+    return _hash == other._hash
+        && _size == other._size
+        && memcmp(getData(), other.getData(), _size * sizeof(uint32_t)) == 0;
+}
+
+void PackedPath::encode(const Design* top, const Path& path, PackedPath* result) {
+    result->clear();
+    result->reserve(static_cast<uint32_t>(path.size()));
+    const Design* design = top;
+    for (const Instance* instance : path) {
+        const size_t position = design->instances.indexOf(instance);
+        if (position == design->instances.size() || instance->isPrimitive()) {
+            panic("path does not follow the hierarchy of its top design");
+        }
+        result->push(static_cast<uint32_t>(position));
+        design = instance->model;
+    }
+}
+
+void PackedPath::decode(const Design* top, Path* result) const {
+    result->clear();
+    result->reserve(_size);
+    const Design* design = top;
+    for (uint32_t position : getPositions()) {
+        if (position >= design->instances.size()) {
+            panic("packed path does not follow the hierarchy of its top design");
+        }
+        Instance* instance = &design->instances[position];
+        if (instance->isPrimitive()) {
+            panic("packed path goes through a primitive instance");
+        }
+        result->push_back(instance);
+        design = instance->model;
+    }
+}
+
+const Design* PackedPath::getDesign(const Design* top) const {
+    const Design* design = top;
+    for (uint32_t position : getPositions()) {
+        if (position >= design->instances.size()) {
+            panic("packed path does not follow the hierarchy of its top design");
+        }
+        const Instance* instance = &design->instances[position];
+        if (instance->isPrimitive()) {
+            panic("packed path goes through a primitive instance");
+        }
+        design = instance->model;
+    }
+    return design;
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <span>
+
+#include "Occurrence.h"
+
+namespace stargate {
+
+struct Design;
+
+// Compact, hashable form of a Path: the position of each instance among
+// the instances of its parent design, 4 bytes per level. Paths of up to
+// INLINE_CAPACITY levels take no allocation, and the hash is kept up to
+// date as levels are pushed, so hashing and most mismatches cost O(1).
+//
+// A PackedPath does not refer to the netlist: it is decoded against a
+// top design, and is invalidated like occurrences by a Uniquifier
+// commit. Positions are kept across a compaction.
+class PackedPath {
+public:
+    static constexpr uint32_t INLINE_CAPACITY = 6;
+
+    PackedPath() = default;
+    PackedPath(const PackedPath& other);
+    PackedPath& operator=(const PackedPath& other);
+    ~PackedPath();
+
+    // Encodes path, which starts in top, into result. Panics if it does
+    // not follow the hierarchy under top.
+    static void encode(const Design* top, const Path& path, PackedPath* result);
+
+    // Fills result with the instances of the path. Panics if it does not
+    // lead through hierarchical instances under top.
+    void decode(const Design* top, Path* result) const;
+
+    // Design at the end of the path, without building the Path.
+    const Design* getDesign(const Design* top) const;
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    uint32_t operator[](size_t i) const { return getData()[i]; }
+    std::span<const uint32_t> getPositions() const { return {getData(), _size}; }
+
+    uint64_t getHash() const { return _hash; }
+
+    void push(uint32_t position);
+    void pop();
+    void clear();
+
+    bool operator==(const PackedPath& other) const;
+
+private:
+    static constexpr uint64_t EMPTY_HASH = 0x9e3779b97f4a7c15ull;
+
+    uint64_t _hash {EMPTY_HASH};
+    uint32_t _size {0};
+    uint32_t _capacity {INLINE_CAPACITY};
+    union {
+        uint32_t _inline[INLINE_CAPACITY];
+        uint32_t* _heap;
+    };
+
+    bool isInline() const { return _capacity == INLINE_CAPACITY; }
+    const uint32_t* getData() const { return isInline() ? _inline : _heap; }
+    uint32_t* getData() { return isInline() ? _inline : _heap; }
+
+    static uint64_t extendHash(uint64_t hash, uint32_t position);
+    void reserve(uint32_t capacity);
+};
+
+struct PackedPathHash {
+    size_t operator()(const PackedPath& path) const { return path.getHash(); }
+};
+
+// Occurrences over packed paths, with the same meaning as those of
+// Occurrence.h.
+struct PackedBitNetOccurrence {
+    PackedPath path;
+    BitNet* net {nullptr};
+
+    bool operator==(const PackedBitNetOccurrence& other) const = default;
+};
+
+struct PackedBitInstTermOccurrence {
+    PackedPath path;
+    BitInstTerm* term {nullptr};
+
+    bool operator==(const PackedBitInstTermOccurrence& other) const = default;
+};
+
+struct PackedBitDesignTermOccurrence {
+    PackedPath path;
+    BitDesignTerm* term {nullptr};
+
+    bool operator==(const PackedBitDesignTermOccurrence& other) const = default;
+};
+
+struct PackedOccurrenceHash {
+    template <typename Occurrence>
+    size_t operator()(const Occurrence& occurrence) const {
+        const uint64_t object = reinterpret_cast<uintptr_t>(getObject(occurrence));
+        return occurrence.path.getHash() ^ (object * 0xff51afd7ed558ccdull);
+    }
+
+private:
+    static const void* getObject(const PackedBitNetOccurrence& o) {
+        return o.net;
+    }
+    static const void* getObject(const PackedBitInstTermOccurrence& o) {
+        return o.term;
+    }
+    static const void* getObject(const PackedBitDesignTermOccurrence& o) {
+        return o.term;
+    }
+};
+
+}
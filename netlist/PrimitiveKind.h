@@ -0,0 +1,269 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace stargate {
+
+// Kind of a primitive design, also stored in the flags of each of its
+// instances. None marks an instance of a non-primitive design.
+enum class PrimitiveKind : uint16_t {
+    None = 0,
+
+    // System primitives: structural relations with no hardware
+    // counterpart.
+    SGC_ASSIGN,
+    SGC_ALIAS,
+
+    // Technology primitives
+    LUT1,
+    LUT2,
+    LUT3,
+    LUT4,
+    LUT5,
+    LUT6,
+    DFF,
+    DFFE,
+    DFFR,
+    DFFRE,
+    DFFS,
+    DFFSE,
+    BUF,
+    INV,
+    IBUF,
+    OBUF,
+    IOBUF,
+    CARRY4,
+    MUX2,
+    MUX4,
+    MUX8,
+    BRAM18,
+    BRAM36,
+    DSP48,
+
+    Count,
+};
+
+// Pin indices of the primitives, for O(1) access to the terms of a
+// primitive instance. Scalar pins and bus pins are numbered
+// separately, in the order the PrimitiveLibrary creates them.
+
+namespace SGC_ASSIGNPins {
+    constexpr uint16_t I = 0;
+    constexpr uint16_t O = 1;
+}
+
+namespace SGC_ALIASPins {
+    constexpr uint16_t A = 0;
+    constexpr uint16_t B = 1;
+}
+
+// LUTn: inputs I0 to In-1, then O at index n.
+namespace LUT1Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t O = 1;
+}
+
+namespace LUT2Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t O = 2;
+}
+
+namespace LUT3Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t I2 = 2;
+    constexpr uint16_t O = 3;
+}
+
+namespace LUT4Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t I2 = 2;
+    constexpr uint16_t I3 = 3;
+    constexpr uint16_t O = 4;
+}
+
+namespace LUT5Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t I2 = 2;
+    constexpr uint16_t I3 = 3;
+    constexpr uint16_t I4 = 4;
+    constexpr uint16_t O = 5;
+}
+
+namespace LUT6Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t I2 = 2;
+    constexpr uint16_t I3 = 3;
+    constexpr uint16_t I4 = 4;
+    constexpr uint16_t I5 = 5;
+    constexpr uint16_t O = 6;
+}
+
+namespace DFFPins {
+    constexpr uint16_t D = 0;
+    constexpr uint16_t CLK = 1;
+    constexpr uint16_t Q = 2;
+}
+
+namespace DFFEPins {
+    constexpr uint16_t D = 0;
+    constexpr uint16_t CLK = 1;
+    constexpr uint16_t CE = 2;
+    constexpr uint16_t Q = 3;
+}
+
+namespace DFFRPins {
+    constexpr uint16_t D = 0;
+    constexpr uint16_t CLK = 1;
+    constexpr uint16_t R = 2;
+    constexpr uint16_t Q = 3;
+}
+
+namespace DFFREPins {
+    constexpr uint16_t D = 0;
+    constexpr uint16_t CLK = 1;
+    constexpr uint16_t CE = 2;
+    constexpr uint16_t R = 3;
+    constexpr uint16_t Q = 4;
+}
+
+namespace DFFSPins {
+    constexpr uint16_t D = 0;
+    constexpr uint16_t CLK = 1;
+    constexpr uint16_t S = 2;
+    constexpr uint16_t Q = 3;
+}
+
+namespace DFFSEPins {
+    constexpr uint16_t D = 0;
+    constexpr uint16_t CLK = 1;
+    constexpr uint16_t CE = 2;
+    constexpr uint16_t S = 3;
+    constexpr uint16_t Q = 4;
+}
+
+namespace BUFPins {
+    constexpr uint16_t I = 0;
+    constexpr uint16_t O = 1;
+}
+
+namespace INVPins {
+    constexpr uint16_t I = 0;
+    constexpr uint16_t O = 1;
+}
+
+namespace IBUFPins {
+    constexpr uint16_t I = 0;
+    constexpr uint16_t O = 1;
+}
+
+namespace OBUFPins {
+    constexpr uint16_t I = 0;
+    constexpr uint16_t O = 1;
+}
+
+namespace IOBUFPins {
+    constexpr uint16_t I = 0;
+    constexpr uint16_t T = 1;
+    constexpr uint16_t O = 2;
+    constexpr uint16_t IO = 3;
+}
+
+namespace CARRY4Pins {
+    // Scalar pins
+    constexpr uint16_t CI = 0;
+    constexpr uint16_t CYINIT = 1;
+
+    // Bus pins, all [3:0]
+    constexpr uint16_t DI = 0;
+    constexpr uint16_t S = 1;
+    constexpr uint16_t O = 2;
+    constexpr uint16_t CO = 3;
+}
+
+namespace MUX2Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t S = 2;
+    constexpr uint16_t O = 3;
+}
+
+namespace MUX4Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t I2 = 2;
+    constexpr uint16_t I3 = 3;
+    constexpr uint16_t S0 = 4;
+    constexpr uint16_t S1 = 5;
+    constexpr uint16_t O = 6;
+}
+
+namespace MUX8Pins {
+    constexpr uint16_t I0 = 0;
+    constexpr uint16_t I1 = 1;
+    constexpr uint16_t I2 = 2;
+    constexpr uint16_t I3 = 3;
+    constexpr uint16_t I4 = 4;
+    constexpr uint16_t I5 = 5;
+    constexpr uint16_t I6 = 6;
+    constexpr uint16_t I7 = 7;
+    constexpr uint16_t S0 = 8;
+    constexpr uint16_t S1 = 9;
+    constexpr uint16_t S2 = 10;
+    constexpr uint16_t O = 11;
+}
+
+namespace BRAM18Pins {
+    // Scalar pins
+    constexpr uint16_t CLKA = 0;
+    constexpr uint16_t ENA = 1;
+    constexpr uint16_t WEA = 2;
+    constexpr uint16_t CLKB = 3;
+    constexpr uint16_t ENB = 4;
+    constexpr uint16_t WEB = 5;
+
+    // Bus pins: ADDR [13:0], DI and DO [15:0]
+    constexpr uint16_t ADDRA = 0;
+    constexpr uint16_t ADDRB = 1;
+    constexpr uint16_t DIA = 2;
+    constexpr uint16_t DIB = 3;
+    constexpr uint16_t DOA = 4;
+    constexpr uint16_t DOB = 5;
+}
+
+// Same pins as BRAM18, with ADDR [15:0], DI and DO [31:0].
+namespace BRAM36Pins {
+    constexpr uint16_t CLKA = 0;
+    constexpr uint16_t ENA = 1;
+    constexpr uint16_t WEA = 2;
+    constexpr uint16_t CLKB = 3;
+    constexpr uint16_t ENB = 4;
+    constexpr uint16_t WEB = 5;
+
+    constexpr uint16_t ADDRA = 0;
+    constexpr uint16_t ADDRB = 1;
+    constexpr uint16_t DIA = 2;
+    constexpr uint16_t DIB = 3;
+    constexpr uint16_t DOA = 4;
+    constexpr uint16_t DOB = 5;
+}
+
+namespace DSP48Pins {
+    // Scalar pins
+    constexpr uint16_t CLK = 0;
+    constexpr uint16_t CE = 1;
+    constexpr uint16_t RST = 2;
+
+    // Bus pins: A [29:0], B [17:0], C and P [47:0], OPMODE [6:0]
+    constexpr uint16_t A = 0;
+    constexpr uint16_t B = 1;
+    constexpr uint16_t C = 2;
+    constexpr uint16_t P = 3;
+    constexpr uint16_t OPMODE = 4;
+}
+
+}
@@ -0,0 +1,300 @@
+#include "PrimitiveLibrary.h"
+
+#include "Design.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistBuilder.h"
+
+namespace stargate {
+
+namespace {
+
+const char* const LUT_INPUTS[] = {"I0", "I1", "I2", "I3", "I4", "I5"};
+const char* const MUX_INPUTS[] = {"I0", "I1", "I2", "I3", "I4", "I5", "I6", "I7"};
+const char* const MUX_SELECTS[] = {"S0", "S1", "S2"};
+
+void addLUTPins(size_t inputs, std::vector<PrimitivePin>& pins) {
+    for (size_t i = 0; i < inputs; i++) {
+        pins.push_back({LUT_INPUTS[i], Direction::Input, 0});
+    }
+    pins.push_back({"O", Direction::Output, 0});
+}
+
+void addMuxPins(size_t selects, std::vector<PrimitivePin>& pins) {
+    for (size_t i = 0; i < (size_t(1) << selects); i++) {
+        pins.push_back({MUX_INPUTS[i], Direction::Input, 0});
+    }
+    if (selects == 1) {
+        pins.push_back({"S", Direction::Input, 0});
+    } else {
+        for (size_t i = 0; i < selects; i++) {
+            pins.push_back({MUX_SELECTS[i], Direction::Input, 0});
+        }
+    }
+    pins.push_back({"O", Direction::Output, 0});
+}
+
+void addFlipFlopPins(const char* enable,
+                     const char* reset,
+                     std::vector<PrimitivePin>& pins) {
+    pins.push_back({"D", Direction::Input, 0});
+    pins.push_back({"CLK", Direction::Input, 0});
+    if (enable) {
+        pins.push_back({enable, Direction::Input, 0});
+    }
+    if (reset) {
+        pins.push_back({reset, Direction::Input, 0});
+    }
+    pins.push_back({"Q", Direction::Output, 0});
+}
+
+void addBRAMPins(uint16_t addrWidth,
+                 uint16_t dataWidth,
+                 std::vector<PrimitivePin>& pins) {
+    pins.push_back({"CLKA", Direction::Input, 0});
+    pins.push_back({"ENA", Direction::Input, 0});
+    pins.push_back({"WEA", Direction::Input, 0});
+    pins.push_back({"CLKB", Direction::Input, 0});
+    pins.push_back({"ENB", Direction::Input, 0});
+    pins.push_back({"WEB", Direction::Input, 0});
+    pins.push_back({"ADDRA", Direction::Input, addrWidth});
+    pins.push_back({"ADDRB", Direction::Input, addrWidth});
+    pins.push_back({"DIA", Direction::Input, dataWidth});
+    pins.push_back({"DIB", Direction::Input, dataWidth});
+    pins.push_back({"DOA", Direction::Output, dataWidth});
+    pins.push_back({"DOB", Direction::Output, dataWidth});
+}
+
+}
+
+PrimitiveLibrary::PrimitiveLibrary(LibraryID id, NameID name)
+    : Library(id, name, FLAG_PRIMITIVE_ONLY)
+{
+}
+
+PrimitiveLibrary::~PrimitiveLibrary() {
+}
+
+void PrimitiveLibrary::initialize(NetlistBuilder* builder) {
+    NameTable* names = builder->getNetlist()->getNameTable();
+    std::vector<PrimitivePin> pins;
+
+    for (uint16_t k = 1; k < static_cast<uint16_t>(PrimitiveKind::Count); k++) {
+        const PrimitiveKind kind = static_cast<PrimitiveKind>(k);
+        const NameID name = names->getName(getKindName(kind));
+        Design* design = builder->createPrimitiveDesign(this, kind, name);
+
+        pins.clear();
+        getPins(kind, pins);
+        for (const PrimitivePin& pin : pins) {
+            const NameID pinName = names->getName(pin.name);
+            if (pin.width == 0) {
+                builder->addScalarDesignTerm(design, pinName, pin.direction);
+            } else {
+                builder->addBusDesignTerm(design, pinName, pin.direction,
+                                          pin.width - 1, 0);
+            }
+        }
+    }
+}
+
+const char* PrimitiveLibrary::getKindName(PrimitiveKind kind) {
+    switch (kind) {
+        case PrimitiveKind::None:
+            return "";
+
+        case PrimitiveKind::SGC_ASSIGN:
+            return "SGC_ASSIGN";
+
+        case PrimitiveKind::SGC_ALIAS:
+            return "SGC_ALIAS";
+
+        case PrimitiveKind::LUT1:
+            return "LUT1";
+
+        case PrimitiveKind::LUT2:
+            return "LUT2";
+
+        case PrimitiveKind::LUT3:
+            return "LUT3";
+
+        case PrimitiveKind::LUT4:
+            return "LUT4";
+
+        case PrimitiveKind::LUT5:
+            return "LUT5";
+
+        case PrimitiveKind::LUT6:
+            return "LUT6";
+
+        case PrimitiveKind::DFF:
+            return "DFF";
+
+        case PrimitiveKind::DFFE:
+            return "DFFE";
+
+        case PrimitiveKind::DFFR:
+            return "DFFR";
+
+        case PrimitiveKind::DFFRE:
+            return "DFFRE";
+
+        case PrimitiveKind::DFFS:
+            return "DFFS";
+
+        case PrimitiveKind::DFFSE:
+            return "DFFSE";
+
+        case PrimitiveKind::BUF:
+            return "BUF";
+
+        case PrimitiveKind::INV:
+            return "INV";
+
+        case PrimitiveKind::IBUF:
+            return "IBUF";
+
+        case PrimitiveKind::OBUF:
+            return "OBUF";
+
+        case PrimitiveKind::IOBUF:
+            return "IOBUF";
+
+        case PrimitiveKind::CARRY4:
+            return "CARRY4";
+
+        case PrimitiveKind::MUX2:
+            return "MUX2";
+
+        case PrimitiveKind::MUX4:
+            return "MUX4";
+
+        case PrimitiveKind::MUX8:
+            return "MUX8";
+
+        case PrimitiveKind::BRAM18:
+            return "BRAM18";
+
+        case PrimitiveKind::BRAM36:
+            return "BRAM36";
+
+        case PrimitiveKind::DSP48:
+            return "DSP48";
+
+        case PrimitiveKind::Count:
+            return "";
+    }
+
+    return "";
+}
+
+void PrimitiveLibrary::getPins(PrimitiveKind kind, std::vector<PrimitivePin>& pins) {
+    switch (kind) {
+        case PrimitiveKind::SGC_ASSIGN:
+            pins.push_back({"I", Direction::Input, 0});
+            pins.push_back({"O", Direction::Output, 0});
+        break;
+
+        case PrimitiveKind::SGC_ALIAS:
+            pins.push_back({"A", Direction::InOut, 0});
+            pins.push_back({"B", Direction::InOut, 0});
+        break;
+
+        case PrimitiveKind::LUT1:
+        case PrimitiveKind::LUT2:
+        case PrimitiveKind::LUT3:
+        case PrimitiveKind::LUT4:
+        case PrimitiveKind::LUT5:
+        case PrimitiveKind::LUT6: {
+            const size_t inputs = static_cast<size_t>(kind)
+                                - static_cast<size_t>(PrimitiveKind::LUT1) + 1;
+            addLUTPins(inputs, pins);
+        }
+        break;
+
+        case PrimitiveKind::DFF:
+            addFlipFlopPins(nullptr, nullptr, pins);
+        break;
+
+        case PrimitiveKind::DFFE:
+            addFlipFlopPins("CE", nullptr, pins);
+        break;
+
+        case PrimitiveKind::DFFR:
+            addFlipFlopPins(nullptr, "R", pins);
+        break;
+
+        case PrimitiveKind::DFFRE:
+            addFlipFlopPins("CE", "R", pins);
+        break;
+
+        case PrimitiveKind::DFFS:
+            addFlipFlopPins(nullptr, "S", pins);
+        break;
+
+        case PrimitiveKind::DFFSE:
+            addFlipFlopPins("CE", "S", pins);
+        break;
+
+        case PrimitiveKind::BUF:
+        case PrimitiveKind::INV:
+        case PrimitiveKind::IBUF:
+        case PrimitiveKind::OBUF:
+            pins.push_back({"I", Direction::Input, 0});
+            pins.push_back({"O", Direction::Output, 0});
+        break;
+
+        case PrimitiveKind::IOBUF:
+            pins.push_back({"I", Direction::Input, 0});
+            pins.push_back({"T", Direction::Input, 0});
+            pins.push_back({"O", Direction::Output, 0});
+            pins.push_back({"IO", Direction::InOut, 0});
+        break;
+
+        case PrimitiveKind::CARRY4:
+            pins.push_back({"CI", Direction::Input, 0});
+            pins.push_back({"CYINIT", Direction::Input, 0});
+            pins.push_back({"DI", Direction::Input, 4});
+            pins.push_back({"S", Direction::Input, 4});
+            pins.push_back({"O", Direction::Output, 4});
+            pins.push_back({"CO", Direction::Output, 4});
+        break;
+
+        case PrimitiveKind::MUX2:
+            addMuxPins(1, pins);
+        break;
+
+        case PrimitiveKind::MUX4:
+            addMuxPins(2, pins);
+        break;
+
+        case PrimitiveKind::MUX8:
+            addMuxPins(3, pins);
+        break;
+
+        case PrimitiveKind::BRAM18:
+            addBRAMPins(14, 16, pins);
+        break;
+
+        case PrimitiveKind::BRAM36:
+            addBRAMPins(16, 32, pins);
+        break;
+
+        case PrimitiveKind::DSP48:
+            pins.push_back({"CLK", Direction::Input, 0});
+            pins.push_back({"CE", Direction::Input, 0});
+            pins.push_back({"RST", Direction::Input, 0});
+            pins.push_back({"A", Direction::Input, 30});
+            pins.push_back({"B", Direction::Input, 18});
+            pins.push_back({"C", Direction::Input, 48});
+            pins.push_back({"P", Direction::Output, 48});
+            pins.push_back({"OPMODE", Direction::Input, 7});
+        break;
+
+        case PrimitiveKind::None:
+        case PrimitiveKind::Count:
+        break;
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "Library.h"
+#include "NetlistIDs.h"
+#include "PrimitiveKind.h"
+
+namespace stargate {
+
+class NetlistBuilder;
+
+// Pin of a primitive design. width is 0 for a scalar pin, otherwise
+// the pin is a [width-1:0] bus.
+struct PrimitivePin {
+    const char* name {nullptr};
+    Direction direction {Direction::Input};
+    uint16_t width {0};
+};
+
+// The library of every primitive design, one per PrimitiveKind. The
+// design of kind k is at index k - 1, so lookups by kind are O(1).
+class PrimitiveLibrary : public Library {
+public:
+    PrimitiveLibrary(LibraryID id, NameID name);
+    ~PrimitiveLibrary() override;
+
+    // Creates the design of every primitive kind, in kind order.
+    void initialize(NetlistBuilder* builder);
+
+    Design* get(PrimitiveKind kind) const {
+        if (kind == PrimitiveKind::None) {
+            return nullptr;
+        }
+        return _designs[static_cast<uint16_t>(kind) - 1];
+    }
+
+    Design* getAssign() const { return get(PrimitiveKind::SGC_ASSIGN); }
+    Design* getAlias() const { return get(PrimitiveKind::SGC_ALIAS); }
+
+    Design* getLUT1() const { return get(PrimitiveKind::LUT1); }
+    Design* getLUT2() const { return get(PrimitiveKind::LUT2); }
+    Design* getLUT3() const { return get(PrimitiveKind::LUT3); }
+    Design* getLUT4() const { return get(PrimitiveKind::LUT4); }
+    Design* getLUT5() const { return get(PrimitiveKind::LUT5); }
+    Design* getLUT6() const { return get(PrimitiveKind::LUT6); }
+
+    Design* getDFF() const { return get(PrimitiveKind::DFF); }
+    Design* getDFFE() const { return get(PrimitiveKind::DFFE); }
+    Design* getDFFR() const { return get(PrimitiveKind::DFFR); }
+    Design* getDFFRE() const { return get(PrimitiveKind::DFFRE); }
+
+    Design* getBUF() const { return get(PrimitiveKind::BUF); }
+    Design* getINV() const { return get(PrimitiveKind::INV); }
+
+    Design* getBRAM18() const { return get(PrimitiveKind::BRAM18); }
+    Design* getBRAM36() const { return get(PrimitiveKind::BRAM36); }
+    Design* getDSP48() const { return get(PrimitiveKind::DSP48); }
+
+    static bool isSystemPrimitive(PrimitiveKind kind) {
+        return kind >= PrimitiveKind::SGC_ASSIGN && kind <= PrimitiveKind::SGC_ALIAS;
+    }
+
+    static bool isLUT(PrimitiveKind kind) {
+        return kind >= PrimitiveKind::LUT1 && kind <= PrimitiveKind::LUT6;
+    }
+
+    static bool isFlipFlop(PrimitiveKind kind) {
+        return kind >= PrimitiveKind::DFF && kind <= PrimitiveKind::DFFSE;
+    }
+
+    static bool isBRAM(PrimitiveKind kind) {
+        return kind == PrimitiveKind::BRAM18 || kind == PrimitiveKind::BRAM36;
+    }
+
+    static const char* getKindName(PrimitiveKind kind);
+
+    // Pins of a primitive, scalar and bus pins each in the order of
+    // their indices in PrimitiveKind.h.
+    static void getPins(PrimitiveKind kind, std::vector<PrimitivePin>& pins);
+};
+
+}
@@ -0,0 +1,687 @@
+#include "Uniquifier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_set>
+
+#include "Compactor.h"
+#include "Design.h"
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistBuilder.h"
+
+#include "Panic.h"
+
+namespace stargate {
+
+namespace {
+
+std::atomic<uint64_t> nextSerial {1};
+
+}
+
+// State of one commit(). Contexts form a tree of the paths that have
+// changes, rooted at the top design, and each is rebuilt at most once.
+struct Uniquifier::Commit {
+    struct Entry {
+        const ChangeLog* log {nullptr};
+        uint32_t index {0};
+        Instance* const* path {nullptr};
+        uint32_t pathSize {0};
+
+        const Change& getChange() const { return log->changes[index]; }
+    };
+
+    struct Context {
+        // Instance leading to this context from its parent.
+        Instance* instance {nullptr};
+        // Design of the context before the commit.
+        Design* design {nullptr};
+        std::vector<Entry> entries;
+        std::vector<uint32_t> children;
+    };
+
+    // Objects of a rebuilt design, by the object they copy.
+    struct DesignMap {
+        std::unordered_map<const BitNet*, BitNet*> nets;
+        std::unordered_map<const BitDesignTerm*, BitDesignTerm*> designTerms;
+        std::unordered_map<const Instance*, Instance*> instances;
+        std::unordered_map<const BitInstTerm*, BitInstTerm*> instTerms;
+    };
+
+    struct StagedDesign {
+        Design* design {nullptr};
+        Library* library {nullptr};
+        NameID name;
+    };
+
+    Uniquifier* _uniquifier {nullptr};
+    NetlistBuilder _builder;
+    std::vector<Context> _contexts;
+
+    // Objects added by each change, by log and change index.
+    std::vector<std::vector<BitNet*>> _pendingNets;
+    std::vector<std::vector<Instance*>> _pendingInstances;
+
+    std::vector<StagedDesign> _stagedDesigns;
+    std::unordered_map<const Design*, size_t> _stagedIndices;
+    // Built instances given a staged model, by index in _stagedDesigns.
+    std::vector<std::pair<Instance*, size_t>> _modelFixups;
+
+    explicit Commit(Uniquifier* uniquifier);
+
+    static bool isAddition(ChangeKind kind) {
+        return kind == ChangeKind::AddScalarNet || kind == ChangeKind::AddInstance;
+    }
+
+    void run();
+    void buildContexts(std::vector<Entry>& entries);
+    Entry getEntry(const ChangeLog* log, uint32_t index) const;
+    Design* process(uint32_t index);
+    Design* rebuild(const Context& context, bool replace, DesignMap* map);
+    void copyDesign(const Design* design, Design* copy,
+                    const std::unordered_set<const Instance*>& removed, DesignMap* map);
+    void applyChange(const Entry& entry, Design* copy, DesignMap* map);
+    BitNet* getNet(const Change& change, const DesignMap& map) const;
+    BitInstTerm* getInstTerm(const Change& change, const DesignMap& map) const;
+    BitDesignTerm* getDesignTerm(const Change& change, const DesignMap& map) const;
+    NameID getCopyName(const Design* design);
+    void release(const Design* design);
+    void stage(Design* design);
+};
+
+Uniquifier::Commit::Commit(Uniquifier* uniquifier)
+    : _uniquifier(uniquifier),
+    _builder(uniquifier->_netlist)
+{
+}
+
+void Uniquifier::Commit::run() {
+    const std::vector<std::unique_ptr<ChangeLog>>& logs = _uniquifier->_logs;
+
+    std::vector<Entry> entries;
+    for (const std::unique_ptr<ChangeLog>& log : logs) {
+        _pendingNets.emplace_back(log->changes.size(), nullptr);
+        _pendingInstances.emplace_back(log->changes.size(), nullptr);
+        for (uint32_t i = 0; i < log->changes.size(); i++) {
+            entries.push_back(getEntry(log.get(), i));
+        }
+    }
+
+    // Changes of one context end up next to each other, in the order
+    // they were recorded in.
+    const auto lessInstance = [](const Instance* a, const Instance* b) {
+        return a->id.value < b->id.value;
+    };
+    std::stable_sort(entries.begin(), entries.end(),
+                     [&](const Entry& a, const Entry& b) {
+        return std::lexicographical_compare(a.path, a.path + a.pathSize,
+                                            b.path, b.path + b.pathSize, lessInstance);
+    });
+    buildContexts(entries);
+
+    process(0);
+    _builder.finalize();
+
+    // The builder repointed libraries and the instances it built; the
+    // rest refers to the final designs by name.
+    std::vector<Design*> finalDesigns;
+    for (const StagedDesign& staged : _stagedDesigns) {
+        finalDesigns.push_back(staged.library->findDesign(staged.name));
+    }
+    for (const auto& [instance, index] : _modelFixups) {
+        instance->model = finalDesigns[index];
+    }
+
+    std::unordered_map<const Design*, uint32_t>& refCounts = _uniquifier->_refCounts;
+    for (size_t i = 0; i < _stagedDesigns.size(); i++) {
+        const auto it = refCounts.find(_stagedDesigns[i].design);
+        if (it != refCounts.end()) {
+            const uint32_t count = it->second;
+            refCounts.erase(it);
+            refCounts[finalDesigns[i]] = count;
+        }
+    }
+}
+
+Uniquifier::Commit::Entry Uniquifier::Commit::getEntry(const ChangeLog* log,
+                                                        uint32_t index) const {
+    const Change& change = log->changes[index];
+    if (change.pathSize != PENDING_PATH) {
+        return {log, index, log->paths.data() + change.pathBegin, change.pathSize};
+    }
+
+    // Both ends of the connection are pending: the context is the one
+    // of the net.
+    const std::vector<std::unique_ptr<ChangeLog>>& logs = _uniquifier->_logs;
+    if (change.pendingNetLog >= logs.size()
+        || change.pendingNet >= logs[change.pendingNetLog]->changes.size()) {
+        panic("invalid pending net reference");
+    }
+    const ChangeLog* netLog = logs[change.pendingNetLog].get();
+    const Change& netChange = netLog->changes[change.pendingNet];
+    return {log, index, netLog->paths.data() + netChange.pathBegin, netChange.pathSize};
+}
+
+void Uniquifier::Commit::buildContexts(std::vector<Entry>& entries) {
+    Context& root = _contexts.emplace_back();
+    root.design = _uniquifier->_netlist->getTopDesign();
+
+    // Entries are sorted by path, so a path shares its prefix with the
+    // last child created at each depth or with none.
+    for (const Entry& entry : entries) {
+        uint32_t index = 0;
+        for (uint32_t depth = 0; depth < entry.pathSize; depth++) {
+            Instance* instance = entry.path[depth];
+            const std::vector<uint32_t>& children = _contexts[index].children;
+            if (!children.empty() && _contexts[children.back()].instance == instance) {
+                index = children.back();
+                continue;
+            }
+
+            if (instance->parent != _contexts[index].design) {
+                panic("occurrence path does not follow the hierarchy");
+            }
+            if (instance->model->isPrimitive()) {
+                panic("occurrence path goes through a primitive instance");
+            }
+
+            const uint32_t child = static_cast<uint32_t>(_contexts.size());
+            Context& context = _contexts.emplace_back();
+            context.instance = instance;
+            context.design = instance->model;
+            _contexts[index].children.push_back(child);
+            index = child;
+        }
+        _contexts[index].entries.push_back(entry);
+    }
+}
+
+Design* Uniquifier::Commit::process(uint32_t index) {
+    const Context& context = _contexts[index];
+    Design* design = context.design;
+    std::unordered_map<const Design*, uint32_t>& refCounts = _uniquifier->_refCounts;
+
+    // Every context has changes or contexts with changes below it. A
+    // design with one occurrence is left alone if only its children
+    // change.
+    const bool unique = index == 0 || refCounts[design] == 1;
+    if (unique && context.entries.empty()) {
+        for (uint32_t childIndex : context.children) {
+            const Context& child = _contexts[childIndex];
+            Design* model = process(childIndex);
+            if (model != child.design) {
+                _modelFixups.emplace_back(child.instance, _stagedIndices.at(model));
+            }
+        }
+        return design;
+    }
+
+    DesignMap map;
+    Design* copy = rebuild(context, unique, &map);
+    for (uint32_t childIndex : context.children) {
+        const Context& child = _contexts[childIndex];
+        const auto it = map.instances.find(child.instance);
+        if (it == map.instances.end()) {
+            panic("changes below an instance that is removed");
+        }
+
+        // The staged instance is repointed by the builder.
+        it->second->model = process(childIndex);
+    }
+    return copy;
+}
+
+Design* Uniquifier::Commit::rebuild(const Context& context,
+                                    bool replace,
+                                    DesignMap* map) {
+    Design* design = context.design;
+    std::unordered_map<const Design*, uint32_t>& refCounts = _uniquifier->_refCounts;
+
+    std::unordered_set<const Instance*> removed;
+    for (const Entry& entry : context.entries) {
+        const Change& change = entry.getChange();
+        if (change.kind == ChangeKind::RemoveInstance) {
+            if (change.instance->parent != design) {
+                panic("removed instance is not in the design of its context");
+            }
+            removed.insert(change.instance);
+        }
+    }
+
+    Design* copy = replace ? _builder.createReplacement(design)
+                           : _builder.createDesign(design->library, getCopyName(design));
+    stage(copy);
+    copyDesign(design, copy, removed, map);
+
+    // Objects are added first, so that a connection may use one added by
+    // a log sorted after its own.
+    for (const Entry& entry : context.entries) {
+        if (isAddition(entry.getChange().kind)) {
+            applyChange(entry, copy, map);
+        }
+    }
+    for (const Entry& entry : context.entries) {
+        if (!isAddition(entry.getChange().kind)) {
+            applyChange(entry, copy, map);
+        }
+    }
+
+    // The copy holds references of its own to its models, the copied
+    // instances being counted by copyDesign().
+    for (const Entry& entry : context.entries) {
+        const Change& change = entry.getChange();
+        if (change.kind == ChangeKind::AddInstance && !change.model->isPrimitive()) {
+            refCounts[change.model]++;
+        }
+    }
+
+    // The context no longer instantiates the design; a copy that took
+    // its last reference releases it like a replacement does.
+    if (replace || --refCounts[design] == 0) {
+        release(design);
+    }
+    if (context.instance) {
+        refCounts[copy] = 1;
+    }
+
+    return copy;
+}
+
+void Uniquifier::Commit::copyDesign(const Design* design,
+                                    Design* copy,
+                                    const std::unordered_set<const Instance*>& removed,
+                                    DesignMap* map) {
+    design->scalarDesignTerms.forEach([&](ScalarDesignTerm& term) {
+        map->designTerms[&term] =
+            _builder.addScalarDesignTerm(copy, term.name, term.direction);
+    });
+    design->busDesignTerms.forEach([&](BusDesignTerm& bus) {
+        BusDesignTerm* copyBus = _builder.addBusDesignTerm(
+            copy, bus.name, bus.direction, bus.msb, bus.lsb);
+        size_t i = 0;
+        bus.bits.forEach([&](BusDesignTermBit& bit) {
+            map->designTerms[&bit] = copyBus->bits.data() + i++;
+        });
+    });
+
+    design->scalarNets.forEach([&](ScalarNet& net) {
+        map->nets[&net] = _builder.addScalarNet(copy, net.name);
+    });
+    design->busNets.forEach([&](BusNet& bus) {
+        BusNet* copyBus = _builder.addBusNet(copy, bus.name, bus.msb, bus.lsb);
+        size_t i = 0;
+        bus.bits.forEach([&](BusNetBit& bit) {
+            map->nets[&bit] = copyBus->bits.data() + i++;
+        });
+    });
+
+    const auto copyConnection = [&](const BitInstTerm& term, BitInstTerm* copyTerm) {
+        map->instTerms[&term] = copyTerm;
+        if (term.connectedNet) {
+            _builder.connect(map->nets.at(term.connectedNet), copyTerm);
+        }
+    };
+
+    design->instances.forEach([&](Instance& instance) {
+        if (removed.count(&instance)) {
+            return;
+        }
+
+        Instance* copyInstance =
+            _builder.addInstance(copy, instance.name, instance.model);
+        copyInstance->flags = instance.flags;
+        map->instances[&instance] = copyInstance;
+        if (!instance.model->isPrimitive()) {
+            _uniquifier->_refCounts[instance.model]++;
+        }
+
+        size_t i = 0;
+        instance.scalarInstTerms.forEach([&](ScalarInstTerm& term) {
+            copyConnection(term, copyInstance->scalarInstTerms.data() + i++);
+        });
+
+        size_t b = 0;
+        instance.busInstTerms.forEach([&](BusInstTerm& bus) {
+            BusInstTerm& copyBus = copyInstance->busInstTerms.data()[b++];
+            size_t j = 0;
+            bus.bits.forEach([&](BusInstTermBit& bit) {
+                copyConnection(bit, copyBus.bits.data() + j++);
+            });
+        });
+    });
+
+    const auto copyPortConnection = [&](const BitDesignTerm& term) {
+        if (term.connectedNet) {
+            _builder.connect(map->nets.at(term.connectedNet), map->designTerms.at(&term));
+        }
+    };
+    design->scalarDesignTerms.forEach(copyPortConnection);
+    design->busDesignTerms.forEach([&](const BusDesignTerm& bus) {
+        bus.bits.forEach(copyPortConnection);
+    });
+}
+
+void Uniquifier::Commit::applyChange(const Entry& entry, Design* copy, DesignMap* map) {
+    const Change& change = entry.getChange();
+    const uint32_t log = entry.log->index;
+
+    switch (change.kind) {
+        case ChangeKind::AddScalarNet:
+            _pendingNets[log][entry.index] = _builder.addScalarNet(copy, change.name);
+        break;
+
+        case ChangeKind::AddInstance:
+            _pendingInstances[log][entry.index] =
+                _builder.addInstance(copy, change.name, change.model);
+        break;
+
+        // Removed instances are not copied.
+        case ChangeKind::RemoveInstance:
+        break;
+
+        case ChangeKind::ConnectInstTerm:
+            _builder.connect(getNet(change, *map), getInstTerm(change, *map));
+        break;
+
+        case ChangeKind::ConnectDesignTerm:
+            _builder.connect(getNet(change, *map), getDesignTerm(change, *map));
+        break;
+
+        case ChangeKind::DisconnectInstTerm:
+            _builder.disconnect(getInstTerm(change, *map));
+        break;
+
+        case ChangeKind::DisconnectDesignTerm:
+            _builder.disconnect(getDesignTerm(change, *map));
+        break;
+    }
+}
+
+BitNet* Uniquifier::Commit::getNet(const Change& change, const DesignMap& map) const {
+    if (change.pendingNet != NONE) {
+        if (change.pendingNetLog >= _pendingNets.size()
+            || change.pendingNet >= _pendingNets[change.pendingNetLog].size()) {
+            panic("invalid pending net reference");
+        }
+
+        // Null if the net is added in another context.
+        BitNet* net = _pendingNets[change.pendingNetLog][change.pendingNet];
+        if (!net) {
+            panic("pending net is not in the context of its connection");
+        }
+        return net;
+    }
+
+    const auto it = map.nets.find(change.net);
+    if (it == map.nets.end()) {
+        panic("net is not in the design of its context");
+    }
+    return it->second;
+}
+
+BitInstTerm* Uniquifier::Commit::getInstTerm(const Change& change,
+                                             const DesignMap& map) const {
+    if (change.pendingInstance == NONE) {
+        const auto it = map.instTerms.find(change.instTerm);
+        if (it == map.instTerms.end()) {
+            panic("term is not on an instance of the design of its context");
+        }
+        return it->second;
+    }
+
+    if (change.pendingInstanceLog >= _pendingInstances.size()) {
+        panic("invalid pending instance reference");
+    }
+    const std::vector<Instance*>& instances =
+        _pendingInstances[change.pendingInstanceLog];
+    if (change.pendingInstance >= instances.size()) {
+        panic("invalid pending instance reference");
+    }
+
+    Instance* instance = instances[change.pendingInstance];
+    if (!instance) {
+        panic("pending instance is not in the context of its connection");
+    }
+
+    // Staged terms are single chunks.
+    uint32_t port = change.port;
+    if (port < instance->scalarInstTerms.size()) {
+        return instance->scalarInstTerms.data() + port;
+    }
+    port -= static_cast<uint32_t>(instance->scalarInstTerms.size());
+
+    for (size_t b = 0; b < instance->busInstTerms.size(); b++) {
+        BusInstTerm& bus = instance->busInstTerms.data()[b];
+        if (port < bus.bits.size()) {
+            return bus.bits.data() + port;
+        }
+        port -= static_cast<uint32_t>(bus.bits.size());
+    }
+
+    panic("port {} is out of range", change.port);
+    return nullptr;
+}
+
+BitDesignTerm* Uniquifier::Commit::getDesignTerm(const Change& change,
+                                                 const DesignMap& map) const {
+    const auto it = map.designTerms.find(change.designTerm);
+    if (it == map.designTerms.end()) {
+        panic("term is not a term of the design of its context");
+    }
+    return it->second;
+}
+
+NameID Uniquifier::Commit::getCopyName(const Design* design) {
+    NameTable* names = _uniquifier->_netlist->getNameTable();
+    const std::string base = std::string(names->getString(design->name))
+                           + "_" + _uniquifier->_prefix;
+    while (true) {
+        const std::string counter = std::to_string(_uniquifier->_counter++);
+        const NameID name = names->getName(base + counter);
+        if (!design->library->findDesign(name)) {
+            return name;
+        }
+    }
+}
+
+void Uniquifier::Commit::release(const Design* design) {
+    std::unordered_map<const Design*, uint32_t>& refCounts = _uniquifier->_refCounts;
+    refCounts.erase(design);
+
+    // A design that is no longer instantiated no longer holds its models.
+    design->instances.forEach([&](const Instance& instance) {
+        if (instance.model->isPrimitive()) {
+            return;
+        }
+        const auto it = refCounts.find(instance.model);
+        if (it != refCounts.end() && --it->second == 0) {
+            release(instance.model);
+        }
+    });
+}
+
+void Uniquifier::Commit::stage(Design* design) {
+    _stagedIndices[design] = _stagedDesigns.size();
+    _stagedDesigns.push_back({design, design->library, design->name});
+}
+
+Uniquifier::Uniquifier(Netlist* netlist)
+    : _netlist(netlist),
+    _serial(nextSerial.fetch_add(1, std::memory_order_relaxed))
+{
+    countReferences();
+}
+
+Uniquifier::~Uniquifier() {
+}
+
+void Uniquifier::countReferences() {
+    const Design* top = _netlist->getTopDesign();
+    if (!top) {
+        return;
+    }
+
+    std::vector<const Design*> stack {top};
+    std::unordered_set<const Design*> visited {top};
+    while (!stack.empty()) {
+        const Design* design = stack.back();
+        stack.pop_back();
+        design->instances.forEach([&](const Instance& instance) {
+            if (instance.model->isPrimitive()) {
+                return;
+            }
+            _refCounts[instance.model]++;
+            if (visited.insert(instance.model).second) {
+                stack.push_back(instance.model);
+            }
+        });
+    }
+}
+
+Uniquifier::ChangeLog* Uniquifier::getLog() {
+    struct LogCache {
+        uint64_t serial {0};
+        ChangeLog* log {nullptr};
+    };
+    thread_local LogCache cache;
+    if (cache.serial == _serial) {
+        return cache.log;
+    }
+
+    std::lock_guard lock(_logsMutex);
+    ChangeLog*& log = _threadLogs[std::this_thread::get_id()];
+    if (!log) {
+        log = new ChangeLog();
+        log->index = static_cast<uint32_t>(_logs.size());
+        _logs.emplace_back(log);
+    }
+    cache = {_serial, log};
+    return log;
+}
+
+Uniquifier::Change* Uniquifier::addChange(ChangeLog* log,
+                                          ChangeKind kind,
+                                          const Path& context) {
+    Change& change = log->changes.emplace_back();
+    change.kind = kind;
+    change.pathBegin = static_cast<uint32_t>(log->paths.size());
+    change.pathSize = static_cast<uint32_t>(context.size());
+    log->paths.insert(log->paths.end(), context.begin(), context.end());
+    return &change;
+}
+
+PendingScalarNetRef Uniquifier::addScalarNet(const Path& context, NameID name) {
+    ChangeLog* log = getLog();
+    Change* change = addChange(log, ChangeKind::AddScalarNet, context);
+    change->name = name;
+    return {log->index, static_cast<uint32_t>(log->changes.size() - 1)};
+}
+
+PendingInstanceRef Uniquifier::addInstance(const Path& context,
+                                           NameID name,
+                                           Design* model) {
+    ChangeLog* log = getLog();
+    Change* change = addChange(log, ChangeKind::AddInstance, context);
+    change->name = name;
+    change->model = model;
+    return {log->index, static_cast<uint32_t>(log->changes.size() - 1)};
+}
+
+void Uniquifier::removeInstance(const InstanceOccurrence& occ) {
+    Change* change = addChange(getLog(), ChangeKind::RemoveInstance, occ.path);
+    change->instance = occ.instance;
+}
+
+Uniquifier::Change* Uniquifier::addConnection(ChangeKind kind,
+                                              const AnyBitNetRef& net,
+                                              const Path* context) {
+    const BitNetOccurrence* netOcc = std::get_if<BitNetOccurrence>(&net);
+    if (netOcc && context && netOcc->path != *context) {
+        panic("a net only connects to terms of its own context");
+    }
+    if (netOcc) {
+        context = &netOcc->path;
+    }
+
+    Change* change = addChange(getLog(), kind, context ? *context : Path());
+    if (netOcc) {
+        change->net = netOcc->net;
+    } else {
+        const PendingScalarNetRef& pending = std::get<PendingScalarNetRef>(net);
+        change->pendingNetLog = pending.log;
+        change->pendingNet = pending.index;
+        if (!context) {
+            change->pathSize = PENDING_PATH;
+        }
+    }
+    return change;
+}
+
+void Uniquifier::connect(const AnyBitNetRef& net, const AnyBitInstTermRef& term) {
+    const BitInstTermOccurrence* termOcc = std::get_if<BitInstTermOccurrence>(&term);
+    Change* change = addConnection(ChangeKind::ConnectInstTerm, net,
+                                   termOcc ? &termOcc->path : nullptr);
+    if (termOcc) {
+        change->instTerm = termOcc->term;
+    } else {
+        const PendingInstTermRef& pending = std::get<PendingInstTermRef>(term);
+        change->pendingInstanceLog = pending.instance.log;
+        change->pendingInstance = pending.instance.index;
+        change->port = pending.port;
+    }
+}
+
+void Uniquifier::connect(const AnyBitNetRef& net, const BitDesignTermOccurrence& term) {
+    Change* change = addConnection(ChangeKind::ConnectDesignTerm, net, &term.path);
+    change->designTerm = term.term;
+}
+
+void Uniquifier::disconnect(const BitInstTermOccurrence& term) {
+    Change* change = addChange(getLog(), ChangeKind::DisconnectInstTerm, term.path);
+    change->instTerm = term.term;
+}
+
+void Uniquifier::disconnect(const BitDesignTermOccurrence& term) {
+    Change* change = addChange(getLog(), ChangeKind::DisconnectDesignTerm, term.path);
+    change->designTerm = term.term;
+}
+
+void Uniquifier::commit() {
+    if (getNumPendingChanges() == 0) {
+        return;
+    }
+    if (!_netlist->getTopDesign()) {
+        panic("cannot commit changes to a netlist without a top design");
+    }
+
+    Commit commit(this);
+    commit.run();
+    clear();
+
+    if (_compactor) {
+        const CompactionStats stats = _compactor->compactIfNeeded();
+        if (stats.numDesigns != 0) {
+            _refCounts.clear();
+            countReferences();
+        }
+    }
+}
+
+void Uniquifier::clear() {
+    for (const std::unique_ptr<ChangeLog>& log : _logs) {
+        log->changes.clear();
+        log->paths.clear();
+    }
+}
+
+size_t Uniquifier::getNumPendingChanges() const {
+    size_t count = 0;
+    for (const std::unique_ptr<ChangeLog>& log : _logs) {
+        count += log->changes.size();
+    }
+    return count;
+}
+
+}
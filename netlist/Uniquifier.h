@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "NetlistIDs.h"
+#include "Occurrence.h"
+
+namespace stargate {
+
+class Compactor;
+class Netlist;
+struct Design;
+
+// Objects added by changes that are not committed yet. They may be
+// used by later changes of the same context.
+struct PendingScalarNetRef {
+    uint32_t log {0};
+    uint32_t index {0};
+};
+
+struct PendingInstanceRef {
+    uint32_t log {0};
+    uint32_t index {0};
+};
+
+// Term of a pending instance, port being the index of the bit among the
+// terms of its model, scalar terms first.
+struct PendingInstTermRef {
+    PendingInstanceRef instance;
+    uint32_t port {0};
+};
+
+using AnyBitNetRef = std::variant<BitNetOccurrence, PendingScalarNetRef>;
+using AnyBitInstTermRef = std::variant<BitInstTermOccurrence, PendingInstTermRef>;
+
+// Records occurrence-specific changes to the netlist and applies them
+// on commit(), uniquifying the designs they touch.
+//
+// Changes may be recorded from many threads at once: each thread gets
+// its own change log on first use, so recording takes no lock. Nothing
+// is checked or applied until commit(), which runs alone, typically at
+// the barrier between two levels. It sorts the logs by context, and
+// rebuilds each touched design once with all of its changes. A design
+// with a single occurrence is rebuilt in place; a shared one is copied
+// for the context, and so are its shared ancestors along the path. The
+// cost of a commit is that of the designs rebuilt, not of the netlist.
+//
+// Connections are made within one context; a net and a term of
+// different designs are rejected. The Uniquifier counts the instances
+// of every design reachable from the top, so the hierarchy must only
+// change through it while it is in use.
+class Uniquifier {
+public:
+    explicit Uniquifier(Netlist* netlist);
+    ~Uniquifier();
+
+    Uniquifier(const Uniquifier&) = delete;
+    Uniquifier& operator=(const Uniquifier&) = delete;
+
+    // Copies of designs are named <design>_<prefix><counter>.
+    void setPrefix(const std::string& prefix) { _prefix = prefix; }
+
+    // Runs compactor->compactIfNeeded() after every commit, which keeps
+    // a long series of commits from scattering the netlist over dead
+    // spaces. nullptr, the default, never compacts.
+    void setCompactor(Compactor* compactor) { _compactor = compactor; }
+
+    PendingScalarNetRef addScalarNet(const Path& context, NameID name);
+    PendingInstanceRef addInstance(const Path& context, NameID name, Design* model);
+    void removeInstance(const InstanceOccurrence& occ);
+
+    void connect(const AnyBitNetRef& net, const AnyBitInstTermRef& term);
+    void connect(const AnyBitNetRef& net, const BitDesignTermOccurrence& term);
+    void disconnect(const BitInstTermOccurrence& term);
+    void disconnect(const BitDesignTermOccurrence& term);
+
+    // Applies every recorded change in one new space. Not to be called
+    // while changes are being recorded.
+    void commit();
+
+    // Discards the recorded changes.
+    void clear();
+
+    size_t getNumPendingChanges() const;
+
+private:
+    enum class ChangeKind : uint8_t {
+        AddScalarNet,
+        AddInstance,
+        RemoveInstance,
+        ConnectInstTerm,
+        ConnectDesignTerm,
+        DisconnectInstTerm,
+        DisconnectDesignTerm,
+    };
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Path of a change that takes its context from its pending net.
+    static constexpr uint32_t PENDING_PATH = UINT32_MAX;
+
+    struct Change {
+        ChangeKind kind {ChangeKind::AddScalarNet};
+        // Range of the context path in the paths of the log.
+        uint32_t pathBegin {0};
+        uint32_t pathSize {0};
+        NameID name;
+        Design* model {nullptr};
+        Instance* instance {nullptr};
+        BitNet* net {nullptr};
+        BitInstTerm* instTerm {nullptr};
+        BitDesignTerm* designTerm {nullptr};
+        // NONE when the change refers to existing objects.
+        uint32_t pendingNetLog {NONE};
+        uint32_t pendingNet {NONE};
+        uint32_t pendingInstanceLog {NONE};
+        uint32_t pendingInstance {NONE};
+        uint32_t port {0};
+    };
+
+    struct ChangeLog {
+        uint32_t index {0};
+        std::vector<Change> changes;
+        std::vector<Instance*> paths;
+    };
+
+    struct Commit;
+
+    Netlist* _netlist {nullptr};
+    std::string _prefix {"uniq_"};
+    Compactor* _compactor {nullptr};
+    uint32_t _counter {0};
+    // Tells the thread-local log caches of successive Uniquifiers apart.
+    uint64_t _serial {0};
+
+    std::mutex _logsMutex;
+    std::vector<std::unique_ptr<ChangeLog>> _logs;
+    std::unordered_map<std::thread::id, ChangeLog*> _threadLogs;
+
+    // Instances of each non-primitive design in the designs reachable
+    // from the top.
+    std::unordered_map<const Design*, uint32_t> _refCounts;
+
+    ChangeLog* getLog();
+    Change* addChange(ChangeLog* log, ChangeKind kind, const Path& context);
+    Change* addConnection(ChangeKind kind, const AnyBitNetRef& net, const Path* context);
+    void countReferences();
+
+    friend struct Commit;
+};
+
+}
@@ -0,0 +1,524 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Compactor.h"
+#include "Design.h"
+#include "EquipotentialExplorator.h"
+#include "FlatNetlist.h"
+#include "LevelScheduler.h"
+#include "Levelize.h"
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
+#include "NetlistBuilder.h"
+#include "NetlistDumper.h"
+#include "NetlistImage.h"
+#include "NetlistLoader.h"
+#include "OccurrenceIndex.h"
+#include "PackedPath.h"
+#include "PrimitiveLibrary.h"
+#include "Uniquifier.h"
+
+#include "FatalException.h"
+#include "ThreadPool.h"
+
+using namespace stargate;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& name) {
+    if (condition) {
+        std::cout << "  OK  " << name << std::endl;
+    } else {
+        std::cout << "  FAIL " << name << std::endl;
+        failures++;
+    }
+}
+
+size_t countInstances(const Design* design) {
+    size_t count = 0;
+    design->instances.forEach([&](const Instance&) {
+        count++;
+    });
+    return count;
+}
+
+// top instantiates mid, which instantiates leaf: one design per level.
+// The net n of each design is on both ports a and b of the instance
+// below it, and of its own design in mid and leaf.
+void buildChain(Netlist* netlist) {
+    NameTable* names = netlist->getNameTable();
+    NetlistBuilder builder(netlist);
+    Library* library = builder.createLibrary(names->getName("work"));
+    const auto addPorts = [&](Design* design, ScalarNet* net) {
+        for (const char* port : {"a", "b"}) {
+            builder.connect(net, builder.addScalarDesignTerm(design, names->getName(port),
+                                                             Direction::Input));
+        }
+    };
+
+    Design* leaf = builder.createDesign(library, names->getName("leaf"));
+    addPorts(leaf, builder.addScalarNet(leaf, names->getName("n")));
+
+    Design* mid = builder.createDesign(library, names->getName("mid"));
+    ScalarNet* midNet = builder.addScalarNet(mid, names->getName("n"));
+    addPorts(mid, midNet);
+    Instance* l0 = builder.addInstance(mid, names->getName("l0"), leaf);
+    builder.connect(midNet, &l0->scalarInstTerms[0]);
+    builder.connect(midNet, &l0->scalarInstTerms[1]);
+
+    Design* top = builder.createDesign(library, names->getName("top"));
+    ScalarNet* topNet = builder.addScalarNet(top, names->getName("n"));
+    Instance* m0 = builder.addInstance(top, names->getName("m0"), mid);
+    builder.connect(topNet, &m0->scalarInstTerms[0]);
+    builder.connect(topNet, &m0->scalarInstTerms[1]);
+
+    builder.setTopDesign(top);
+    builder.finalize();
+}
+
+// From the net of top, the walk goes down through both ports of m0
+// and l0 and comes back up through the other one: each occurrence of
+// n is reached twice and must be reported once. Bounded by mid, the
+// walk from the net of l0 stops at the ports of mid.
+void checkExploration() {
+    Netlist netlist;
+    buildChain(&netlist);
+    Design* top = netlist.getTopDesign();
+    Instance* m0 = &top->instances[0];
+    Instance* l0 = &m0->model->instances[0];
+
+    EquipotentialExplorator explorator(&netlist);
+    const BitNetOccurrence topNet {Path(), &top->scalarNets[0]};
+    std::vector<size_t> depths;
+    for (const EquipotentialNet& net : explorator.exploreNets(topNet)) {
+        depths.push_back(net.net.path.size());
+    }
+    std::sort(depths.begin(), depths.end());
+    check(depths == std::vector<size_t>({0, 1, 2}),
+          "exploration: every net occurrence reported once");
+    check(explorator.explore(topNet).empty(),
+          "exploration: no endpoint without primitives or top ports");
+
+    EquipotentialExplorator bounded(&netlist, m0->model);
+    const BitNetOccurrence leafNet {Path {l0}, &l0->model->scalarNets[0]};
+    bool atPorts = true;
+    size_t numPorts = 0;
+    for (const EquipotentialEndpoint& endpoint : bounded.explore(leafNet)) {
+        atPorts &= endpoint.isBoundaryDesignTerm()
+            && endpoint.asBoundaryDesignTerm().path.empty();
+        numPorts++;
+    }
+    check(atPorts && numPorts == 2,
+          "exploration: bounded walk stops at the ports of mid");
+}
+
+// Threads intern the same names in different orders, enough of them
+// for every shard to grow its table while others probe it.
+void checkConcurrentInterning() {
+    constexpr size_t NAME_COUNT = 20000;
+    constexpr size_t THREAD_COUNT = 8;
+
+    NameTable names;
+    std::vector<std::vector<NameID>> ids(THREAD_COUNT);
+    ThreadPool pool(4);
+    pool.parallelFor(THREAD_COUNT, [&](size_t t) {
+        ids[t].resize(NAME_COUNT);
+        for (size_t i = 0; i < NAME_COUNT; i++) {
+            const size_t k = (i * 7919 + t * 1237) % NAME_COUNT;
+            ids[t][k] = names.getName("n" + std::to_string(k));
+        }
+    });
+
+    bool stable = true;
+    bool roundTrips = true;
+    std::set<uint32_t> distinct;
+    for (size_t k = 0; k < NAME_COUNT; k++) {
+        const std::string str = "n" + std::to_string(k);
+        for (size_t t = 1; t < THREAD_COUNT; t++) {
+            stable &= ids[t][k] == ids[0][k];
+        }
+        stable &= names.getName(str) == ids[0][k] && names.findName(str) == ids[0][k];
+        roundTrips &= names.getString(ids[0][k]) == str;
+        distinct.insert(ids[0][k].value);
+    }
+
+    check(stable, "names: every thread got the same ID for a name");
+    check(distinct.size() == NAME_COUNT && names.size() == NAME_COUNT,
+          "names: one distinct ID per name");
+    check(roundTrips, "names: getString returns the interned string");
+}
+
+// top drives x through cell c0, an SGC_ASSIGN and cell c1 to z, each
+// cell being an INV between its ports.
+void buildCells(Netlist* netlist) {
+    NameTable* names = netlist->getNameTable();
+    NetlistBuilder builder(netlist);
+    PrimitiveLibrary* primitives = builder.createPrimitiveLibrary();
+    Library* library = builder.createLibrary(names->getName("work"));
+
+    Design* cell = builder.createDesign(library, names->getName("cell"));
+    ScalarDesignTerm* a = builder.addScalarDesignTerm(cell, names->getName("a"),
+                                                      Direction::Input);
+    ScalarDesignTerm* y = builder.addScalarDesignTerm(cell, names->getName("y"),
+                                                      Direction::Output);
+    ScalarNet* na = builder.addScalarNet(cell, names->getName("na"));
+    ScalarNet* ny = builder.addScalarNet(cell, names->getName("ny"));
+    builder.connect(na, a);
+    builder.connect(ny, y);
+    Instance* inv = builder.addInstance(cell, names->getName("u"), primitives->getINV());
+    builder.connect(na, inv->getPrimitiveScalarTerm(INVPins::I));
+    builder.connect(ny, inv->getPrimitiveScalarTerm(INVPins::O));
+
+    Design* top = builder.createDesign(library, names->getName("top"));
+    ScalarDesignTerm* x = builder.addScalarDesignTerm(top, names->getName("x"),
+                                                      Direction::Input);
+    ScalarDesignTerm* z = builder.addScalarDesignTerm(top, names->getName("z"),
+                                                      Direction::Output);
+    ScalarNet* nx = builder.addScalarNet(top, names->getName("nx"));
+    ScalarNet* n1 = builder.addScalarNet(top, names->getName("n1"));
+    ScalarNet* n2 = builder.addScalarNet(top, names->getName("n2"));
+    ScalarNet* nz = builder.addScalarNet(top, names->getName("nz"));
+    builder.connect(nx, x);
+    builder.connect(nz, z);
+
+    Instance* c0 = builder.addInstance(top, names->getName("c0"), cell);
+    builder.connect(nx, &c0->scalarInstTerms[0]);
+    builder.connect(n1, &c0->scalarInstTerms[1]);
+    Instance* assign = builder.addInstance(top, names->getName("as"),
+                                           primitives->getAssign());
+    builder.connect(n1, assign->getPrimitiveScalarTerm(SGC_ASSIGNPins::I));
+    builder.connect(n2, assign->getPrimitiveScalarTerm(SGC_ASSIGNPins::O));
+    Instance* c1 = builder.addInstance(top, names->getName("c1"), cell);
+    builder.connect(n2, &c1->scalarInstTerms[0]);
+    builder.connect(nz, &c1->scalarInstTerms[1]);
+
+    builder.setTopDesign(top);
+    builder.finalize();
+}
+
+// Nets are merged across the ports of the cells and the assignment,
+// and each net row lists its drivers before its receivers.
+void checkFlatNetlist() {
+    Netlist netlist;
+    buildCells(&netlist);
+    NameTable* names = netlist.getNameTable();
+
+    FlatNetlist flat;
+    FlatNetlist::create(&netlist, &flat, 2);
+    check(flat.getScopes().size() == 3, "flat: one scope per instantiation");
+    check(flat.getInstances().size() == 2, "flat: the assignment is dissolved");
+    check(flat.getTerms().size() == 6, "flat: instance terms and top ports");
+
+    bool rowsMatch = true;
+    for (uint32_t i = 0; i < flat.getInstances().size(); i++) {
+        const std::span<const FlatNetlist::FlatTerm> terms = flat.getInstanceTerms(i);
+        rowsMatch &= terms.size() == 2;
+        for (const FlatNetlist::FlatTerm& term : terms) {
+            rowsMatch &= term.instance == i;
+        }
+    }
+    check(rowsMatch, "flat: instance rows hold the terms of their instance");
+
+    std::vector<std::string> netNames;
+    for (const FlatNetlist::FlatNet& net : flat.getNets()) {
+        netNames.emplace_back(names->getString(net.name));
+    }
+    check(netNames == std::vector<std::string>({"nx", "n1", "nz"}),
+          "flat: nets merged across hierarchy, named from the top");
+
+    // x is driven by the input port, n1 by the INV of c0 and z by the
+    // INV of c1, whose output port receives it.
+    const std::span<const FlatNetlist::FlatTerm> terms = flat.getTerms();
+    const FlatNetlist::FlatTerm& x = terms[flat.getNetDrivers(0)[0]];
+    const FlatNetlist::FlatTerm& n1 = terms[flat.getNetDrivers(1)[0]];
+    const FlatNetlist::FlatTerm& n1Load = terms[flat.getNetReceivers(1)[0]];
+    const FlatNetlist::FlatTerm& z = terms[flat.getNetReceivers(2)[0]];
+    bool ordered = true;
+    for (uint32_t net = 0; net < 3; net++) {
+        ordered &= flat.getNetTerms(net).size() == 2
+            && flat.getNetDrivers(net).size() == 1
+            && flat.getNetReceivers(net).size() == 1;
+    }
+    ordered &= x.instance == FlatNetlist::NONE && x.designTerm;
+    ordered &= n1.direction == Direction::Output && n1.scope == 1;
+    ordered &= n1Load.direction == Direction::Input && n1Load.scope == 2;
+    ordered &= z.instance == FlatNetlist::NONE && z.direction == Direction::Output;
+    check(ordered, "flat: drivers come before receivers");
+}
+
+// One line per library, design, term, net and instance, by name.
+void describeNetlist(const Netlist& netlist, std::vector<std::string>& result) {
+    const NameTable* names = netlist.getNameTable();
+    const auto name = [&](NameID id) {
+        return std::string(names->getString(id));
+    };
+    result.clear();
+    result.push_back("top " + name(netlist.getTopDesign()->name));
+    for (const Library* library : netlist.getLibraries()) {
+        result.push_back("library " + name(library->getName()));
+        for (const Design* design : library->getDesigns()) {
+            result.push_back("design " + name(design->name));
+            design->scalarDesignTerms.forEach([&](const ScalarDesignTerm& term) {
+                result.push_back("term " + name(term.name));
+            });
+            design->scalarNets.forEach([&](const ScalarNet& net) {
+                result.push_back("net " + name(net.name));
+            });
+            design->instances.forEach([&](const Instance& instance) {
+                result.push_back("instance " + name(instance.name)
+                                 + " " + name(instance.model->name));
+            });
+        }
+    }
+}
+
+bool loadFails(const std::string& path) {
+    try {
+        Netlist netlist;
+        NetlistLoader(&netlist, 1).load(path);
+    } catch (const FatalException&) {
+        return true;
+    }
+    return false;
+}
+
+// A dumped netlist loads back with the same objects and names; an
+// image cut short or with a flipped metadata byte is rejected.
+void checkDumpLoad() {
+    const std::string path = (std::filesystem::temp_directory_path()
+        / ("sgcnetlisttest." + std::to_string(getpid()) + ".sgn")).string();
+
+    Netlist netlist;
+    buildCells(&netlist);
+    NetlistDumper(&netlist).dump(path);
+
+    Netlist loaded;
+    NetlistLoader(&loaded, 2).load(path);
+    std::vector<std::string> expected;
+    std::vector<std::string> actual;
+    describeNetlist(netlist, expected);
+    describeNetlist(loaded, actual);
+    check(actual == expected, "image: loaded netlist matches the dumped one");
+
+    FlatNetlist flat;
+    FlatNetlist::create(&loaded, &flat, 1);
+    check(flat.getNets().size() == 3, "image: connectivity survives the round trip");
+
+    std::string image;
+    {
+        std::ifstream in(path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    }
+    const auto write = [&](const std::string& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    };
+
+    write(image.substr(0, image.size() - 1));
+    check(loadFails(path), "image: truncated image rejected");
+
+    std::string corrupt = image;
+    corrupt[sizeof(NetlistImageHeader)] ^= 1;
+    write(corrupt);
+    check(loadFails(path), "image: bad checksum rejected");
+
+    std::filesystem::remove(path);
+}
+
+// The level callback commits changes that rebuild the designs of later
+// levels: the scheduler must hand the transform the rebuilt designs.
+void checkCommitInLevelCallback(bool compact) {
+    const std::string prefix = compact ? "commit with compactor: " : "commit: ";
+
+    Netlist netlist;
+    buildChain(&netlist);
+    NameTable* names = netlist.getNameTable();
+    Design* leaf = netlist.findDesign(names->getName("leaf"));
+
+    ThreadPool pool(2);
+    Compactor compactor(&netlist, &pool);
+    compactor.setMinLiveRatio(1.0);
+
+    Uniquifier uniquifier(&netlist);
+    if (compact) {
+        uniquifier.setCompactor(&compactor);
+    }
+
+    LevelScheduler scheduler(&netlist, &pool);
+    scheduler.setLevelCallback([&](const Level&) {
+        uniquifier.commit();
+    });
+
+    std::vector<std::string> visited;
+    bool topIsLive = false;
+    size_t topInstances = 0;
+    scheduler.runBottomUp([&](Design* design) {
+        const std::string name(names->getString(design->name));
+        visited.push_back(name);
+        if (name == "leaf") {
+            uniquifier.addInstance(Path(), names->getName("l1"), leaf);
+        } else if (name == "top") {
+            topIsLive = design == netlist.getTopDesign();
+            topInstances = countInstances(design);
+            uniquifier.addScalarNet(Path(), names->getName("t"));
+        }
+    });
+
+    check(visited == std::vector<std::string>({"leaf", "mid", "top"}),
+          prefix + "every design visited once");
+    check(topIsLive, prefix + "top level runs on the rebuilt top");
+    check(topInstances == 2, prefix + "top level sees the committed instance");
+
+    bool hasNet = false;
+    netlist.getTopDesign()->scalarNets.forEach([&](const ScalarNet& net) {
+        hasNet |= net.name == names->getName("t");
+    });
+    check(hasNet, prefix + "change recorded at the top level is committed");
+}
+
+// Compacting a netlist without garbage moves every design and reclaims
+// nothing; after a commit, the bytes of the replaced designs are.
+void checkCompactionReclaim() {
+    Netlist netlist;
+    buildChain(&netlist);
+    NameTable* names = netlist.getNameTable();
+
+    ThreadPool pool(1);
+    Compactor compactor(&netlist, &pool);
+    const CompactionStats clean = compactor.compactFull();
+    check(clean.bytesMoved != 0, "compaction: moves the live designs");
+    check(clean.bytesReclaimed == 0, "compaction: nothing reclaimed without garbage");
+
+    Uniquifier uniquifier(&netlist);
+    uniquifier.addScalarNet(Path(), names->getName("t"));
+    uniquifier.commit();
+
+    // The compactor walks only the rebuilt top; a new one walks all.
+    const FragmentationReport kept = compactor.analyze();
+    const FragmentationReport fresh = Compactor(&netlist, &pool).analyze();
+    check(kept.numDesigns == fresh.numDesigns && kept.liveBytes == fresh.liveBytes
+          && kept.numSpans == fresh.numSpans && kept.numChunks == fresh.numChunks
+          && kept.numDesignSpaces == fresh.numDesignSpaces
+          && kept.allocatedBytes == fresh.allocatedBytes,
+          "compaction: kept layouts match a full analysis");
+
+    const CompactionStats dirty = compactor.compactFull();
+    check(dirty.bytesReclaimed != 0, "compaction: replaced designs reclaimed");
+    check(dirty.after.allocatedBytes == dirty.bytesMoved,
+          "compaction: only the new space is left");
+}
+
+// top instantiates mid twice. Once m1 is removed, mid and leaf have a
+// single occurrence each and a change below m0 rebuilds both in place.
+void checkReleasedReferences() {
+    Netlist netlist;
+    NameTable* names = netlist.getNameTable();
+    {
+        NetlistBuilder builder(&netlist);
+        Library* library = builder.createLibrary(names->getName("work"));
+        Design* leaf = builder.createDesign(library, names->getName("leaf"));
+        Design* mid = builder.createDesign(library, names->getName("mid"));
+        builder.addInstance(mid, names->getName("l0"), leaf);
+        Design* top = builder.createDesign(library, names->getName("top"));
+        builder.addInstance(top, names->getName("m0"), mid);
+        builder.addInstance(top, names->getName("m1"), mid);
+        builder.setTopDesign(top);
+        builder.finalize();
+    }
+
+    Uniquifier uniquifier(&netlist);
+    Design* top = netlist.getTopDesign();
+    uniquifier.removeInstance({Path(), &top->instances[1]});
+    uniquifier.commit();
+
+    top = netlist.getTopDesign();
+    check(countInstances(top) == 1, "release: removed instance is gone");
+
+    Path path;
+    path.push_back(&top->instances[0]);
+    path.push_back(&path[0]->model->instances[0]);
+    uniquifier.addScalarNet(path, names->getName("x"));
+    uniquifier.commit();
+
+    const Instance& m0 = netlist.getTopDesign()->instances[0];
+    const Instance& l0 = m0.model->instances[0];
+    check(m0.model->name == names->getName("mid")
+          && l0.model->name == names->getName("leaf"),
+          "release: designs left with one occurrence are rebuilt in place");
+
+    bool hasNet = false;
+    l0.model->scalarNets.forEach([&](const ScalarNet& net) {
+        hasNet |= net.name == names->getName("x");
+    });
+    check(hasNet, "release: change below the remaining occurrence is committed");
+}
+
+// A path encodes to positions, decodes back to the same instances and
+// is named and resolved by the occurrence index.
+void checkPackedPath() {
+    Netlist netlist;
+    buildChain(&netlist);
+    const Design* top = netlist.getTopDesign();
+
+    Path path;
+    path.push_back(&top->instances[0]);
+    path.push_back(&path[0]->model->instances[0]);
+
+    PackedPath packed;
+    PackedPath::encode(top, path, &packed);
+    check(packed.size() == 2, "packed path: one position per level");
+
+    Path decoded;
+    packed.decode(top, &decoded);
+    check(decoded == path, "packed path: decodes to the encoded path");
+
+    const PackedPath copy = packed;
+    check(copy == packed && copy.getHash() == packed.getHash(),
+          "packed path: copies are equal");
+
+    OccurrenceIndex index(&netlist, '.', 1);
+    std::string name;
+    index.getName(packed, name);
+    check(name == "m0.l0", "packed path: named by the occurrence index");
+
+    PackedPath found;
+    check(index.findInstance(name, &found) && found == packed,
+          "packed path: name resolves to the same path");
+
+    bool rejected = false;
+    packed.pop();
+    packed.pop();
+    try {
+        packed.pop();
+    } catch (const FatalException&) {
+        rejected = true;
+    }
+    check(rejected && packed.empty(), "packed path: popping an empty path throws");
+}
+
+}
+
+int main() {
+    checkExploration();
+    checkConcurrentInterning();
+    checkFlatNetlist();
+    checkDumpLoad();
+    checkCommitInLevelCallback(false);
+    checkCommitInLevelCallback(true);
+    checkCompactionReclaim();
+    checkReleasedReferences();
+    checkPackedPath();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,11 @@
+#!/bin/bash
+# Runs the netlist checks built into sgcnetlisttest. Each prints one
+# OK or FAIL line; the program fails if any check does.
+set -u
+
+if ! sgcnetlisttest; then
+    echo "netlist: some checks failed"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,3 @@
+module elab_self(input a, output y);
+    elab_self u0 (.a(a), .y(y));
+endmodule
@@ -0,0 +1,17 @@
+// A generate loop of N cells and a generate if that adds one more.
+module elab_cell(input a, output y);
+endmodule
+
+module elab_generate #(parameter N = 3, parameter USE_LAST = 1)
+                      (input [N-1:0] a, output [N-1:0] y);
+    genvar i;
+    generate
+        for (i = 0; i < N; i = i + 1) begin : gen_bit
+            elab_cell c (.a(a[i]), .y(y[i]));
+        end
+        if (USE_LAST) begin : gen_last
+            elab_cell c (.a(a[0]), .y());
+        end else begin : gen_none
+        end
+    endgenerate
+endmodule
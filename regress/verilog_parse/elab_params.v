@@ -0,0 +1,11 @@
+// Two specializations of one module: u1 and u2 keep the default W
+// and share a design, u0 gets its own.
+module elab_leaf #(parameter W = 4) (input [W-1:0] a, output [W-1:0] y);
+    assign y = a;
+endmodule
+
+module elab_params(input [7:0] a, output [7:0] y, output [3:0] z);
+    elab_leaf #(.W(8)) u0 (.a(a), .y(y));
+    elab_leaf u1 (.a(a[3:0]), .y(z));
+    elab_leaf #(4) u2 (.a(a[7:4]), .y());
+endmodule
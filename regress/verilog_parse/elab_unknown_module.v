@@ -0,0 +1,3 @@
+module elab_missing(input a, output y);
+    elab_no_such_module u0 (.a(a), .y(y));
+endmodule
@@ -0,0 +1,17 @@
+// Parameter values the elaborator cannot evaluate, strings and x/z
+// literals, must still select one design per distinct value.
+module elab_name #(parameter NAME = "a") (input i, output o);
+    assign o = i;
+endmodule
+
+module elab_mask #(parameter MASK = 4'b0000) (input i, output o);
+    assign o = i;
+endmodule
+
+module elab_unknown_params(input i, output [4:0] o);
+    elab_name #(.NAME("a")) n0 (.i(i), .o(o[0]));
+    elab_name #(.NAME("b")) n1 (.i(i), .o(o[1]));
+    elab_name #(.NAME("c")) n2 (.i(i), .o(o[2]));
+    elab_mask #(.MASK(4'bxx01)) m0 (.i(i), .o(o[3]));
+    elab_mask #(.MASK(4'bzz01)) m1 (.i(i), .o(o[4]));
+endmodule
@@ -0,0 +1,6 @@
+module elab_port_leaf(input a, output y);
+endmodule
+
+module elab_port_top(input a, output y);
+    elab_port_leaf u0 (.a(a), .z(y));
+endmodule
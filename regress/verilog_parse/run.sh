@@ -39,6 +39,129 @@ for f in "${FAIL_FILES[@]}"; do
     fi
 done
 
+# The same corpus in one parallel invocation: every pass file must
+# still pass, and a single bad file must fail the whole run.
+if sgcparse -j 4 "${PASS_FILES[@]}" 2> /dev/null; then
+    echo "  OK  -j 4 pass corpus"
+else
+    echo "  FAIL expected pass: -j 4 pass corpus"
+    failures=$((failures + 1))
+fi
+
+if sgcparse -j 4 "${PASS_FILES[@]}" "${FAIL_FILES[@]}" 2> /dev/null; then
+    echo "  FAIL expected fail: -j 4 mixed corpus"
+    failures=$((failures + 1))
+else
+    echo "  OK  -j 4 mixed corpus (failed as expected)"
+fi
+
+# The syntax tree must carry the module, its ports and its gates.
+ast=$(sgcparse --dump-ast "$SCRIPT_DIR/gates.v" 2> /dev/null)
+if echo "$ast" | grep -q "^  Module gates" \
+    && echo "$ast" | grep -q "Declarator y_xor" \
+    && echo "$ast" | grep -q "Instantiation xor gate"; then
+    echo "  OK  --dump-ast gates.v"
+else
+    echo "  FAIL --dump-ast gates.v"
+    failures=$((failures + 1))
+fi
+
+# A warm parse cache must reproduce the cold outcome of every file.
+cache_dir=$(mktemp -d)
+for pass in cold warm; do
+    if sgcparse --cache-dir "$cache_dir" "${PASS_FILES[@]}" 2> /dev/null \
+        && ! sgcparse --cache-dir "$cache_dir" "${FAIL_FILES[@]}" 2> /dev/null; then
+        echo "  OK  --cache-dir ($pass)"
+    else
+        echo "  FAIL --cache-dir ($pass)"
+        failures=$((failures + 1))
+    fi
+done
+rm -rf "$cache_dir"
+
+# A header created earlier on the include path than the one a cached
+# file included must shadow it: the cached outcome is stale.
+shadow_dir=$(mktemp -d)
+mkdir -p "$shadow_dir/inc1" "$shadow_dir/inc2"
+printf '`include "defs.vh"\nmodule top(output [`W-1:0] y);\nendmodule\n' > "$shadow_dir/top.v"
+echo '`define W 2' > "$shadow_dir/inc2/defs.vh"
+sgcparse -E --cache-dir "$shadow_dir/cache" -I "$shadow_dir/inc1" -I "$shadow_dir/inc2" \
+    "$shadow_dir/top.v" > /dev/null 2>&1
+echo '`define W 5' > "$shadow_dir/inc1/defs.vh"
+if sgcparse -E --cache-dir "$shadow_dir/cache" -I "$shadow_dir/inc1" -I "$shadow_dir/inc2" \
+    "$shadow_dir/top.v" 2> /dev/null | grep -q "5-1:0"; then
+    echo "  OK  --cache-dir shadowed include"
+else
+    echo "  FAIL --cache-dir shadowed include"
+    failures=$((failures + 1))
+fi
+rm -rf "$shadow_dir"
+
+# Elaboration: design counts from the stats line, and design names.
+elab() {
+    sgcparse --elaborate --dump-designs --top "$@" 2>&1
+}
+
+expect_designs() {
+    local label=$1 output=$2 count=$3
+    shift 3
+    local ok=1
+    echo "$output" | grep -qF "into $count design(s)" || ok=0
+    for design in "$@"; do
+        echo "$output" | grep -qxF "design $design" || ok=0
+    done
+    if [ $ok -eq 1 ]; then
+        echo "  OK  --elaborate $label"
+    else
+        echo "  FAIL --elaborate $label"
+        failures=$((failures + 1))
+    fi
+}
+
+expect_error() {
+    local label=$1 output=$2 message=$3
+    if echo "$output" | grep -qF "$message" \
+        && echo "$output" | grep -qF "elaboration failed"; then
+        echo "  OK  --elaborate $label (failed as expected)"
+    else
+        echo "  FAIL --elaborate $label"
+        failures=$((failures + 1))
+    fi
+}
+
+out=$(elab elab_params "$SCRIPT_DIR/elab_params.v")
+expect_designs "parameter specializations" "$out" 3 \
+    elab_params elab_leaf "elab_leaf#(W=8)"
+
+out=$(elab elab_generate "$SCRIPT_DIR/elab_generate.v")
+expect_designs "generate for/if" "$out" 2 elab_generate elab_cell
+if ! echo "$out" | grep -qF "4 instance(s)"; then
+    echo "  FAIL --elaborate generate for/if instance count"
+    failures=$((failures + 1))
+fi
+
+# Unknown values are told apart by key: three names, two masks.
+out=$(elab elab_unknown_params "$SCRIPT_DIR/elab_unknown_params.v")
+expect_designs "unknown parameter values" "$out" 6 \
+    elab_unknown_params elab_name
+if [ "$(echo "$out" | grep -c '^design elab_name#(NAME=?')" != 2 ] \
+    || [ "$(echo "$out" | grep -c '^design elab_mask#(MASK=?')" != 2 ]; then
+    echo "  FAIL --elaborate unknown parameter value names"
+    failures=$((failures + 1))
+fi
+
+out=$(elab elab_missing "$SCRIPT_DIR/elab_unknown_module.v")
+expect_error "unknown module" "$out" "unknown module 'elab_no_such_module'"
+
+out=$(elab elab_port_top "$SCRIPT_DIR/elab_unknown_port.v")
+expect_error "unknown port" "$out" "module 'elab_port_leaf' has no port 'z'"
+
+out=$(elab elab_self "$SCRIPT_DIR/elab_cycle.v")
+expect_error "self instantiation" "$out" "module 'elab_self' instantiates itself"
+
+out=$(elab elab_nowhere "$SCRIPT_DIR/elab_cycle.v")
+expect_error "unknown top" "$out" "unknown top module 'elab_nowhere'"
+
 if [ $failures -gt 0 ]; then
     echo "verilog_parse: $failures failure(s)"
     exit 1
@@ -9,13 +9,20 @@
 # This regress checks that for each vivado task (synth/impl/bitstream)
 # stargate emits a TCL file, a command.sh that invokes vivado with the
 # expected args, a distrib.toml that pins the awsec2 flow, and a
-# status.json reporting success.
+# status.json reporting success, and that a second build with unchanged
+# inputs, or into a new output directory sharing the artifact cache,
+# invokes vivado no more. Editing an implementation-only constraint file
+# must rerun impl and bitstream but not synth, while editing any other
+# constraint file reruns synth too. Finally, -target all must build the
+# default and the small target in one invocation.
 set -u
 
 SCRIPT_DIR=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
 WORK_DIR="$SCRIPT_DIR/.run"
 STUB_DIR="$WORK_DIR/bin"
 OUT_DIR="$WORK_DIR/sg.out"
+CACHE_DIR="$WORK_DIR/cache"
+TARGET_DIR="$OUT_DIR/targets/default"
 VIVADO_CALLS="$WORK_DIR/vivado_calls.log"
 
 rm -rf "$WORK_DIR"
@@ -23,6 +30,8 @@ mkdir -p "$WORK_DIR" "$STUB_DIR"
 
 cp "$SCRIPT_DIR/stargate.toml" "$WORK_DIR/stargate.toml"
 cp "$SCRIPT_DIR/top.v" "$WORK_DIR/top.v"
+cp "$SCRIPT_DIR/clocks.xdc" "$WORK_DIR/clocks.xdc"
+cp "$SCRIPT_DIR/pins.impl.xdc" "$WORK_DIR/pins.impl.xdc"
 
 cat > "$STUB_DIR/vivado" <<EOF
 #!/bin/bash
@@ -34,7 +43,8 @@ chmod +x "$STUB_DIR/vivado"
 cd "$WORK_DIR"
 
 LOG="$WORK_DIR/build.log"
-PATH="$STUB_DIR:$PATH" stargate -c stargate.toml -o "$OUT_DIR" build > "$LOG" 2>&1
+PATH="$STUB_DIR:$PATH" stargate -c stargate.toml -o "$OUT_DIR" \
+    -cache_dir "$CACHE_DIR" build > "$LOG" 2>&1
 rc=$?
 
 if [ $rc -ne 0 ]; then
@@ -67,7 +77,7 @@ check_grep() {
 }
 
 for task in synth impl bitstream; do
-    task_dir="$OUT_DIR/vivado/$task"
+    task_dir="$TARGET_DIR/vivado/$task"
     check_file "$task_dir/$task.tcl"
     check_file "$task_dir/command.sh"
     check_file "$task_dir/distrib.sh"
@@ -84,12 +94,12 @@ for task in synth impl bitstream; do
     check_grep "\"exit_code\": 0" "$task_dir/status.json"
 done
 
-check_grep "set sg_top   top" "$OUT_DIR/vivado/synth/synth.tcl"
-check_grep "set sg_part  xc7a35tcpg236-1" "$OUT_DIR/vivado/synth/synth.tcl"
+check_grep "set sg_top   top" "$TARGET_DIR/vivado/synth/synth.tcl"
+check_grep "set sg_part  xc7a35tcpg236-1" "$TARGET_DIR/vivado/synth/synth.tcl"
 check_grep "synth_design -top \\\$sg_top -part \\\$sg_part" \
-    "$OUT_DIR/vivado/synth/synth.tcl"
-check_grep "open_checkpoint" "$OUT_DIR/vivado/impl/impl.tcl"
-check_grep "write_bitstream" "$OUT_DIR/vivado/bitstream/bitstream.tcl"
+    "$TARGET_DIR/vivado/synth/synth.tcl"
+check_grep "open_checkpoint" "$TARGET_DIR/vivado/impl/impl.tcl"
+check_grep "write_bitstream" "$TARGET_DIR/vivado/bitstream/bitstream.tcl"
 
 if [ ! -f "$VIVADO_CALLS" ]; then
     echo "ERROR: stub vivado was never invoked"
@@ -111,6 +121,104 @@ else
     done
 fi
 
+# A second build with unchanged inputs must not invoke vivado again.
+PATH="$STUB_DIR:$PATH" stargate -c stargate.toml -o "$OUT_DIR" build >> "$LOG" 2>&1
+rc=$?
+if [ $rc -ne 0 ]; then
+    echo "ERROR: second stargate build exited with status $rc"
+    fail=$((fail + 1))
+elif [ -f "$VIVADO_CALLS" ]; then
+    rerun_calls=$(wc -l < "$VIVADO_CALLS" | tr -d ' ')
+    if [ "$rerun_calls" -ne 3 ]; then
+        echo "ERROR: up to date build invoked vivado $((rerun_calls - 3)) more time(s)"
+        fail=$((fail + 1))
+    fi
+fi
+
+# A build in a fresh output directory must restore every task from the
+# artifact cache.
+PATH="$STUB_DIR:$PATH" stargate -c stargate.toml -o "$WORK_DIR/sg2.out" \
+    -cache_dir "$CACHE_DIR" build >> "$LOG" 2>&1
+rc=$?
+if [ $rc -ne 0 ]; then
+    echo "ERROR: cached stargate build exited with status $rc"
+    fail=$((fail + 1))
+else
+    for task in synth impl bitstream; do
+        check_grep "\"status\": \"success\"" \
+            "$WORK_DIR/sg2.out/targets/default/vivado/$task/status.json"
+    done
+    if [ -f "$VIVADO_CALLS" ]; then
+        cached_calls=$(wc -l < "$VIVADO_CALLS" | tr -d ' ')
+        if [ "$cached_calls" -ne 3 ]; then
+            echo "ERROR: cached build invoked vivado $((cached_calls - 3)) more time(s)"
+            fail=$((fail + 1))
+        fi
+    fi
+fi
+
+# Constraints are read before synthesis, except implementation-only ones.
+PROJECT_DIR="$OUT_DIR/project/default"
+check_grep "^read_xdc .*/clocks\.xdc$" "$PROJECT_DIR/files.tcl"
+check_grep "^read_xdc .*/pins\.impl\.xdc$" "$PROJECT_DIR/constraints.tcl"
+if grep -q "pins\.impl\.xdc" "$PROJECT_DIR/files.tcl" 2>/dev/null; then
+    echo "ERROR: implementation-only constraints are read before synthesis"
+    fail=$((fail + 1))
+fi
+
+# Builds again after an edit of $1 and checks that vivado ran exactly
+# the tasks listed in the remaining arguments.
+check_rerun() {
+    local file="$1"
+    shift
+    local before=0
+    [ -f "$VIVADO_CALLS" ] && before=$(wc -l < "$VIVADO_CALLS" | tr -d ' ')
+
+    echo "# edited" >> "$WORK_DIR/$file"
+    PATH="$STUB_DIR:$PATH" stargate -c stargate.toml -o "$OUT_DIR" build >> "$LOG" 2>&1
+    local rc=$?
+    if [ $rc -ne 0 ]; then
+        echo "ERROR: stargate build after editing $file exited with status $rc"
+        fail=$((fail + 1))
+        return
+    fi
+
+    local calls
+    calls=$(tail -n +$((before + 1)) "$VIVADO_CALLS" | sed -nE 's|.*-source [^ ]*/([a-z]+)\.tcl.*|\1|p' | xargs)
+    if [ "$calls" != "$*" ]; then
+        echo "ERROR: editing $file ran '$calls', expected '$*'"
+        fail=$((fail + 1))
+    fi
+}
+
+check_rerun pins.impl.xdc impl bitstream
+check_rerun clocks.xdc synth impl bitstream
+
+# Every target of the project is built, each in its own subtree.
+calls_before=0
+[ -f "$VIVADO_CALLS" ] && calls_before=$(wc -l < "$VIVADO_CALLS" | tr -d ' ')
+PATH="$STUB_DIR:$PATH" stargate -c stargate.toml -o "$WORK_DIR/sg_all.out" \
+    -target all build >> "$LOG" 2>&1
+rc=$?
+if [ $rc -ne 0 ]; then
+    echo "ERROR: stargate -target all build exited with status $rc"
+    fail=$((fail + 1))
+else
+    for target in default small; do
+        for task in synth impl bitstream; do
+            check_grep "\"status\": \"success\"" \
+                "$WORK_DIR/sg_all.out/targets/$target/vivado/$task/status.json"
+        done
+    done
+    check_grep "set sg_part  xc7a15tcpg236-1" \
+        "$WORK_DIR/sg_all.out/targets/small/vivado/synth/synth.tcl"
+    all_calls=$(wc -l < "$VIVADO_CALLS" | tr -d ' ')
+    if [ "$((all_calls - calls_before))" -ne 6 ]; then
+        echo "ERROR: -target all invoked vivado $((all_calls - calls_before)) time(s), expected 6"
+        fail=$((fail + 1))
+    fi
+fi
+
 if [ $fail -gt 0 ]; then
     echo "vivado_test: $fail check(s) failed"
     echo "--- build log ---"
@@ -16,18 +16,24 @@
 #include "Flow.h"
 #include "FlowSection.h"
 #include "FlowTask.h"
+#include "TaskScheduler.h"
+#include "ArtifactCache.h"
 
 #include "AWSEC2Config.h"
 #include "DistribConfig.h"
 #include "DistribFlow.h"
 #include "DistribFlowManager.h"
 
+#include "ContentHash.h"
 #include "FileUtils.h"
 #include "FileSetCollector.h"
 #include "Panic.h"
 
 using namespace stargate;
 
+static const std::string ALL_TARGETS = "all";
+static const std::string IMPL_CONSTRAINT_SUFFIX = ".impl.xdc";
+
 Stargate::Stargate(const StargateConfig& config)
     : _config(config)
 {
@@ -131,22 +137,10 @@ void Stargate::runFlow(const ProjectConfig* projectConfig,
                        const std::string& targetName) {
     prepareExecution(projectConfig);
 
-    const ProjectTarget* target = projectConfig->getTarget(targetName);
-    if (!target) {
-        panic("Target '{}' not found", targetName);
-    }
-
-    Flow* flow = getTargetFlow(target);
-
-    FlowSection* buildSection = flow->getBuildSection();
-    if (buildSection) {
-        executeSection(target, buildSection);
-    }
-
-    FlowSection* runSection = flow->getRunSection();
-    if (runSection) {
-        executeSection(target, runSection);
-    }
+    Targets targets;
+    getTargets(projectConfig, targetName, targets);
+    executeSections(targets, "build", false);
+    executeSections(targets, "run", false);
 }
 
 void Stargate::runSection(const ProjectConfig* projectConfig,
@@ -154,18 +148,9 @@ void Stargate::runSection(const ProjectConfig* projectConfig,
                           const std::string& sectionName) {
     prepareExecution(projectConfig);
 
-    const ProjectTarget* target = projectConfig->getTarget(targetName);
-    if (!target) {
-        panic("Target '{}' not found", targetName);
-    }
-
-    Flow* flow = getTargetFlow(target);
-    FlowSection* section = flow->getSection(sectionName);
-    if (!section) {
-        panic("Flow '{}' does not have a '{}' section", flow->getName(), sectionName);
-    }
-
-    executeSection(target, section);
+    Targets targets;
+    getTargets(projectConfig, targetName, targets);
+    executeSections(targets, sectionName, true);
 }
 
 void Stargate::executeTask(const ProjectConfig* projectConfig,
@@ -173,37 +158,33 @@ void Stargate::executeTask(const ProjectConfig* projectConfig,
                            const std::string& taskName) {
     prepareExecution(projectConfig);
 
-    const ProjectTarget* target = projectConfig->getTarget(targetName);
-    if (!target) {
-        panic("Target '{}' not found", targetName);
-    }
+    Targets targets;
+    getTargets(projectConfig, targetName, targets);
 
-    Flow* flow = getTargetFlow(target);
+    TaskScheduler scheduler(_config.getJobCount());
+    for (const ProjectTarget* target : targets) {
+        Flow* flow = getTargetFlow(target);
 
-    FlowTask* task = nullptr;
-    FlowSection* taskSection = nullptr;
+        FlowTask* task = nullptr;
+        FlowSection* taskSection = nullptr;
 
-    for (FlowSection* section : flow->sections()) {
-        task = section->getTask(taskName);
-        if (task) {
-            taskSection = section;
-            break;
+        for (FlowSection* section : flow->sections()) {
+            task = section->getTask(taskName);
+            if (task) {
+                taskSection = section;
+                break;
+            }
         }
-    }
-
-    if (!task) {
-        panic("Task '{}' not found in flow '{}'", taskName, flow->getName());
-    }
 
-    if (!checkSectionDependencies(flow, taskSection)) {
-        panic("Task '{}' has unmet section dependencies", taskName);
-    }
+        if (!task) {
+            panic("Task '{}' not found in flow '{}'", taskName, flow->getName());
+        }
 
-    if (!checkTaskDependencies(taskSection, task->getIndex())) {
-        panic("Task '{}' has unmet dependencies", taskName);
+        addSectionTasks(&scheduler, target, taskSection,
+                        task->getIndex(), task->getIndex());
     }
 
-    task->execute(target);
+    runTasks(&scheduler);
 }
 
 void Stargate::executeTaskRange(const ProjectConfig* projectConfig,
@@ -212,53 +193,59 @@ void Stargate::executeTaskRange(const ProjectConfig* projectConfig,
                                 const std::string& endTaskName) {
     prepareExecution(projectConfig);
 
-    const ProjectTarget* target = projectConfig->getTarget(targetName);
-    if (!target) {
-        panic("Target '{}' not found", targetName);
-    }
+    Targets targets;
+    getTargets(projectConfig, targetName, targets);
 
-    Flow* flow = getTargetFlow(target);
+    TaskScheduler scheduler(_config.getJobCount());
+    for (const ProjectTarget* target : targets) {
+        Flow* flow = getTargetFlow(target);
 
-    std::optional<size_t> startID;
-    std::optional<size_t> endID;
-    FlowSection* taskSection = nullptr;
+        std::optional<size_t> startID;
+        std::optional<size_t> endID;
+        FlowSection* taskSection = nullptr;
 
-    for (FlowSection* section : flow->sections()) {
-        const auto& tasks = section->tasks();
-        for (size_t i = 0; i < tasks.size(); i++) {
-            if (tasks[i]->getName() == startTaskName) {
-                startID = i;
-                taskSection = section;
-            }
-            if (tasks[i]->getName() == endTaskName) {
-                endID = i;
-                if (!taskSection) {
+        for (FlowSection* section : flow->sections()) {
+            const auto& tasks = section->tasks();
+            for (size_t i = 0; i < tasks.size(); i++) {
+                if (tasks[i]->getName() == startTaskName) {
+                    startID = i;
                     taskSection = section;
                 }
+                if (tasks[i]->getName() == endTaskName) {
+                    endID = i;
+                    if (!taskSection) {
+                        taskSection = section;
+                    }
+                }
+            }
+            if (startID && endID) {
+                break;
             }
         }
-        if (startID && endID) {
-            break;
+
+        if (!startID) {
+            panic("Start task '{}' not found in flow '{}'",
+                  startTaskName, flow->getName());
         }
-    }
 
-    if (!startID) {
-        panic("Start task '{}' not found in flow '{}'", startTaskName, flow->getName());
-    }
+        if (!endID) {
+            panic("End task '{}' not found in flow '{}'", endTaskName, flow->getName());
+        }
 
-    if (!endID) {
-        panic("End task '{}' not found in flow '{}'", endTaskName, flow->getName());
-    }
+        if (*startID > *endID) {
+            panic("Start task '{}' comes after end task '{}'",
+                  startTaskName, endTaskName);
+        }
 
-    if (*startID > *endID) {
-        panic("Start task '{}' comes after end task '{}'", startTaskName, endTaskName);
+        addSectionTasks(&scheduler, target, taskSection, *startID, *endID);
     }
 
-    executeSection(target, taskSection, *startID, *endID);
+    runTasks(&scheduler);
 }
 
 void Stargate::prepareExecution(const ProjectConfig* projConfig) {
     createOutputDir();
+    openArtifactCache();
     writeTargets(projConfig);
     _flowManager->setDistribConfig(projConfig->getDistribConfig());
 }
@@ -266,11 +253,9 @@ void Stargate::prepareExecution(const ProjectConfig* projConfig) {
 void Stargate::createOutputDir() {
     const auto& stargateDir = _config.getStargateDir();
 
-    // Empty output directory if it exists, create otherwise
-    if (FileUtils::exists(stargateDir)) {
-        FileUtils::removeDirectory(stargateDir);
-    }
-
+    // Outputs of earlier runs are kept: a task whose inputs did not
+    // change is not run again, and one that runs again clears its own
+    // output directory first.
     FileUtils::createDirectory(stargateDir);
 
     _flowManager->setOutputDir(stargateDir);
@@ -278,15 +263,30 @@ void Stargate::createOutputDir() {
     spdlog::info("Using stargate output directory {}", stargateDir);
 }
 
+void Stargate::openArtifactCache() {
+    const std::string& cacheDir = _config.getCacheDir();
+    if (cacheDir.empty() || _artifactCache) {
+        return;
+    }
+
+    _artifactCache = std::make_unique<ArtifactCache>(cacheDir, _config.getCacheSize());
+    _flowManager->setArtifactCache(_artifactCache.get());
+
+    spdlog::info("Using artifact cache {}", cacheDir);
+}
+
 void Stargate::writeTargets(const ProjectConfig* projConfig) {
     const auto basePath =
         std::filesystem::path(projConfig->getConfigPath()).parent_path().string();
 
+    std::string sourceDir;
+    FileUtils::absolute(basePath, sourceDir);
+    _flowManager->setSourceDir(sourceDir);
+
     // Create project subdirectory
     const std::string projDirPath = _config.getStargateDir()+"/project";
 
     std::string targetPath;
-    std::string tclPath;
     for (const ProjectTarget* target : projConfig->targets()) {
         // Create target directory
         targetPath = projDirPath;
@@ -295,10 +295,10 @@ void Stargate::writeTargets(const ProjectConfig* projConfig) {
 
         FileUtils::createDirectory(targetPath);
 
-        // Files tcl path
-        tclPath = targetPath+"/files.tcl";
-
-        writeTargetFilesTcl(target, basePath, tclPath);
+        writeTargetFilesTcl(target,
+                            basePath,
+                            targetPath+"/files.tcl",
+                            targetPath+"/constraints.tcl");
     }
 }
 
@@ -323,22 +323,23 @@ static void readCommandForExtension(const std::string& path,
     }
 }
 
-void Stargate::writeTargetFilesTcl(const ProjectTarget* target,
-                                   const std::string& basePath,
-                                   const std::string& tclPath) {
-    FileSetCollector collector;
-    collector.setBasePath(basePath);
-
-    for (const FileSet* fileset : target->filesets()) {
-        collector.addFileSet(fileset);
-    }
-
-    std::vector<std::string> paths;
-    collector.collect(paths);
+// Whether path is an implementation-only constraint file, named
+// <name>.impl.xdc, such as placement or routing constraints.
+static bool isImplConstraint(const std::string& path) {
+    std::string name = std::filesystem::path(path).filename().string();
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
 
-    std::string absBasePath;
-    FileUtils::absolute(basePath, absBasePath);
+    return name.size() > IMPL_CONSTRAINT_SUFFIX.size()
+        && name.ends_with(IMPL_CONSTRAINT_SUFFIX);
+}
 
+// Writes the script reading the files of paths, followed by the
+// hashes of their contents: the script changes whenever one of the
+// files does, which is what task fingerprints rely on.
+static void writeReadTcl(const std::vector<std::string>& paths,
+                         const std::string& absBasePath,
+                         const std::string& tclPath) {
     std::ofstream out(tclPath);
     if (!out) {
         panic("Failed to open files tcl for writing: {}", tclPath);
@@ -357,6 +358,50 @@ void Stargate::writeTargetFilesTcl(const ProjectTarget* target,
         }
         out << command << " $SGC_SOURCE_DIR/" << rel << "\n";
     }
+
+    out << "\n# Content hashes\n";
+    std::string hash;
+    for (const std::string& path : paths) {
+        if (!ContentHash::hashFile(path, &hash)) {
+            panic("Failed to read source file: {}", path);
+        }
+        const auto rel = std::filesystem::relative(path, absBasePath).string();
+        out << "# " << hash << " " << rel << "\n";
+    }
+}
+
+void Stargate::writeTargetFilesTcl(const ProjectTarget* target,
+                                   const std::string& basePath,
+                                   const std::string& filesTclPath,
+                                   const std::string& constraintsTclPath) {
+    FileSetCollector collector;
+    collector.setBasePath(basePath);
+
+    for (const FileSet* fileset : target->filesets()) {
+        collector.addFileSet(fileset);
+    }
+
+    std::vector<std::string> paths;
+    collector.collect(paths);
+
+    std::string absBasePath;
+    FileUtils::absolute(basePath, absBasePath);
+
+    // Constraints are read before synthesis, which may depend on them.
+    // Only the files marked as implementation-only are read by impl,
+    // so that editing them does not invalidate synthesis.
+    std::vector<std::string> sourcePaths;
+    std::vector<std::string> constraintPaths;
+    for (const std::string& path : paths) {
+        if (isImplConstraint(path)) {
+            constraintPaths.push_back(path);
+        } else {
+            sourcePaths.push_back(path);
+        }
+    }
+
+    writeReadTcl(sourcePaths, absBasePath, filesTclPath);
+    writeReadTcl(constraintPaths, absBasePath, constraintsTclPath);
 }
 
 void Stargate::clean() {
@@ -384,35 +429,85 @@ Flow* Stargate::getTargetFlow(const ProjectTarget* target) {
     return flow;
 }
 
-void Stargate::executeSection(const ProjectTarget* target, FlowSection* section) {
-    const auto& tasks = section->tasks();
-    executeSection(target, section, 0, tasks.size() - 1);
+void Stargate::getTargets(const ProjectConfig* projectConfig,
+                          const std::string& targetName,
+                          Targets& targets) {
+    targets.clear();
+
+    const ProjectTarget* target = projectConfig->getTarget(targetName);
+    if (target) {
+        targets.push_back(target);
+        return;
+    }
+
+    // "all" selects every target, unless a target has that name.
+    if (targetName != ALL_TARGETS) {
+        panic("Target '{}' not found", targetName);
+    }
+
+    for (const ProjectTarget* projectTarget : projectConfig->targets()) {
+        targets.push_back(projectTarget);
+    }
+
+    if (targets.empty()) {
+        panic("The project does not define any target");
+    }
 }
 
-void Stargate::executeSection(const ProjectTarget* target,
-                              FlowSection* section,
-                              size_t startIdx,
-                              size_t endIdx) {
+void Stargate::executeSections(const Targets& targets,
+                               const std::string& sectionName,
+                               bool required) {
+    TaskScheduler scheduler(_config.getJobCount());
+    for (const ProjectTarget* target : targets) {
+        Flow* flow = getTargetFlow(target);
+        FlowSection* section = flow->getSection(sectionName);
+        if (!section) {
+            if (required) {
+                panic("Flow '{}' does not have a '{}' section",
+                      flow->getName(), sectionName);
+            }
+            continue;
+        }
+
+        if (section->tasks().empty()) {
+            continue;
+        }
+
+        addSectionTasks(&scheduler, target, section, 0, section->tasks().size() - 1);
+    }
+
+    runTasks(&scheduler);
+}
+
+void Stargate::addSectionTasks(TaskScheduler* scheduler,
+                               const ProjectTarget* target,
+                               FlowSection* section,
+                               size_t startIdx,
+                               size_t endIdx) {
     const auto& tasks = section->tasks();
     Flow* flow = section->getParent();
 
-    if (!checkSectionDependencies(flow, section)) {
-        panic("Section '{}' has unmet dependencies", section->getName());
+    if (!checkSectionDependencies(target, flow, section)) {
+        panic("Section '{}' has unmet dependencies for target '{}'",
+              section->getName(), target->getName());
     }
 
-    if (!checkTaskDependencies(section, startIdx)) {
-        const FlowTask* task = tasks[startIdx];
-        panic("Task '{}' has unmet dependencies", task->getName());
+    for (size_t i = startIdx; i <= endIdx; i++) {
+        scheduler->addTask(tasks[i], target);
     }
+}
 
-    for (size_t i = startIdx; i <= endIdx; i++) {
-        FlowTask* task = tasks[i];
-        spdlog::info("Executing task: {}", task->getName());
-        task->execute(target);
+void Stargate::runTasks(TaskScheduler* scheduler) {
+    // Dependencies that are not scheduled must have succeeded in an
+    // earlier run; the scheduler checks them.
+    if (!scheduler->run()) {
+        panic("Some tasks did not complete successfully");
     }
 }
 
-bool Stargate::checkSectionDependencies(Flow* flow, FlowSection* section) {
+bool Stargate::checkSectionDependencies(const ProjectTarget* target,
+                                        Flow* flow,
+                                        FlowSection* section) {
     const auto& sections = flow->sections();
 
     for (FlowSection* depSection : sections) {
@@ -421,7 +516,7 @@ bool Stargate::checkSectionDependencies(Flow* flow, FlowSection* section) {
         }
 
         for (const FlowTask* task : depSection->tasks()) {
-            const TaskStatus::Status status = task->getStatus();
+            const TaskStatus::Status status = task->getStatus(target);
             if (status != TaskStatus::Status::Success) {
                 spdlog::error(
                     "Dependency section '{}' task '{}' has not completed successfully "
@@ -434,20 +529,3 @@ bool Stargate::checkSectionDependencies(Flow* flow, FlowSection* section) {
 
     return true;
 }
-
-bool Stargate::checkTaskDependencies(FlowSection* section, size_t taskIdx) {
-    const auto& tasks = section->tasks();
-
-    for (size_t i = 0; i < taskIdx; i++) {
-        const FlowTask* depTask = tasks[i];
-        const TaskStatus::Status status = depTask->getStatus();
-        if (status != TaskStatus::Status::Success) {
-            spdlog::error(
-                "Dependency task '{}' has not completed successfully (status: {})",
-                depTask->getName(), TaskStatus::toString(status));
-            return false;
-        }
-    }
-
-    return true;
-}
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace stargate {
 
@@ -15,10 +16,14 @@ class FlowTask;
 class DistribFlowManager;
 class DistribFlow;
 class DistribConfig;
+class TaskScheduler;
+class ArtifactCache;
 enum class GUIAction;
 
 class Stargate {
 public:
+    using Targets = std::vector<const ProjectTarget*>;
+
     Stargate(const StargateConfig& config);
     ~Stargate();
 
@@ -50,25 +55,40 @@ private:
     const StargateConfig& _config;
     std::unique_ptr<FlowManager> _flowManager;
     std::unique_ptr<DistribFlowManager> _distribFlowManager;
+    std::unique_ptr<ArtifactCache> _artifactCache;
     DistribFlow* _distribFlow {nullptr};
     const DistribConfig* _distribConfig {nullptr};
 
     void prepareExecution(const ProjectConfig* projConfig);
     void createOutputDir();
+    void openArtifactCache();
     void writeTargets(const ProjectConfig* projConfig);
     void writeTargetFilesTcl(const ProjectTarget* target,
                              const std::string& basePath,
-                             const std::string& tclPath);
+                             const std::string& filesTclPath,
+                             const std::string& constraintsTclPath);
 
     Flow* getTargetFlow(const ProjectTarget* target);
     void setupDistrib(const ProjectConfig* projectConfig);
-    void executeSection(const ProjectTarget* target, FlowSection* section);
-    void executeSection(const ProjectTarget* target,
-                        FlowSection* section,
-                        size_t startIdx,
-                        size_t endIdx);
-    bool checkSectionDependencies(Flow* flow, FlowSection* section);
-    bool checkTaskDependencies(FlowSection* section, size_t taskIdx);
+
+    // The target named targetName, or every target for "all".
+    void getTargets(const ProjectConfig* projectConfig,
+                    const std::string& targetName,
+                    Targets& targets);
+
+    // Runs the section of every target's flow in one schedule.
+    void executeSections(const Targets& targets,
+                         const std::string& sectionName,
+                         bool required);
+    void addSectionTasks(TaskScheduler* scheduler,
+                         const ProjectTarget* target,
+                         FlowSection* section,
+                         size_t startIdx,
+                         size_t endIdx);
+    void runTasks(TaskScheduler* scheduler);
+    bool checkSectionDependencies(const ProjectTarget* target,
+                                  Flow* flow,
+                                  FlowSection* section);
 };
 
 }
@@ -17,3 +17,7 @@ StargateConfig::~StargateConfig() {
 void StargateConfig::setStargateDir(const std::string& stargateDir) {
     _stargateDir = std::filesystem::absolute(stargateDir);
 }
+
+void StargateConfig::setCacheDir(const std::string& cacheDir) {
+    _cacheDir = std::filesystem::absolute(cacheDir);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include <string>
 
 namespace stargate {
@@ -16,9 +17,24 @@ public:
     bool getVerbose() const { return _verbose; }
     void setVerbose(bool verbose) { _verbose = verbose; }
 
+    // Maximum number of tasks run at once, 0 for one per core.
+    unsigned getJobCount() const { return _jobCount; }
+    void setJobCount(unsigned jobCount) { _jobCount = jobCount; }
+
+    // Artifact cache directory, empty if outputs are not cached.
+    const std::string& getCacheDir() const { return _cacheDir; }
+    void setCacheDir(const std::string& cacheDir);
+
+    // Maximum size of the artifact cache, in bytes.
+    uint64_t getCacheSize() const { return _cacheSize; }
+    void setCacheSize(uint64_t cacheSize) { _cacheSize = cacheSize; }
+
 private:
     std::string _stargateDir;
     bool _verbose {false};
+    unsigned _jobCount {0};
+    std::string _cacheDir;
+    uint64_t _cacheSize {0};
 };
 
 }
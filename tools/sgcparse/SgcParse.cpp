@@ -1,19 +1,65 @@
 #include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 #include <argparse/argparse.hpp>
 #include <spdlog/spdlog.h>
 
+#include "Elaborator.h"
+#include "IncludeCache.h"
+#include "ParseCache.h"
 #include "VerilogDriver.h"
 
+#include "ContentHash.h"
 #include "FatalException.h"
+#include "FileUtils.h"
+
+#include "Design.h"
+#include "Library.h"
+#include "NameTable.h"
+#include "Netlist.h"
 
 using namespace stargate;
 using namespace argparse;
 
 constexpr const char* SGCPARSE_NAME = "sgcparse";
 
-static void parseDefine(VerilogDriver* drv, const std::string& spec) {
+namespace {
+
+struct ParseOptions {
+    std::vector<std::string> includeDirs;
+    std::vector<std::string> defines;
+    bool trace {false};
+    bool preprocessOnly {false};
+    bool dumpAst {false};
+    // Keeps each job's driver, and so its syntax tree, for the
+    // elaborator. The parse cache is not used then.
+    bool elaborate {false};
+    // Shared by every job, so a header is expanded once per macro
+    // context rather than once per input file.
+    IncludeCache* includeCache {nullptr};
+    // Outcomes of earlier invocations, if --cache-dir is given.
+    ParseCache* parseCache {nullptr};
+};
+
+// One input file. Workers fill in the result fields; the main thread
+// reports them in input order once every worker has joined.
+struct ParseJob {
+    std::string path;
+    uintmax_t size {0};
+    int rc {0};
+    std::vector<std::string> errors;
+    std::string output;
+    std::string fatal;
+    std::unique_ptr<VerilogDriver> driver;
+};
+
+void parseDefine(VerilogDriver* drv, const std::string& spec) {
     const size_t eq = spec.find('=');
     if (eq == std::string::npos) {
         drv->defineMacro(spec, "");
@@ -22,12 +68,220 @@ static void parseDefine(VerilogDriver* drv, const std::string& spec) {
     }
 }
 
+// Key of a job's outcome in the parse cache: the file and everything
+// on the command line that changes what parsing it produces. Paths are
+// made absolute, since relative include directories resolve against
+// the working directory. The SV keyword mode follows from the path.
+bool getCacheKey(const ParseJob* job, const ParseOptions* options,
+                 std::string* key) {
+    std::string contentHash;
+    if (!options->parseCache->hashFile(job->path, &contentHash)) {
+        return false;
+    }
+
+    ContentHash hash;
+    std::string absPath;
+    FileUtils::absolute(job->path, absPath);
+    hash.update(absPath);
+    hash.update(contentHash);
+    hash.update(options->preprocessOnly);
+    hash.update(options->dumpAst);
+
+    hash.update(options->includeDirs.size());
+    for (const auto& dir : options->includeDirs) {
+        FileUtils::absolute(dir, absPath);
+        hash.update(absPath);
+    }
+
+    hash.update(options->defines.size());
+    for (const auto& d : options->defines) {
+        hash.update(d);
+    }
+
+    hash.hex(*key);
+    return true;
+}
+
+// Stores the outcome of a job that ran to completion. A failure to
+// preprocess is not stored: it may come from an include that does not
+// exist yet, which no listed input would reveal.
+void storeJob(const ParseJob* job,
+              const VerilogDriver& drv,
+              const ParseOptions* options,
+              const std::string& key) {
+    if (!job->fatal.empty() || drv.hasPreprocessorErrors()) {
+        return;
+    }
+
+    ParseCacheEntry entry;
+    for (const auto& path : drv.dependencies()) {
+        std::string hash;
+        if (!options->parseCache->hashFile(path, &hash)) {
+            return;
+        }
+        entry.inputs.emplace_back(path, hash);
+    }
+    entry.missingIncludes.assign(drv.missingIncludes().begin(),
+                                 drv.missingIncludes().end());
+    entry.rc = job->rc;
+    entry.errors = job->errors;
+    entry.output = job->output;
+    options->parseCache->store(key, entry);
+}
+
+void runJobUnchecked(ParseJob* job, const ParseOptions* options) {
+    std::string cacheKey;
+    if (options->parseCache && !options->elaborate
+        && getCacheKey(job, options, &cacheKey)) {
+        ParseCacheEntry entry;
+        if (options->parseCache->load(cacheKey, &entry)) {
+            job->rc = entry.rc;
+            job->errors.swap(entry.errors);
+            job->output.swap(entry.output);
+            return;
+        }
+    }
+
+    job->driver = std::make_unique<VerilogDriver>();
+    VerilogDriver& drv = *job->driver;
+    drv.setTrace(options->trace);
+    drv.setIncludeCache(options->includeCache);
+    for (const auto& dir : options->includeDirs) {
+        drv.addIncludeDir(dir);
+    }
+    for (const auto& d : options->defines) {
+        parseDefine(&drv, d);
+    }
+
+    try {
+        if (options->preprocessOnly) {
+            job->rc = drv.preprocessFile(job->path, &job->output);
+        } else {
+            job->rc = drv.parseFile(job->path);
+            if (options->dumpAst && job->rc == 0) {
+                std::ostringstream oss;
+                drv.ast()->dump(oss, drv.sourceMap());
+                job->output = oss.str();
+            }
+        }
+    } catch (const FatalException& e) {
+        job->fatal = e.what();
+        job->rc = 1;
+    }
+
+    job->errors = drv.errors();
+
+    if (!cacheKey.empty()) {
+        storeJob(job, drv, options, cacheKey);
+    }
+
+    if (!options->elaborate) {
+        job->driver.reset();
+    }
+}
+
+// Runs on worker threads: any exception, such as a bad_alloc or a
+// filesystem_error, fails the job rather than terminating sgcparse.
+void runJob(ParseJob* job, const ParseOptions* options) {
+    try {
+        runJobUnchecked(job, options);
+    } catch (const std::exception& e) {
+        job->fatal = e.what();
+        job->rc = 1;
+    }
+}
+
+// Elaborates the syntax trees of every job into a netlist.
+bool elaborate(const std::vector<ParseJob>& jobs,
+               const std::string& top,
+               bool dumpDesigns,
+               unsigned workerCount) {
+    Netlist netlist;
+    Elaborator elaborator(&netlist, workerCount);
+    for (const ParseJob& job : jobs) {
+        elaborator.addAst(job.driver->ast(), job.driver->sourceMap());
+    }
+
+    if (!elaborator.elaborate(top)) {
+        for (const auto& msg : elaborator.errors()) {
+            std::cerr << msg << std::endl;
+        }
+        spdlog::error("elaboration failed");
+        return false;
+    }
+
+    const ElaborationStats& stats = elaborator.getStats();
+    spdlog::info("elaborated {} module(s) into {} design(s): "
+                 "{} instance(s), {} net(s), {} assignment(s)",
+                 stats.numModules, stats.numDesigns, stats.numInstances,
+                 stats.numNets, stats.numAssigns);
+    spdlog::info("not lowered: {} connection(s), {} assignment(s), "
+                 "{} gate(s), {} process(es)",
+                 stats.numUnloweredConnections, stats.numUnloweredAssigns,
+                 stats.numUnloweredGates, stats.numProcesses);
+
+    if (dumpDesigns) {
+        const NameTable* names = netlist.getNameTable();
+        for (const Library* library : netlist.getLibraries()) {
+            if (library->isPrimitiveOnly()) {
+                continue;
+            }
+            for (const Design* design : library->getDesigns()) {
+                std::cout << "design " << names->getString(design->name) << std::endl;
+            }
+        }
+    }
+    return true;
+}
+
+// Files are handed out largest-first from a shared cursor: each idle
+// worker grabs the next biggest remaining file, so a huge netlist
+// starts early instead of being left alone on one core at the end.
+void runJobs(std::vector<ParseJob>& jobs,
+             const ParseOptions* options,
+             unsigned workerCount) {
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return jobs[a].size > jobs[b].size;
+    });
+
+    std::atomic<size_t> next {0};
+    auto worker = [&]() {
+        while (true) {
+            const size_t k = next.fetch_add(1, std::memory_order_relaxed);
+            if (k >= order.size()) {
+                return;
+            }
+            runJob(&jobs[order[k]], options);
+        }
+    };
+
+    workerCount = std::min<size_t>(workerCount, jobs.size());
+    if (workerCount <= 1) {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < workerCount; i++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+}
+
 int main(int argc, char** argv) {
     ArgumentParser argParser(SGCPARSE_NAME);
 
     std::vector<std::string> inputs;
-    std::vector<std::string> includeDirs;
-    std::vector<std::string> defines;
+    ParseOptions options;
+    int jobCount = 1;
 
     argParser.add_argument("files")
         .nargs(argparse::nargs_pattern::at_least_one)
@@ -40,14 +294,14 @@ int main(int argc, char** argv) {
         .default_value(std::vector<std::string>{})
         .metavar("dir")
         .help("Add a directory to the `include search path")
-        .store_into(includeDirs);
+        .store_into(options.includeDirs);
 
     argParser.add_argument("-D", "--define")
         .append()
         .default_value(std::vector<std::string>{})
         .metavar("NAME[=BODY]")
         .help("Predefine a Verilog macro")
-        .store_into(defines);
+        .store_into(options.defines);
 
     argParser.add_argument("-E", "--preprocess-only")
         .nargs(0)
@@ -55,6 +309,42 @@ int main(int argc, char** argv) {
         .implicit_value(true)
         .help("Run only the preprocessor and emit the result to stdout");
 
+    argParser.add_argument("--dump-ast")
+        .nargs(0)
+        .default_value(false)
+        .implicit_value(true)
+        .help("Print the syntax tree of each parsed file to stdout");
+
+    argParser.add_argument("--elaborate")
+        .nargs(0)
+        .default_value(false)
+        .implicit_value(true)
+        .help("Elaborate the parsed modules into a netlist");
+
+    argParser.add_argument("--dump-designs")
+        .nargs(0)
+        .default_value(false)
+        .implicit_value(true)
+        .help("Print the name of each elaborated design to stdout");
+
+    argParser.add_argument("--top")
+        .default_value(std::string())
+        .metavar("module")
+        .help("Top module to elaborate (default: the one module that "
+              "no other instantiates)");
+
+    argParser.add_argument("-j", "--jobs")
+        .default_value(1)
+        .scan<'i', int>()
+        .metavar("N")
+        .help("Parse files on N worker threads (0: one per core)")
+        .store_into(jobCount);
+
+    argParser.add_argument("--cache-dir")
+        .metavar("dir")
+        .help("Reuse the outcome of unchanged files from earlier runs, "
+              "kept in dir");
+
     argParser.add_argument("--trace")
         .nargs(0)
         .default_value(false)
@@ -69,48 +359,91 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
-    const bool isTrace = argParser.get<bool>("--trace");
-    const bool preprocessOnly = argParser.get<bool>("--preprocess-only");
+    options.trace = argParser.get<bool>("--trace");
+    options.preprocessOnly = argParser.get<bool>("--preprocess-only");
+    options.dumpAst = argParser.get<bool>("--dump-ast");
+    options.elaborate = argParser.get<bool>("--elaborate");
 
-    int failureCount = 0;
+    if (options.elaborate && options.preprocessOnly) {
+        spdlog::error("--elaborate and --preprocess-only are exclusive");
+        return EXIT_FAILURE;
+    }
 
-    try {
-        for (const auto& path : inputs) {
-            VerilogDriver drv;
-            drv.setTrace(isTrace);
-            for (const auto& dir : includeDirs) {
-                drv.addIncludeDir(dir);
-            }
-            for (const auto& d : defines) {
-                parseDefine(&drv, d);
-            }
+    if (jobCount < 0) {
+        spdlog::error("--jobs must be positive or 0");
+        return EXIT_FAILURE;
+    }
 
-            int rc = 0;
-            if (preprocessOnly) {
-                std::string processed;
-                rc = drv.preprocessFile(path, &processed);
-                if (rc == 0) {
-                    std::cout << processed;
-                }
-            } else {
-                rc = drv.parseFile(path);
-            }
+    unsigned workerCount = static_cast<unsigned>(jobCount);
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
 
-            for (const auto& msg : drv.errors()) {
-                std::cerr << path << ": " << msg << std::endl;
-            }
+    std::vector<ParseJob> jobs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        jobs[i].path = inputs[i];
 
-            if (rc != 0) {
-                spdlog::error("parse failed: {}", path);
-                failureCount++;
-            } else if (!preprocessOnly) {
-                spdlog::info("parse ok: {}", path);
-            }
+        std::error_code ec;
+        const uintmax_t size = std::filesystem::file_size(inputs[i], ec);
+        jobs[i].size = ec ? 0 : size;
+    }
+
+    IncludeCache includeCache;
+    options.includeCache = &includeCache;
+
+    std::unique_ptr<ParseCache> parseCache;
+    if (auto cacheDir = argParser.present("--cache-dir")) {
+        try {
+            parseCache = std::make_unique<ParseCache>(*cacheDir);
+        } catch (const FatalException& e) {
+            spdlog::error("{}", e.what());
+            return EXIT_FAILURE;
         }
-    } catch (const FatalException& e) {
-        spdlog::error("{}", e.what());
+        options.parseCache = parseCache.get();
+    }
+
+    runJobs(jobs, &options, workerCount);
+
+    if (parseCache) {
+        spdlog::info("parse cache: {} hit(s), {} miss(es)",
+                     parseCache->getHitCount(),
+                     parseCache->getMissCount());
+    }
+
+    int failureCount = 0;
+    for (const ParseJob& job : jobs) {
+        if (!job.fatal.empty()) {
+            spdlog::error("{}", job.fatal);
+            return EXIT_FAILURE;
+        }
+
+        if (job.rc == 0) {
+            std::cout << job.output;
+        }
+
+        for (const auto& msg : job.errors) {
+            std::cerr << job.path << ": " << msg << std::endl;
+        }
+
+        if (job.rc != 0) {
+            spdlog::error("parse failed: {}", job.path);
+            failureCount++;
+        } else if (!options.preprocessOnly) {
+            spdlog::info("parse ok: {}", job.path);
+        }
+    }
+
+    if (failureCount != 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (options.elaborate
+        && !elaborate(jobs,
+                      argParser.get<std::string>("--top"),
+                      argParser.get<bool>("--dump-designs"),
+                      workerCount)) {
         return EXIT_FAILURE;
     }
 
-    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    return EXIT_SUCCESS;
 }
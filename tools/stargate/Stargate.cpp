@@ -17,6 +17,7 @@ using namespace argparse;
 
 constexpr const char* STARGATE_NAME = "stargate";
 constexpr const char* DEFAULT_TARGET = "default";
+constexpr int DEFAULT_CACHE_SIZE_GB = 100;
 
 int main(int argc, char** argv) {
     // Parse arguments
@@ -28,6 +29,9 @@ int main(int argc, char** argv) {
     std::string startTaskName;
     std::string endTaskName;
     bool isVerbose = false;
+    int jobCount = 0;
+    std::string cacheDirPath;
+    int cacheSizeGB = DEFAULT_CACHE_SIZE_GB;
 
     argParser.add_argument("-c", "-config")
         .nargs(1)
@@ -47,7 +51,8 @@ int main(int argc, char** argv) {
         .nargs(1)
         .default_value(DEFAULT_TARGET)
         .metavar("target")
-        .help("Target name (default: default)")
+        .help("Target name, or 'all' to build every target at once "
+              "(default: default)")
         .store_into(targetName);
 
     argParser.add_argument("-task")
@@ -71,6 +76,29 @@ int main(int argc, char** argv) {
         .help("End execution at this task (inclusive)")
         .store_into(endTaskName);
 
+    argParser.add_argument("-j", "-jobs")
+        .nargs(1)
+        .default_value(0)
+        .scan<'i', int>()
+        .metavar("N")
+        .help("Run at most N tasks at once (default: 0, one per core)")
+        .store_into(jobCount);
+
+    argParser.add_argument("-cache_dir")
+        .nargs(1)
+        .default_value("")
+        .metavar("dir")
+        .help("Restore task outputs from, and store them in, this artifact cache")
+        .store_into(cacheDirPath);
+
+    argParser.add_argument("-cache_size")
+        .nargs(1)
+        .default_value(DEFAULT_CACHE_SIZE_GB)
+        .scan<'i', int>()
+        .metavar("GB")
+        .help("Maximum size of the artifact cache (default: 100)")
+        .store_into(cacheSizeGB);
+
     argParser.add_argument("--verbose")
         .nargs(0)
         .help("Set stargate into verbose mode")
@@ -131,6 +159,21 @@ int main(int argc, char** argv) {
             stargateConfig.setStargateDir(outDirPath);
         }
 
+        if (jobCount < 0) {
+            spdlog::error("-jobs must be positive or 0");
+            return EXIT_FAILURE;
+        }
+        stargateConfig.setJobCount(static_cast<unsigned>(jobCount));
+
+        if (cacheSizeGB < 0) {
+            spdlog::error("-cache_size must be positive or 0");
+            return EXIT_FAILURE;
+        }
+        if (!cacheDirPath.empty()) {
+            stargateConfig.setCacheDir(cacheDirPath);
+        }
+        stargateConfig.setCacheSize(static_cast<uint64_t>(cacheSizeGB) << 30);
+
         Stargate stargate(stargateConfig);
         stargate.init();
 
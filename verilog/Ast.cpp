@@ -0,0 +1,444 @@
+#include "Ast.h"
+
+#include "SourceMap.h"
+
+namespace stargate {
+
+namespace {
+
+const char* const OP_NAMES[] = {
+    "", "+", "-", "!", "~", "&", "~&", "|", "~|", "^", "~^",
+    "+", "-", "*", "/", "%", "**", "<", "<=", ">", ">=", "==", "!=",
+    "===", "!==", "&&", "||", "&", "|", "^", "~&", "~|", "~^",
+    "<<", ">>", "<<<", ">>>", "++x", "--x", "x++", "x--", "+:", "-:",
+};
+
+static_assert(sizeof(OP_NAMES) / sizeof(OP_NAMES[0])
+              == static_cast<size_t>(AstOp::IndexedDown) + 1);
+
+const char* const DATA_TYPE_NAMES[] = {
+    "", "wire", "wand", "wor", "supply0", "supply1", "reg", "logic",
+    "bit", "byte", "shortint", "int", "longint", "integer", "time",
+    "real", "string", "chandle", "event", "enum", "struct", "union",
+    "user", "type", "void",
+};
+
+static_assert(sizeof(DATA_TYPE_NAMES) / sizeof(DATA_TYPE_NAMES[0])
+              == static_cast<size_t>(AstDataType::Void) + 1);
+
+bool hasDataType(AstKind kind) {
+    switch (kind) {
+        case AstKind::ParamDecl:
+        case AstKind::PortDecl:
+        case AstKind::NetDecl:
+        case AstKind::VarDecl:
+        case AstKind::GenvarDecl:
+        case AstKind::Typedef:
+        case AstKind::Cast:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+Ast::Ast() {
+    // Slot 0 is the null node.
+    _nodes.emplace_back();
+    _root = addNode(AstKind::SourceText, 0);
+}
+
+Ast::~Ast() {
+}
+
+AstNodeID Ast::addNode(AstKind kind, uint32_t line) {
+    const AstNodeID id = _nodes.size();
+    AstNode& node = _nodes.emplace_back();
+    node.kind = kind;
+    node.line = line;
+    return id;
+}
+
+AstNodeID Ast::addNamedNode(AstKind kind, SymbolID name, uint32_t line) {
+    const AstNodeID id = addNode(kind, line);
+    _nodes[id].name = name;
+    return id;
+}
+
+AstNodeID Ast::addUnary(AstOp op, AstNodeID operand, uint32_t line) {
+    const AstNodeID id = addNode(AstKind::Unary, line);
+    setOp(id, op);
+    addChild(id, operand);
+    return id;
+}
+
+AstNodeID Ast::addBinary(AstOp op, AstNodeID lhs, AstNodeID rhs,
+                         uint32_t line) {
+    const AstNodeID id = addNode(AstKind::Binary, line);
+    setOp(id, op);
+    addChild(id, lhs);
+    addChild(id, rhs);
+    return id;
+}
+
+AstNodeID Ast::addTernary(AstKind kind, AstNodeID a, AstNodeID b,
+                          AstNodeID c, uint32_t line) {
+    const AstNodeID id = addNode(kind, line);
+    addChild(id, a);
+    addChild(id, b);
+    addChild(id, c);
+    return id;
+}
+
+AstNodeID Ast::addDeclarator(SymbolID name, const AstList& dims,
+                             AstNodeID init, uint32_t line) {
+    const AstNodeID id = addNamedNode(AstKind::Declarator, name, line);
+    addChildren(id, dims);
+    addChild(id, init);
+    return id;
+}
+
+AstNodeID Ast::addDecl(AstKind kind, const AstTypeSpec& type,
+                       const AstList& declarators, uint32_t line) {
+    const AstNodeID id = addNamedNode(kind, type.userType, line);
+    setDataType(id, type.type);
+    addFlags(id, type.flags);
+    addChildren(id, type.dims);
+    addChildren(id, type.members);
+    addChildren(id, declarators);
+    return id;
+}
+
+void Ast::addChild(AstNodeID parent, AstNodeID child) {
+    if (child == NULL_AST_NODE) {
+        return;
+    }
+
+    AstNode& p = _nodes[parent];
+    if (p.lastChild == NULL_AST_NODE) {
+        p.firstChild = child;
+    } else {
+        _nodes[p.lastChild].nextSibling = child;
+    }
+    p.lastChild = child;
+}
+
+void Ast::addChildren(AstNodeID parent, const AstList& list) {
+    if (list.head == NULL_AST_NODE) {
+        return;
+    }
+
+    AstNode& p = _nodes[parent];
+    if (p.lastChild == NULL_AST_NODE) {
+        p.firstChild = list.head;
+    } else {
+        _nodes[p.lastChild].nextSibling = list.head;
+    }
+    p.lastChild = list.tail;
+}
+
+void Ast::getChildren(AstNodeID id, std::vector<AstNodeID>& children) const {
+    for (AstNodeID c = _nodes[id].firstChild; c; c = _nodes[c].nextSibling) {
+        children.push_back(c);
+    }
+}
+
+AstList Ast::makeList(AstNodeID id) {
+    AstList list;
+    append(list, id);
+    return list;
+}
+
+void Ast::append(AstList& list, AstNodeID id) {
+    if (id == NULL_AST_NODE) {
+        return;
+    }
+
+    if (list.tail == NULL_AST_NODE) {
+        list.head = id;
+    } else {
+        _nodes[list.tail].nextSibling = id;
+    }
+    list.tail = id;
+}
+
+void Ast::concat(AstList& list, const AstList& other) {
+    if (other.head == NULL_AST_NODE) {
+        return;
+    }
+
+    if (list.tail == NULL_AST_NODE) {
+        list.head = other.head;
+    } else {
+        _nodes[list.tail].nextSibling = other.head;
+    }
+    list.tail = other.tail;
+}
+
+void Ast::partition(const AstList& list, AstKind kind,
+                    AstList& matching, AstList& others) {
+    AstNodeID id = list.head;
+    while (id != NULL_AST_NODE) {
+        const AstNodeID next = _nodes[id].nextSibling;
+        _nodes[id].nextSibling = NULL_AST_NODE;
+        append(_nodes[id].kind == kind ? matching : others, id);
+        if (id == list.tail) {
+            break;
+        }
+        id = next;
+    }
+}
+
+void Ast::dump(std::ostream& out, const SourceMap* sourceMap) const {
+    dumpNode(out, sourceMap, _root, 0);
+}
+
+void Ast::dumpNode(std::ostream& out, const SourceMap* sourceMap,
+                   AstNodeID id, size_t depth) const {
+    const AstNode& node = _nodes[id];
+
+    out << std::string(depth * 2, ' ') << getKindName(node.kind);
+    if (node.name != NULL_SYMBOL) {
+        out << " " << _symbols.getString(node.name);
+    }
+
+    if (hasDataType(node.kind)) {
+        const char* type = DATA_TYPE_NAMES[node.sub];
+        if (*type) {
+            out << " <" << type << ">";
+        }
+    } else if (node.sub != 0) {
+        out << " '" << OP_NAMES[node.sub] << "'";
+    }
+
+    if (node.flags & AstFlags::Input) {
+        out << " input";
+    }
+    if (node.flags & AstFlags::Output) {
+        out << " output";
+    }
+    if (node.flags & AstFlags::Inout) {
+        out << " inout";
+    }
+    if (node.flags & AstFlags::Signed) {
+        out << " signed";
+    }
+    if (node.flags & AstFlags::Unsigned) {
+        out << " unsigned";
+    }
+    if (node.flags & AstFlags::Const) {
+        out << " const";
+    }
+    if (node.flags & AstFlags::Header) {
+        out << " header";
+    }
+    if (node.flags & AstFlags::Named) {
+        out << " named";
+    }
+    if (node.flags & AstFlags::Local) {
+        out << " local";
+    }
+    if (node.flags & AstFlags::Default) {
+        out << " default";
+    }
+    if (node.flags & AstFlags::Gate) {
+        out << " gate";
+    }
+
+    if (node.line != 0) {
+        uint32_t file = 0;
+        uint32_t line = node.line;
+        if (sourceMap) {
+            sourceMap->resolve(node.line, &file, &line);
+        }
+        out << " @" << line;
+    }
+    out << "\n";
+
+    for (AstNodeID c = node.firstChild; c; c = _nodes[c].nextSibling) {
+        dumpNode(out, sourceMap, c, depth + 1);
+    }
+}
+
+const char* Ast::getKindName(AstKind kind) {
+    switch (kind) {
+        case AstKind::Null:
+            return "Null";
+
+        case AstKind::SourceText:
+            return "SourceText";
+
+        case AstKind::Module:
+            return "Module";
+
+        case AstKind::Interface:
+            return "Interface";
+
+        case AstKind::Package:
+            return "Package";
+
+        case AstKind::Import:
+            return "Import";
+
+        case AstKind::Typedef:
+            return "Typedef";
+
+        case AstKind::ParamDecl:
+            return "ParamDecl";
+
+        case AstKind::PortDecl:
+            return "PortDecl";
+
+        case AstKind::NetDecl:
+            return "NetDecl";
+
+        case AstKind::VarDecl:
+            return "VarDecl";
+
+        case AstKind::GenvarDecl:
+            return "GenvarDecl";
+
+        case AstKind::Declarator:
+            return "Declarator";
+
+        case AstKind::EnumItem:
+            return "EnumItem";
+
+        case AstKind::PortRef:
+            return "PortRef";
+
+        case AstKind::Range:
+            return "Range";
+
+        case AstKind::ContAssign:
+            return "ContAssign";
+
+        case AstKind::Defparam:
+            return "Defparam";
+
+        case AstKind::Instantiation:
+            return "Instantiation";
+
+        case AstKind::ParamOverrides:
+            return "ParamOverrides";
+
+        case AstKind::Instance:
+            return "Instance";
+
+        case AstKind::PortConn:
+            return "PortConn";
+
+        case AstKind::GenerateIf:
+            return "GenerateIf";
+
+        case AstKind::GenerateFor:
+            return "GenerateFor";
+
+        case AstKind::GenerateCase:
+            return "GenerateCase";
+
+        case AstKind::GenerateCaseItem:
+            return "GenerateCaseItem";
+
+        case AstKind::GenerateBlock:
+            return "GenerateBlock";
+
+        case AstKind::Always:
+            return "Always";
+
+        case AstKind::AlwaysComb:
+            return "AlwaysComb";
+
+        case AstKind::AlwaysFF:
+            return "AlwaysFF";
+
+        case AstKind::AlwaysLatch:
+            return "AlwaysLatch";
+
+        case AstKind::Initial:
+            return "Initial";
+
+        case AstKind::Final:
+            return "Final";
+
+        case AstKind::Function:
+            return "Function";
+
+        case AstKind::Task:
+            return "Task";
+
+        case AstKind::Assign:
+            return "Assign";
+
+        case AstKind::Number:
+            return "Number";
+
+        case AstKind::RealNumber:
+            return "RealNumber";
+
+        case AstKind::StringLiteral:
+            return "StringLiteral";
+
+        case AstKind::Identifier:
+            return "Identifier";
+
+        case AstKind::ScopedIdentifier:
+            return "ScopedIdentifier";
+
+        case AstKind::Member:
+            return "Member";
+
+        case AstKind::Select:
+            return "Select";
+
+        case AstKind::RangeSelect:
+            return "RangeSelect";
+
+        case AstKind::Unary:
+            return "Unary";
+
+        case AstKind::Binary:
+            return "Binary";
+
+        case AstKind::Ternary:
+            return "Ternary";
+
+        case AstKind::Inside:
+            return "Inside";
+
+        case AstKind::Concat:
+            return "Concat";
+
+        case AstKind::Replicate:
+            return "Replicate";
+
+        case AstKind::Call:
+            return "Call";
+
+        case AstKind::SystemCall:
+            return "SystemCall";
+
+        case AstKind::NamedArg:
+            return "NamedArg";
+
+        case AstKind::Pattern:
+            return "Pattern";
+
+        case AstKind::PatternItem:
+            return "PatternItem";
+
+        case AstKind::Cast:
+            return "Cast";
+
+        case AstKind::MacroRef:
+            return "MacroRef";
+
+        case AstKind::NullLiteral:
+            return "NullLiteral";
+    }
+
+    return "?";
+}
+
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <stdint.h>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "StringTable.h"
+
+namespace stargate {
+
+class SourceMap;
+
+// Index of a node in its Ast. Id 0 is reserved for "no node".
+using AstNodeID = uint32_t;
+
+constexpr AstNodeID NULL_AST_NODE = 0;
+
+enum class AstKind : uint8_t {
+    Null,
+    SourceText,
+
+    // Design units
+    Module,
+    Interface,
+    Package,
+    Import,
+    Typedef,
+
+    // Declarations. Children are the packed dimensions (Range) of
+    // the declared type, the members of a struct, union or enum type,
+    // then one Declarator per name. A struct or union has one VarDecl
+    // per member line; an enum has a VarDecl without declarators for
+    // its base type, then one EnumItem per constant, whose child is
+    // its value if given.
+    ParamDecl,
+    PortDecl,
+    NetDecl,
+    VarDecl,
+    GenvarDecl,
+    Declarator,
+    EnumItem,
+    PortRef,
+    Range,
+
+    // Module items
+    ContAssign,
+    Defparam,
+    Instantiation,
+    ParamOverrides,
+    Instance,
+    PortConn,
+    GenerateIf,
+    GenerateFor,
+    GenerateCase,
+    GenerateCaseItem,
+    GenerateBlock,
+    Always,
+    AlwaysComb,
+    AlwaysFF,
+    AlwaysLatch,
+    Initial,
+    Final,
+    Function,
+    Task,
+    Assign,
+
+    // Expressions
+    Number,
+    RealNumber,
+    StringLiteral,
+    Identifier,
+    ScopedIdentifier,
+    Member,
+    Select,
+    RangeSelect,
+    Unary,
+    Binary,
+    Ternary,
+    Inside,
+    Concat,
+    Replicate,
+    Call,
+    SystemCall,
+    NamedArg,
+    Pattern,
+    PatternItem,
+    Cast,
+    MacroRef,
+    NullLiteral,
+};
+
+// Operator of Unary, Binary, RangeSelect and compound Assign nodes.
+enum class AstOp : uint8_t {
+    None,
+    Plus,
+    Minus,
+    LogNot,
+    BitNot,
+    RedAnd,
+    RedNand,
+    RedOr,
+    RedNor,
+    RedXor,
+    RedXnor,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Pow,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Eq,
+    Neq,
+    CaseEq,
+    CaseNeq,
+    LogAnd,
+    LogOr,
+    BitAnd,
+    BitOr,
+    BitXor,
+    BitNand,
+    BitNor,
+    BitXnor,
+    Shl,
+    Shr,
+    AShl,
+    AShr,
+    PreInc,
+    PreDec,
+    PostInc,
+    PostDec,
+    IndexedUp,
+    IndexedDown,
+};
+
+// Data type of declaration, Typedef and Cast nodes.
+enum class AstDataType : uint8_t {
+    Implicit,
+    Wire,
+    Wand,
+    Wor,
+    Supply0,
+    Supply1,
+    Reg,
+    Logic,
+    Bit,
+    Byte,
+    ShortInt,
+    Int,
+    LongInt,
+    Integer,
+    Time,
+    Real,
+    String,
+    Chandle,
+    Event,
+    Enum,
+    Struct,
+    Union,
+    User,
+    Type,
+    Void,
+};
+
+namespace AstFlags {
+
+constexpr uint16_t Signed    = 1 << 0;
+constexpr uint16_t Unsigned  = 1 << 1;
+constexpr uint16_t Input     = 1 << 2;
+constexpr uint16_t Output    = 1 << 3;
+constexpr uint16_t Inout     = 1 << 4;
+constexpr uint16_t Local     = 1 << 5;
+constexpr uint16_t Const     = 1 << 6;
+constexpr uint16_t Default   = 1 << 7;
+constexpr uint16_t Named     = 1 << 8;
+constexpr uint16_t Gate      = 1 << 9;
+constexpr uint16_t Header    = 1 << 10;
+
+}
+
+// 24 bytes. Children form a singly linked list through nextSibling;
+// lastChild makes appending O(1) while the tree is built bottom-up.
+// line is a preprocessed output line of the driver that built the
+// tree; its SourceMap gives the original file and line.
+struct AstNode {
+    AstKind kind {AstKind::Null};
+    uint8_t sub {0};
+    uint16_t flags {0};
+    SymbolID name {NULL_SYMBOL};
+    AstNodeID firstChild {NULL_AST_NODE};
+    AstNodeID lastChild {NULL_AST_NODE};
+    AstNodeID nextSibling {NULL_AST_NODE};
+    uint32_t line {0};
+};
+
+// Sibling chain that is not attached to a parent yet. Grammar list
+// rules carry one of these until the enclosing construct reduces.
+struct AstList {
+    AstNodeID head {NULL_AST_NODE};
+    AstNodeID tail {NULL_AST_NODE};
+};
+
+// Type part of a declaration, accumulated by the data type rules and
+// consumed by Ast::addDecl.
+struct AstTypeSpec {
+    AstDataType type {AstDataType::Implicit};
+    uint16_t flags {0};
+    SymbolID userType {NULL_SYMBOL};
+    AstList dims;
+    AstList members;
+};
+
+// Syntax tree of everything parsed by one VerilogDriver. Nodes live
+// in a single pool and refer to each other by 32-bit index, and all
+// identifier text is interned in the owned StringTable, so building
+// the tree does no per-node heap allocation and tearing it down is a
+// couple of frees. Each parsed file appends its descriptions under
+// the SourceText root.
+class Ast {
+public:
+    Ast();
+    ~Ast();
+
+    StringTable* symbols() { return &_symbols; }
+    const StringTable* symbols() const { return &_symbols; }
+
+    SymbolID intern(std::string_view str) { return _symbols.intern(str); }
+
+    AstNodeID root() const { return _root; }
+    size_t size() const { return _nodes.size() - 1; }
+    void reserve(size_t numNodes) { _nodes.reserve(numNodes + 1); }
+
+    const AstNode& getNode(AstNodeID id) const { return _nodes[id]; }
+    AstKind getKind(AstNodeID id) const { return _nodes[id].kind; }
+    AstOp getOp(AstNodeID id) const {
+        return static_cast<AstOp>(_nodes[id].sub);
+    }
+    AstDataType getDataType(AstNodeID id) const {
+        return static_cast<AstDataType>(_nodes[id].sub);
+    }
+    bool hasFlag(AstNodeID id, uint16_t flag) const {
+        return (_nodes[id].flags & flag) != 0;
+    }
+    std::string_view getName(AstNodeID id) const {
+        return _symbols.getString(_nodes[id].name);
+    }
+    AstNodeID getFirstChild(AstNodeID id) const {
+        return _nodes[id].firstChild;
+    }
+    AstNodeID getNextSibling(AstNodeID id) const {
+        return _nodes[id].nextSibling;
+    }
+    void getChildren(AstNodeID id, std::vector<AstNodeID>& children) const;
+
+    AstNodeID addNode(AstKind kind, uint32_t line);
+    AstNodeID addNamedNode(AstKind kind, SymbolID name, uint32_t line);
+    AstNodeID addUnary(AstOp op, AstNodeID operand, uint32_t line);
+    AstNodeID addBinary(AstOp op, AstNodeID lhs, AstNodeID rhs,
+                        uint32_t line);
+    AstNodeID addTernary(AstKind kind, AstNodeID a, AstNodeID b,
+                         AstNodeID c, uint32_t line);
+
+    // Declarator children are the unpacked dimensions followed by
+    // the initializer, if any.
+    AstNodeID addDeclarator(SymbolID name, const AstList& dims,
+                            AstNodeID init, uint32_t line);
+
+    // Creates a declaration node carrying the type, with the packed
+    // dimensions and the members of the type followed by the
+    // declarators as children.
+    AstNodeID addDecl(AstKind kind, const AstTypeSpec& type,
+                      const AstList& declarators, uint32_t line);
+
+    void setOp(AstNodeID id, AstOp op) {
+        _nodes[id].sub = static_cast<uint8_t>(op);
+    }
+    void setDataType(AstNodeID id, AstDataType type) {
+        _nodes[id].sub = static_cast<uint8_t>(type);
+    }
+    void setName(AstNodeID id, SymbolID name) { _nodes[id].name = name; }
+    void addFlags(AstNodeID id, uint16_t flags) { _nodes[id].flags |= flags; }
+
+    // Null children and empty lists are ignored.
+    void addChild(AstNodeID parent, AstNodeID child);
+    void addChildren(AstNodeID parent, const AstList& list);
+
+    AstList makeList(AstNodeID id);
+    void append(AstList& list, AstNodeID id);
+    void concat(AstList& list, const AstList& other);
+
+    // Splits list into the nodes of the given kind and the others,
+    // preserving order.
+    void partition(const AstList& list, AstKind kind,
+                   AstList& matching, AstList& others);
+
+    // With a source map, node lines are printed as source lines.
+    void dump(std::ostream& out, const SourceMap* sourceMap = nullptr) const;
+
+    static const char* getKindName(AstKind kind);
+
+private:
+    std::vector<AstNode> _nodes;
+    StringTable _symbols;
+    AstNodeID _root {NULL_AST_NODE};
+
+    void dumpNode(std::ostream& out, const SourceMap* sourceMap,
+                  AstNodeID id, size_t depth) const;
+};
+
+}
@@ -0,0 +1,56 @@
+#include "IncludeCache.h"
+
+#include <mutex>
+
+namespace stargate {
+
+IncludeCache::IncludeCache() {
+}
+
+IncludeCache::~IncludeCache() {
+}
+
+void IncludeCache::getUnits(const std::string& path,
+                            std::vector<const IncludeUnit*>& units) const {
+    std::shared_lock lock(_mutex);
+    const auto it = _units.find(path);
+    if (it == _units.end()) {
+        return;
+    }
+
+    for (const auto& unit : it->second) {
+        units.push_back(unit.get());
+    }
+}
+
+bool IncludeCache::addUnit(const IncludeUnit& unit) {
+    std::unique_lock lock(_mutex);
+    auto& units = _units[unit.path];
+    if (units.size() >= MAX_UNITS_PER_FILE) {
+        return false;
+    }
+
+    // Drivers that missed the same header under the same context at
+    // once each recorded it; one copy is enough.
+    for (const auto& other : units) {
+        if (other->uses == unit.uses && other->files == unit.files
+            && other->includeDirs == unit.includeDirs
+            && other->missingIncludes == unit.missingIncludes) {
+            return false;
+        }
+    }
+
+    units.emplace_back(new IncludeUnit(unit));
+    return true;
+}
+
+size_t IncludeCache::size() const {
+    std::shared_lock lock(_mutex);
+    size_t count = 0;
+    for (const auto& [path, units] : _units) {
+        count += units.size();
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "SourceMap.h"
+
+namespace stargate {
+
+// Piece of a function-like macro body: either a literal run of the
+// body or, when param is not negative, the slot of a parameter.
+struct MacroChunk {
+    uint32_t offset {0};
+    uint32_t length {0};
+    int32_t param {-1};
+
+    bool operator==(const MacroChunk&) const = default;
+};
+
+struct MacroDef {
+    std::vector<std::string> params;
+    std::string body;
+    bool isFunctionLike {false};
+    // Body split once at `define time, so that an expansion is a
+    // plain concatenation. Empty for object-like macros.
+    std::vector<MacroChunk> chunks;
+
+    bool operator==(const MacroDef&) const = default;
+};
+
+// Preprocessed text of one `include, together with everything its
+// expansion depended on. A macro mapped to nullopt was read while
+// undefined, or was undefined by the include.
+struct IncludeUnit {
+    using MacroStates = std::map<std::string, std::optional<MacroDef>, std::less<>>;
+
+    std::string path;
+    // Include directories the includes of the file were resolved
+    // against, in search order.
+    std::vector<std::string> includeDirs;
+    // Every file read to produce text, the included one first.
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> files;
+    // Include candidates found missing while resolving the includes
+    // of text.
+    std::vector<std::string> missingIncludes;
+    // Macros read before the include wrote them, with the state they
+    // had when first read.
+    MacroStates uses;
+    // Final state of every macro the include defined or undefined.
+    MacroStates effects;
+    std::string text;
+    // Newlines in text, and the source map runs that describe it.
+    // Run lines are relative to the first line of text, and run files
+    // index sourceFiles.
+    uint32_t lines {0};
+    std::vector<SourceMapRun> sourceRuns;
+    std::vector<std::string> sourceFiles;
+};
+
+// Include units shared by every Preprocessor of one invocation. The
+// cache owns its units and keeps them until it is destroyed, and a
+// unit is immutable once added, so readers may keep using it after
+// the lock is released. Safe to use from concurrent drivers.
+class IncludeCache {
+public:
+    IncludeCache();
+    ~IncludeCache();
+
+    void getUnits(const std::string& path,
+                  std::vector<const IncludeUnit*>& units) const;
+
+    // Adds a copy of unit, unless a unit of the same file was recorded
+    // under the same macro context and include directories, or the file already has
+    // MAX_UNITS_PER_FILE units. Returns true if the unit was added.
+    bool addUnit(const IncludeUnit& unit);
+
+    size_t size() const;
+
+private:
+    mutable std::shared_mutex _mutex;
+    std::unordered_map<std::string,
+                       std::vector<std::unique_ptr<IncludeUnit>>> _units;
+
+    // Distinct macro contexts kept per file. A header expanded under
+    // more contexts than this is probably configured per includer,
+    // and keeping every variant would not pay off.
+    static constexpr size_t MAX_UNITS_PER_FILE = 8;
+};
+
+}
@@ -0,0 +1,236 @@
+#include "ParseCache.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <thread>
+
+#include "ContentHash.h"
+#include "FileUtils.h"
+#include "MappedFile.h"
+
+namespace stargate {
+
+namespace {
+
+// Bump whenever the entry layout or the meaning of a cached outcome
+// changes; older entries then simply stop being found.
+constexpr char ENTRY_MAGIC[8] = {'S', 'G', 'P', 'C', 'A', 'C', 'H', '3'};
+
+void writeU64(std::string& out, uint64_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::string& out, std::string_view str) {
+    writeU64(out, str.size());
+    out.append(str);
+}
+
+// Reads back what writeU64 and writeString wrote, failing instead of
+// reading past the end of a truncated or corrupt entry.
+class EntryReader {
+public:
+    explicit EntryReader(std::string_view data)
+        : _data(data)
+    {
+    }
+
+    bool readU64(uint64_t* value) {
+        if (_data.size() - _pos < sizeof(*value)) {
+            return false;
+        }
+        memcpy(value, _data.data() + _pos, sizeof(*value));
+        _pos += sizeof(*value);
+        return true;
+    }
+
+    bool readString(std::string* str) {
+        uint64_t size = 0;
+        if (!readU64(&size) || _data.size() - _pos < size) {
+            return false;
+        }
+        str->assign(_data.substr(_pos, size));
+        _pos += size;
+        return true;
+    }
+
+    bool atEnd() const { return _pos == _data.size(); }
+
+private:
+    std::string_view _data;
+    size_t _pos {0};
+};
+
+}
+
+ParseCache::ParseCache(const std::string& dir)
+    : _dir(dir)
+{
+    FileUtils::createDirectory(_dir);
+}
+
+ParseCache::~ParseCache() {
+}
+
+bool ParseCache::hashFile(const std::string& path, std::string* hash) {
+    {
+        std::lock_guard lock(_mutex);
+        const auto it = _fileHashes.find(path);
+        if (it != _fileHashes.end()) {
+            *hash = it->second;
+            return true;
+        }
+    }
+
+    if (!ContentHash::hashFile(path, hash)) {
+        return false;
+    }
+
+    std::lock_guard lock(_mutex);
+    _fileHashes.emplace(path, *hash);
+    return true;
+}
+
+void ParseCache::getEntryPath(const std::string& key, std::string& result) const {
+    // Fanned out over subdirectories, as large trees make for many
+    // entries.
+    result = _dir;
+    result += "/";
+    result.append(key, 0, 2);
+    result += "/";
+    result.append(key, 2);
+}
+
+bool ParseCache::load(const std::string& key, ParseCacheEntry* entry) {
+    std::string entryPath;
+    getEntryPath(key, entryPath);
+    if (!read(entryPath, entry)) {
+        _misses++;
+        return false;
+    }
+
+    for (const auto& [path, storedHash] : entry->inputs) {
+        std::string hash;
+        if (!hashFile(path, &hash) || hash != storedHash) {
+            _misses++;
+            return false;
+        }
+    }
+
+    for (const auto& path : entry->missingIncludes) {
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec) || ec) {
+            _misses++;
+            return false;
+        }
+    }
+
+    _hits++;
+    return true;
+}
+
+bool ParseCache::read(const std::string& path, ParseCacheEntry* entry) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    const std::string_view data = file.data();
+    if (data.size() < sizeof(ENTRY_MAGIC)
+        || memcmp(data.data(), ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0) {
+        return false;
+    }
+
+    EntryReader reader(data.substr(sizeof(ENTRY_MAGIC)));
+    uint64_t inputCount = 0;
+    if (!reader.readU64(&inputCount)) {
+        return false;
+    }
+    entry->inputs.clear();
+    for (uint64_t i = 0; i < inputCount; i++) {
+        auto& [inputPath, hash] = entry->inputs.emplace_back();
+        if (!reader.readString(&inputPath) || !reader.readString(&hash)) {
+            return false;
+        }
+    }
+
+    uint64_t missingCount = 0;
+    if (!reader.readU64(&missingCount)) {
+        return false;
+    }
+    entry->missingIncludes.clear();
+    for (uint64_t i = 0; i < missingCount; i++) {
+        if (!reader.readString(&entry->missingIncludes.emplace_back())) {
+            return false;
+        }
+    }
+
+    uint64_t rc = 0;
+    uint64_t errorCount = 0;
+    if (!reader.readU64(&rc) || !reader.readU64(&errorCount)) {
+        return false;
+    }
+    entry->rc = static_cast<int>(rc);
+    entry->errors.clear();
+    for (uint64_t i = 0; i < errorCount; i++) {
+        if (!reader.readString(&entry->errors.emplace_back())) {
+            return false;
+        }
+    }
+
+    return reader.readString(&entry->output) && reader.atEnd();
+}
+
+void ParseCache::store(const std::string& key, const ParseCacheEntry& entry) {
+    std::string data(ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    writeU64(data, entry.inputs.size());
+    for (const auto& [path, hash] : entry.inputs) {
+        writeString(data, path);
+        writeString(data, hash);
+    }
+    writeU64(data, entry.missingIncludes.size());
+    for (const auto& path : entry.missingIncludes) {
+        writeString(data, path);
+    }
+    writeU64(data, static_cast<uint64_t>(entry.rc));
+    writeU64(data, entry.errors.size());
+    for (const std::string& error : entry.errors) {
+        writeString(data, error);
+    }
+    writeString(data, entry.output);
+
+    std::string path;
+    getEntryPath(key, path);
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path(), ec);
+    if (ec) {
+        return;
+    }
+
+    // Unique per process and thread, so writers never share a file and
+    // readers only ever see complete entries.
+    const std::string tmpPath = path + ".tmp."
+        + std::to_string(getpid()) + "."
+        + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stargate {
+
+// Outcome of parsing one file, as kept in the parse cache.
+struct ParseCacheEntry {
+    // Every included file the outcome was computed from, with the hash
+    // of its contents at the time.
+    std::vector<std::pair<std::string, std::string>> inputs;
+    // Include candidates that did not exist. Creating one of them may
+    // shadow an input, so the entry is stale once one exists.
+    std::vector<std::string> missingIncludes;
+    int rc {0};
+    std::vector<std::string> errors;
+    std::string output;
+};
+
+// Parse outcomes kept on disk across invocations. An entry is stored
+// under a key that covers the file contents and every option that
+// changes the outcome; the files it included cannot be known before
+// preprocessing, so they are listed in the entry and checked on load.
+// Entries are written to a temporary file and renamed into place, so
+// concurrent processes may share one directory. Safe to use from
+// concurrent drivers.
+class ParseCache {
+public:
+    explicit ParseCache(const std::string& dir);
+    ~ParseCache();
+
+    // Hash of a file's contents, computed once per invocation. Returns
+    // false if the file cannot be read.
+    bool hashFile(const std::string& path, std::string* hash);
+
+    // Returns false if there is no entry for key, if one of the files
+    // it lists has changed since it was stored, or if one of its
+    // missing include candidates now exists.
+    bool load(const std::string& key, ParseCacheEntry* entry);
+    // Failures to write are ignored: the cache only ever saves work.
+    void store(const std::string& key, const ParseCacheEntry& entry);
+
+    size_t getHitCount() const { return _hits; }
+    size_t getMissCount() const { return _misses; }
+
+private:
+    std::string _dir;
+    std::mutex _mutex;
+    std::unordered_map<std::string, std::string> _fileHashes;
+    std::atomic<size_t> _hits {0};
+    std::atomic<size_t> _misses {0};
+
+    void getEntryPath(const std::string& key, std::string& result) const;
+    bool read(const std::string& path, ParseCacheEntry* entry);
+};
+
+}
@@ -1,6 +1,9 @@
 // Verilog-2001 (IEEE 1364-2005) parser, transcribed from Annex A.
-// Recognizer-only: every semantic action body is empty. An AST will
-// land in a follow-up.
+// The semantic actions build the driver's Ast (see Ast.h): design
+// units, parameters, ports, nets and variables, instantiations,
+// generate constructs, continuous assigns and full expressions.
+// Procedural code is still recognized only: always/initial blocks,
+// functions and tasks become bodiless nodes.
 //
 // SystemVerilog (IEEE 1800) — pragmatic subset.
 // The grammar accepts a useful slice of SV beyond plain Verilog-2001:
@@ -31,15 +34,104 @@
 
 %code requires {
     #include <string>
+
+    #include "Ast.h"
+
     namespace stargate { class VerilogDriver; }
 }
 
+// The scanner is the driver's reentrant flex state (an opaque
+// yyscan_t), threaded through to yylex so that no lexer state is
+// global.
 %param { stargate::VerilogDriver& drv }
+%param { void* scanner }
 
 %code {
     #include "VerilogDriver.h"
 
-    stargate::Parser::symbol_type yylex(stargate::VerilogDriver& drv);
+    stargate::Parser::symbol_type yylex(stargate::VerilogDriver& drv,
+                                        void* scanner);
+
+    // Shorthands for the semantic actions.
+    #define AST (drv.ast())
+    #define LINE(loc) static_cast<uint32_t>((loc).begin.line)
+
+    namespace {
+
+    stargate::AstTypeSpec makeType(stargate::AstDataType type,
+                                   uint16_t flags) {
+        stargate::AstTypeSpec spec;
+        spec.type = type;
+        spec.flags = flags;
+        return spec;
+    }
+
+    stargate::AstTypeSpec makeType(stargate::AstDataType type,
+                                   uint16_t flags,
+                                   const stargate::AstList& dims) {
+        stargate::AstTypeSpec spec = makeType(type, flags);
+        spec.dims = dims;
+        return spec;
+    }
+
+    stargate::AstTypeSpec makeType(stargate::AstDataType type,
+                                   uint16_t flags,
+                                   stargate::AstNodeID range) {
+        stargate::AstTypeSpec spec = makeType(type, flags);
+        spec.dims.head = range;
+        spec.dims.tail = range;
+        return spec;
+    }
+
+    // `parameter IDENT ...` and `input IDENT ...` only reveal whether
+    // IDENT was a user type or the declared name once the tail has
+    // been reduced. The tail rules leave that identifier out; this
+    // puts it back in the right place.
+    void nameLeadingIdent(stargate::Ast* ast,
+                          stargate::AstNodeID decl,
+                          stargate::SymbolID ident) {
+        if (ast->getDataType(decl) == stargate::AstDataType::User) {
+            ast->setName(decl, ident);
+        } else {
+            ast->setName(ast->getFirstChild(decl), ident);
+        }
+    }
+
+    // `T #(...) a (...), b;` mixes module instances and, in SV,
+    // variables of user type T. Instances are grouped under one
+    // Instantiation of T, declarators under one VarDecl of type T.
+    stargate::AstList buildInstOrVar(stargate::Ast* ast,
+                                     stargate::SymbolID typeName,
+                                     stargate::AstNodeID params,
+                                     const stargate::AstList& dims,
+                                     const stargate::AstList& items,
+                                     uint32_t line) {
+        using namespace stargate;
+
+        AstList instances;
+        AstList declarators;
+        ast->partition(items, AstKind::Instance, instances, declarators);
+
+        AstList result;
+        if (instances.head != NULL_AST_NODE) {
+            const AstNodeID inst = ast->addNamedNode(AstKind::Instantiation,
+                                                     typeName, line);
+            ast->addChild(inst, params);
+            ast->addChildren(inst, instances);
+            ast->append(result, inst);
+        }
+
+        if (declarators.head != NULL_AST_NODE) {
+            AstTypeSpec type = makeType(AstDataType::User, 0, dims);
+            type.userType = typeName;
+            ast->append(result, ast->addDecl(AstKind::VarDecl, type,
+                                             declarators, line));
+        }
+
+        return result;
+    }
+
+    }
 }
 
 %token YYEOF 0 "end of file"
@@ -277,13 +369,73 @@
 // ============================================================
 // Literals & identifiers
 // ============================================================
-%token <std::string> NUMBER
-%token <std::string> REAL_NUMBER
-%token <std::string> STRING_LITERAL
-%token <std::string> IDENTIFIER
-%token <std::string> SYSTEM_ID
-%token <std::string> MACRO_REF
-%token <std::string> SCOPED_NAME_HEAD    "<ident>::"
+// Identifier and literal text is interned by the lexer.
+%token <stargate::SymbolID> NUMBER
+%token <stargate::SymbolID> REAL_NUMBER
+%token <stargate::SymbolID> STRING_LITERAL
+%token <stargate::SymbolID> IDENTIFIER
+%token <stargate::SymbolID> SYSTEM_ID
+%token <stargate::SymbolID> MACRO_REF
+%token <stargate::SymbolID> SCOPED_NAME_HEAD    "<ident>::"
+
+// ============================================================
+// Semantic values
+// ============================================================
+%type <stargate::AstNodeID>
+    package_declaration interface_declaration package_import_item
+    sv_typedef_declaration packed_dim unpacked_dim sv_data_declaration
+    module_declaration module_parameter_port_decl mp_after_param_ident
+    param_type_assignment port_item port_typed_classic_form
+    opt_port_init port_after_dir_ident_tail port_reference_or_named
+    opt_range range final_construct conditional_generate_construct
+    loop_generate_construct case_generate_construct generate_case_item
+    generate_block_or_null generate_block port_decl_stmt
+    net_declaration net_decl_assignment_or_id opt_range_or_dimensions
+    reg_declaration var_decl_assignment integer_declaration
+    real_declaration time_declaration event_declaration
+    genvar_declaration parameter_declaration localparam_declaration
+    pdecl_after_param_ident param_assignment defparam_assign
+    net_assignment always_construct initial_construct
+    function_declaration task_declaration inst_or_var
+    opt_param_value_assignment port_conn gate_instantiation
+    gate_instance blocking_assignment variable_lvalue
+    hierarchical_identifier hierarchical_identifier_with_select
+    for_init for_step inc_or_dec_expression expression inside_value
+    primary sv_assignment_pattern assignment_pattern_item
+    cast_expression concatenation multiple_concatenation function_call
+    named_arg system_function_call enum_member struct_member
+
+%type <stargate::AstList>
+    description package_item_list_opt package_item_list package_item
+    sv_package_import_declaration package_import_item_list
+    opt_packed_dim_list packed_dim_list opt_unpacked_dim_list
+    unpacked_dim_list list_of_var_decl_assignments opt_module_imports
+    module_imports opt_module_parameter_port_list
+    module_parameter_port_decls opt_list_of_ports port_list
+    module_item_list_opt module_item_list module_item
+    actual_module_item generate_case_items generate_block_items
+    list_of_net_decl_assignments pdecl_more_param_assignments
+    param_type_assignments param_assignments identifier_list
+    defparam_statement defparam_assignments continuous_assign
+    list_of_net_assignments generate_construct
+    gate_or_module_instantiation module_or_udp_instantiation
+    inst_or_var_list port_connections_opt port_connections
+    gate_instance_list variable_lvalue_list expression_list
+    expression_list_opt inside_value_list assignment_pattern_items
+    function_args named_arg_list enum_member_list struct_member_list
+
+%type <stargate::AstTypeSpec>
+    data_type data_type_or_user data_type_or_implicit
+    sv_param_data_type sv_port_data_type opt_param_type_or_range
+    opt_enum_base
+
+%type <stargate::AstDataType>
+    integer_atom_type integer_vector_type non_integer_type
+    opt_net_or_reg net_type
+
+%type <uint16_t> opt_signedness opt_const port_direction opt_signed
+%type <stargate::AstOp> compound_assign_op unary_op
+%type <stargate::SymbolID> gate_type
 
 // ============================================================
 // Precedence (lowest to highest)
@@ -312,15 +464,15 @@
 // ============================================================
 source_text
     : %empty                              { }
-    | source_text description             { }
+    | source_text description             { AST->addChildren(AST->root(), $2); }
     ;
 
 description
-    : module_declaration                  { }
-    | package_declaration                 { }
-    | interface_declaration               { }
-    | sv_typedef_declaration              { }
-    | sv_package_import_declaration       { }
+    : module_declaration                  { $$ = AST->makeList($1); }
+    | package_declaration                 { $$ = AST->makeList($1); }
+    | interface_declaration               { $$ = AST->makeList($1); }
+    | sv_typedef_declaration              { $$ = AST->makeList($1); }
+    | sv_package_import_declaration       { $$ = $1; }
     ;
 
 // ============================================================
@@ -328,7 +480,11 @@ description
 // ============================================================
 package_declaration
     : K_PACKAGE opt_lifetime IDENTIFIER SEMI
-        package_item_list_opt K_ENDPACKAGE opt_endlabel             { }
+        package_item_list_opt K_ENDPACKAGE opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Package, $3, LINE(@1));
+            AST->addChildren($$, $5);
+        }
     ;
 
 opt_lifetime
@@ -344,24 +500,36 @@ opt_endlabel
 
 package_item_list_opt
     : %empty                                                        { }
-    | package_item_list                                             { }
+    | package_item_list                                             { $$ = $1; }
     ;
 
 package_item_list
-    : package_item                                                  { }
-    | package_item_list package_item                                { }
+    : package_item                                                  { $$ = $1; }
+    | package_item_list package_item
+        {
+            $$ = $1;
+            AST->concat($$, $2);
+        }
     ;
 
 package_item
-    : parameter_declaration                                         { }
-    | localparam_declaration                                        { }
-    | sv_typedef_declaration                                        { }
-    | function_declaration                                          { }
-    | task_declaration                                              { }
-    | net_declaration                                               { }
-    | reg_declaration                                               { }
-    | sv_data_declaration                                           { }
-    | sv_package_import_declaration                                 { }
+    : parameter_declaration
+        { $$ = AST->makeList($1); }
+    | localparam_declaration
+        { $$ = AST->makeList($1); }
+    | sv_typedef_declaration
+        { $$ = AST->makeList($1); }
+    | function_declaration
+        { $$ = AST->makeList($1); }
+    | task_declaration
+        { $$ = AST->makeList($1); }
+    | net_declaration
+        { $$ = AST->makeList($1); }
+    | reg_declaration
+        { $$ = AST->makeList($1); }
+    | sv_data_declaration
+        { $$ = AST->makeList($1); }
+    | sv_package_import_declaration                                 { $$ = $1; }
     ;
 
 // ============================================================
@@ -370,33 +538,64 @@ package_item
 interface_declaration
     : K_INTERFACE IDENTIFIER opt_module_parameter_port_list
         opt_list_of_ports SEMI module_item_list_opt
-        K_ENDINTERFACE opt_endlabel                                 { }
+        K_ENDINTERFACE opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Interface, $2, LINE(@1));
+            AST->addChildren($$, $3);
+            AST->addChildren($$, $4);
+            AST->addChildren($$, $6);
+        }
     ;
 
 // ============================================================
 // SV package import / export
 // ============================================================
 sv_package_import_declaration
-    : K_IMPORT package_import_item_list SEMI                        { }
+    : K_IMPORT package_import_item_list SEMI                        { $$ = $2; }
     | K_EXPORT package_import_item_list SEMI                        { }
     ;
 
 package_import_item_list
-    : package_import_item                                           { }
-    | package_import_item_list COMMA package_import_item            { }
+    : package_import_item
+        { $$ = AST->makeList($1); }
+    | package_import_item_list COMMA package_import_item
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 package_import_item
-    : SCOPED_NAME_HEAD STAR                                         { }
-    | SCOPED_NAME_HEAD IDENTIFIER                                   { }
+    : SCOPED_NAME_HEAD STAR
+        {
+            $$ = AST->addNamedNode(AstKind::Import, $1, LINE(@1));
+        }
+    | SCOPED_NAME_HEAD IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::Import, $1, LINE(@1));
+            AST->addChild($$,
+                AST->addNamedNode(AstKind::Identifier, $2, LINE(@2)));
+        }
     ;
 
 // ============================================================
 // SV typedef and data types
 // ============================================================
 sv_typedef_declaration
-    : K_TYPEDEF data_type_or_user IDENTIFIER opt_unpacked_dim_list SEMI { }
-    | K_TYPEDEF IDENTIFIER SEMI                                     { }
+    : K_TYPEDEF data_type_or_user IDENTIFIER opt_unpacked_dim_list SEMI
+        {
+            const AstNodeID decl = AST->addDeclarator($3, $4,
+                NULL_AST_NODE, LINE(@3));
+            $$ = AST->addDecl(AstKind::Typedef, $2, AST->makeList(decl),
+                LINE(@1));
+        }
+    | K_TYPEDEF IDENTIFIER SEMI
+        {
+            const AstNodeID decl = AST->addDeclarator($2, AstList(),
+                NULL_AST_NODE, LINE(@2));
+            $$ = AST->addDecl(AstKind::Typedef, AstTypeSpec(),
+                AST->makeList(decl), LINE(@1));
+        }
     ;
 
 // Keyword-prefixed data types. Anything starting with an IDENTIFIER
@@ -410,46 +609,103 @@ sv_typedef_declaration
 // contexts that are syntactically locked (typedef body, struct or
 // union member) where the surrounding rule disambiguates.
 data_type
-    : integer_atom_type opt_signedness                              { }
-    | integer_vector_type opt_signedness opt_packed_dim_list        { }
-    | non_integer_type                                              { }
+    : integer_atom_type opt_signedness
+        {
+            $$.type = $1;
+            $$.flags = $2;
+        }
+    | integer_vector_type opt_signedness opt_packed_dim_list
+        {
+            $$.type = $1;
+            $$.flags = $2;
+            $$.dims = $3;
+        }
+    | non_integer_type                                              { $$.type = $1; }
     | K_STRUCT opt_packed opt_signedness LBRACE struct_member_list RBRACE
-        opt_packed_dim_list                                         { }
+        opt_packed_dim_list
+        {
+            $$.type = AstDataType::Struct;
+            $$.flags = $3;
+            $$.dims = $7;
+            $$.members = $5;
+        }
     | K_UNION opt_packed opt_signedness LBRACE struct_member_list RBRACE
-        opt_packed_dim_list                                         { }
+        opt_packed_dim_list
+        {
+            $$.type = AstDataType::Union;
+            $$.flags = $3;
+            $$.dims = $7;
+            $$.members = $5;
+        }
     | K_ENUM opt_enum_base LBRACE enum_member_list RBRACE
-        opt_packed_dim_list                                         { }
-    | K_STRING                                                      { }
-    | K_CHANDLE                                                     { }
-    | K_EVENT                                                       { }
-    | K_VIRTUAL K_INTERFACE IDENTIFIER                              { }
+        opt_packed_dim_list
+        {
+            $$.type = AstDataType::Enum;
+            $$.dims = $6;
+            $$.members = AST->makeList(AST->addDecl(AstKind::VarDecl, $2,
+                AstList(), LINE(@1)));
+            AST->concat($$.members, $4);
+        }
+    | K_STRING
+        { $$.type = AstDataType::String; }
+    | K_CHANDLE
+        { $$.type = AstDataType::Chandle; }
+    | K_EVENT
+        { $$.type = AstDataType::Event; }
+    | K_VIRTUAL K_INTERFACE IDENTIFIER
+        {
+            $$.type = AstDataType::User;
+            $$.userType = $3;
+        }
     ;
 
 data_type_or_user
-    : data_type                                                     { }
-    | IDENTIFIER opt_packed_dim_list                                { }
-    | SCOPED_NAME_HEAD IDENTIFIER opt_packed_dim_list               { }
+    : data_type                                                     { $$ = $1; }
+    | IDENTIFIER opt_packed_dim_list
+        {
+            $$.type = AstDataType::User;
+            $$.userType = $1;
+            $$.dims = $2;
+        }
+    | SCOPED_NAME_HEAD IDENTIFIER opt_packed_dim_list
+        {
+            $$.type = AstDataType::User;
+            $$.userType = $2;
+            $$.dims = $3;
+        }
     ;
 
 integer_atom_type
-    : K_BYTE                                                        { }
-    | K_SHORTINT                                                    { }
-    | K_INT                                                         { }
-    | K_LONGINT                                                     { }
-    | K_INTEGER                                                     { }
-    | K_TIME                                                        { }
+    : K_BYTE
+        { $$ = AstDataType::Byte; }
+    | K_SHORTINT
+        { $$ = AstDataType::ShortInt; }
+    | K_INT
+        { $$ = AstDataType::Int; }
+    | K_LONGINT
+        { $$ = AstDataType::LongInt; }
+    | K_INTEGER
+        { $$ = AstDataType::Integer; }
+    | K_TIME
+        { $$ = AstDataType::Time; }
     ;
 
 integer_vector_type
-    : K_BIT                                                         { }
-    | K_LOGIC                                                       { }
-    | K_REG                                                         { }
+    : K_BIT
+        { $$ = AstDataType::Bit; }
+    | K_LOGIC
+        { $$ = AstDataType::Logic; }
+    | K_REG
+        { $$ = AstDataType::Reg; }
     ;
 
 non_integer_type
-    : K_REAL                                                        { }
-    | K_REALTIME                                                    { }
-    | K_SHORTINT                                                    { }
+    : K_REAL
+        { $$ = AstDataType::Real; }
+    | K_REALTIME
+        { $$ = AstDataType::Real; }
+    | K_SHORTINT
+        { $$ = AstDataType::ShortInt; }
     ;
 
 opt_packed
@@ -459,80 +715,143 @@ opt_packed
 
 opt_signedness
     : %empty                                                        { }
-    | K_SIGNED                                                      { }
-    | K_UNSIGNED                                                    { }
+    | K_SIGNED
+        { $$ = AstFlags::Signed; }
+    | K_UNSIGNED
+        { $$ = AstFlags::Unsigned; }
     ;
 
 opt_packed_dim_list
     : %empty                                                        { }
-    | packed_dim_list                                               { }
+    | packed_dim_list                                               { $$ = $1; }
     ;
 
 packed_dim_list
-    : packed_dim                                                    { }
-    | packed_dim_list packed_dim                                    { }
+    : packed_dim
+        { $$ = AST->makeList($1); }
+    | packed_dim_list packed_dim
+        {
+            $$ = $1;
+            AST->append($$, $2);
+        }
     ;
 
 packed_dim
-    : range                                                         { }
+    : range                                                         { $$ = $1; }
     ;
 
 opt_unpacked_dim_list
     : %empty                                                        { }
-    | unpacked_dim_list                                             { }
+    | unpacked_dim_list                                             { $$ = $1; }
     ;
 
 unpacked_dim_list
-    : unpacked_dim                                                  { }
-    | unpacked_dim_list unpacked_dim                                { }
+    : unpacked_dim
+        { $$ = AST->makeList($1); }
+    | unpacked_dim_list unpacked_dim
+        {
+            $$ = $1;
+            AST->append($$, $2);
+        }
     ;
 
 unpacked_dim
-    : LBRACK expression RBRACK                                      { }
-    | LBRACK expression COLON expression RBRACK                     { }
+    : LBRACK expression RBRACK
+        {
+            $$ = AST->addNode(AstKind::Range, LINE(@1));
+            AST->addChild($$, $2);
+        }
+    | LBRACK expression COLON expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::Range, $2, $4, NULL_AST_NODE,
+                LINE(@1));
+        }
     ;
 
 
+// An enum without a base type is an int.
 opt_enum_base
-    : %empty                                                        { }
-    | integer_atom_type opt_signedness                              { }
-    | integer_vector_type opt_signedness opt_packed_dim_list        { }
+    : %empty
+        { $$ = makeType(AstDataType::Int, 0); }
+    | integer_atom_type opt_signedness
+        { $$ = makeType($1, $2); }
+    | integer_vector_type opt_signedness opt_packed_dim_list
+        { $$ = makeType($1, $2, $3); }
     ;
 
 enum_member_list
-    : enum_member                                                   { }
-    | enum_member_list COMMA enum_member                            { }
+    : enum_member
+        { $$ = AST->makeList($1); }
+    | enum_member_list COMMA enum_member
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
+// Ranges of enum names (`A[3]`) are accepted but not expanded.
 enum_member
-    : IDENTIFIER                                                    { }
-    | IDENTIFIER ASSIGN expression                                  { }
-    | IDENTIFIER LBRACK expression RBRACK                           { }
-    | IDENTIFIER LBRACK expression COLON expression RBRACK          { }
-    | IDENTIFIER LBRACK expression RBRACK ASSIGN expression         { }
+    : IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::EnumItem, $1, LINE(@1));
+        }
+    | IDENTIFIER ASSIGN expression
+        {
+            $$ = AST->addNamedNode(AstKind::EnumItem, $1, LINE(@1));
+            AST->addChild($$, $3);
+        }
+    | IDENTIFIER LBRACK expression RBRACK
+        {
+            $$ = AST->addNamedNode(AstKind::EnumItem, $1, LINE(@1));
+        }
+    | IDENTIFIER LBRACK expression COLON expression RBRACK
+        {
+            $$ = AST->addNamedNode(AstKind::EnumItem, $1, LINE(@1));
+        }
+    | IDENTIFIER LBRACK expression RBRACK ASSIGN expression
+        {
+            $$ = AST->addNamedNode(AstKind::EnumItem, $1, LINE(@1));
+            AST->addChild($$, $6);
+        }
     ;
 
 struct_member_list
-    : struct_member                                                 { }
-    | struct_member_list struct_member                              { }
+    : struct_member
+        { $$ = AST->makeList($1); }
+    | struct_member_list struct_member
+        {
+            $$ = $1;
+            AST->append($$, $2);
+        }
     ;
 
 struct_member
-    : data_type_or_user identifier_list SEMI                        { }
+    : data_type_or_user identifier_list SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl, $1, $2, LINE(@2));
+        }
     ;
 
 // ============================================================
 // SV data declaration: `logic [W-1:0] x;`, `int x = 0;`, etc.
 // ============================================================
 sv_data_declaration
-    : opt_const opt_var_lifetime data_type list_of_var_decl_assignments SEMI  { }
+    : opt_const opt_var_lifetime data_type list_of_var_decl_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl, $3, $4, LINE(@3));
+            AST->addFlags($$, $1);
+        }
     | K_VAR opt_var_lifetime data_type_or_implicit
-        list_of_var_decl_assignments SEMI                           { }
+        list_of_var_decl_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl, $3, $4, LINE(@1));
+        }
     ;
 
 opt_const
     : %empty                                                        { }
-    | K_CONST                                                       { }
+    | K_CONST
+        { $$ = AstFlags::Const; }
     ;
 
 opt_var_lifetime
@@ -542,8 +861,12 @@ opt_var_lifetime
     ;
 
 data_type_or_implicit
-    : data_type                                                     { }
-    | opt_signedness opt_packed_dim_list                            { }
+    : data_type                                                     { $$ = $1; }
+    | opt_signedness opt_packed_dim_list
+        {
+            $$.flags = $1;
+            $$.dims = $2;
+        }
     ;
 
 // ============================================================
@@ -553,17 +876,28 @@ module_declaration
     : module_keyword IDENTIFIER opt_module_imports
         opt_module_parameter_port_list
         opt_list_of_ports SEMI module_item_list_opt
-        K_ENDMODULE opt_endlabel                                { }
+        K_ENDMODULE opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Module, $2, LINE(@1));
+            AST->addChildren($$, $3);
+            AST->addChildren($$, $4);
+            AST->addChildren($$, $5);
+            AST->addChildren($$, $7);
+        }
     ;
 
 opt_module_imports
     : %empty                                                    { }
-    | module_imports                                            { }
+    | module_imports                                            { $$ = $1; }
     ;
 
 module_imports
-    : sv_package_import_declaration                             { }
-    | module_imports sv_package_import_declaration              { }
+    : sv_package_import_declaration                             { $$ = $1; }
+    | module_imports sv_package_import_declaration
+        {
+            $$ = $1;
+            AST->concat($$, $2);
+        }
     ;
 
 module_keyword
@@ -573,12 +907,17 @@ module_keyword
 
 opt_module_parameter_port_list
     : %empty                                                      { }
-    | HASH LPAREN module_parameter_port_decls RPAREN              { }
+    | HASH LPAREN module_parameter_port_decls RPAREN              { $$ = $3; }
     ;
 
 module_parameter_port_decls
-    : module_parameter_port_decl                                  { }
-    | module_parameter_port_decls COMMA module_parameter_port_decl { }
+    : module_parameter_port_decl
+        { $$ = AST->makeList($1); }
+    | module_parameter_port_decls COMMA module_parameter_port_decl
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 // Module-port parameter declaration. The IDENTIFIER alternative
@@ -588,49 +927,118 @@ module_parameter_port_decls
 // the first IDENTIFIER: ASSIGN means bare, another IDENTIFIER means
 // type-then-name.
 module_parameter_port_decl
-    : K_PARAMETER opt_param_type_or_range param_assignment        { }
-    | K_PARAMETER sv_param_data_type param_assignment             { }
-    | K_PARAMETER K_TYPE param_type_assignment                    { }
-    | K_PARAMETER IDENTIFIER mp_after_param_ident                 { }
-    | sv_param_data_type param_assignment                         { }
-    | param_assignment                                            { }
+    : K_PARAMETER opt_param_type_or_range param_assignment
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $2, AST->makeList($3),
+                LINE(@1));
+            AST->addFlags($$, AstFlags::Header);
+        }
+    | K_PARAMETER sv_param_data_type param_assignment
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $2, AST->makeList($3),
+                LINE(@1));
+            AST->addFlags($$, AstFlags::Header);
+        }
+    | K_PARAMETER K_TYPE param_type_assignment
+        {
+            AstTypeSpec type;
+            type.type = AstDataType::Type;
+            $$ = AST->addDecl(AstKind::ParamDecl, type, AST->makeList($3),
+                LINE(@1));
+            AST->addFlags($$, AstFlags::Header);
+        }
+    | K_PARAMETER IDENTIFIER mp_after_param_ident
+        {
+            $$ = $3;
+            nameLeadingIdent(AST, $$, $2);
+            AST->addFlags($$, AstFlags::Header);
+        }
+    | sv_param_data_type param_assignment
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $1, AST->makeList($2),
+                LINE(@1));
+            AST->addFlags($$, AstFlags::Header);
+        }
+    | param_assignment
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, AstTypeSpec(),
+                AST->makeList($1), LINE(@1));
+            AST->addFlags($$, AstFlags::Header);
+        }
     ;
 
 mp_after_param_ident
-    : opt_unpacked_dim_list ASSIGN expression                     { }
+    : opt_unpacked_dim_list ASSIGN expression
+        {
+            const AstNodeID decl = AST->addDeclarator(NULL_SYMBOL, $1, $3,
+                LINE(@2));
+            $$ = AST->addDecl(AstKind::ParamDecl, AstTypeSpec(),
+                AST->makeList(decl), LINE(@2));
+        }
     | opt_packed_dim_list IDENTIFIER opt_unpacked_dim_list
-        ASSIGN expression                                         { }
+        ASSIGN expression
+        {
+            const AstNodeID decl = AST->addDeclarator($2, $3, $5, LINE(@2));
+            $$ = AST->addDecl(AstKind::ParamDecl,
+                makeType(AstDataType::User, 0, $1), AST->makeList(decl),
+                LINE(@2));
+        }
     ;
 
 sv_param_data_type
-    : K_LOGIC opt_signedness opt_packed_dim_list                  { }
-    | K_BIT opt_signedness opt_packed_dim_list                    { }
-    | K_BYTE opt_signedness                                       { }
-    | K_INT opt_signedness                                        { }
-    | K_LONGINT opt_signedness                                    { }
-    | K_SHORTINT opt_signedness                                   { }
-    | K_INTEGER opt_signedness                                    { }
-    | K_TIME                                                      { }
-    | K_REAL                                                      { }
-    | K_REALTIME                                                  { }
-    | K_STRING                                                    { }
-    | SCOPED_NAME_HEAD IDENTIFIER opt_packed_dim_list             { }
+    : K_LOGIC opt_signedness opt_packed_dim_list
+        { $$ = makeType(AstDataType::Logic, $2, $3); }
+    | K_BIT opt_signedness opt_packed_dim_list
+        { $$ = makeType(AstDataType::Bit, $2, $3); }
+    | K_BYTE opt_signedness
+        { $$ = makeType(AstDataType::Byte, $2); }
+    | K_INT opt_signedness
+        { $$ = makeType(AstDataType::Int, $2); }
+    | K_LONGINT opt_signedness
+        { $$ = makeType(AstDataType::LongInt, $2); }
+    | K_SHORTINT opt_signedness
+        { $$ = makeType(AstDataType::ShortInt, $2); }
+    | K_INTEGER opt_signedness
+        { $$ = makeType(AstDataType::Integer, $2); }
+    | K_TIME
+        { $$.type = AstDataType::Time; }
+    | K_REAL
+        { $$.type = AstDataType::Real; }
+    | K_REALTIME
+        { $$.type = AstDataType::Real; }
+    | K_STRING
+        { $$.type = AstDataType::String; }
+    | SCOPED_NAME_HEAD IDENTIFIER opt_packed_dim_list
+        {
+            $$ = makeType(AstDataType::User, 0, $3);
+            $$.userType = $2;
+        }
     ;
 
 param_type_assignment
-    : IDENTIFIER ASSIGN data_type                                 { }
-    | IDENTIFIER                                                  { }
+    : IDENTIFIER ASSIGN data_type
+        {
+            $$ = AST->addDeclarator($1, AstList(), NULL_AST_NODE, LINE(@1));
+        }
+    | IDENTIFIER
+        {
+            $$ = AST->addDeclarator($1, AstList(), NULL_AST_NODE, LINE(@1));
+        }
     ;
 
 opt_list_of_ports
     : %empty                              { }
     | LPAREN RPAREN                       { }
-    | LPAREN port_list RPAREN             { }
+    | LPAREN port_list RPAREN             { $$ = $2; }
     ;
 
 port_list
-    : port_item                           { }
-    | port_list COMMA port_item           { }
+    : port_item                           { $$ = AST->makeList($1); }
+    | port_list COMMA port_item
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 // `port_item` accepts the four major shapes:
@@ -642,27 +1050,76 @@ port_list
 //      or `output crash_dump_t crash_dump_o` (unscoped user type
 //      then name). Disambiguated via `port_after_dir_ident_tail`.
 port_item
-    : port_reference_or_named             { }
-    | port_direction port_typed_classic_form                        { }
-    | port_direction sv_port_data_type IDENTIFIER opt_unpacked_dim_list { }
+    : port_reference_or_named             { $$ = $1; }
+    | port_direction port_typed_classic_form
+        {
+            $$ = $2;
+            AST->addFlags($$, $1);
+        }
     | port_direction sv_port_data_type IDENTIFIER opt_unpacked_dim_list
-        ASSIGN expression                                            { }
-    | port_direction IDENTIFIER port_after_dir_ident_tail           { }
+        {
+            const AstNodeID decl = AST->addDeclarator($3, $4,
+                NULL_AST_NODE, LINE(@3));
+            $$ = AST->addDecl(AstKind::PortDecl, $2, AST->makeList(decl),
+                LINE(@1));
+            AST->addFlags($$, $1);
+        }
+    | port_direction sv_port_data_type IDENTIFIER opt_unpacked_dim_list
+        ASSIGN expression
+        {
+            const AstNodeID decl = AST->addDeclarator($3, $4, $6, LINE(@3));
+            $$ = AST->addDecl(AstKind::PortDecl, $2, AST->makeList(decl),
+                LINE(@1));
+            AST->addFlags($$, $1);
+        }
+    | port_direction IDENTIFIER port_after_dir_ident_tail
+        {
+            $$ = $3;
+            nameLeadingIdent(AST, $$, $2);
+            AST->addFlags($$, $1);
+        }
     ;
 
 // Classic Verilog-2001 typed forms — start with a net_type, K_REG,
 // K_SIGNED, or a `range`. Empty form is intentionally NOT here; it
 // is handled via the IDENTIFIER alternative of `port_item`.
 port_typed_classic_form
-    : net_type opt_signed opt_range IDENTIFIER opt_port_init        { }
-    | K_REG opt_signed opt_range IDENTIFIER opt_port_init           { }
-    | K_SIGNED opt_range IDENTIFIER opt_port_init                   { }
-    | range IDENTIFIER opt_port_init                                { }
+    : net_type opt_signed opt_range IDENTIFIER opt_port_init
+        {
+            const AstNodeID decl = AST->addDeclarator($4, AstList(), $5,
+                LINE(@4));
+            $$ = AST->addDecl(AstKind::PortDecl, makeType($1, $2, $3),
+                AST->makeList(decl), LINE(@1));
+        }
+    | K_REG opt_signed opt_range IDENTIFIER opt_port_init
+        {
+            const AstNodeID decl = AST->addDeclarator($4, AstList(), $5,
+                LINE(@4));
+            $$ = AST->addDecl(AstKind::PortDecl,
+                makeType(AstDataType::Reg, $2, $3), AST->makeList(decl),
+                LINE(@1));
+        }
+    | K_SIGNED opt_range IDENTIFIER opt_port_init
+        {
+            const AstNodeID decl = AST->addDeclarator($3, AstList(), $4,
+                LINE(@3));
+            $$ = AST->addDecl(AstKind::PortDecl,
+                makeType(AstDataType::Implicit, AstFlags::Signed, $2),
+                AST->makeList(decl), LINE(@1));
+        }
+    | range IDENTIFIER opt_port_init
+        {
+            const AstNodeID decl = AST->addDeclarator($2, AstList(), $3,
+                LINE(@2));
+            $$ = AST->addDecl(AstKind::PortDecl,
+                makeType(AstDataType::Implicit, 0, $1),
+                AST->makeList(decl), LINE(@1));
+        }
     ;
 
 opt_port_init
     : %empty                                                        { }
-    | ASSIGN expression                                             { }
+    | ASSIGN expression                                             { $$ = $2; }
     ;
 
 // What follows `port_direction IDENTIFIER`. If the next token is
@@ -671,9 +1128,21 @@ opt_port_init
 // dims and then an IDENTIFIER), the first IDENTIFIER was an
 // unscoped user type and the next is the port name.
 port_after_dir_ident_tail
-    : opt_unpacked_dim_list opt_port_init                           { }
+    : opt_unpacked_dim_list opt_port_init
+        {
+            const AstNodeID decl = AST->addDeclarator(NULL_SYMBOL, $1, $2,
+                LINE(@$));
+            $$ = AST->addDecl(AstKind::PortDecl, AstTypeSpec(),
+                AST->makeList(decl), LINE(@$));
+        }
     | opt_packed_dim_list IDENTIFIER opt_unpacked_dim_list
-        opt_port_init                                               { }
+        opt_port_init
+        {
+            const AstNodeID decl = AST->addDeclarator($2, $3, $4, LINE(@2));
+            $$ = AST->addDecl(AstKind::PortDecl,
+                makeType(AstDataType::User, 0, $1), AST->makeList(decl),
+                LINE(@2));
+        }
     ;
 
 // SV port data types — keyword-prefixed only. The classic
@@ -685,65 +1154,104 @@ port_after_dir_ident_tail
 // IDENTIFIER is the port name or the start of a scoped type) and
 // regresses Verilog-2001 inputs.
 sv_port_data_type
-    : K_LOGIC opt_signedness opt_packed_dim_list                    { }
-    | K_BIT opt_signedness opt_packed_dim_list                      { }
-    | K_BYTE opt_signedness                                         { }
-    | K_INT opt_signedness                                          { }
-    | K_LONGINT opt_signedness                                      { }
-    | K_SHORTINT opt_signedness                                     { }
-    | K_REAL                                                        { }
-    | K_REALTIME                                                    { }
-    | K_STRING                                                      { }
-    | SCOPED_NAME_HEAD IDENTIFIER opt_packed_dim_list               { }
+    : K_LOGIC opt_signedness opt_packed_dim_list
+        { $$ = makeType(AstDataType::Logic, $2, $3); }
+    | K_BIT opt_signedness opt_packed_dim_list
+        { $$ = makeType(AstDataType::Bit, $2, $3); }
+    | K_BYTE opt_signedness
+        { $$ = makeType(AstDataType::Byte, $2); }
+    | K_INT opt_signedness
+        { $$ = makeType(AstDataType::Int, $2); }
+    | K_LONGINT opt_signedness
+        { $$ = makeType(AstDataType::LongInt, $2); }
+    | K_SHORTINT opt_signedness
+        { $$ = makeType(AstDataType::ShortInt, $2); }
+    | K_REAL
+        { $$.type = AstDataType::Real; }
+    | K_REALTIME
+        { $$.type = AstDataType::Real; }
+    | K_STRING
+        { $$.type = AstDataType::String; }
+    | SCOPED_NAME_HEAD IDENTIFIER opt_packed_dim_list
+        {
+            $$ = makeType(AstDataType::User, 0, $3);
+            $$.userType = $2;
+        }
     ;
 
 port_reference_or_named
-    : IDENTIFIER                                                  { }
-    | IDENTIFIER LBRACK expression RBRACK                         { }
-    | IDENTIFIER LBRACK expression COLON expression RBRACK        { }
-    | DOT IDENTIFIER LPAREN RPAREN                                { }
-    | DOT IDENTIFIER LPAREN expression RPAREN                     { }
+    : IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::PortRef, $1, LINE(@1));
+        }
+    | IDENTIFIER LBRACK expression RBRACK
+        {
+            $$ = AST->addNamedNode(AstKind::PortRef, $1, LINE(@1));
+            AST->addChild($$, AST->addTernary(AstKind::Range, $3,
+                NULL_AST_NODE, NULL_AST_NODE, LINE(@2)));
+        }
+    | IDENTIFIER LBRACK expression COLON expression RBRACK
+        {
+            $$ = AST->addNamedNode(AstKind::PortRef, $1, LINE(@1));
+            AST->addChild($$, AST->addTernary(AstKind::Range, $3, $5,
+                NULL_AST_NODE, LINE(@2)));
+        }
+    | DOT IDENTIFIER LPAREN RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::PortRef, $2, LINE(@1));
+            AST->addFlags($$, AstFlags::Named);
+        }
+    | DOT IDENTIFIER LPAREN expression RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::PortRef, $2, LINE(@1));
+            AST->addFlags($$, AstFlags::Named);
+            AST->addChild($$, $4);
+        }
     ;
 
 port_direction
-    : K_INPUT                             { }
-    | K_OUTPUT                            { }
-    | K_INOUT                             { }
+    : K_INPUT                             { $$ = AstFlags::Input; }
+    | K_OUTPUT                            { $$ = AstFlags::Output; }
+    | K_INOUT                             { $$ = AstFlags::Inout; }
     ;
 
 opt_net_or_reg
     : %empty                              { }
-    | net_type                            { }
-    | K_REG                               { }
+    | net_type                            { $$ = $1; }
+    | K_REG                               { $$ = AstDataType::Reg; }
     ;
 
 net_type
-    : K_WIRE                              { }
-    | K_TRI                               { }
-    | K_TRI0                              { }
-    | K_TRI1                              { }
-    | K_TRIAND                            { }
-    | K_TRIOR                             { }
-    | K_TRIREG                            { }
-    | K_WAND                              { }
-    | K_WOR                               { }
-    | K_UWIRE                             { }
-    | K_SUPPLY0                           { }
-    | K_SUPPLY1                           { }
+    : K_WIRE                              { $$ = AstDataType::Wire; }
+    | K_TRI                               { $$ = AstDataType::Wire; }
+    | K_TRI0                              { $$ = AstDataType::Wire; }
+    | K_TRI1                              { $$ = AstDataType::Wire; }
+    | K_TRIAND                            { $$ = AstDataType::Wand; }
+    | K_TRIOR                             { $$ = AstDataType::Wor; }
+    | K_TRIREG                            { $$ = AstDataType::Wire; }
+    | K_WAND                              { $$ = AstDataType::Wand; }
+    | K_WOR                               { $$ = AstDataType::Wor; }
+    | K_UWIRE                             { $$ = AstDataType::Wire; }
+    | K_SUPPLY0                           { $$ = AstDataType::Supply0; }
+    | K_SUPPLY1                           { $$ = AstDataType::Supply1; }
     ;
 
 opt_signed
     : %empty                              { }
-    | K_SIGNED                            { }
+    | K_SIGNED                            { $$ = AstFlags::Signed; }
     ;
 
 opt_range
     : %empty                              { }
-    | range                               { }
+    | range                               { $$ = $1; }
     ;
 
 range
-    : LBRACK expression COLON expression RBRACK   { }
+    : LBRACK expression COLON expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::Range, $2, $4, NULL_AST_NODE,
+                LINE(@1));
+        }
     ;
 
 // ============================================================
@@ -751,12 +1259,16 @@ range
 // ============================================================
 module_item_list_opt
     : %empty                              { }
-    | module_item_list                    { }
+    | module_item_list                    { $$ = $1; }
     ;
 
 module_item_list
-    : module_item                         { }
-    | module_item_list module_item        { }
+    : module_item                         { $$ = $1; }
+    | module_item_list module_item
+        {
+            $$ = $1;
+            AST->concat($$, $2);
+        }
     ;
 
 // `module_item` factors out two MACRO_REF positions that would
@@ -772,36 +1284,36 @@ module_item_list
 //   MACRO_REF IDENTIFIER... → gate_or_module_instantiation
 //   MACRO_REF MACRO_REF ... → another decoration in the chain
 module_item
-    : actual_module_item                              { }
-    | macro_decorations actual_module_item            { }
-    | gate_or_module_instantiation                    { }
-    | conditional_generate_construct                  { }
-    | loop_generate_construct                         { }
-    | case_generate_construct                         { }
+    : actual_module_item                              { $$ = $1; }
+    | macro_decorations actual_module_item            { $$ = $2; }
+    | gate_or_module_instantiation                    { $$ = $1; }
+    | conditional_generate_construct                  { $$ = AST->makeList($1); }
+    | loop_generate_construct                         { $$ = AST->makeList($1); }
+    | case_generate_construct                         { $$ = AST->makeList($1); }
     ;
 
 actual_module_item
-    : port_decl_stmt                      { }
-    | net_declaration                     { }
-    | reg_declaration                     { }
-    | integer_declaration                 { }
-    | real_declaration                    { }
-    | time_declaration                    { }
-    | event_declaration                   { }
-    | genvar_declaration                  { }
-    | parameter_declaration               { }
-    | localparam_declaration              { }
-    | continuous_assign                   { }
-    | always_construct                    { }
-    | initial_construct                   { }
-    | final_construct                     { }
-    | function_declaration                { }
-    | task_declaration                    { }
-    | generate_construct                  { }
-    | defparam_statement                  { }
-    | sv_data_declaration                 { }
-    | sv_typedef_declaration              { }
-    | sv_package_import_declaration       { }
+    : port_decl_stmt                      { $$ = AST->makeList($1); }
+    | net_declaration                     { $$ = AST->makeList($1); }
+    | reg_declaration                     { $$ = AST->makeList($1); }
+    | integer_declaration                 { $$ = AST->makeList($1); }
+    | real_declaration                    { $$ = AST->makeList($1); }
+    | time_declaration                    { $$ = AST->makeList($1); }
+    | event_declaration                   { $$ = AST->makeList($1); }
+    | genvar_declaration                  { $$ = AST->makeList($1); }
+    | parameter_declaration               { $$ = AST->makeList($1); }
+    | localparam_declaration              { $$ = AST->makeList($1); }
+    | continuous_assign                   { $$ = $1; }
+    | always_construct                    { $$ = AST->makeList($1); }
+    | initial_construct                   { $$ = AST->makeList($1); }
+    | final_construct                     { $$ = AST->makeList($1); }
+    | function_declaration                { $$ = AST->makeList($1); }
+    | task_declaration                    { $$ = AST->makeList($1); }
+    | generate_construct                  { $$ = $1; }
+    | defparam_statement                  { $$ = $1; }
+    | sv_data_declaration                 { $$ = AST->makeList($1); }
+    | sv_typedef_declaration              { $$ = AST->makeList($1); }
+    | sv_package_import_declaration       { $$ = $1; }
     | system_task_enable                  { }
     | dpi_export_declaration              { }
     ;
@@ -812,7 +1324,10 @@ dpi_export_declaration
     ;
 
 final_construct
-    : K_FINAL statement                                             { }
+    : K_FINAL statement
+        {
+            $$ = AST->addNode(AstKind::Final, LINE(@1));
+        }
     ;
 
 macro_decorations
@@ -825,46 +1340,101 @@ macro_decorations
 // ============================================================
 conditional_generate_construct
     : K_IF LPAREN expression RPAREN generate_block_or_null
-        %prec IF_NO_ELSE                                            { }
+        %prec IF_NO_ELSE
+        {
+            $$ = AST->addTernary(AstKind::GenerateIf, $3, $5,
+                NULL_AST_NODE, LINE(@1));
+        }
     | K_IF LPAREN expression RPAREN generate_block_or_null
-        K_ELSE generate_block_or_null                               { }
+        K_ELSE generate_block_or_null
+        {
+            $$ = AST->addTernary(AstKind::GenerateIf, $3, $5, $7, LINE(@1));
+        }
     ;
 
 loop_generate_construct
     : K_FOR LPAREN for_init SEMI expression SEMI
-            for_step RPAREN generate_block                          { }
+            for_step RPAREN generate_block
+        {
+            $$ = AST->addTernary(AstKind::GenerateFor, $3, $5, $7, LINE(@1));
+            AST->addChild($$, $9);
+        }
     ;
 
 case_generate_construct
     : K_CASE LPAREN expression RPAREN generate_case_items
-        K_ENDCASE                                                   { }
+        K_ENDCASE
+        {
+            $$ = AST->addNode(AstKind::GenerateCase, LINE(@1));
+            AST->addChild($$, $3);
+            AST->addChildren($$, $5);
+        }
     ;
 
 generate_case_items
-    : generate_case_item                                            { }
-    | generate_case_items generate_case_item                        { }
+    : generate_case_item
+        { $$ = AST->makeList($1); }
+    | generate_case_items generate_case_item
+        {
+            $$ = $1;
+            AST->append($$, $2);
+        }
     ;
 
 generate_case_item
-    : expression_list COLON generate_block_or_null                  { }
-    | K_DEFAULT COLON generate_block_or_null                        { }
-    | K_DEFAULT generate_block_or_null                              { }
+    : expression_list COLON generate_block_or_null
+        {
+            $$ = AST->addNode(AstKind::GenerateCaseItem, LINE(@1));
+            AST->addChildren($$, $1);
+            AST->addChild($$, $3);
+        }
+    | K_DEFAULT COLON generate_block_or_null
+        {
+            $$ = AST->addNode(AstKind::GenerateCaseItem, LINE(@1));
+            AST->addFlags($$, AstFlags::Default);
+            AST->addChild($$, $3);
+        }
+    | K_DEFAULT generate_block_or_null
+        {
+            $$ = AST->addNode(AstKind::GenerateCaseItem, LINE(@1));
+            AST->addFlags($$, AstFlags::Default);
+            AST->addChild($$, $2);
+        }
     ;
 
 generate_block_or_null
-    : SEMI                                                          { }
-    | generate_block                                                { }
+    : SEMI
+        {
+            $$ = AST->addNode(AstKind::GenerateBlock, LINE(@1));
+        }
+    | generate_block                                                { $$ = $1; }
     ;
 
 generate_block
-    : K_BEGIN generate_block_items K_END opt_endlabel               { }
-    | K_BEGIN COLON IDENTIFIER generate_block_items K_END opt_endlabel { }
-    | module_item                                                   { }
+    : K_BEGIN generate_block_items K_END opt_endlabel
+        {
+            $$ = AST->addNode(AstKind::GenerateBlock, LINE(@1));
+            AST->addChildren($$, $2);
+        }
+    | K_BEGIN COLON IDENTIFIER generate_block_items K_END opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::GenerateBlock, $3, LINE(@1));
+            AST->addChildren($$, $4);
+        }
+    | module_item
+        {
+            $$ = AST->addNode(AstKind::GenerateBlock, LINE(@1));
+            AST->addChildren($$, $1);
+        }
     ;
 
 generate_block_items
     : %empty                                                        { }
-    | generate_block_items module_item                              { }
+    | generate_block_items module_item
+        {
+            $$ = $1;
+            AST->concat($$, $2);
+        }
     ;
 
 // ============================================================
@@ -872,77 +1442,169 @@ generate_block_items
 // ============================================================
 port_decl_stmt
     : port_direction opt_net_or_reg opt_signed opt_range
-        identifier_list SEMI                                      { }
+        identifier_list SEMI
+        {
+            $$ = AST->addDecl(AstKind::PortDecl, makeType($2, $3, $4), $5,
+                LINE(@1));
+            AST->addFlags($$, $1);
+        }
     ;
 
 net_declaration
     : net_type opt_signed opt_range list_of_net_decl_assignments
-        SEMI                                                      { }
+        SEMI
+        {
+            $$ = AST->addDecl(AstKind::NetDecl, makeType($1, $2, $3), $4,
+                LINE(@1));
+        }
     ;
 
 list_of_net_decl_assignments
-    : net_decl_assignment_or_id                                   { }
-    | list_of_net_decl_assignments COMMA net_decl_assignment_or_id  { }
+    : net_decl_assignment_or_id
+        { $$ = AST->makeList($1); }
+    | list_of_net_decl_assignments COMMA net_decl_assignment_or_id
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 net_decl_assignment_or_id
-    : IDENTIFIER opt_range_or_dimensions                          { }
-    | IDENTIFIER ASSIGN expression                                { }
+    : IDENTIFIER opt_range_or_dimensions
+        {
+            $$ = AST->addDeclarator($1, AST->makeList($2), NULL_AST_NODE,
+                LINE(@1));
+        }
+    | IDENTIFIER ASSIGN expression
+        {
+            $$ = AST->addDeclarator($1, AstList(), $3, LINE(@1));
+        }
     ;
 
 opt_range_or_dimensions
     : %empty                                                      { }
-    | range                                                       { }
+    | range                                                       { $$ = $1; }
     ;
 
 reg_declaration
     : K_REG opt_signed opt_range list_of_var_decl_assignments
-        SEMI                                                      { }
+        SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl,
+                makeType(AstDataType::Reg, $2, $3), $4, LINE(@1));
+        }
     ;
 
 list_of_var_decl_assignments
-    : var_decl_assignment                                         { }
-    | list_of_var_decl_assignments COMMA var_decl_assignment      { }
+    : var_decl_assignment
+        { $$ = AST->makeList($1); }
+    | list_of_var_decl_assignments COMMA var_decl_assignment
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 var_decl_assignment
-    : IDENTIFIER opt_unpacked_dim_list                            { }
-    | IDENTIFIER opt_unpacked_dim_list ASSIGN expression          { }
+    : IDENTIFIER opt_unpacked_dim_list
+        {
+            $$ = AST->addDeclarator($1, $2, NULL_AST_NODE, LINE(@1));
+        }
+    | IDENTIFIER opt_unpacked_dim_list ASSIGN expression
+        {
+            $$ = AST->addDeclarator($1, $2, $4, LINE(@1));
+        }
     ;
 
 integer_declaration
-    : K_INTEGER list_of_var_decl_assignments SEMI                 { }
+    : K_INTEGER list_of_var_decl_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl,
+                makeType(AstDataType::Integer, 0), $2, LINE(@1));
+        }
     ;
 
 real_declaration
-    : K_REAL list_of_var_decl_assignments SEMI                    { }
-    | K_REALTIME list_of_var_decl_assignments SEMI                { }
+    : K_REAL list_of_var_decl_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl,
+                makeType(AstDataType::Real, 0), $2, LINE(@1));
+        }
+    | K_REALTIME list_of_var_decl_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl,
+                makeType(AstDataType::Real, 0), $2, LINE(@1));
+        }
     ;
 
 time_declaration
-    : K_TIME list_of_var_decl_assignments SEMI                    { }
+    : K_TIME list_of_var_decl_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl,
+                makeType(AstDataType::Time, 0), $2, LINE(@1));
+        }
     ;
 
 event_declaration
-    : K_EVENT identifier_list SEMI                                { }
+    : K_EVENT identifier_list SEMI
+        {
+            $$ = AST->addDecl(AstKind::VarDecl,
+                makeType(AstDataType::Event, 0), $2, LINE(@1));
+        }
     ;
 
 genvar_declaration
-    : K_GENVAR identifier_list SEMI                               { }
+    : K_GENVAR identifier_list SEMI
+        {
+            $$ = AST->addDecl(AstKind::GenvarDecl, AstTypeSpec(), $2,
+                LINE(@1));
+        }
     ;
 
 parameter_declaration
-    : K_PARAMETER opt_param_type_or_range param_assignments SEMI  { }
-    | K_PARAMETER sv_param_data_type param_assignments SEMI       { }
-    | K_PARAMETER K_TYPE param_type_assignments SEMI              { }
-    | K_PARAMETER IDENTIFIER pdecl_after_param_ident SEMI         { }
+    : K_PARAMETER opt_param_type_or_range param_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $2, $3, LINE(@1));
+        }
+    | K_PARAMETER sv_param_data_type param_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $2, $3, LINE(@1));
+        }
+    | K_PARAMETER K_TYPE param_type_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl,
+                makeType(AstDataType::Type, 0), $3, LINE(@1));
+        }
+    | K_PARAMETER IDENTIFIER pdecl_after_param_ident SEMI
+        {
+            $$ = $3;
+            nameLeadingIdent(AST, $$, $2);
+        }
     ;
 
 localparam_declaration
-    : K_LOCALPARAM opt_param_type_or_range param_assignments SEMI { }
-    | K_LOCALPARAM sv_param_data_type param_assignments SEMI      { }
-    | K_LOCALPARAM K_TYPE param_type_assignments SEMI             { }
-    | K_LOCALPARAM IDENTIFIER pdecl_after_param_ident SEMI        { }
+    : K_LOCALPARAM opt_param_type_or_range param_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $2, $3, LINE(@1));
+            AST->addFlags($$, AstFlags::Local);
+        }
+    | K_LOCALPARAM sv_param_data_type param_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl, $2, $3, LINE(@1));
+            AST->addFlags($$, AstFlags::Local);
+        }
+    | K_LOCALPARAM K_TYPE param_type_assignments SEMI
+        {
+            $$ = AST->addDecl(AstKind::ParamDecl,
+                makeType(AstDataType::Type, 0), $3, LINE(@1));
+            AST->addFlags($$, AstFlags::Local);
+        }
+    | K_LOCALPARAM IDENTIFIER pdecl_after_param_ident SEMI
+        {
+            $$ = $3;
+            nameLeadingIdent(AST, $$, $2);
+            AST->addFlags($$, AstFlags::Local);
+        }
     ;
 
 // Same disambiguation pattern as `mp_after_param_ident` but for
@@ -950,91 +1612,154 @@ localparam_declaration
 // comma-separated list of assignments rather than just one.
 pdecl_after_param_ident
     : opt_unpacked_dim_list ASSIGN expression
-        pdecl_more_param_assignments                              { }
+        pdecl_more_param_assignments
+        {
+            AstList decls = AST->makeList(
+                AST->addDeclarator(NULL_SYMBOL, $1, $3, LINE(@2)));
+            AST->concat(decls, $4);
+            $$ = AST->addDecl(AstKind::ParamDecl, AstTypeSpec(), decls,
+                LINE(@2));
+        }
     | opt_packed_dim_list IDENTIFIER opt_unpacked_dim_list
-        ASSIGN expression pdecl_more_param_assignments            { }
+        ASSIGN expression pdecl_more_param_assignments
+        {
+            AstList decls = AST->makeList(
+                AST->addDeclarator($2, $3, $5, LINE(@2)));
+            AST->concat(decls, $6);
+            $$ = AST->addDecl(AstKind::ParamDecl,
+                makeType(AstDataType::User, 0, $1), decls, LINE(@2));
+        }
     ;
 
 pdecl_more_param_assignments
     : %empty                                                      { }
-    | pdecl_more_param_assignments COMMA param_assignment         { }
+    | pdecl_more_param_assignments COMMA param_assignment
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 param_type_assignments
-    : param_type_assignment                                       { }
-    | param_type_assignments COMMA param_type_assignment          { }
+    : param_type_assignment
+        { $$ = AST->makeList($1); }
+    | param_type_assignments COMMA param_type_assignment
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 opt_param_type_or_range
     : %empty                              { }
-    | K_SIGNED                            { }
-    | K_INTEGER                           { }
-    | K_REAL                              { }
-    | K_REALTIME                          { }
-    | K_TIME                              { }
-    | range                               { }
-    | K_SIGNED range                      { }
+    | K_SIGNED                            { $$.flags = AstFlags::Signed; }
+    | K_INTEGER                           { $$.type = AstDataType::Integer; }
+    | K_REAL                              { $$.type = AstDataType::Real; }
+    | K_REALTIME                          { $$.type = AstDataType::Real; }
+    | K_TIME                              { $$.type = AstDataType::Time; }
+    | range                               { $$ = makeType(AstDataType::Implicit, 0, $1); }
+    | K_SIGNED range
+        {
+            $$ = makeType(AstDataType::Implicit, AstFlags::Signed, $2);
+        }
     ;
 
 param_assignments
-    : param_assignment                                  { }
-    | param_assignments COMMA param_assignment          { }
+    : param_assignment                                  { $$ = AST->makeList($1); }
+    | param_assignments COMMA param_assignment
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 param_assignment
-    : IDENTIFIER opt_unpacked_dim_list ASSIGN expression { }
+    : IDENTIFIER opt_unpacked_dim_list ASSIGN expression
+        {
+            $$ = AST->addDeclarator($1, $2, $4, LINE(@1));
+        }
     ;
 
 identifier_list
-    : IDENTIFIER                                        { }
-    | identifier_list COMMA IDENTIFIER                  { }
+    : IDENTIFIER
+        {
+            $$ = AST->makeList(AST->addDeclarator($1, AstList(),
+                NULL_AST_NODE, LINE(@1)));
+        }
+    | identifier_list COMMA IDENTIFIER
+        {
+            $$ = $1;
+            AST->append($$, AST->addDeclarator($3, AstList(),
+                NULL_AST_NODE, LINE(@3)));
+        }
     ;
 
 defparam_statement
-    : K_DEFPARAM defparam_assignments SEMI              { }
+    : K_DEFPARAM defparam_assignments SEMI              { $$ = $2; }
     ;
 
 defparam_assignments
-    : defparam_assign                                   { }
-    | defparam_assignments COMMA defparam_assign        { }
+    : defparam_assign                                   { $$ = AST->makeList($1); }
+    | defparam_assignments COMMA defparam_assign
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 defparam_assign
-    : hierarchical_identifier ASSIGN expression         { }
+    : hierarchical_identifier ASSIGN expression
+        {
+            $$ = AST->addTernary(AstKind::Defparam, $1, $3, NULL_AST_NODE,
+                LINE(@1));
+        }
     ;
 
 // ============================================================
 // Continuous assignments
 // ============================================================
 continuous_assign
-    : K_ASSIGN list_of_net_assignments SEMI             { }
+    : K_ASSIGN list_of_net_assignments SEMI             { $$ = $2; }
     ;
 
 list_of_net_assignments
-    : net_assignment                                    { }
-    | list_of_net_assignments COMMA net_assignment      { }
+    : net_assignment                                    { $$ = AST->makeList($1); }
+    | list_of_net_assignments COMMA net_assignment
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 net_assignment
-    : variable_lvalue ASSIGN expression                 { }
+    : variable_lvalue ASSIGN expression
+        {
+            $$ = AST->addTernary(AstKind::ContAssign, $1, $3, NULL_AST_NODE,
+                LINE(@1));
+        }
     ;
 
 // ============================================================
 // always / initial / generate
 // ============================================================
 always_construct
-    : K_ALWAYS statement                                { }
-    | K_ALWAYS_FF statement                             { }
-    | K_ALWAYS_COMB statement                           { }
-    | K_ALWAYS_LATCH statement                          { }
+    : K_ALWAYS statement
+        { $$ = AST->addNode(AstKind::Always, LINE(@1)); }
+    | K_ALWAYS_FF statement
+        { $$ = AST->addNode(AstKind::AlwaysFF, LINE(@1)); }
+    | K_ALWAYS_COMB statement
+        { $$ = AST->addNode(AstKind::AlwaysComb, LINE(@1)); }
+    | K_ALWAYS_LATCH statement
+        { $$ = AST->addNode(AstKind::AlwaysLatch, LINE(@1)); }
     ;
 
 initial_construct
-    : K_INITIAL statement                               { }
+    : K_INITIAL statement
+        { $$ = AST->addNode(AstKind::Initial, LINE(@1)); }
     ;
 
 generate_construct
-    : K_GENERATE module_item_list_opt K_ENDGENERATE     { }
+    : K_GENERATE module_item_list_opt K_ENDGENERATE     { $$ = $2; }
     ;
 
 // ============================================================
@@ -1043,15 +1768,24 @@ generate_construct
 function_declaration
     : K_FUNCTION opt_automatic opt_function_range_or_type
         IDENTIFIER SEMI function_item_decls statement_list_opt
-        K_ENDFUNCTION opt_endlabel                      { }
+        K_ENDFUNCTION opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Function, $4, LINE(@1));
+        }
     | K_FUNCTION opt_automatic opt_function_range_or_type
         IDENTIFIER LPAREN tf_port_list RPAREN SEMI
         function_item_decls_opt statement_list_opt
-        K_ENDFUNCTION opt_endlabel                      { }
+        K_ENDFUNCTION opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Function, $4, LINE(@1));
+        }
     | K_FUNCTION opt_automatic opt_function_range_or_type
         IDENTIFIER LPAREN RPAREN SEMI
         function_item_decls_opt statement_list_opt
-        K_ENDFUNCTION opt_endlabel                      { }
+        K_ENDFUNCTION opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Function, $4, LINE(@1));
+        }
     ;
 
 opt_automatic
@@ -1096,11 +1830,20 @@ function_item_decl
 
 task_declaration
     : K_TASK opt_automatic IDENTIFIER SEMI
-        task_item_decls_opt statement_list_opt K_ENDTASK opt_endlabel { }
+        task_item_decls_opt statement_list_opt K_ENDTASK opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Task, $3, LINE(@1));
+        }
     | K_TASK opt_automatic IDENTIFIER LPAREN tf_port_list RPAREN
-        SEMI task_item_decls_opt statement_list_opt K_ENDTASK opt_endlabel { }
+        SEMI task_item_decls_opt statement_list_opt K_ENDTASK opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Task, $3, LINE(@1));
+        }
     | K_TASK opt_automatic IDENTIFIER LPAREN RPAREN
-        SEMI task_item_decls_opt statement_list_opt K_ENDTASK opt_endlabel { }
+        SEMI task_item_decls_opt statement_list_opt K_ENDTASK opt_endlabel
+        {
+            $$ = AST->addNamedNode(AstKind::Task, $3, LINE(@1));
+        }
     ;
 
 task_item_decls_opt
@@ -1153,35 +1896,79 @@ tf_port_decl
 // `inst_or_var_list` rule and let the parser choose per-element
 // based on the next token: `(` → instance, `,`/`;`/`=`/`[` → var.
 gate_or_module_instantiation
-    : module_or_udp_instantiation                       { }
-    | gate_instantiation                                { }
+    : module_or_udp_instantiation                       { $$ = $1; }
+    | gate_instantiation                                { $$ = AST->makeList($1); }
     ;
 
 module_or_udp_instantiation
     : IDENTIFIER opt_param_value_assignment opt_packed_dim_list
-        inst_or_var_list SEMI                                      { }
+        inst_or_var_list SEMI
+        {
+            $$ = buildInstOrVar(AST, $1, $2, $3, $4, LINE(@1));
+        }
     | SCOPED_NAME_HEAD IDENTIFIER opt_param_value_assignment
-        opt_packed_dim_list inst_or_var_list SEMI                  { }
-    | MACRO_REF  opt_param_value_assignment inst_or_var_list SEMI  { }
+        opt_packed_dim_list inst_or_var_list SEMI
+        {
+            $$ = buildInstOrVar(AST, $2, $3, $4, $5, LINE(@1));
+        }
+    | MACRO_REF  opt_param_value_assignment inst_or_var_list SEMI
+        {
+            $$ = buildInstOrVar(AST, $1, $2, AstList(), $3, LINE(@1));
+        }
     ;
 
 inst_or_var_list
-    : inst_or_var                                       { }
-    | inst_or_var_list COMMA inst_or_var                { }
+    : inst_or_var                                       { $$ = AST->makeList($1); }
+    | inst_or_var_list COMMA inst_or_var
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 inst_or_var
-    : IDENTIFIER LPAREN port_connections_opt RPAREN     { }
-    | IDENTIFIER range LPAREN port_connections_opt RPAREN { }
-    | IDENTIFIER opt_unpacked_dim_list                  { }
-    | IDENTIFIER opt_unpacked_dim_list ASSIGN expression { }
+    : IDENTIFIER LPAREN port_connections_opt RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::Instance, $1, LINE(@1));
+            AST->addChildren($$, $3);
+        }
+    | IDENTIFIER range LPAREN port_connections_opt RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::Instance, $1, LINE(@1));
+            AST->addChild($$, $2);
+            AST->addChildren($$, $4);
+        }
+    | IDENTIFIER opt_unpacked_dim_list
+        {
+            $$ = AST->addDeclarator($1, $2, NULL_AST_NODE, LINE(@1));
+        }
+    | IDENTIFIER opt_unpacked_dim_list ASSIGN expression
+        {
+            $$ = AST->addDeclarator($1, $2, $4, LINE(@1));
+        }
     ;
 
 opt_param_value_assignment
     : %empty                                            { }
-    | HASH LPAREN port_connections RPAREN               { }
-    | HASH NUMBER                                       { }
-    | HASH IDENTIFIER                                   { }
+    | HASH LPAREN port_connections RPAREN
+        {
+            $$ = AST->addNode(AstKind::ParamOverrides, LINE(@1));
+            AST->addChildren($$, $3);
+        }
+    | HASH NUMBER
+        {
+            $$ = AST->addNode(AstKind::ParamOverrides, LINE(@1));
+            AST->addChild($$, AST->addTernary(AstKind::PortConn,
+                AST->addNamedNode(AstKind::Number, $2, LINE(@2)),
+                NULL_AST_NODE, NULL_AST_NODE, LINE(@2)));
+        }
+    | HASH IDENTIFIER
+        {
+            $$ = AST->addNode(AstKind::ParamOverrides, LINE(@1));
+            AST->addChild($$, AST->addTernary(AstKind::PortConn,
+                AST->addNamedNode(AstKind::Identifier, $2, LINE(@2)),
+                NULL_AST_NODE, NULL_AST_NODE, LINE(@2)));
+        }
     ;
 
 instance_list
@@ -1195,62 +1982,103 @@ instance
 
 port_connections_opt
     : %empty                                            { }
-    | port_connections                                  { }
+    | port_connections                                  { $$ = $1; }
     ;
 
 port_connections
-    : port_conn                                         { }
-    | port_connections COMMA port_conn                  { }
+    : port_conn                                         { $$ = AST->makeList($1); }
+    | port_connections COMMA port_conn
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 port_conn
-    : expression                                        { }
-    | DOT IDENTIFIER LPAREN RPAREN                      { }
-    | DOT IDENTIFIER LPAREN expression RPAREN           { }
-    | DOT IDENTIFIER                                    { }
+    : expression
+        {
+            $$ = AST->addNode(AstKind::PortConn, LINE(@1));
+            AST->addChild($$, $1);
+        }
+    | DOT IDENTIFIER LPAREN RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::PortConn, $2, LINE(@1));
+            AST->addFlags($$, AstFlags::Named);
+        }
+    | DOT IDENTIFIER LPAREN expression RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::PortConn, $2, LINE(@1));
+            AST->addFlags($$, AstFlags::Named);
+            AST->addChild($$, $4);
+        }
+    | DOT IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::PortConn, $2, LINE(@1));
+            AST->addFlags($$, AstFlags::Named);
+            AST->addChild($$,
+                AST->addNamedNode(AstKind::Identifier, $2, LINE(@2)));
+        }
     ;
 
 gate_instantiation
-    : gate_type gate_instance_list SEMI                 { }
+    : gate_type gate_instance_list SEMI
+        {
+            $$ = AST->addNamedNode(AstKind::Instantiation, $1, LINE(@1));
+            AST->addFlags($$, AstFlags::Gate);
+            AST->addChildren($$, $2);
+        }
     ;
 
 gate_type
-    : K_AND                                             { }
-    | K_OR                                              { }
-    | K_NAND                                            { }
-    | K_NOR                                             { }
-    | K_XOR                                             { }
-    | K_XNOR                                            { }
-    | K_BUF                                             { }
-    | K_NOT                                             { }
-    | K_BUFIF0                                          { }
-    | K_BUFIF1                                          { }
-    | K_NOTIF0                                          { }
-    | K_NOTIF1                                          { }
-    | K_NMOS                                            { }
-    | K_PMOS                                            { }
-    | K_RNMOS                                           { }
-    | K_RPMOS                                           { }
-    | K_CMOS                                            { }
-    | K_RCMOS                                           { }
-    | K_TRAN                                            { }
-    | K_TRANIF0                                         { }
-    | K_TRANIF1                                         { }
-    | K_RTRAN                                           { }
-    | K_RTRANIF0                                        { }
-    | K_RTRANIF1                                        { }
-    | K_PULLUP                                          { }
-    | K_PULLDOWN                                        { }
+    : K_AND                                             { $$ = AST->intern("and"); }
+    | K_OR                                              { $$ = AST->intern("or"); }
+    | K_NAND                                            { $$ = AST->intern("nand"); }
+    | K_NOR                                             { $$ = AST->intern("nor"); }
+    | K_XOR                                             { $$ = AST->intern("xor"); }
+    | K_XNOR                                            { $$ = AST->intern("xnor"); }
+    | K_BUF                                             { $$ = AST->intern("buf"); }
+    | K_NOT                                             { $$ = AST->intern("not"); }
+    | K_BUFIF0                                          { $$ = AST->intern("bufif0"); }
+    | K_BUFIF1                                          { $$ = AST->intern("bufif1"); }
+    | K_NOTIF0                                          { $$ = AST->intern("notif0"); }
+    | K_NOTIF1                                          { $$ = AST->intern("notif1"); }
+    | K_NMOS                                            { $$ = AST->intern("nmos"); }
+    | K_PMOS                                            { $$ = AST->intern("pmos"); }
+    | K_RNMOS                                           { $$ = AST->intern("rnmos"); }
+    | K_RPMOS                                           { $$ = AST->intern("rpmos"); }
+    | K_CMOS                                            { $$ = AST->intern("cmos"); }
+    | K_RCMOS                                           { $$ = AST->intern("rcmos"); }
+    | K_TRAN                                            { $$ = AST->intern("tran"); }
+    | K_TRANIF0                                         { $$ = AST->intern("tranif0"); }
+    | K_TRANIF1                                         { $$ = AST->intern("tranif1"); }
+    | K_RTRAN                                           { $$ = AST->intern("rtran"); }
+    | K_RTRANIF0                                        { $$ = AST->intern("rtranif0"); }
+    | K_RTRANIF1                                        { $$ = AST->intern("rtranif1"); }
+    | K_PULLUP                                          { $$ = AST->intern("pullup"); }
+    | K_PULLDOWN                                        { $$ = AST->intern("pulldown"); }
     ;
 
 gate_instance_list
-    : gate_instance                                     { }
-    | gate_instance_list COMMA gate_instance            { }
+    : gate_instance                                     { $$ = AST->makeList($1); }
+    | gate_instance_list COMMA gate_instance
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 gate_instance
-    : LPAREN port_connections RPAREN                    { }
-    | IDENTIFIER opt_range LPAREN port_connections RPAREN { }
+    : LPAREN port_connections RPAREN
+        {
+            $$ = AST->addNode(AstKind::Instance, LINE(@1));
+            AST->addChildren($$, $2);
+        }
+    | IDENTIFIER opt_range LPAREN port_connections RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::Instance, $1, LINE(@1));
+            AST->addChild($$, $2);
+            AST->addChildren($$, $4);
+        }
     ;
 
 // ============================================================
@@ -1305,24 +2133,49 @@ jump_statement
     ;
 
 blocking_assignment
-    : variable_lvalue ASSIGN expression                                 { }
-    | variable_lvalue ASSIGN delay_or_event_control expression          { }
-    | variable_lvalue compound_assign_op expression                     { }
+    : variable_lvalue ASSIGN expression
+        {
+            $$ = AST->addTernary(AstKind::Assign, $1, $3, NULL_AST_NODE,
+                LINE(@1));
+        }
+    | variable_lvalue ASSIGN delay_or_event_control expression
+        {
+            $$ = AST->addTernary(AstKind::Assign, $1, $4, NULL_AST_NODE,
+                LINE(@1));
+        }
+    | variable_lvalue compound_assign_op expression
+        {
+            $$ = AST->addTernary(AstKind::Assign, $1, $3, NULL_AST_NODE,
+                LINE(@1));
+            AST->setOp($$, $2);
+        }
     ;
 
 compound_assign_op
-    : PLUS_EQ                                                           { }
-    | MINUS_EQ                                                          { }
-    | STAR_EQ                                                           { }
-    | SLASH_EQ                                                          { }
-    | PERCENT_EQ                                                        { }
-    | AMP_EQ                                                            { }
-    | PIPE_EQ                                                           { }
-    | CARET_EQ                                                          { }
-    | LSHIFT_EQ                                                         { }
-    | RSHIFT_EQ                                                         { }
-    | LSHIFTA_EQ                                                        { }
-    | RSHIFTA_EQ                                                        { }
+    : PLUS_EQ
+        { $$ = AstOp::Add; }
+    | MINUS_EQ
+        { $$ = AstOp::Sub; }
+    | STAR_EQ
+        { $$ = AstOp::Mul; }
+    | SLASH_EQ
+        { $$ = AstOp::Div; }
+    | PERCENT_EQ
+        { $$ = AstOp::Mod; }
+    | AMP_EQ
+        { $$ = AstOp::BitAnd; }
+    | PIPE_EQ
+        { $$ = AstOp::BitOr; }
+    | CARET_EQ
+        { $$ = AstOp::BitXor; }
+    | LSHIFT_EQ
+        { $$ = AstOp::Shl; }
+    | RSHIFT_EQ
+        { $$ = AstOp::Shr; }
+    | LSHIFTA_EQ
+        { $$ = AstOp::AShl; }
+    | RSHIFTA_EQ
+        { $$ = AstOp::AShr; }
     ;
 
 nonblocking_assignment
@@ -1331,28 +2184,68 @@ nonblocking_assignment
     ;
 
 variable_lvalue
-    : hierarchical_identifier_with_select                               { }
-    | LBRACE variable_lvalue_list RBRACE                                { }
+    : hierarchical_identifier_with_select                               { $$ = $1; }
+    | LBRACE variable_lvalue_list RBRACE
+        {
+            $$ = AST->addNode(AstKind::Concat, LINE(@1));
+            AST->addChildren($$, $2);
+        }
     ;
 
 variable_lvalue_list
-    : variable_lvalue                                                   { }
-    | variable_lvalue_list COMMA variable_lvalue                        { }
+    : variable_lvalue
+        { $$ = AST->makeList($1); }
+    | variable_lvalue_list COMMA variable_lvalue
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 hierarchical_identifier
-    : IDENTIFIER                                                        { }
-    | hierarchical_identifier DOT IDENTIFIER                            { }
-    | SCOPED_NAME_HEAD IDENTIFIER                                       { }
+    : IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::Identifier, $1, LINE(@1));
+        }
+    | hierarchical_identifier DOT IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::Member, $3, LINE(@1));
+            AST->addChild($$, $1);
+        }
+    | SCOPED_NAME_HEAD IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::ScopedIdentifier, $2, LINE(@1));
+            AST->addChild($$,
+                AST->addNamedNode(AstKind::Identifier, $1, LINE(@1)));
+        }
     ;
 
 hierarchical_identifier_with_select
-    : hierarchical_identifier                                           { }
-    | hierarchical_identifier_with_select LBRACK expression RBRACK      { }
-    | hierarchical_identifier_with_select LBRACK expression COLON expression RBRACK         { }
-    | hierarchical_identifier_with_select LBRACK expression PLUS_COLON expression RBRACK    { }
-    | hierarchical_identifier_with_select LBRACK expression MINUS_COLON expression RBRACK   { }
-    | hierarchical_identifier_with_select DOT IDENTIFIER                { }
+    : hierarchical_identifier                                           { $$ = $1; }
+    | hierarchical_identifier_with_select LBRACK expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::Select, $1, $3, NULL_AST_NODE,
+                LINE(@1));
+        }
+    | hierarchical_identifier_with_select LBRACK expression COLON expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::RangeSelect, $1, $3, $5, LINE(@1));
+        }
+    | hierarchical_identifier_with_select LBRACK expression PLUS_COLON expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::RangeSelect, $1, $3, $5, LINE(@1));
+            AST->setOp($$, AstOp::IndexedUp);
+        }
+    | hierarchical_identifier_with_select LBRACK expression MINUS_COLON expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::RangeSelect, $1, $3, $5, LINE(@1));
+            AST->setOp($$, AstOp::IndexedDown);
+        }
+    | hierarchical_identifier_with_select DOT IDENTIFIER
+        {
+            $$ = AST->addNamedNode(AstKind::Member, $3, LINE(@1));
+            AST->addChild($$, $1);
+        }
     ;
 
 conditional_statement
@@ -1400,21 +2293,35 @@ loop_statement
     ;
 
 for_init
-    : blocking_assignment                                               { }
-    | data_type IDENTIFIER ASSIGN expression                            { }
-    | K_GENVAR IDENTIFIER ASSIGN expression                             { }
+    : blocking_assignment                                               { $$ = $1; }
+    | data_type IDENTIFIER ASSIGN expression
+        {
+            $$ = AST->addTernary(AstKind::Assign,
+                AST->addNamedNode(AstKind::Identifier, $2, LINE(@2)), $4,
+                NULL_AST_NODE, LINE(@1));
+        }
+    | K_GENVAR IDENTIFIER ASSIGN expression
+        {
+            $$ = AST->addTernary(AstKind::Assign,
+                AST->addNamedNode(AstKind::Identifier, $2, LINE(@2)), $4,
+                NULL_AST_NODE, LINE(@1));
+        }
     ;
 
 for_step
-    : blocking_assignment                                               { }
-    | inc_or_dec_expression                                             { }
+    : blocking_assignment                                               { $$ = $1; }
+    | inc_or_dec_expression                                             { $$ = $1; }
     ;
 
 inc_or_dec_expression
-    : variable_lvalue INC                                               { }
-    | variable_lvalue DEC                                               { }
-    | INC variable_lvalue                                               { }
-    | DEC variable_lvalue                                               { }
+    : variable_lvalue INC
+        { $$ = AST->addUnary(AstOp::PostInc, $1, LINE(@1)); }
+    | variable_lvalue DEC
+        { $$ = AST->addUnary(AstOp::PostDec, $1, LINE(@1)); }
+    | INC variable_lvalue
+        { $$ = AST->addUnary(AstOp::PreInc, $2, LINE(@1)); }
+    | DEC variable_lvalue
+        { $$ = AST->addUnary(AstOp::PreDec, $2, LINE(@1)); }
     ;
 
 sequential_block
@@ -1510,101 +2417,183 @@ delay_or_event_control
 // Expressions
 // ============================================================
 expression_list
-    : expression                                                        { }
-    | expression_list COMMA expression                                  { }
+    : expression
+        { $$ = AST->makeList($1); }
+    | expression_list COMMA expression
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 expression_list_opt
     : %empty                                                            { }
-    | expression_list                                                   { }
+    | expression_list                                                   { $$ = $1; }
     ;
 
 expression
-    : primary                                                           { }
-    | unary_op primary  %prec UNARY_PREC                                { }
-    | expression PLUS expression                                        { }
-    | expression MINUS expression                                       { }
-    | expression STAR expression                                        { }
-    | expression SLASH expression                                       { }
-    | expression PERCENT expression                                     { }
-    | expression POWER expression                                       { }
-    | expression LT expression                                          { }
-    | expression LE expression                                          { }
-    | expression GT expression                                          { }
-    | expression GE expression                                          { }
-    | expression EQEQ expression                                        { }
-    | expression NEQ expression                                         { }
-    | expression CASEEQ expression                                      { }
-    | expression CASENEQ expression                                     { }
-    | expression LOGAND expression                                      { }
-    | expression LOGOR expression                                       { }
-    | expression AMP expression                                         { }
-    | expression PIPE expression                                        { }
-    | expression CARET expression                                       { }
-    | expression NAND_OP expression                                     { }
-    | expression NOR_OP expression                                      { }
-    | expression XNOR_OP expression                                     { }
-    | expression LSHIFT expression                                      { }
-    | expression RSHIFT expression                                      { }
-    | expression LSHIFTA expression                                     { }
-    | expression RSHIFTA expression                                     { }
-    | expression QUESTION expression COLON expression                   { }
-    | expression K_INSIDE LBRACE inside_value_list RBRACE               { }
+    : primary                                                           { $$ = $1; }
+    | unary_op primary  %prec UNARY_PREC
+        { $$ = AST->addUnary($1, $2, LINE(@1)); }
+    | expression PLUS expression
+        { $$ = AST->addBinary(AstOp::Add, $1, $3, LINE(@2)); }
+    | expression MINUS expression
+        { $$ = AST->addBinary(AstOp::Sub, $1, $3, LINE(@2)); }
+    | expression STAR expression
+        { $$ = AST->addBinary(AstOp::Mul, $1, $3, LINE(@2)); }
+    | expression SLASH expression
+        { $$ = AST->addBinary(AstOp::Div, $1, $3, LINE(@2)); }
+    | expression PERCENT expression
+        { $$ = AST->addBinary(AstOp::Mod, $1, $3, LINE(@2)); }
+    | expression POWER expression
+        { $$ = AST->addBinary(AstOp::Pow, $1, $3, LINE(@2)); }
+    | expression LT expression
+        { $$ = AST->addBinary(AstOp::Lt, $1, $3, LINE(@2)); }
+    | expression LE expression
+        { $$ = AST->addBinary(AstOp::Le, $1, $3, LINE(@2)); }
+    | expression GT expression
+        { $$ = AST->addBinary(AstOp::Gt, $1, $3, LINE(@2)); }
+    | expression GE expression
+        { $$ = AST->addBinary(AstOp::Ge, $1, $3, LINE(@2)); }
+    | expression EQEQ expression
+        { $$ = AST->addBinary(AstOp::Eq, $1, $3, LINE(@2)); }
+    | expression NEQ expression
+        { $$ = AST->addBinary(AstOp::Neq, $1, $3, LINE(@2)); }
+    | expression CASEEQ expression
+        { $$ = AST->addBinary(AstOp::CaseEq, $1, $3, LINE(@2)); }
+    | expression CASENEQ expression
+        { $$ = AST->addBinary(AstOp::CaseNeq, $1, $3, LINE(@2)); }
+    | expression LOGAND expression
+        { $$ = AST->addBinary(AstOp::LogAnd, $1, $3, LINE(@2)); }
+    | expression LOGOR expression
+        { $$ = AST->addBinary(AstOp::LogOr, $1, $3, LINE(@2)); }
+    | expression AMP expression
+        { $$ = AST->addBinary(AstOp::BitAnd, $1, $3, LINE(@2)); }
+    | expression PIPE expression
+        { $$ = AST->addBinary(AstOp::BitOr, $1, $3, LINE(@2)); }
+    | expression CARET expression
+        { $$ = AST->addBinary(AstOp::BitXor, $1, $3, LINE(@2)); }
+    | expression NAND_OP expression
+        { $$ = AST->addBinary(AstOp::BitNand, $1, $3, LINE(@2)); }
+    | expression NOR_OP expression
+        { $$ = AST->addBinary(AstOp::BitNor, $1, $3, LINE(@2)); }
+    | expression XNOR_OP expression
+        { $$ = AST->addBinary(AstOp::BitXnor, $1, $3, LINE(@2)); }
+    | expression LSHIFT expression
+        { $$ = AST->addBinary(AstOp::Shl, $1, $3, LINE(@2)); }
+    | expression RSHIFT expression
+        { $$ = AST->addBinary(AstOp::Shr, $1, $3, LINE(@2)); }
+    | expression LSHIFTA expression
+        { $$ = AST->addBinary(AstOp::AShl, $1, $3, LINE(@2)); }
+    | expression RSHIFTA expression
+        { $$ = AST->addBinary(AstOp::AShr, $1, $3, LINE(@2)); }
+    | expression QUESTION expression COLON expression
+        {
+            $$ = AST->addTernary(AstKind::Ternary, $1, $3, $5, LINE(@2));
+        }
+    | expression K_INSIDE LBRACE inside_value_list RBRACE
+        {
+            $$ = AST->addNode(AstKind::Inside, LINE(@2));
+            AST->addChild($$, $1);
+            AST->addChildren($$, $4);
+        }
     ;
 
 inside_value_list
-    : inside_value                                                      { }
-    | inside_value_list COMMA inside_value                              { }
+    : inside_value
+        { $$ = AST->makeList($1); }
+    | inside_value_list COMMA inside_value
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 inside_value
-    : expression                                                        { }
-    | LBRACK expression COLON expression RBRACK                         { }
+    : expression                                                        { $$ = $1; }
+    | LBRACK expression COLON expression RBRACK
+        {
+            $$ = AST->addTernary(AstKind::Range, $2, $4, NULL_AST_NODE,
+                LINE(@1));
+        }
     ;
 
 unary_op
-    : PLUS                                                              { }
-    | MINUS                                                             { }
-    | BANG                                                              { }
-    | TILDE                                                             { }
-    | AMP                                                               { }
-    | NAND_OP                                                           { }
-    | PIPE                                                              { }
-    | NOR_OP                                                            { }
-    | CARET                                                             { }
-    | XNOR_OP                                                           { }
+    : PLUS
+        { $$ = AstOp::Plus; }
+    | MINUS
+        { $$ = AstOp::Minus; }
+    | BANG
+        { $$ = AstOp::LogNot; }
+    | TILDE
+        { $$ = AstOp::BitNot; }
+    | AMP
+        { $$ = AstOp::RedAnd; }
+    | NAND_OP
+        { $$ = AstOp::RedNand; }
+    | PIPE
+        { $$ = AstOp::RedOr; }
+    | NOR_OP
+        { $$ = AstOp::RedNor; }
+    | CARET
+        { $$ = AstOp::RedXor; }
+    | XNOR_OP
+        { $$ = AstOp::RedXnor; }
     ;
 
 primary
-    : NUMBER                                                            { }
-    | REAL_NUMBER                                                       { }
-    | STRING_LITERAL                                                    { }
-    | hierarchical_identifier_with_select                               { }
-    | concatenation                                                     { }
-    | multiple_concatenation                                            { }
-    | LPAREN expression RPAREN                                          { }
-    | function_call                                                     { }
-    | system_function_call                                              { }
-    | MACRO_REF                                                         { }
-    | K_NULL                                                            { }
-    | sv_assignment_pattern                                             { }
-    | cast_expression                                                   { }
+    : NUMBER
+        { $$ = AST->addNamedNode(AstKind::Number, $1, LINE(@1)); }
+    | REAL_NUMBER
+        { $$ = AST->addNamedNode(AstKind::RealNumber, $1, LINE(@1)); }
+    | STRING_LITERAL
+        { $$ = AST->addNamedNode(AstKind::StringLiteral, $1, LINE(@1)); }
+    | hierarchical_identifier_with_select                               { $$ = $1; }
+    | concatenation                                                     { $$ = $1; }
+    | multiple_concatenation                                            { $$ = $1; }
+    | LPAREN expression RPAREN                                          { $$ = $2; }
+    | function_call                                                     { $$ = $1; }
+    | system_function_call                                              { $$ = $1; }
+    | MACRO_REF
+        { $$ = AST->addNamedNode(AstKind::MacroRef, $1, LINE(@1)); }
+    | K_NULL
+        { $$ = AST->addNode(AstKind::NullLiteral, LINE(@1)); }
+    | sv_assignment_pattern                                             { $$ = $1; }
+    | cast_expression                                                   { $$ = $1; }
     ;
 
 // SV assignment pattern: '{a, b}, '{key: val, ...}, '{default: val}.
 sv_assignment_pattern
-    : APOST_LBRACE assignment_pattern_items RBRACE                      { }
+    : APOST_LBRACE assignment_pattern_items RBRACE
+        {
+            $$ = AST->addNode(AstKind::Pattern, LINE(@1));
+            AST->addChildren($$, $2);
+        }
     ;
 
 assignment_pattern_items
-    : assignment_pattern_item                                           { }
-    | assignment_pattern_items COMMA assignment_pattern_item            { }
+    : assignment_pattern_item
+        { $$ = AST->makeList($1); }
+    | assignment_pattern_items COMMA assignment_pattern_item
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 assignment_pattern_item
-    : expression                                                        { }
-    | expression COLON expression                                       { }
-    | K_DEFAULT COLON expression                                        { }
+    : expression                                                        { $$ = $1; }
+    | expression COLON expression
+        {
+            $$ = AST->addTernary(AstKind::PatternItem, $1, $3,
+                NULL_AST_NODE, LINE(@1));
+        }
+    | K_DEFAULT COLON expression
+        {
+            $$ = AST->addNode(AstKind::PatternItem, LINE(@1));
+            AST->addFlags($$, AstFlags::Default);
+            AST->addChild($$, $3);
+        }
     ;
 
 // SV cast: <size_or_type>'(expr). The lexer emits APOST_LPAREN for
@@ -1613,45 +2602,112 @@ assignment_pattern_item
 // system call) — that covers Ibex's casts (`Width'(x)`,
 // `opcode_e'(x)`, `32'(x)`).
 cast_expression
-    : primary APOST_LPAREN expression RPAREN                            { }
-    | integer_atom_type APOST_LPAREN expression RPAREN                  { }
-    | integer_vector_type APOST_LPAREN expression RPAREN                { }
-    | K_SIGNED APOST_LPAREN expression RPAREN                           { }
-    | K_UNSIGNED APOST_LPAREN expression RPAREN                         { }
-    | K_VOID APOST_LPAREN expression RPAREN                             { }
+    : primary APOST_LPAREN expression RPAREN
+        {
+            $$ = AST->addTernary(AstKind::Cast, $1, $3, NULL_AST_NODE,
+                LINE(@1));
+        }
+    | integer_atom_type APOST_LPAREN expression RPAREN
+        {
+            $$ = AST->addNode(AstKind::Cast, LINE(@1));
+            AST->setDataType($$, $1);
+            AST->addChild($$, $3);
+        }
+    | integer_vector_type APOST_LPAREN expression RPAREN
+        {
+            $$ = AST->addNode(AstKind::Cast, LINE(@1));
+            AST->setDataType($$, $1);
+            AST->addChild($$, $3);
+        }
+    | K_SIGNED APOST_LPAREN expression RPAREN
+        {
+            $$ = AST->addNode(AstKind::Cast, LINE(@1));
+            AST->addFlags($$, AstFlags::Signed);
+            AST->addChild($$, $3);
+        }
+    | K_UNSIGNED APOST_LPAREN expression RPAREN
+        {
+            $$ = AST->addNode(AstKind::Cast, LINE(@1));
+            AST->addFlags($$, AstFlags::Unsigned);
+            AST->addChild($$, $3);
+        }
+    | K_VOID APOST_LPAREN expression RPAREN
+        {
+            $$ = AST->addNode(AstKind::Cast, LINE(@1));
+            AST->setDataType($$, AstDataType::Void);
+            AST->addChild($$, $3);
+        }
     ;
 
 concatenation
-    : LBRACE expression_list RBRACE                                     { }
+    : LBRACE expression_list RBRACE
+        {
+            $$ = AST->addNode(AstKind::Concat, LINE(@1));
+            AST->addChildren($$, $2);
+        }
     ;
 
 multiple_concatenation
-    : LBRACE expression LBRACE expression_list RBRACE RBRACE            { }
+    : LBRACE expression LBRACE expression_list RBRACE RBRACE
+        {
+            const AstNodeID concat = AST->addNode(AstKind::Concat, LINE(@3));
+            AST->addChildren(concat, $4);
+            $$ = AST->addTernary(AstKind::Replicate, $2, concat,
+                NULL_AST_NODE, LINE(@1));
+        }
     ;
 
 function_call
-    : hierarchical_identifier LPAREN function_args RPAREN               { }
-    | hierarchical_identifier LPAREN RPAREN                             { }
+    : hierarchical_identifier LPAREN function_args RPAREN
+        {
+            $$ = AST->addNode(AstKind::Call, LINE(@1));
+            AST->addChild($$, $1);
+            AST->addChildren($$, $3);
+        }
+    | hierarchical_identifier LPAREN RPAREN
+        {
+            $$ = AST->addNode(AstKind::Call, LINE(@1));
+            AST->addChild($$, $1);
+        }
     ;
 
 function_args
-    : expression_list                                                   { }
-    | named_arg_list                                                    { }
+    : expression_list                                                   { $$ = $1; }
+    | named_arg_list                                                    { $$ = $1; }
     ;
 
 named_arg_list
-    : named_arg                                                         { }
-    | named_arg_list COMMA named_arg                                    { }
+    : named_arg
+        { $$ = AST->makeList($1); }
+    | named_arg_list COMMA named_arg
+        {
+            $$ = $1;
+            AST->append($$, $3);
+        }
     ;
 
 named_arg
-    : DOT IDENTIFIER LPAREN RPAREN                                      { }
-    | DOT IDENTIFIER LPAREN expression RPAREN                           { }
+    : DOT IDENTIFIER LPAREN RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::NamedArg, $2, LINE(@1));
+        }
+    | DOT IDENTIFIER LPAREN expression RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::NamedArg, $2, LINE(@1));
+            AST->addChild($$, $4);
+        }
     ;
 
 system_function_call
-    : SYSTEM_ID                                                         { }
-    | SYSTEM_ID LPAREN expression_list_opt RPAREN                       { }
+    : SYSTEM_ID
+        {
+            $$ = AST->addNamedNode(AstKind::SystemCall, $1, LINE(@1));
+        }
+    | SYSTEM_ID LPAREN expression_list_opt RPAREN
+        {
+            $$ = AST->addNamedNode(AstKind::SystemCall, $1, LINE(@1));
+            AST->addChildren($$, $3);
+        }
     ;
 
 %%
@@ -0,0 +1,65 @@
+#include "PreprocessedStream.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace stargate {
+
+PreprocessedStream::PreprocessedStream() {
+}
+
+PreprocessedStream::~PreprocessedStream() {
+}
+
+void PreprocessedStream::push(const std::string& block) {
+    if (block.empty()) {
+        return;
+    }
+
+    std::unique_lock lock(_mutex);
+    _notFull.wait(lock, [this] {
+        return _cancelled || _blocks.size() < MAX_QUEUED_BLOCKS;
+    });
+    if (_cancelled) {
+        return;
+    }
+    _blocks.push_back(block);
+    _notEmpty.notify_one();
+}
+
+void PreprocessedStream::close() {
+    std::lock_guard lock(_mutex);
+    _closed = true;
+    _notEmpty.notify_all();
+}
+
+size_t PreprocessedStream::read(char* buf, size_t maxSize) {
+    if (_pos == _current.size()) {
+        std::unique_lock lock(_mutex);
+        _notEmpty.wait(lock, [this] {
+            return _closed || !_blocks.empty();
+        });
+        if (_blocks.empty()) {
+            return 0;
+        }
+        _current.swap(_blocks.front());
+        _blocks.pop_front();
+        _pos = 0;
+        _notFull.notify_one();
+    }
+
+    // _current and _pos belong to the consumer alone.
+    const size_t n = std::min(maxSize, _current.size() - _pos);
+    memcpy(buf, _current.data() + _pos, n);
+    _pos += n;
+    return n;
+}
+
+void PreprocessedStream::cancel() {
+    std::lock_guard lock(_mutex);
+    _cancelled = true;
+    _blocks.clear();
+    _notFull.notify_all();
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+namespace stargate {
+
+// Bounded queue of preprocessed text between a Preprocessor running on
+// one thread and the lexer pulling from another. The producer blocks
+// once MAX_QUEUED_BLOCKS are waiting, so memory stays bounded however
+// large the source is.
+class PreprocessedStream {
+public:
+    PreprocessedStream();
+    ~PreprocessedStream();
+
+    // Preprocessor output is handed over once it reaches this size.
+    static constexpr size_t BLOCK_SIZE = 256 * 1024;
+    static constexpr size_t MAX_QUEUED_BLOCKS = 4;
+
+    // Producer side. push is a no-op after cancel.
+    void push(const std::string& block);
+    void close();
+
+    // Consumer side. Copies up to maxSize bytes into buf and returns
+    // the count, or 0 once the stream is closed and drained.
+    size_t read(char* buf, size_t maxSize);
+
+    // Called by a consumer that stops early, so that the producer
+    // never waits for room again.
+    void cancel();
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::deque<std::string> _blocks;
+    std::string _current;
+    size_t _pos {0};
+    bool _closed {false};
+    bool _cancelled {false};
+};
+
+}
@@ -1,12 +1,103 @@
 #include "Preprocessor.h"
 
 #include <stdio.h>
-#include <fstream>
+#include <algorithm>
+#include <bit>
 #include <sstream>
 #include <filesystem>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "MappedFile.h"
+#include "PreprocessedStream.h"
+#include "SourceMap.h"
+
 namespace stargate {
 
+namespace {
+
+// Characters that may start a string, a comment or a directive.
+bool isSpecial(char c) {
+    return c == '`' || c == '"' || c == '/';
+}
+
+// Returns the position of the next special character at or after i,
+// or the end of src, adding the newlines skipped over to line. Most
+// RTL bytes are plain, so this is where the preprocessor spends its
+// time; the vector paths test a whole block per iteration.
+size_t scanPlain(std::string_view src, size_t i, int& line) {
+    const char* const data = src.data();
+    const size_t size = src.size();
+
+#if defined(__AVX2__)
+    const __m256i tick = _mm256_set1_epi8('`');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (i + 32 <= size) {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, tick),
+                            _mm256_cmpeq_epi8(v, quote)),
+            _mm256_cmpeq_epi8(v, slash));
+        const uint32_t special = _mm256_movemask_epi8(hits);
+        const uint32_t newlines =
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        if (special) {
+            const int n = std::countr_zero(special);
+            line += std::popcount(newlines & ((1u << n) - 1));
+            return i + n;
+        }
+        line += std::popcount(newlines);
+        i += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i tick = _mm_set1_epi8('`');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (i + 16 <= size) {
+        const __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, tick), _mm_cmpeq_epi8(v, quote)),
+            _mm_cmpeq_epi8(v, slash));
+        const uint32_t special = _mm_movemask_epi8(hits);
+        const uint32_t newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+        if (special) {
+            const int n = std::countr_zero(special);
+            line += std::popcount(newlines & ((1u << n) - 1));
+            return i + n;
+        }
+        line += std::popcount(newlines);
+        i += 16;
+    }
+#endif
+
+    for (; i < size; ++i) {
+        const char c = data[i];
+        if (isSpecial(c)) {
+            return i;
+        }
+        if (c == '\n') {
+            ++line;
+        }
+    }
+    return i;
+}
+
+}
+
+struct Preprocessor::IncludeFile {
+    MappedFile file;
+    std::string guard;
+};
+
 Preprocessor::Preprocessor() {
 }
 
@@ -15,28 +106,136 @@ Preprocessor::~Preprocessor() {
 
 void Preprocessor::addIncludeDir(const std::string& dir) {
     _includeDirs.push_back(dir);
+    _includePaths.clear();
 }
 
 void Preprocessor::define(const std::string& name, const std::string& body) {
     Macro m;
     m.body = body;
     m.isFunctionLike = false;
-    _macros[name] = m;
+    setMacro(name, m);
 }
 
 void Preprocessor::undefine(const std::string& name) {
-    _macros.erase(name);
+    eraseMacro(name);
 }
 
-bool Preprocessor::isActive() const {
-    for (const auto& f : _condStack) {
-        if (!f.active) {
+const Preprocessor::Macro* Preprocessor::findMacro(std::string_view name) const {
+    const SymbolID id = _macroNames.find(name);
+    if (id == NULL_SYMBOL) {
+        return nullptr;
+    }
+    return _macros[id.value].get();
+}
+
+const Preprocessor::Macro* Preprocessor::lookupMacro(std::string_view name) {
+    const Macro* m = findMacro(name);
+
+    for (IncludeUnit* unit : _recordings) {
+        if (unit->effects.find(name) != unit->effects.end()
+            || unit->uses.find(name) != unit->uses.end()) {
+            continue;
+        }
+        std::optional<Macro> state;
+        if (m) {
+            state = *m;
+        }
+        unit->uses.emplace(std::string(name), state);
+    }
+    return m;
+}
+
+void Preprocessor::setMacro(const std::string& name, const Macro& m) {
+    const SymbolID id = _macroNames.intern(name);
+    if (id.value >= _macros.size()) {
+        _macros.resize(id.value + 1);
+    }
+    _macros[id.value] = std::make_unique<Macro>(m);
+    for (IncludeUnit* unit : _recordings) {
+        unit->effects.insert_or_assign(name, m);
+    }
+}
+
+void Preprocessor::eraseMacro(std::string_view name) {
+    const SymbolID id = _macroNames.find(name);
+    if (id != NULL_SYMBOL) {
+        _macros[id.value].reset();
+    }
+    for (IncludeUnit* unit : _recordings) {
+        unit->effects.insert_or_assign(std::string(name), std::nullopt);
+    }
+}
+
+bool Preprocessor::matchesUnit(const IncludeUnit& unit) const {
+    // Other include directories may resolve the nested includes of
+    // the unit to other files.
+    if (unit.includeDirs != _includeDirs) {
+        return false;
+    }
+
+    for (const auto& [name, state] : unit.uses) {
+        const Macro* m = findMacro(name);
+        if (!m) {
+            if (state) {
+                return false;
+            }
+        } else if (!state || !(*m == *state)) {
+            return false;
+        }
+    }
+
+    for (const auto& [path, mtime] : unit.files) {
+        std::error_code ec;
+        if (std::filesystem::last_write_time(path, ec) != mtime || ec) {
             return false;
         }
     }
     return true;
 }
 
+void Preprocessor::replayUnit(const IncludeUnit& unit, std::string* out) {
+    // Enclosing recordings depend on whatever the unit depended on.
+    for (const auto& [name, state] : unit.uses) {
+        lookupMacro(name);
+    }
+    for (IncludeUnit* rec : _recordings) {
+        rec->files.insert(rec->files.end(), unit.files.begin(), unit.files.end());
+    }
+    for (const auto& [path, mtime] : unit.files) {
+        _dependencies.insert(path);
+    }
+    addMissingIncludes(unit.missingIncludes);
+
+    if (_sourceMap) {
+        for (SourceMapRun run : unit.sourceRuns) {
+            run.outputLine += _outLine;
+            run.file = _sourceMap->addFile(unit.sourceFiles[run.file]);
+            addSourceRun(run);
+        }
+    }
+
+    out->append(unit.text);
+    _outLine += unit.lines;
+
+    for (const auto& [name, state] : unit.effects) {
+        if (state) {
+            setMacro(name, *state);
+        } else {
+            eraseMacro(name);
+        }
+    }
+}
+
+void Preprocessor::updateActive() {
+    _active = true;
+    for (const auto& f : _condStack) {
+        if (!f.active) {
+            _active = false;
+            return;
+        }
+    }
+}
+
 bool Preprocessor::parentActive() const {
     if (_condStack.size() < 2) {
         return true;
@@ -69,7 +268,7 @@ bool Preprocessor::isIdCont(char c) {
             c == '$';
 }
 
-std::string Preprocessor::readIdent(const std::string& src, size_t& i) {
+std::string_view Preprocessor::readIdent(std::string_view src, size_t& i) {
     const size_t start = i;
     while (i < src.size() && isIdCont(src[i])) {
         ++i;
@@ -77,13 +276,13 @@ std::string Preprocessor::readIdent(const std::string& src, size_t& i) {
     return src.substr(start, i - start);
 }
 
-void Preprocessor::skipSpaces(const std::string& src, size_t& i) {
+void Preprocessor::skipSpaces(std::string_view src, size_t& i) {
     while (i < src.size() && (src[i] == ' ' || src[i] == '\t')) {
         ++i;
     }
 }
 
-int Preprocessor::skipToEol(const std::string& src, size_t& i) {
+int Preprocessor::skipToEol(std::string_view src, size_t& i) {
     int newlines = 0;
     while (i < src.size() && src[i] != '\n') {
         if (src[i] == '\\' && i + 1 < src.size() && src[i + 1] == '\n') {
@@ -96,7 +295,7 @@ int Preprocessor::skipToEol(const std::string& src, size_t& i) {
     return newlines;
 }
 
-std::string Preprocessor::readDirectiveLine(const std::string& src,
+std::string Preprocessor::readDirectiveLine(std::string_view src,
                                             size_t& i,
                                             int* lineDelta) {
     std::string body;
@@ -114,7 +313,113 @@ std::string Preprocessor::readDirectiveLine(const std::string& src,
     return body;
 }
 
-void Preprocessor::skipBalancedParens(const std::string& src,
+void Preprocessor::skipBlank(std::string_view src, size_t& i) {
+    while (i < src.size()) {
+        const char c = src[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            ++i;
+        } else if (c == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+            while (i < src.size() && src[i] != '\n') {
+                ++i;
+            }
+        } else if (c == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+            const size_t end = src.find("*/", i + 2);
+            i = (end == std::string_view::npos) ? src.size() : end + 2;
+        } else {
+            return;
+        }
+    }
+}
+
+// Recognizes the multiple-include idiom: the file is, apart from
+// whitespace and comments, one `ifndef X ... `endif whose first
+// directive is `define X and which has no `else or `elsif. Once X is
+// defined, including the file again can only produce nothing. Returns
+// false, with an empty guard, if the file does not follow it.
+bool Preprocessor::detectIncludeGuard(std::string_view src, std::string& guard) {
+    guard.clear();
+
+    size_t i = 0;
+    skipBlank(src, i);
+    if (i >= src.size() || src[i] != '`') {
+        return false;
+    }
+    ++i;
+    if (readIdent(src, i) != "ifndef") {
+        return false;
+    }
+    skipSpaces(src, i);
+    const std::string_view guardName = readIdent(src, i);
+    if (guardName.empty()) {
+        return false;
+    }
+
+    skipBlank(src, i);
+    if (i >= src.size() || src[i] != '`') {
+        return false;
+    }
+    ++i;
+    if (readIdent(src, i) != "define") {
+        return false;
+    }
+    skipSpaces(src, i);
+    if (readIdent(src, i) != guardName) {
+        return false;
+    }
+
+    int depth = 1;
+    while (i < src.size()) {
+        const char c = src[i];
+        if (c == '"') {
+            ++i;
+            while (i < src.size() && src[i] != '"' && src[i] != '\n') {
+                if (src[i] == '\\' && i + 1 < src.size()) {
+                    ++i;
+                }
+                ++i;
+            }
+            ++i;
+            continue;
+        }
+
+        if (c == '/') {
+            const size_t start = i;
+            skipBlank(src, i);
+            if (i == start) {
+                ++i;
+            }
+            continue;
+        }
+
+        if (c != '`') {
+            ++i;
+            continue;
+        }
+
+        ++i;
+        const std::string_view name = readIdent(src, i);
+        if (name == "ifdef" || name == "ifndef") {
+            ++depth;
+        } else if (name == "else" || name == "elsif") {
+            if (depth == 1) {
+                return false;
+            }
+        } else if (name == "endif") {
+            --depth;
+            if (depth == 0) {
+                skipBlank(src, i);
+                if (i < src.size()) {
+                    return false;
+                }
+                guard = guardName;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Preprocessor::skipBalancedParens(std::string_view src,
                                       size_t& i,
                                       int& line) {
     if (i >= src.size() || src[i] != '(') {
@@ -146,7 +451,7 @@ void Preprocessor::skipBalancedParens(const std::string& src,
     }
 }
 
-bool Preprocessor::readMacroArgs(const std::string& src,
+bool Preprocessor::readMacroArgs(std::string_view src,
                                  size_t& i,
                                  int& line,
                                  std::vector<std::string>* args) {
@@ -222,21 +527,31 @@ bool Preprocessor::readMacroArgs(const std::string& src,
     return false;
 }
 
-std::string Preprocessor::substituteParams(
-    const Macro* m,
-    const std::vector<std::string>& args) {
+// Splits the body of a function-like macro into literal runs and
+// parameter slots. Identifiers inside strings and line comments are
+// never parameters.
+void Preprocessor::compileMacro(Macro* m) {
+    m->chunks.clear();
     if (!m->isFunctionLike || m->params.empty()) {
-        return m->body;
+        return;
     }
 
-    std::string out;
     const std::string& body = m->body;
+    size_t literal = 0;
     size_t i = 0;
 
+    auto addChunk = [&](size_t offset, size_t length, int32_t param) {
+        if (length == 0 && param < 0) {
+            return;
+        }
+        m->chunks.push_back({static_cast<uint32_t>(offset),
+                             static_cast<uint32_t>(length),
+                             param});
+    };
+
     while (i < body.size()) {
         const char c = body[i];
         if (c == '"') {
-            const size_t start = i;
             ++i;
             while (i < body.size() && body[i] != '"' && body[i] != '\n') {
                 if (body[i] == '\\' && i + 1 < body.size()) {
@@ -247,15 +562,10 @@ std::string Preprocessor::substituteParams(
             if (i < body.size() && body[i] == '"') {
                 ++i;
             }
-            out.append(body, start, i - start);
             continue;
         }
         if (c == '/' && i + 1 < body.size() && body[i + 1] == '/') {
-            const size_t start = i;
-            while (i < body.size() && body[i] != '\n') {
-                ++i;
-            }
-            out.append(body, start, i - start);
+            i = std::min(body.find('\n', i), body.size());
             continue;
         }
         if (isIdStart(c)) {
@@ -263,24 +573,40 @@ std::string Preprocessor::substituteParams(
             while (i < body.size() && isIdCont(body[i])) {
                 ++i;
             }
-            std::string token = body.substr(start, i - start);
-            ssize_t found = -1;
+            const std::string_view token(body.data() + start, i - start);
             for (size_t p = 0; p < m->params.size(); ++p) {
                 if (m->params[p] == token) {
-                    found = static_cast<ssize_t>(p);
+                    addChunk(literal, start - literal, -1);
+                    addChunk(start, i - start, static_cast<int32_t>(p));
+                    literal = i;
                     break;
                 }
             }
-            if (found >= 0 && static_cast<size_t>(found) < args.size()) {
-                out.append(args[found]);
-            } else {
-                out.append(token);
-            }
             continue;
         }
-        out.push_back(c);
         ++i;
     }
+    addChunk(literal, body.size() - literal, -1);
+}
+
+std::string Preprocessor::substituteParams(
+    const Macro* m,
+    const std::vector<std::string>& args) {
+    if (!m->isFunctionLike || m->params.empty()) {
+        return m->body;
+    }
+
+    std::string out;
+    out.reserve(m->body.size());
+    for (const MacroChunk& chunk : m->chunks) {
+        if (chunk.param >= 0 && static_cast<size_t>(chunk.param) < args.size()) {
+            out.append(args[chunk.param]);
+        } else {
+            // Literal run, or a parameter the call did not supply,
+            // which expands to its own name.
+            out.append(m->body, chunk.offset, chunk.length);
+        }
+    }
     return out;
 }
 
@@ -289,37 +615,87 @@ bool Preprocessor::resolveIncludePath(const std::string& referenced,
                                       std::string* resolved) {
     namespace fs = std::filesystem;
 
+    std::string key = fs::path(fromFile).parent_path().string();
+    key.push_back('\n');
+    key.append(referenced);
+
+    auto cached = _includePaths.find(key);
+    if (cached == _includePaths.end()) {
+        IncludeResolution resolution;
+        if (!resolveIncludePathUncached(referenced, fromFile, &resolution)) {
+            return false;
+        }
+        cached = _includePaths.emplace(key, resolution).first;
+    }
+
+    // Recorded on every use, as each may be for a different recording.
+    addMissingIncludes(cached->second.missing);
+    *resolved = cached->second.path;
+    return true;
+}
+
+bool Preprocessor::resolveIncludePathUncached(const std::string& referenced,
+                                              const std::string& fromFile,
+                                              IncludeResolution* resolution) {
+    namespace fs = std::filesystem;
+
     fs::path ref(referenced);
-    if (ref.is_absolute() && fs::exists(ref)) {
-        *resolved = ref.string();
+    if (ref.is_absolute()) {
+        if (!fs::exists(ref)) {
+            return false;
+        }
+        resolution->path = ref.string();
         return true;
     }
 
+    std::vector<fs::path> candidates;
     if (!fromFile.empty()) {
-        fs::path fromDir = fs::path(fromFile).parent_path();
-        fs::path candidate = fromDir / ref;
-        if (fs::exists(candidate)) {
-            *resolved = candidate.string();
-            return true;
-        }
+        candidates.push_back(fs::path(fromFile).parent_path() / ref);
     }
-
     for (const auto& dir : _includeDirs) {
-        fs::path candidate = fs::path(dir) / ref;
+        candidates.push_back(fs::path(dir) / ref);
+    }
+
+    for (const fs::path& candidate : candidates) {
         if (fs::exists(candidate)) {
-            *resolved = candidate.string();
+            resolution->path = candidate.string();
             return true;
         }
+        resolution->missing.push_back(candidate.string());
     }
     return false;
 }
 
-void Preprocessor::handleDefine(const std::string& src,
+void Preprocessor::addMissingIncludes(const std::vector<std::string>& paths) {
+    _missingIncludes.insert(paths.begin(), paths.end());
+    for (IncludeUnit* rec : _recordings) {
+        rec->missingIncludes.insert(rec->missingIncludes.end(), paths.begin(), paths.end());
+    }
+}
+
+Preprocessor::IncludeFile* Preprocessor::getIncludeFile(const std::string& path) {
+    const auto it = _includeFiles.find(path);
+    if (it != _includeFiles.end()) {
+        return it->second.get();
+    }
+
+    IncludeFile* inc = new IncludeFile();
+    if (!inc->file.open(path)) {
+        delete inc;
+        return nullptr;
+    }
+    detectIncludeGuard(inc->file.data(), inc->guard);
+
+    _includeFiles[path].reset(inc);
+    return inc;
+}
+
+void Preprocessor::handleDefine(std::string_view src,
                                 size_t& i,
                                 const std::string& filename,
                                 int& line) {
     skipSpaces(src, i);
-    const std::string name = readIdent(src, i);
+    const std::string name(readIdent(src, i));
     if (name.empty()) {
         addError(filename, line, "`define without macro name");
         skipToEol(src, i);
@@ -333,7 +709,7 @@ void Preprocessor::handleDefine(const std::string& src,
         ++i;
         skipSpaces(src, i);
         while (i < src.size() && src[i] != ')') {
-            const std::string param = readIdent(src, i);
+            const std::string param(readIdent(src, i));
             if (param.empty()) {
                 addError(filename, line, "expected parameter name in `define");
                 break;
@@ -386,11 +762,12 @@ void Preprocessor::handleDefine(const std::string& src,
         clean.pop_back();
     }
     m.body = clean;
+    compileMacro(&m);
 
-    _macros[name] = m;
+    setMacro(name, m);
 }
 
-void Preprocessor::handleInclude(const std::string& src,
+void Preprocessor::handleInclude(std::string_view src,
                                  size_t& i,
                                  const std::string& filename,
                                  int line,
@@ -426,34 +803,149 @@ void Preprocessor::handleInclude(const std::string& src,
         return;
     }
 
+    _dependencies.insert(resolved);
+
     if (_includeDepth >= MAX_INCLUDE_DEPTH) {
         addError(filename, line, "include depth limit exceeded");
         return;
     }
 
-    std::ifstream f(resolved);
-    if (!f) {
+    // An expansion recorded under the same macro state stands in for
+    // the file. For a guarded header that state has the guard macro
+    // undefined, so this never bypasses the guard check below.
+    if (_includeCache) {
+        std::vector<const IncludeUnit*> units;
+        _includeCache->getUnits(resolved, units);
+        for (const IncludeUnit* unit : units) {
+            if (matchesUnit(*unit)) {
+                replayUnit(*unit, out);
+                return;
+            }
+        }
+    }
+
+    IncludeFile* inc = getIncludeFile(resolved);
+    if (!inc) {
         addError(filename, line,
             "cannot open included file: " + resolved);
         return;
     }
-    std::ostringstream oss;
-    oss << f.rdbuf();
+
+    // Already included and guarded out: skip without scanning.
+    if (!inc->guard.empty() && lookupMacro(inc->guard)) {
+        return;
+    }
+
+    if (!_includeCache) {
+        includeSource(inc->file.data(), resolved, out);
+        return;
+    }
+
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(resolved, ec);
+
+    IncludeUnit unit;
+    unit.path = resolved;
+    unit.includeDirs = _includeDirs;
+    unit.files.emplace_back(resolved, mtime);
+    for (IncludeUnit* rec : _recordings) {
+        rec->files.emplace_back(resolved, mtime);
+    }
+
+    const size_t outStart = out->size();
+    const uint32_t lineStart = _outLine;
+    const size_t errorCount = _errors.size();
+    const size_t condDepth = _condStack.size();
+
+    _recordings.push_back(&unit);
+    includeSource(inc->file.data(), resolved, out);
+    _recordings.pop_back();
+
+    // Only self-contained, clean expansions are worth sharing: a unit
+    // that reported errors or left a conditional open depends on more
+    // than the recorded state.
+    if (ec || _errors.size() != errorCount || _condStack.size() != condDepth) {
+        return;
+    }
+    unit.text = out->substr(outStart);
+    unit.lines = _outLine - lineStart;
+
+    // Runs were recorded with absolute lines and map-wide file ids;
+    // make them relative so that any driver can replay them.
+    std::unordered_map<uint32_t, uint32_t> files;
+    for (SourceMapRun& run : unit.sourceRuns) {
+        run.outputLine -= lineStart;
+        const auto [it, added] = files.emplace(run.file, files.size());
+        if (added) {
+            unit.sourceFiles.push_back(_sourceMap->getFileName(run.file));
+        }
+        run.file = it->second;
+    }
+    _includeCache->addUnit(unit);
+}
+
+void Preprocessor::includeSource(std::string_view src,
+                                 const std::string& path,
+                                 std::string* out) {
+    const uint32_t parentFile = _curFile;
+    if (_sourceMap) {
+        _curFile = _sourceMap->addFile(path);
+    }
 
     ++_includeDepth;
-    processSource(oss.str(), resolved, out);
+    processSource(src, path, out);
     --_includeDepth;
+
+    _curFile = parentFile;
+}
+
+void Preprocessor::beginSourceMap(const std::string& name) {
+    if (_sourceMap) {
+        _curFile = _sourceMap->addFile(name);
+        _outLine = _sourceMap->getEndLine();
+    }
+}
+
+void Preprocessor::endSourceMap() {
+    if (_sourceMap) {
+        _sourceMap->setEndLine(_outLine + 1);
+    }
 }
 
-void Preprocessor::processSource(const std::string& src,
+void Preprocessor::markSource(int line) {
+    if (!_sourceMap) {
+        return;
+    }
+
+    // Every line of an expansion maps to the line of the call.
+    if (_expansionDepth > 0) {
+        addSourceRun({_outLine, _curFile,
+                      static_cast<uint32_t>(_expansionLine), 0});
+    } else {
+        addSourceRun({_outLine, _curFile, static_cast<uint32_t>(line), 1});
+    }
+}
+
+void Preprocessor::addSourceRun(const SourceMapRun& run) {
+    _sourceMap->addRun(run.outputLine, run.file, run.line, run.lineStep);
+    for (IncludeUnit* rec : _recordings) {
+        rec->sourceRuns.push_back(run);
+    }
+}
+
+void Preprocessor::processSource(std::string_view src,
                                  const std::string& filename,
                                  std::string* out) {
     int line = 1;
     size_t i = 0;
+    // Set once a directive or an expansion may have broken the line
+    // for line correspondence between src and the output.
+    bool needMark = true;
 
-    auto emit = [&](const std::string& s) {
+    auto emit = [&](std::string_view s, int newlines) {
         if (isActive()) {
             out->append(s);
+            _outLine += newlines;
         }
     };
     auto emitChar = [&](char c) {
@@ -463,15 +955,16 @@ void Preprocessor::processSource(const std::string& src,
     };
 
     while (i < src.size()) {
-        const char c = src[i];
-
-        if (c == '\n') {
-            ++line;
-            emitChar(c);
-            ++i;
-            continue;
+        if (_stream && out->size() >= PreprocessedStream::BLOCK_SIZE) {
+            flushStream(out);
+        }
+        if (needMark) {
+            markSource(line);
+            needMark = false;
         }
 
+        const char c = src[i];
+
         if (c == '"') {
             const size_t start = i;
             ++i;
@@ -484,44 +977,42 @@ void Preprocessor::processSource(const std::string& src,
             if (i < src.size() && src[i] == '"') {
                 ++i;
             }
-            emit(src.substr(start, i - start));
+            emit(src.substr(start, i - start), 0);
             continue;
         }
 
         if (c == '/' && i + 1 < src.size() && src[i + 1] == '/') {
             const size_t start = i;
-            while (i < src.size() && src[i] != '\n') {
-                ++i;
-            }
-            emit(src.substr(start, i - start));
+            i = std::min(src.find('\n', i), src.size());
+            emit(src.substr(start, i - start), 0);
             continue;
         }
 
         if (c == '/' && i + 1 < src.size() && src[i + 1] == '*') {
             const size_t start = i;
-            i += 2;
-            while (i + 1 < src.size() &&
-                   !(src[i] == '*' && src[i + 1] == '/')) {
-                if (src[i] == '\n') {
-                    ++line;
-                }
-                ++i;
-            }
-            if (i + 1 < src.size()) {
-                i += 2;
-            }
-            emit(src.substr(start, i - start));
+            const size_t end = src.find("*/", i + 2);
+            i = (end == std::string_view::npos) ? src.size() : end + 2;
+            const int newlines =
+                std::count(src.begin() + start, src.begin() + i, '\n');
+            line += newlines;
+            emit(src.substr(start, i - start), newlines);
             continue;
         }
 
         if (c != '`') {
-            emitChar(c);
-            ++i;
+            // A run of plain text, possibly led by a '/' that does not
+            // open a comment, copied with a single append.
+            const size_t start = i;
+            const int startLine = line;
+            i = scanPlain(src, c == '/' ? i + 1 : i, line);
+            emit(src.substr(start, i - start), line - startLine);
             continue;
         }
 
+        const int callLine = line;
+        needMark = true;
         ++i;
-        const std::string name = readIdent(src, i);
+        const std::string_view name = readIdent(src, i);
         if (name.empty()) {
             emitChar('`');
             continue;
@@ -529,22 +1020,19 @@ void Preprocessor::processSource(const std::string& src,
 
         if (name == "ifdef" || name == "ifndef") {
             skipSpaces(src, i);
-            const std::string macroName = readIdent(src, i);
-            int delta = 0;
-            readDirectiveLine(src, i, &delta);
-            line += delta;
-            const bool defined = _macros.count(macroName) > 0;
+            const std::string_view macroName = readIdent(src, i);
+            line += skipToEol(src, i);
+            const bool defined = lookupMacro(macroName) != nullptr;
             const bool branchTrue = (name == "ifdef") ? defined : !defined;
             const bool here = parentActive() && isActive() && branchTrue;
             CondFrame f {here, branchTrue, false};
             _condStack.push_back(f);
+            updateActive();
             continue;
         }
 
         if (name == "else") {
-            int delta = 0;
-            readDirectiveLine(src, i, &delta);
-            line += delta;
+            line += skipToEol(src, i);
             if (_condStack.empty()) {
                 addError(filename, line, "`else without matching `if[n]def");
                 continue;
@@ -559,15 +1047,14 @@ void Preprocessor::processSource(const std::string& src,
             if (f.active) {
                 f.seenTrueBranch = true;
             }
+            updateActive();
             continue;
         }
 
         if (name == "elsif") {
             skipSpaces(src, i);
-            const std::string macroName = readIdent(src, i);
-            int delta = 0;
-            readDirectiveLine(src, i, &delta);
-            line += delta;
+            const std::string_view macroName = readIdent(src, i);
+            line += skipToEol(src, i);
             if (_condStack.empty()) {
                 addError(filename, line,
                     "`elsif without matching `if[n]def");
@@ -578,7 +1065,7 @@ void Preprocessor::processSource(const std::string& src,
                 addError(filename, line, "`elsif after `else");
                 continue;
             }
-            const bool defined = _macros.count(macroName) > 0;
+            const bool defined = lookupMacro(macroName) != nullptr;
             if (f.seenTrueBranch || !defined) {
                 f.active = false;
             } else {
@@ -587,19 +1074,19 @@ void Preprocessor::processSource(const std::string& src,
                     f.seenTrueBranch = true;
                 }
             }
+            updateActive();
             continue;
         }
 
         if (name == "endif") {
-            int delta = 0;
-            readDirectiveLine(src, i, &delta);
-            line += delta;
+            line += skipToEol(src, i);
             if (_condStack.empty()) {
                 addError(filename, line,
                     "`endif without matching `if[n]def");
                 continue;
             }
             _condStack.pop_back();
+            updateActive();
             continue;
         }
 
@@ -618,11 +1105,9 @@ void Preprocessor::processSource(const std::string& src,
         }
         if (name == "undef") {
             skipSpaces(src, i);
-            const std::string macroName = readIdent(src, i);
-            int delta = 0;
-            readDirectiveLine(src, i, &delta);
-            line += delta;
-            _macros.erase(macroName);
+            const std::string_view macroName = readIdent(src, i);
+            line += skipToEol(src, i);
+            eraseMacro(macroName);
             continue;
         }
         if (name == "include") {
@@ -640,14 +1125,12 @@ void Preprocessor::processSource(const std::string& src,
             name == "warning" || name == "info" || name == "note" ||
             name == "protect" || name == "endprotect" ||
             name == "protected" || name == "endprotected") {
-            int delta = 0;
-            readDirectiveLine(src, i, &delta);
-            line += delta;
+            line += skipToEol(src, i);
             continue;
         }
 
-        const auto it = _macros.find(name);
-        if (it == _macros.end()) {
+        const Macro* macro = lookupMacro(name);
+        if (!macro) {
             // Undefined macro. If it looks function-like (parens
             // follow immediately), strip the args wholesale — many
             // such macros expand to a self-contained statement, and
@@ -672,23 +1155,23 @@ void Preprocessor::processSource(const std::string& src,
                 }
             } else {
                 emitChar('`');
-                emit(name);
+                emit(name, 0);
             }
             continue;
         }
 
-        const Macro& m = it->second;
+        const Macro& m = *macro;
         std::vector<std::string> args;
         if (m.isFunctionLike) {
             if (i < src.size() && src[i] == '(') {
                 if (!readMacroArgs(src, i, line, &args)) {
                     addError(filename, line,
-                        "malformed arguments to macro `" + name);
+                        "malformed arguments to macro `" + std::string(name));
                     continue;
                 }
             } else {
                 addError(filename, line,
-                    "function-like macro `" + name +
+                    "function-like macro `" + std::string(name) +
                     " requires arguments");
                 continue;
             }
@@ -698,36 +1181,76 @@ void Preprocessor::processSource(const std::string& src,
 
         if (_expansionDepth >= MAX_EXPANSION_DEPTH) {
             addError(filename, line,
-                "macro expansion depth exceeded for `" + name);
+                "macro expansion depth exceeded for `" + std::string(name));
             continue;
         }
+        if (_expansionDepth == 0) {
+            _expansionLine = callLine;
+        }
         ++_expansionDepth;
-        std::string nested;
         processSource(substituted,
-                      filename + " (in macro `" + name + ")",
-                      &nested);
+                      filename + " (in macro `" + std::string(name) + ")",
+                      out);
         --_expansionDepth;
-        emit(nested);
     }
 }
 
 int Preprocessor::processFile(const std::string& path, std::string* out) {
-    std::ifstream f(path);
-    if (!f) {
+    MappedFile f;
+    if (!f.open(path)) {
         addError(path, 1, "cannot open file");
         return 1;
     }
-    std::ostringstream oss;
-    oss << f.rdbuf();
-    return processString(oss.str(), path, out);
+    return processString(f.data(), path, out);
+}
+
+int Preprocessor::processFile(const std::string& path,
+                              PreprocessedStream* stream) {
+    MappedFile f;
+    if (!f.open(path)) {
+        addError(path, 1, "cannot open file");
+        stream->close();
+        return 1;
+    }
+
+    std::string block;
+    block.reserve(PreprocessedStream::BLOCK_SIZE);
+    _condStack.clear();
+    updateActive();
+
+    _stream = stream;
+    beginSourceMap(path);
+    processSource(f.data(), path, &block);
+    endSourceMap();
+    _stream = nullptr;
+
+    stream->push(block);
+    stream->close();
+    return _errors.empty() ? 0 : 1;
+}
+
+void Preprocessor::flushStream(std::string* out) {
+    // An include being recorded for the cache still needs its text in
+    // one piece; the block is handed over once it completes.
+    if (!_recordings.empty()) {
+        return;
+    }
+    _stream->push(*out);
+    out->clear();
 }
 
-int Preprocessor::processString(const std::string& source,
+int Preprocessor::processString(std::string_view source,
                                 const std::string& sourceName,
                                 std::string* out) {
     out->clear();
+    // Output is rarely much larger than the input; reserve it once so
+    // the span appends do not keep regrowing it.
+    out->reserve(source.size());
     _condStack.clear();
+    updateActive();
+    beginSourceMap(sourceName);
     processSource(source, sourceName, out);
+    endSourceMap();
     return _errors.empty() ? 0 : 1;
 }
 
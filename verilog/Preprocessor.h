@@ -1,12 +1,21 @@
 #pragma once
 
 #include <stddef.h>
-#include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "IncludeCache.h"
+#include "StringTable.h"
+
 namespace stargate {
 
+class PreprocessedStream;
+class SourceMap;
+
 class Preprocessor {
 public:
     Preprocessor();
@@ -16,19 +25,46 @@ public:
     void define(const std::string& name, const std::string& body);
     void undefine(const std::string& name);
 
+    // Reuse and publish preprocessed includes through a cache shared
+    // with other Preprocessors. The cache must outlive this object.
+    void setIncludeCache(IncludeCache* cache) { _includeCache = cache; }
+
+    // Record where every output line comes from. Output lines are
+    // numbered on from the end line of the map, which is advanced past
+    // each processed file.
+    void setSourceMap(SourceMap* map) { _sourceMap = map; }
+
     int processFile(const std::string& path, std::string* out);
-    int processString(const std::string& source,
+    // Hands the output to stream in blocks while it is produced, and
+    // closes the stream when done.
+    int processFile(const std::string& path, PreprocessedStream* stream);
+    int processString(std::string_view source,
                       const std::string& sourceName,
                       std::string* out);
 
     const std::vector<std::string>& errors() const { return _errors; }
     bool hasErrors() const { return !_errors.empty(); }
 
+    // Every file included so far, as resolved, including the ones a
+    // cached include unit read.
+    const std::set<std::string>& dependencies() const { return _dependencies; }
+
+    // Paths probed before the ones includes resolved to, which did not
+    // exist. A file created at one of them would be included instead.
+    const std::set<std::string>& missingIncludes() const { return _missingIncludes; }
+
 private:
-    struct Macro {
-        std::vector<std::string> params;
-        std::string body;
-        bool isFunctionLike {false};
+    using Macro = MacroDef;
+
+    // An included file, mapped once per session. guard is the macro
+    // of its `ifndef/`define/`endif include guard, if it has one.
+    struct IncludeFile;
+
+    // Where an `include resolved to, and the candidates probed before
+    // it that did not exist.
+    struct IncludeResolution {
+        std::string path;
+        std::vector<std::string> missing;
     };
 
     struct CondFrame {
@@ -37,57 +73,109 @@ private:
         bool seenElse;
     };
 
-    std::map<std::string, Macro> _macros;
+    // Macro names are interned; a macro lives at the index of its
+    // SymbolID, and a null entry is a name that is not defined.
+    StringTable _macroNames;
+    std::vector<std::unique_ptr<Macro>> _macros;
     std::vector<std::string> _includeDirs;
+    // Keyed by the including directory and the requested path.
+    std::unordered_map<std::string, IncludeResolution> _includePaths;
+    std::unordered_map<std::string, std::unique_ptr<IncludeFile>> _includeFiles;
     std::vector<CondFrame> _condStack;
+    // True when every frame of _condStack is active. Kept up to date
+    // by updateActive() so the scan loop does not walk the stack.
+    bool _active {true};
     std::vector<std::string> _errors;
+    std::set<std::string> _dependencies;
+    std::set<std::string> _missingIncludes;
+    IncludeCache* _includeCache {nullptr};
+    PreprocessedStream* _stream {nullptr};
+    SourceMap* _sourceMap {nullptr};
+    // Output line being written, the source map file being read, and
+    // the line of the outermost macro call being expanded.
+    uint32_t _outLine {0};
+    uint32_t _curFile {0};
+    int _expansionLine {0};
+    // Units being recorded for the include cache, outermost first.
+    std::vector<IncludeUnit*> _recordings;
     int _includeDepth {0};
     int _expansionDepth {0};
 
     static constexpr int MAX_INCLUDE_DEPTH = 64;
     static constexpr int MAX_EXPANSION_DEPTH = 256;
 
-    bool isActive() const;
+    bool isActive() const { return _active; }
     bool parentActive() const;
+    void updateActive();
+
+    // All macro table accesses go through these so that the include
+    // units being recorded see what they read and write.
+    const Macro* lookupMacro(std::string_view name);
+    const Macro* findMacro(std::string_view name) const;
+    void setMacro(const std::string& name, const Macro& m);
+    void eraseMacro(std::string_view name);
+
+    bool matchesUnit(const IncludeUnit& unit) const;
+    void replayUnit(const IncludeUnit& unit, std::string* out);
+
+    void flushStream(std::string* out);
+
+    void beginSourceMap(const std::string& name);
+    void endSourceMap();
+    void markSource(int line);
+    void addSourceRun(const SourceMapRun& run);
+    void includeSource(std::string_view src,
+                       const std::string& path,
+                       std::string* out);
 
     void addError(const std::string& filename,
                   int line,
                   const std::string& msg);
 
-    void processSource(const std::string& src,
+    // Appends the preprocessed text of src to out. Text that passes
+    // through unchanged is copied straight from src in spans.
+    void processSource(std::string_view src,
                        const std::string& filename,
                        std::string* out);
 
-    void handleDefine(const std::string& src,
+    void handleDefine(std::string_view src,
                       size_t& i,
                       const std::string& filename,
                       int& line);
-    void handleInclude(const std::string& src,
+    void handleInclude(std::string_view src,
                        size_t& i,
                        const std::string& filename,
                        int line,
                        std::string* out);
-    bool readMacroArgs(const std::string& src,
+    bool readMacroArgs(std::string_view src,
                        size_t& i,
                        int& line,
                        std::vector<std::string>* args);
-    std::string substituteParams(const Macro* m,
-                                 const std::vector<std::string>& args);
-    void skipBalancedParens(const std::string& src,
+    static void compileMacro(Macro* m);
+    static std::string substituteParams(const Macro* m,
+                                        const std::vector<std::string>& args);
+    void skipBalancedParens(std::string_view src,
                             size_t& i,
                             int& line);
 
     static bool isIdStart(char c);
     static bool isIdCont(char c);
-    static std::string readIdent(const std::string& src, size_t& i);
-    static void skipSpaces(const std::string& src, size_t& i);
-    static int skipToEol(const std::string& src, size_t& i);
-    static std::string readDirectiveLine(const std::string& src, size_t& i,
+    static std::string_view readIdent(std::string_view src, size_t& i);
+    static void skipSpaces(std::string_view src, size_t& i);
+    static int skipToEol(std::string_view src, size_t& i);
+    static std::string readDirectiveLine(std::string_view src, size_t& i,
                                          int* lineDelta);
+    static void skipBlank(std::string_view src, size_t& i);
+    static bool detectIncludeGuard(std::string_view src, std::string& guard);
 
     bool resolveIncludePath(const std::string& referenced,
                             const std::string& fromFile,
                             std::string* resolved);
+    bool resolveIncludePathUncached(const std::string& referenced,
+                                    const std::string& fromFile,
+                                    IncludeResolution* resolution);
+    void addMissingIncludes(const std::vector<std::string>& paths);
+    IncludeFile* getIncludeFile(const std::string& path);
 };
 
 }
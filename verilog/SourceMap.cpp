@@ -0,0 +1,59 @@
+#include "SourceMap.h"
+
+#include <algorithm>
+
+namespace stargate {
+
+SourceMap::SourceMap() {
+}
+
+SourceMap::~SourceMap() {
+}
+
+uint32_t SourceMap::addFile(const std::string& name) {
+    const auto it = _fileIndex.find(name);
+    if (it != _fileIndex.end()) {
+        return it->second;
+    }
+
+    const uint32_t file = _files.size();
+    _files.push_back(name);
+    _fileIndex.emplace(name, file);
+    return file;
+}
+
+void SourceMap::addRun(uint32_t outputLine, uint32_t file, uint32_t line,
+                       uint32_t lineStep) {
+    if (!_runs.empty()) {
+        SourceMapRun& last = _runs.back();
+        if (last.file == file && last.lineStep == lineStep
+            && last.line + (outputLine - last.outputLine) * lineStep == line) {
+            return;
+        }
+
+        // Still on the line the last run starts at: the later origin
+        // wins.
+        if (last.outputLine == outputLine) {
+            last = {outputLine, file, line, lineStep};
+            return;
+        }
+    }
+    _runs.push_back({outputLine, file, line, lineStep});
+}
+
+bool SourceMap::resolve(uint32_t outputLine, uint32_t* file, uint32_t* line) const {
+    const auto it = std::upper_bound(_runs.begin(), _runs.end(), outputLine,
+        [](uint32_t l, const SourceMapRun& run) {
+            return l < run.outputLine;
+        });
+    if (it == _runs.begin()) {
+        return false;
+    }
+
+    const SourceMapRun& run = *(it - 1);
+    *file = run.file;
+    *line = run.line + (outputLine - run.outputLine) * run.lineStep;
+    return true;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace stargate {
+
+// One run of preprocessed output lines that map linearly back to a
+// source file. Inside a macro expansion every output line maps to the
+// line of the call, so lineStep is 0 there and 1 elsewhere.
+struct SourceMapRun {
+    uint32_t outputLine {0};
+    uint32_t file {0};
+    uint32_t line {0};
+    uint32_t lineStep {1};
+};
+
+// Maps lines of preprocessed output back to (file, line). Output lines
+// are numbered across every file a driver preprocesses, so a line
+// kept in the AST identifies its source on its own. Runs are appended
+// in output order and only where the mapping stops being linear, so a
+// lookup is a binary search over a short table.
+class SourceMap {
+public:
+    SourceMap();
+    ~SourceMap();
+
+    uint32_t addFile(const std::string& name);
+    const std::string& getFileName(uint32_t file) const { return _files[file]; }
+
+    // States that outputLine comes from line of file. Ignored when the
+    // last run already implies it.
+    void addRun(uint32_t outputLine, uint32_t file, uint32_t line,
+                uint32_t lineStep);
+
+    // First output line of the next preprocessed file.
+    uint32_t getEndLine() const { return _endLine; }
+    void setEndLine(uint32_t line) { _endLine = line; }
+
+    bool resolve(uint32_t outputLine, uint32_t* file, uint32_t* line) const;
+
+    const std::vector<SourceMapRun>& getRuns() const { return _runs; }
+
+private:
+    std::vector<SourceMapRun> _runs;
+    std::vector<std::string> _files;
+    std::unordered_map<std::string, uint32_t> _fileIndex;
+    uint32_t _endLine {1};
+};
+
+}
@@ -0,0 +1,92 @@
+#include "StringTable.h"
+
+namespace stargate {
+
+namespace {
+
+constexpr size_t INITIAL_SLOTS = 1024;
+
+}
+
+StringTable::StringTable()
+    : _slots(INITIAL_SLOTS, 0),
+    _mask(INITIAL_SLOTS - 1)
+{
+    _strings.emplace_back();
+    _hashes.push_back(0);
+}
+
+StringTable::~StringTable() {
+}
+
+uint64_t StringTable::hash(std::string_view str) {
+    // FNV-1a, 64 bit.
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const char c : str) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+SymbolID StringTable::find(std::string_view str) const {
+    const uint64_t h = hash(str);
+    size_t slot = h & _mask;
+    while (true) {
+        const uint32_t id = _slots[slot];
+        if (id == 0) {
+            return NULL_SYMBOL;
+        }
+        if (_hashes[id] == h && _strings[id] == str) {
+            return SymbolID {id};
+        }
+        slot = (slot + 1) & _mask;
+    }
+}
+
+SymbolID StringTable::intern(std::string_view str) {
+    if (str.empty()) {
+        return NULL_SYMBOL;
+    }
+
+    const uint64_t h = hash(str);
+    size_t slot = h & _mask;
+    while (true) {
+        const uint32_t id = _slots[slot];
+        if (id == 0) {
+            break;
+        }
+        if (_hashes[id] == h && _strings[id] == str) {
+            return SymbolID {id};
+        }
+        slot = (slot + 1) & _mask;
+    }
+
+    const uint32_t id = _strings.size();
+    _strings.push_back(_arena.copyString(str));
+    _hashes.push_back(h);
+    _slots[slot] = id;
+
+    // Keep the load factor under 1/2 so probe sequences stay short.
+    if (_strings.size() * 2 > _slots.size()) {
+        grow();
+    }
+
+    return SymbolID {id};
+}
+
+void StringTable::grow() {
+    const size_t newSize = _slots.size() * 2;
+    _slots.assign(newSize, 0);
+    _mask = newSize - 1;
+
+    for (uint32_t id = 1; id < _strings.size(); id++) {
+        size_t slot = _hashes[id] & _mask;
+        while (_slots[slot] != 0) {
+            slot = (slot + 1) & _mask;
+        }
+        _slots[slot] = id;
+    }
+}
+
+}
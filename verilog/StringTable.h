@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+#include "Arena.h"
+
+namespace stargate {
+
+// Interned identifier. Id 0 is reserved for "no symbol" and maps to
+// the empty string.
+struct SymbolID {
+    uint32_t value {0};
+
+    bool operator==(const SymbolID& other) const = default;
+};
+
+constexpr SymbolID NULL_SYMBOL {0};
+
+// Open-addressing intern table. The characters of every distinct
+// string are stored once in an arena; a symbol is a dense 32-bit
+// index so the parser and the AST never carry std::string copies.
+class StringTable {
+public:
+    StringTable();
+    ~StringTable();
+
+    SymbolID intern(std::string_view str);
+
+    // Returns NULL_SYMBOL if str was never interned.
+    SymbolID find(std::string_view str) const;
+
+    std::string_view getString(SymbolID id) const {
+        return _strings[id.value];
+    }
+
+    size_t size() const { return _strings.size() - 1; }
+
+    static uint64_t hash(std::string_view str);
+
+private:
+    Arena _arena;
+    std::vector<std::string_view> _strings;
+    std::vector<uint64_t> _hashes;
+    std::vector<uint32_t> _slots;
+    size_t _mask {0};
+
+    void grow();
+};
+
+}
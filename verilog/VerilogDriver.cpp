@@ -1,23 +1,31 @@
 #include "VerilogDriver.h"
 
 #include <stdio.h>
+#include <exception>
 #include <sstream>
+#include <thread>
 
 #include "Parser.h"
+#include "PreprocessedStream.h"
 #include "Preprocessor.h"
 
 namespace stargate {
 
 void scanBeginFile(VerilogDriver& drv, const std::string& path);
 void scanBeginString(VerilogDriver& drv, const std::string& source);
-void scanEnd();
+void scanBeginStream(VerilogDriver& drv, PreprocessedStream* stream);
+void scanEnd(VerilogDriver& drv);
 
 VerilogDriver::VerilogDriver()
-    : _pp(std::make_unique<Preprocessor>())
+    : _pp(std::make_unique<Preprocessor>()),
+    _ast(std::make_unique<Ast>()),
+    _sourceMap(std::make_unique<SourceMap>())
 {
+    _pp->setSourceMap(_sourceMap.get());
 }
 
 VerilogDriver::~VerilogDriver() {
+    scanEnd(*this);
 }
 
 void VerilogDriver::addIncludeDir(const std::string& dir) {
@@ -29,6 +37,10 @@ void VerilogDriver::defineMacro(const std::string& name,
     _pp->define(name, body);
 }
 
+void VerilogDriver::setIncludeCache(IncludeCache* cache) {
+    _pp->setIncludeCache(cache);
+}
+
 int VerilogDriver::preprocessFile(const std::string& path,
                                   std::string* out) {
     _filename = path;
@@ -52,39 +64,87 @@ int VerilogDriver::parseFile(const std::string& path) {
         _svKeywords = (ext == ".sv" || ext == ".svh");
     }
 
-    std::string processed;
-    const int prc = _pp->processFile(path, &processed);
-    copyPreprocessorErrors();
+    // The preprocessor runs on its own thread and the lexer pulls its
+    // output block by block, so lexing overlaps preprocessing and the
+    // whole preprocessed file never sits in memory.
+    _parseErrors.clear();
+
+    PreprocessedStream stream;
+    const uint32_t firstLine = _sourceMap->getEndLine();
+    int prc = 0;
+    std::exception_ptr ppException;
+    std::thread producer([&]() {
+        try {
+            prc = _pp->processFile(path, &stream);
+        } catch (...) {
+            ppException = std::current_exception();
+            stream.close();
+        }
+    });
+
+    const int rc = parseStream(&stream, firstLine);
+    stream.cancel();
+    producer.join();
+
+    if (ppException) {
+        std::rethrow_exception(ppException);
+    }
+
+    // As before streaming: a file that fails to preprocess reports
+    // the preprocessor errors only.
     if (prc != 0) {
+        _errors.clear();
+        _parseErrors.clear();
+        copyPreprocessorErrors();
         return 1;
     }
-    return parseProcessed(processed);
+    resolveParseErrors();
+    return rc;
 }
 
 int VerilogDriver::parseString(const std::string& source) {
     _filename = "<string>";
     _errors.clear();
+    _parseErrors.clear();
 
     std::string processed;
+    const uint32_t firstLine = _sourceMap->getEndLine();
     const int prc = _pp->processString(source, _filename, &processed);
     copyPreprocessorErrors();
     if (prc != 0) {
         return 1;
     }
-    return parseProcessed(processed);
+
+    const int rc = parseProcessed(processed, firstLine);
+    resolveParseErrors();
+    return rc;
 }
 
-int VerilogDriver::parseProcessed(const std::string& processed) {
-    _location.initialize(&_filename);
+int VerilogDriver::parseProcessed(const std::string& processed,
+                                  uint32_t firstLine) {
+    _location.initialize(&_filename, firstLine);
+
+    // Rough node density of real sources; avoids most of the pool
+    // regrowth on large files.
+    _ast->reserve(_ast->size() + processed.size() / 16);
 
     scanBeginString(*this, processed);
     const int rc = doParse();
-    scanEnd();
+    scanEnd(*this);
+    return rc;
+}
+
+int VerilogDriver::parseStream(PreprocessedStream* stream, uint32_t firstLine) {
+    _location.initialize(&_filename, firstLine);
+
+    scanBeginStream(*this, stream);
+    const int rc = doParse();
+    scanEnd(*this);
     return rc;
 }
 
 int VerilogDriver::doParse() {
-    Parser parser(*this);
+    Parser parser(*this, _scanner);
     parser.set_debug_level(_trace ? 1 : 0);
     const int rc = parser.parse();
     if (rc != 0 || hasErrors()) {
@@ -95,9 +155,36 @@ int VerilogDriver::doParse() {
 
 void VerilogDriver::addError(const Parser::location_type& loc,
                              const std::string& msg) {
-    std::ostringstream oss;
-    oss << loc << ": " << msg;
-    _errors.push_back(oss.str());
+    _parseErrors.emplace_back(loc, msg);
+}
+
+void VerilogDriver::resolveParseErrors() {
+    for (const auto& [loc, msg] : _parseErrors) {
+        std::ostringstream oss;
+        uint32_t file = 0;
+        uint32_t line = 0;
+        if (_sourceMap->resolve(loc.begin.line, &file, &line)) {
+            oss << _sourceMap->getFileName(file) << ":" << line
+                << "." << loc.begin.column;
+        } else {
+            oss << loc;
+        }
+        oss << ": " << msg;
+        _errors.push_back(oss.str());
+    }
+    _parseErrors.clear();
+}
+
+bool VerilogDriver::hasPreprocessorErrors() const {
+    return _pp->hasErrors();
+}
+
+const std::set<std::string>& VerilogDriver::dependencies() const {
+    return _pp->dependencies();
+}
+
+const std::set<std::string>& VerilogDriver::missingIncludes() const {
+    return _pp->missingIncludes();
 }
 
 void VerilogDriver::copyPreprocessorErrors() {
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <memory>
+#include <set>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "Ast.h"
 #include "Parser.h"
+#include "SourceMap.h"
 
 namespace stargate {
 
+class IncludeCache;
+class PreprocessedStream;
 class Preprocessor;
 
 class VerilogDriver {
@@ -17,6 +24,7 @@ public:
 
     void addIncludeDir(const std::string& dir);
     void defineMacro(const std::string& name, const std::string& body);
+    void setIncludeCache(IncludeCache* cache);
 
     int parseFile(const std::string& path);
     int parseString(const std::string& source);
@@ -24,11 +32,35 @@ public:
     int preprocessFile(const std::string& path, std::string* out);
 
     const std::vector<std::string>& errors() const { return _errors; }
-    bool hasErrors() const { return !_errors.empty(); }
+    bool hasErrors() const { return !_errors.empty() || !_parseErrors.empty(); }
+    bool hasPreprocessorErrors() const;
+
+    // Every file included by the sources processed so far.
+    const std::set<std::string>& dependencies() const;
+
+    // Include candidates that did not exist, see
+    // Preprocessor::missingIncludes().
+    const std::set<std::string>& missingIncludes() const;
+
+    // Syntax tree of every file parsed by this driver so far.
+    Ast* ast() { return _ast.get(); }
+    const Ast* ast() const { return _ast.get(); }
+
+    SymbolID intern(std::string_view text) { return _ast->intern(text); }
+
+    // Resolves the lines of locations and AST nodes, which count
+    // preprocessed output lines across every file of this driver.
+    const SourceMap* sourceMap() const { return _sourceMap.get(); }
 
     Parser::location_type& location() { return _location; }
     const std::string& filename() const { return _filename; }
 
+    // Opaque reentrant flex scanner (yyscan_t). Each driver owns its
+    // own scanner state, so distinct drivers may parse concurrently;
+    // a single driver is not meant to be shared between threads.
+    void* scanner() const { return _scanner; }
+    void setScanner(void* scanner) { _scanner = scanner; }
+
     void setTrace(bool on) { _trace = on; }
     bool trace() const { return _trace; }
 
@@ -46,12 +78,21 @@ public:
 private:
     Parser::location_type _location;
     std::vector<std::string> _errors;
+    // Lexer and parser errors, formatted once the source map is
+    // complete. The preprocessor may still be extending it while
+    // they are raised.
+    std::vector<std::pair<Parser::location_type, std::string>> _parseErrors;
     std::string _filename;
+    void* _scanner {nullptr};
     bool _trace {false};
     bool _svKeywords {true};
     std::unique_ptr<Preprocessor> _pp;
+    std::unique_ptr<Ast> _ast;
+    std::unique_ptr<SourceMap> _sourceMap;
 
-    int parseProcessed(const std::string& processed);
+    int parseProcessed(const std::string& processed, uint32_t firstLine);
+    int parseStream(PreprocessedStream* stream, uint32_t firstLine);
+    void resolveParseErrors();
     int doParse();
     void copyPreprocessorErrors();
 };